@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -279,6 +280,42 @@ size_t TF_StringEncodedSize(size_t len) {
   return static_cast<size_t>(tensorflow::core::VarintLength(len)) + len;
 }
 
+TF_Tensor* TF_NewFlatStringTensor(const int64_t* dims, int num_dims,
+                                  void* data, size_t len,
+                                  void (*deallocator)(void* data, size_t len,
+                                                      void* arg),
+                                  void* deallocator_arg) {
+  TF_Tensor* t = TF_NewTensor(TF_STRING, dims, num_dims, data, len,
+                              deallocator, deallocator_arg);
+  t->flat_strings = true;
+  return t;
+}
+
+TF_Tensor* TF_AllocateFlatStringTensor(const int64_t* dims, int num_dims,
+                                       size_t len) {
+  void* data = allocate_tensor("TF_AllocateFlatStringTensor", len);
+  return TF_NewFlatStringTensor(dims, num_dims, data, len, deallocate_buffer,
+                                nullptr);
+}
+
+int TF_TensorHasFlatStrings(const TF_Tensor* t) {
+  return t->dtype == TF_STRING && t->flat_strings;
+}
+
+size_t TF_FlatStringTensorByteSize(int64_t num_elements,
+                                   size_t total_string_len) {
+  // Saturates rather than wraps around, so that size checks against the
+  // result fail.
+  const size_t max_size = std::numeric_limits<size_t>::max();
+  if (num_elements < 0 || static_cast<tensorflow::uint64>(num_elements) >=
+                              max_size / sizeof(tensorflow::uint64)) {
+    return max_size;
+  }
+  const size_t offsets_size = sizeof(tensorflow::uint64) * (num_elements + 1);
+  if (total_string_len > max_size - offsets_size) return max_size;
+  return offsets_size + total_string_len;
+}
+
 // --------------------------------------------------------------------------
 TF_SessionOptions* TF_NewSessionOptions() { return new TF_SessionOptions; }
 void TF_DeleteSessionOptions(TF_SessionOptions* opt) { delete opt; }
@@ -424,6 +461,103 @@ bool TF_Tensor_DecodeStrings(TF_Tensor* src, Tensor* dst, TF_Status* status) {
   return true;
 }
 
+// Non-static for testing.
+bool TF_Tensor_DecodeFlatStrings(TF_Tensor* src, Tensor* dst,
+                                 TF_Status* status) {
+  const tensorflow::int64 num_elements = src->shape.num_elements();
+  const char* input = reinterpret_cast<const char*>(TF_TensorData(src));
+  const size_t src_size = TF_TensorByteSize(src);
+  const size_t offsets_size = TF_FlatStringTensorByteSize(num_elements, 0);
+  if (src_size < offsets_size) {
+    status->status = InvalidArgument(
+        "Malformed flat TF_STRING tensor; too short to hold the offsets");
+    return false;
+  }
+  const tensorflow::uint64* offsets =
+      reinterpret_cast<const tensorflow::uint64*>(input);
+  const char* data_start = input + offsets_size;
+  const size_t data_size = src_size - offsets_size;
+  if (offsets[0] != 0) {
+    status->status =
+        InvalidArgument("Malformed flat TF_STRING tensor; offsets out of range");
+    return false;
+  }
+  // All the offsets are checked before any string is read.
+  for (tensorflow::int64 i = 0; i < num_elements; ++i) {
+    if (offsets[i + 1] < offsets[i] || offsets[i + 1] > data_size) {
+      status->status = InvalidArgument(
+          "Malformed flat TF_STRING tensor; element ", i, " out of range");
+      return false;
+    }
+  }
+
+  *dst = Tensor(tensorflow::DT_STRING, src->shape);
+  auto dstarray = dst->flat<tensorflow::string>();
+  for (tensorflow::int64 i = 0; i < num_elements; ++i) {
+    dstarray(i).assign(data_start + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+  return true;
+}
+
+// Returns an error if "dst", preallocated by the caller, cannot hold "src".
+static Status CheckPreallocatedOutput(const Tensor& src, const TF_Tensor* dst) {
+  if (static_cast<DataType>(dst->dtype) != src.dtype() ||
+      dst->shape != src.shape()) {
+    return InvalidArgument(
+        "Preallocated output of type ", DataTypeString(
+                                            static_cast<DataType>(dst->dtype)),
+        " and shape ", dst->shape.DebugString(), " does not match ",
+        DataTypeString(src.dtype()), " output of shape ",
+        src.shape().DebugString());
+  }
+  if (src.dtype() != tensorflow::DT_STRING &&
+      !tensorflow::DataTypeCanUseMemcpy(src.dtype())) {
+    return InvalidArgument("Outputs of type ", DataTypeString(src.dtype()),
+                           " cannot be preallocated");
+  }
+  size_t size = src.TotalBytes();
+  if (src.dtype() == tensorflow::DT_STRING) {
+    if (!dst->flat_strings) {
+      return InvalidArgument(
+          "Preallocated TF_STRING outputs must be in the flat format");
+    }
+    size_t total_string_len = 0;
+    const auto& srcarray = src.flat<tensorflow::string>();
+    for (tensorflow::int64 i = 0; i < srcarray.size(); ++i) {
+      total_string_len += srcarray(i).size();
+    }
+    size = TF_FlatStringTensorByteSize(srcarray.size(), total_string_len);
+  }
+  if (TF_TensorByteSize(dst) < size) {
+    return InvalidArgument("Preallocated output of ", TF_TensorByteSize(dst),
+                           " bytes is too small to hold ", size, " bytes");
+  }
+  return Status::OK();
+}
+
+// Copies "src" into "dst", which CheckPreallocatedOutput() accepted.
+static void CopyToPreallocatedOutput(const Tensor& src, TF_Tensor* dst) {
+  char* dst_data = static_cast<char*>(TF_TensorData(dst));
+  if (src.dtype() != tensorflow::DT_STRING) {
+    const tensorflow::StringPiece src_data = src.tensor_data();
+    if (src_data.data() != dst_data) {
+      memcpy(dst_data, src_data.data(), src_data.size());
+    }
+    return;
+  }
+  const auto& srcarray = src.flat<tensorflow::string>();
+  tensorflow::uint64* offsets = reinterpret_cast<tensorflow::uint64*>(dst_data);
+  char* data_start = dst_data + TF_FlatStringTensorByteSize(srcarray.size(), 0);
+  tensorflow::uint64 offset = 0;
+  for (tensorflow::int64 i = 0; i < srcarray.size(); ++i) {
+    offsets[i] = offset;
+    const tensorflow::string& s = srcarray(i);
+    memcpy(data_start + offset, s.data(), s.size());
+    offset += s.size();
+  }
+  offsets[srcarray.size()] = offset;
+}
+
 // Non-static for testing.
 TF_Tensor* TF_Tensor_EncodeStrings(const Tensor& src) {
   // Compute bytes needed for encoding.
@@ -517,6 +651,11 @@ static bool TF_Run_Inputs(
     if (c_inputs[i]->dtype != TF_STRING) {
       (*input_pairs)[i].second = tensorflow::TensorCApi::MakeTensor(
           src->dtype, src->shape, src->buffer);
+    } else if (src->flat_strings) {
+      if (!tensorflow::TF_Tensor_DecodeFlatStrings(
+              src, &(*input_pairs)[i].second, status)) {
+        return false;
+      }
     } else if (!tensorflow::TF_Tensor_DecodeStrings(
                    src, &(*input_pairs)[i].second, status)) {
       // TF_STRING tensors require copying since Tensor class expects
@@ -536,7 +675,9 @@ static void TF_Run_Helper(
     TF_Tensor** c_outputs,
     // Target nodes
     const std::vector<tensorflow::string>& target_oper_names,
-    TF_Buffer* run_metadata, TF_Status* status) {
+    TF_Buffer* run_metadata,
+    // If true, the non-null c_outputs[] are preallocated by the caller.
+    bool preallocated_outputs, TF_Status* status) {
   const int noutputs = output_tensor_names.size();
   std::vector<Tensor> outputs(noutputs);
   Status result;
@@ -572,9 +713,23 @@ static void TF_Run_Helper(
     return;
   }
 
+  // Check the preallocated outputs before allocating any other.
+  if (preallocated_outputs) {
+    for (int i = 0; i < noutputs; ++i) {
+      if (c_outputs[i] == nullptr) continue;
+      status->status =
+          tensorflow::CheckPreallocatedOutput(outputs[i], c_outputs[i]);
+      if (!status->status.ok()) return;
+    }
+  }
+
   // Store results in c_outputs[]
   for (int i = 0; i < noutputs; ++i) {
     const Tensor& src = outputs[i];
+    if (preallocated_outputs && c_outputs[i] != nullptr) {
+      tensorflow::CopyToPreallocatedOutput(src, c_outputs[i]);
+      continue;
+    }
     if (!src.IsInitialized() || src.NumElements() == 0) {
       c_outputs[i] = tensorflow::EmptyTensor(
           static_cast<TF_DataType>(src.dtype()), src.shape());
@@ -617,7 +772,7 @@ void TF_Run(TF_DeprecatedSession* s, const TF_Buffer* run_options,
     target_oper_names[i] = c_target_oper_names[i];
   }
   TF_Run_Helper(s->session, nullptr, run_options, input_pairs, output_names,
-                c_outputs, target_oper_names, run_metadata, status);
+                c_outputs, target_oper_names, run_metadata, false, status);
 }
 
 void TF_PRunSetup(TF_DeprecatedSession* s,
@@ -680,7 +835,7 @@ void TF_PRun(TF_DeprecatedSession* s, const char* handle,
     target_oper_names[i] = c_target_oper_names[i];
   }
   TF_Run_Helper(s->session, handle, nullptr, input_pairs, output_names,
-                c_outputs, target_oper_names, nullptr, status);
+                c_outputs, target_oper_names, nullptr, false, status);
 }
 
 TF_Library* TF_LoadLibrary(const char* library_filename, TF_Status* status) {
@@ -2281,12 +2436,12 @@ static bool ExtendSessionGraphHelper(TF_Session* session, TF_Status* status) {
   return true;
 }
 
-void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
-                   const TF_Output* inputs, TF_Tensor* const* input_values,
-                   int ninputs, const TF_Output* outputs,
-                   TF_Tensor** output_values, int noutputs,
-                   const TF_Operation* const* target_opers, int ntargets,
-                   TF_Buffer* run_metadata, TF_Status* status) {
+static void TF_SessionRun_Helper(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, bool preallocated_outputs, TF_Status* status) {
   // TODO(josh11b,mrry): Change Session to be able to use a Graph*
   // directly, instead of requiring us to serialize to a GraphDef and
   // call Session::Extend().
@@ -2294,7 +2449,11 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
     return;
   }
 
-  TF_Run_Setup(noutputs, output_values, status);
+  if (preallocated_outputs) {
+    status->status = Status::OK();
+  } else {
+    TF_Run_Setup(noutputs, output_values, status);
+  }
 
   // Convert from TF_Output and TF_Tensor to a string and Tensor.
   std::vector<std::pair<tensorflow::string, Tensor>> input_pairs(ninputs);
@@ -2318,7 +2477,29 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
   // Actually run.
   TF_Run_Helper(session->session, nullptr, run_options, input_pairs,
                 output_names, output_values, target_names, run_metadata,
-                status);
+                preallocated_outputs, status);
+}
+
+void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
+                   const TF_Output* inputs, TF_Tensor* const* input_values,
+                   int ninputs, const TF_Output* outputs,
+                   TF_Tensor** output_values, int noutputs,
+                   const TF_Operation* const* target_opers, int ntargets,
+                   TF_Buffer* run_metadata, TF_Status* status) {
+  TF_SessionRun_Helper(session, run_options, inputs, input_values, ninputs,
+                       outputs, output_values, noutputs, target_opers,
+                       ntargets, run_metadata, false, status);
+}
+
+void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  TF_SessionRun_Helper(session, run_options, inputs, input_values, ninputs,
+                       outputs, output_values, noutputs, target_opers,
+                       ntargets, run_metadata, true, status);
 }
 
 void TF_SessionPRunSetup(TF_Session* session, const TF_Output* inputs,
@@ -2394,7 +2575,7 @@ void TF_SessionPRun(TF_Session* session, const char* handle,
   }
 
   TF_Run_Helper(session->session, handle, nullptr, input_pairs, output_names,
-                output_values, target_names, nullptr, status);
+                output_values, target_names, nullptr, false, status);
 }
 
 }  // end extern "C"
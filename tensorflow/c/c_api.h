@@ -214,6 +214,14 @@ TF_CAPI_EXPORT extern TF_Buffer TF_GetBuffer(TF_Buffer* buffer);
 //   The string length (as a varint), followed by the contents of the string
 //   is encoded at data[start_offset[i]]]. TF_StringEncode and TF_StringDecode
 //   facilitate this encoding.
+//
+// TF_STRING tensors created by TF_NewFlatStringTensor or
+// TF_AllocateFlatStringTensor use the flat format instead, which needs no
+// per-string encoding:
+//   offsets: array[uint64] with num_elements + 1 entries
+//   data:    byte[...]
+//
+//   String i is data[offsets[i], offsets[i + 1]), and offsets[0] is 0.
 
 typedef struct TF_Tensor TF_Tensor;
 
@@ -292,6 +300,29 @@ TF_CAPI_EXPORT extern size_t TF_StringDecode(const char* src, size_t src_len,
 // TF_STRING tensor.
 TF_CAPI_EXPORT extern size_t TF_StringEncodedSize(size_t len);
 
+// Return a new TF_STRING tensor in the flat format that holds the bytes
+// data[0,len-1], as TF_NewTensor does. Feeding the tensor to a session
+// decodes its strings without varint parsing.
+TF_CAPI_EXPORT extern TF_Tensor* TF_NewFlatStringTensor(
+    const int64_t* dims, int num_dims, void* data, size_t len,
+    void (*deallocator)(void* data, size_t len, void* arg),
+    void* deallocator_arg);
+
+// Allocate and return a new TF_STRING tensor in the flat format, as
+// TF_AllocateTensor does. `len` should be at least
+// TF_FlatStringTensorByteSize() of the strings to hold.
+TF_CAPI_EXPORT extern TF_Tensor* TF_AllocateFlatStringTensor(
+    const int64_t* dims, int num_dims, size_t len);
+
+// Return 1 if `tensor` is a TF_STRING tensor in the flat format, 0 otherwise.
+TF_CAPI_EXPORT extern int TF_TensorHasFlatStrings(const TF_Tensor* tensor);
+
+// Return the size in bytes of a TF_STRING tensor in the flat format that
+// holds `num_elements` strings of `total_string_len` bytes in total, or
+// SIZE_MAX if that size is not representable.
+TF_CAPI_EXPORT extern size_t TF_FlatStringTensorByteSize(
+    int64_t num_elements, size_t total_string_len);
+
 // --------------------------------------------------------------------------
 // TF_SessionOptions holds options that can be passed during session creation.
 typedef struct TF_SessionOptions TF_SessionOptions;
@@ -1093,6 +1124,40 @@ TF_CAPI_EXPORT extern void TF_SessionRun(
     // Output status
     TF_Status*);
 
+// Like TF_SessionRun, but the caller may preallocate the tensors that the
+// outputs are written to, such as buffers reused across runs.
+//
+// The outputs are computed as by TF_SessionRun and then copied into the
+// preallocated tensors. This saves the allocation and encoding of a new
+// tensor for TF_STRING outputs, but adds a copy for the other types, whose
+// buffer TF_SessionRun hands out without copying it. Preallocate those only
+// when the results are needed in buffers owned by the caller.
+//
+// If output_values[i] is not NULL on entry, it must be a tensor with the type
+// and shape of outputs[i], whose buffer is large enough to hold it: for a
+// TF_STRING output, a tensor in the flat format of at least
+// TF_FlatStringTensorByteSize() bytes. Outputs of types that are not plain
+// data, such as TF_RESOURCE, cannot be preallocated. The output is copied into
+// the tensor, and the caller keeps its ownership. Otherwise, output_values[i]
+// is set to a new tensor as by TF_SessionRun.
+//
+// On failure, the entries of output_values[] that were NULL on entry are
+// NULL, and the contents of the preallocated tensors are undefined.
+TF_CAPI_EXPORT extern void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session,
+    // RunOptions
+    const TF_Buffer* run_options,
+    // Input tensors
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    const TF_Output* outputs, TF_Tensor** output_values, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status*);
+
 // Set up the graph with the intended feeds (inputs) and fetches (outputs) for a
 // sequence of partial run calls.
 //
@@ -40,6 +40,9 @@ struct TF_Tensor {
   TF_DataType dtype;
   tensorflow::TensorShape shape;
   tensorflow::TensorBuffer* buffer;
+  // True if this TF_STRING tensor is in the flat format (see
+  // TF_NewFlatStringTensor).
+  bool flat_strings;
 };
 
 struct TF_SessionOptions {
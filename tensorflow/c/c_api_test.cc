@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <vector>
 #include "tensorflow/cc/saved_model/signature_constants.h"
@@ -38,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/util/equal_graph_def.h"
 
@@ -51,6 +53,8 @@ using tensorflow::TensorShape;
 namespace tensorflow {
 bool TF_Tensor_DecodeStrings(TF_Tensor* src, Tensor* dst, TF_Status* status);
 TF_Tensor* TF_Tensor_EncodeStrings(const Tensor& src);
+bool TF_Tensor_DecodeFlatStrings(TF_Tensor* src, Tensor* dst,
+                                 TF_Status* status);
 }  // namespace tensorflow
 
 namespace {
@@ -180,6 +184,85 @@ TEST(CAPI, TensorEncodeDecodeStrings) {
   TestEncodeDecode(__LINE__, {"small", big, "small2"});
 }
 
+// Returns a new TF_STRING tensor in the flat format that holds "strings".
+TF_Tensor* FlatStringTensor(const std::vector<string>& strings) {
+  size_t total_string_len = 0;
+  for (const string& s : strings) total_string_len += s.size();
+  const int64_t dims[] = {static_cast<int64_t>(strings.size())};
+  TF_Tensor* t = TF_AllocateFlatStringTensor(
+      dims, 1, TF_FlatStringTensorByteSize(strings.size(), total_string_len));
+  tensorflow::uint64* offsets =
+      static_cast<tensorflow::uint64*>(TF_TensorData(t));
+  char* data = reinterpret_cast<char*>(offsets + strings.size() + 1);
+  tensorflow::uint64 offset = 0;
+  for (int i = 0; i < strings.size(); ++i) {
+    offsets[i] = offset;
+    memcpy(data + offset, strings[i].data(), strings[i].size());
+    offset += strings[i].size();
+  }
+  offsets[strings.size()] = offset;
+  return t;
+}
+
+// Returns the strings of "t", a TF_STRING tensor in the flat format.
+std::vector<string> FlatStrings(TF_Tensor* t) {
+  const int64_t num_elements = TF_Dim(t, 0);
+  const tensorflow::uint64* offsets =
+      static_cast<const tensorflow::uint64*>(TF_TensorData(t));
+  const char* data = reinterpret_cast<const char*>(offsets + num_elements + 1);
+  std::vector<string> strings;
+  for (int64_t i = 0; i < num_elements; ++i) {
+    strings.emplace_back(data + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+  return strings;
+}
+
+TEST(CAPI, TensorDecodeFlatStrings) {
+  TF_Status* status = TF_NewStatus();
+  const std::vector<string> strings = {"the", "", "quick", string(1000, 'a')};
+  TF_Tensor* src = FlatStringTensor(strings);
+  EXPECT_TRUE(TF_TensorHasFlatStrings(src));
+  Tensor output;
+  ASSERT_TRUE(TF_Tensor_DecodeFlatStrings(src, &output, status));
+  ASSERT_EQ(TF_OK, TF_GetCode(status));
+  ASSERT_EQ(strings.size(), output.NumElements());
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ(strings[i], output.flat<string>()(i));
+  }
+
+  // An offset past the end of the data is rejected.
+  tensorflow::uint64* offsets =
+      static_cast<tensorflow::uint64*>(TF_TensorData(src));
+  offsets[2] = 10000;
+  EXPECT_FALSE(TF_Tensor_DecodeFlatStrings(src, &output, status));
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status));
+
+  // So are decreasing offsets.
+  offsets[2] = 1;
+  EXPECT_FALSE(TF_Tensor_DecodeFlatStrings(src, &output, status));
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status));
+
+  TF_DeleteTensor(src);
+
+  // A shape whose offsets do not fit in memory is rejected.
+  const int64_t dims[] = {int64_t{1} << 62};
+  src = TF_AllocateFlatStringTensor(dims, 1, 16);
+  EXPECT_FALSE(TF_Tensor_DecodeFlatStrings(src, &output, status));
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status));
+
+  TF_DeleteTensor(src);
+  TF_DeleteStatus(status);
+}
+
+TEST(CAPI, FlatStringTensorByteSize) {
+  EXPECT_EQ(3 * sizeof(tensorflow::uint64) + 5,
+            TF_FlatStringTensorByteSize(2, 5));
+  const size_t max_size = std::numeric_limits<size_t>::max();
+  EXPECT_EQ(max_size, TF_FlatStringTensorByteSize(int64_t{1} << 62, 0));
+  EXPECT_EQ(max_size, TF_FlatStringTensorByteSize(-1, 0));
+  EXPECT_EQ(max_size, TF_FlatStringTensorByteSize(1, max_size - 1));
+}
+
 TEST(CAPI, SessionOptions) {
   TF_SessionOptions* opt = TF_NewSessionOptions();
   TF_DeleteSessionOptions(opt);
@@ -1044,6 +1127,234 @@ TEST(CAPI, Session) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI, SessionRunWithPreallocatedOutputs) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+
+  // A string and an int32 placeholder, each fetched through an Identity.
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph, "Placeholder", "string_feed");
+  TF_SetAttrType(desc, "dtype", TF_STRING);
+  TF_Operation* string_feed = TF_FinishOperation(desc, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  desc = TF_NewOperation(graph, "Identity", "string_fetch");
+  TF_AddInput(desc, {string_feed, 0});
+  TF_Operation* string_fetch = TF_FinishOperation(desc, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* int_feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(int_feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  const std::vector<string> strings = {"hello", "", "world"};
+  TF_Output inputs[] = {{string_feed, 0}, {int_feed, 0}};
+  TF_Output outputs[] = {{string_fetch, 0}, {add, 0}};
+  int64_t dims[] = {3};
+  TF_Tensor* string_out = TF_AllocateFlatStringTensor(
+      dims, 1, TF_FlatStringTensorByteSize(3, 10));
+  TF_Tensor* int_out = TF_AllocateTensor(TF_INT32, nullptr, 0, sizeof(int32));
+  for (int32 v : {3, 7}) {
+    TF_Tensor* input_values[] = {FlatStringTensor(strings), Int32Tensor(v)};
+    TF_Tensor* output_values[] = {string_out, int_out};
+    TF_SessionRunWithPreallocatedOutputs(session, nullptr, inputs,
+                                         input_values, 2, outputs,
+                                         output_values, 2, nullptr, 0,
+                                         nullptr, s);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    // The outputs are written to the caller's tensors.
+    EXPECT_EQ(string_out, output_values[0]);
+    EXPECT_EQ(int_out, output_values[1]);
+    EXPECT_EQ(strings, FlatStrings(string_out));
+    EXPECT_EQ(v + 2, *static_cast<int32*>(TF_TensorData(int_out)));
+    TF_DeleteTensor(input_values[0]);
+    TF_DeleteTensor(input_values[1]);
+  }
+
+  // NULL entries are allocated as by TF_SessionRun.
+  {
+    TF_Tensor* input_values[] = {FlatStringTensor(strings), Int32Tensor(1)};
+    TF_Tensor* output_values[] = {string_out, nullptr};
+    TF_SessionRunWithPreallocatedOutputs(session, nullptr, inputs,
+                                         input_values, 2, outputs,
+                                         output_values, 2, nullptr, 0,
+                                         nullptr, s);
+    ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+    ASSERT_TRUE(output_values[1] != nullptr);
+    EXPECT_NE(int_out, output_values[1]);
+    EXPECT_EQ(3, *static_cast<int32*>(TF_TensorData(output_values[1])));
+    TF_DeleteTensor(output_values[1]);
+    TF_DeleteTensor(input_values[0]);
+    TF_DeleteTensor(input_values[1]);
+  }
+
+  // A preallocated output too small for the result is an error.
+  {
+    const std::vector<string> long_strings = {"a", "b", string(100, 'c')};
+    TF_Tensor* input_values[] = {FlatStringTensor(long_strings),
+                                 Int32Tensor(1)};
+    TF_Tensor* output_values[] = {string_out, nullptr};
+    TF_SessionRunWithPreallocatedOutputs(session, nullptr, inputs,
+                                         input_values, 2, outputs,
+                                         output_values, 2, nullptr, 0,
+                                         nullptr, s);
+    EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+    EXPECT_EQ(nullptr, output_values[1]);
+    TF_DeleteTensor(input_values[0]);
+    TF_DeleteTensor(input_values[1]);
+  }
+
+  // So is one of the wrong type.
+  {
+    TF_Tensor* input_values[] = {FlatStringTensor(strings), Int32Tensor(1)};
+    TF_Tensor* output_values[] = {string_out, string_out};
+    TF_SessionRunWithPreallocatedOutputs(session, nullptr, inputs,
+                                         input_values, 2, outputs,
+                                         output_values, 2, nullptr, 0,
+                                         nullptr, s);
+    EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+    TF_DeleteTensor(input_values[0]);
+    TF_DeleteTensor(input_values[1]);
+  }
+
+  TF_DeleteTensor(string_out);
+  TF_DeleteTensor(int_out);
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
+TEST(CAPI, SessionRunWithPreallocatedResourceOutput) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph, "VarHandleOp", "var");
+  TF_SetAttrType(desc, "dtype", TF_FLOAT);
+  TF_SetAttrShape(desc, "shape", nullptr, 0);
+  TF_Operation* var = TF_FinishOperation(desc, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  // Resource handles are not plain data, and cannot be copied into a
+  // preallocated tensor.
+  TF_Output outputs[] = {{var, 0}};
+  TF_Tensor* handle = TF_AllocateTensor(TF_RESOURCE, nullptr, 0, 1024);
+  TF_Tensor* output_values[] = {handle};
+  TF_SessionRunWithPreallocatedOutputs(session, nullptr, nullptr, nullptr, 0,
+                                       outputs, output_values, 1, nullptr, 0,
+                                       nullptr, s);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteTensor(handle);
+
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
+// Benchmarks fetching a TF_STRING or TF_FLOAT output of "num_elements"
+// elements, fed through an Identity, with TF_SessionRun or into a tensor
+// preallocated once.
+void SessionRunOutputBenchmarkHelper(int iters, TF_DataType dtype,
+                                     int num_elements, bool preallocated) {
+  tensorflow::testing::StopTiming();
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph, "Placeholder", "feed");
+  TF_SetAttrType(desc, "dtype", dtype);
+  TF_Operation* feed = TF_FinishOperation(desc, s);
+  CHECK_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  desc = TF_NewOperation(graph, "Identity", "fetch");
+  TF_AddInput(desc, {feed, 0});
+  TF_Operation* fetch = TF_FinishOperation(desc, s);
+  CHECK_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  CHECK_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Tensor* input;
+  TF_Tensor* output = nullptr;
+  const int64_t dims[] = {num_elements};
+  if (dtype == TF_STRING) {
+    input = FlatStringTensor(std::vector<string>(num_elements, "0123456789"));
+    if (preallocated) {
+      output = TF_AllocateFlatStringTensor(
+          dims, 1,
+          TF_FlatStringTensorByteSize(num_elements, 10 * num_elements));
+    }
+  } else {
+    input = TF_AllocateTensor(dtype, dims, 1, num_elements * sizeof(float));
+    memset(TF_TensorData(input), 0, TF_TensorByteSize(input));
+    if (preallocated) {
+      output = TF_AllocateTensor(dtype, dims, 1, num_elements * sizeof(float));
+    }
+  }
+  TF_Output inputs[] = {{feed, 0}};
+  TF_Output outputs[] = {{fetch, 0}};
+  tensorflow::testing::ItemsProcessed(static_cast<int64_t>(iters) *
+                                      num_elements);
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_Tensor* output_values[] = {output};
+    if (preallocated) {
+      TF_SessionRunWithPreallocatedOutputs(session, nullptr, inputs, &input, 1,
+                                           outputs, output_values, 1, nullptr,
+                                           0, nullptr, s);
+    } else {
+      TF_SessionRun(session, nullptr, inputs, &input, 1, outputs,
+                    output_values, 1, nullptr, 0, nullptr, s);
+      TF_DeleteTensor(output_values[0]);
+    }
+    CHECK_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  }
+  tensorflow::testing::StopTiming();
+
+  if (output != nullptr) TF_DeleteTensor(output);
+  TF_DeleteTensor(input);
+  TF_CloseSession(session, s);
+  TF_DeleteSession(session, s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
+void BM_SessionRunStringOutput(int iters, int num_elements) {
+  SessionRunOutputBenchmarkHelper(iters, TF_STRING, num_elements, false);
+}
+
+void BM_SessionRunPreallocatedStringOutput(int iters, int num_elements) {
+  SessionRunOutputBenchmarkHelper(iters, TF_STRING, num_elements, true);
+}
+
+void BM_SessionRunFloatOutput(int iters, int num_elements) {
+  SessionRunOutputBenchmarkHelper(iters, TF_FLOAT, num_elements, false);
+}
+
+void BM_SessionRunPreallocatedFloatOutput(int iters, int num_elements) {
+  SessionRunOutputBenchmarkHelper(iters, TF_FLOAT, num_elements, true);
+}
+
+BENCHMARK(BM_SessionRunStringOutput)->Arg(1 << 4)->Arg(1 << 12);
+BENCHMARK(BM_SessionRunPreallocatedStringOutput)->Arg(1 << 4)->Arg(1 << 12);
+BENCHMARK(BM_SessionRunFloatOutput)->Arg(1 << 4)->Arg(1 << 20);
+BENCHMARK(BM_SessionRunPreallocatedFloatOutput)->Arg(1 << 4)->Arg(1 << 20);
+
 TEST(CAPI, SessionPRun) {
   TF_Status* s = TF_NewStatus();
   TF_Graph* graph = TF_NewGraph();
@@ -271,6 +271,118 @@ class BatchDatasetTest(test.TestCase):
                                    "larger than the row shape"):
         sess.run(get_next)
 
+  def testMapAndBatchDataset(self):
+    """Test a dataset that maps a TF function across its input elements."""
+    # The pipeline is TensorSliceDataset -> RepeatDataset(count) ->
+    # MapAndBatchDataset(square_3, batch_size).
+    components = [np.arange(7),
+                  np.array([[1, 2, 3]]) * np.arange(7)[:, np.newaxis],
+                  np.array(37.0) * np.arange(7)]
+
+    count = array_ops.placeholder(dtypes.int64, shape=[])
+    batch_size = array_ops.placeholder(dtypes.int64, shape=[])
+    num_parallel_batches = array_ops.placeholder(dtypes.int64, shape=[])
+
+    def _map_fn(x, y, z):
+      return math_ops.square(x), math_ops.square(y), math_ops.square(z)
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .repeat(count)
+                .map_and_batch(_map_fn, batch_size, num_parallel_batches)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([[None] + list(c.shape[1:]) for c in components],
+                     [t.shape.as_list() for t in get_next])
+
+    with self.test_session() as sess:
+      for parallel_batches in [1, 3]:
+        # Batch of a finite input, where the batch_size divides the
+        # total number of elements.
+        sess.run(init_op, feed_dict={count: 28, batch_size: 14,
+                                     num_parallel_batches: parallel_batches})
+        num_batches = (28 * 7) // 14
+        for i in range(num_batches):
+          result = sess.run(get_next)
+          for component, result_component in zip(components, result):
+            for j in range(14):
+              self.assertAllEqual(component[(i*14 + j) % 7]**2,
+                                  result_component[j])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+        # Batch of a finite input, where the batch_size does not
+        # divide the total number of elements.
+        sess.run(init_op, feed_dict={count: 14, batch_size: 8,
+                                     num_parallel_batches: parallel_batches})
+
+        # We expect (num_batches - 1) full-sized batches.
+        num_batches = int(math.ceil((14 * 7) / 8))
+        for i in range(num_batches - 1):
+          result = sess.run(get_next)
+          for component, result_component in zip(components, result):
+            for j in range(8):
+              self.assertAllEqual(component[(i*8 + j) % 7]**2,
+                                  result_component[j])
+        result = sess.run(get_next)
+        for component, result_component in zip(components, result):
+          self.assertEqual((14 * 7) % 8, len(result_component))
+          for j in range((14 * 7) % 8):
+            self.assertAllEqual(component[((num_batches - 1)*8 + j) % 7]**2,
+                                result_component[j])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+        # The end of the sequence is sticky.
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+        # Batch of an empty input should fail straight away.
+        sess.run(init_op, feed_dict={count: 0, batch_size: 8,
+                                     num_parallel_batches: parallel_batches})
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+      # Empty batch should be an initialization time error.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(init_op, feed_dict={count: 14, batch_size: 0,
+                                     num_parallel_batches: 1})
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(init_op, feed_dict={count: 14, batch_size: 8,
+                                     num_parallel_batches: 0})
+
+  def testMapAndBatchDatasetPropagatesErrors(self):
+    components = np.array([1., 2., 0., 4.], dtype=np.float32)
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map_and_batch(
+                    lambda x: array_ops.check_numerics(1. / x, "error"), 2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertAllClose([1., 0.5], sess.run(get_next))
+      # The error fails the whole batch, and does not end the sequence.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testMapAndBatchDatasetShapeMismatch(self):
+    iterator = (dataset_ops.Dataset.range(4)
+                .map_and_batch(lambda x: array_ops.fill([x], x), 2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "Cannot batch tensors with different "
+                                   "shapes"):
+        sess.run(get_next)
+
 
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,189 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import time
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import script_ops
+from tensorflow.python.platform import test
+
+
+class CacheDatasetTest(test.TestCase):
+
+  def setUp(self):
+    self._num_evaluations = 0
+
+  def _buildDataset(self, filename, count=5):
+    """Returns a dataset of `range(count)` that counts its evaluations."""
+
+    def _evaluate(x):
+      self._num_evaluations += 1
+      return x
+
+    dataset = dataset_ops.Dataset.range(count).map(
+        lambda x: script_ops.py_func(_evaluate, [x], dtypes.int64))
+    return dataset.cache(filename)
+
+  def _testCacheDataset(self, filename):
+    iterator = (self._buildDataset(filename).repeat(3)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      for _ in range(3):
+        for i in range(5):
+          self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+    # Only the first epoch evaluates the input.
+    self.assertEqual(5, self._num_evaluations)
+
+  def testMemoryCache(self):
+    self._testCacheDataset("")
+
+  def testFileCache(self):
+    filename = os.path.join(self.get_temp_dir(), "cache")
+    self._testCacheDataset(filename)
+
+    # Another pipeline reads the complete cache file.
+    with ops.Graph().as_default():
+      iterator = self._buildDataset(filename).make_initializable_iterator()
+      get_next = iterator.get_next()
+      with self.test_session() as sess:
+        sess.run(iterator.initializer)
+        for i in range(5):
+          self.assertEqual(i, sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+    self.assertEqual(5, self._num_evaluations)
+
+  def testPartialFileCacheIsDiscarded(self):
+    filename = os.path.join(self.get_temp_dir(), "partial_cache")
+    iterator = self._buildDataset(filename).make_initializable_iterator()
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertEqual(0, sess.run(get_next))
+      self.assertEqual(1, sess.run(get_next))
+      # Reinitializing destroys the writing iterator before the end, which
+      # must leave neither a cache file nor a lockfile behind. The new
+      # iterator was created while the cache file was being written, so it
+      # passes the input through.
+      sess.run(init_op)
+      self.assertFalse([f for f in os.listdir(self.get_temp_dir())
+                        if f.startswith("partial_cache")])
+      for i in range(5):
+        self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+      self.assertFalse(os.path.exists(filename))
+
+      # The next iterator writes the cache file.
+      sess.run(init_op)
+      for i in range(5):
+        self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+      self.assertTrue(os.path.exists(filename))
+      self.assertFalse(os.path.exists(filename + ".lockfile"))
+    self.assertEqual(12, self._num_evaluations)
+
+  def _testLockfile(self, filename, refresh_time):
+    # Another process holds the lockfile, and last refreshed it at
+    # `refresh_time`.
+    os.mkdir(filename + ".lockfile")
+    with open(os.path.join(filename + ".lockfile", "owner"), "w") as f:
+      f.write(str(int(refresh_time * 1e6)))
+    iterator = self._buildDataset(filename).make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for i in range(5):
+        self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testHeldLockfile(self):
+    filename = os.path.join(self.get_temp_dir(), "held_lockfile")
+    self._testLockfile(filename, time.time())
+    # The iterator passes the input through, and leaves the lockfile alone.
+    self.assertFalse(os.path.exists(filename))
+    self.assertTrue(os.path.exists(filename + ".lockfile"))
+
+  def testExpiredLockfile(self):
+    filename = os.path.join(self.get_temp_dir(), "expired_lockfile")
+    self._testLockfile(filename, time.time() - 3600)
+    # The iterator breaks the lockfile of the writer that died, and writes
+    # the cache file.
+    self.assertTrue(os.path.exists(filename))
+    self.assertFalse(os.path.exists(filename + ".lockfile"))
+
+  def testConcurrentIterators(self):
+    for filename in ["", os.path.join(self.get_temp_dir(), "concurrent")]:
+      dataset = self._buildDataset(filename)
+      iterator_1 = dataset.make_initializable_iterator()
+      iterator_2 = dataset.make_initializable_iterator()
+      get_next_1 = iterator_1.get_next()
+      get_next_2 = iterator_2.get_next()
+
+      with self.test_session() as sess:
+        # The second iterator reads the input while the first one writes
+        # the cache, and both see every element.
+        sess.run([iterator_1.initializer, iterator_2.initializer])
+        for i in range(5):
+          self.assertEqual([i, i], sess.run([get_next_1, get_next_2]))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next_1)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next_2)
+
+  def testErrorsAreNotCached(self):
+    components = np.array([1., 0., 2.], dtype=np.float32)
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map(lambda x: array_ops.check_numerics(1. / x, "error"))
+                .cache().repeat(2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      # The error reoccurs in the second epoch, which reads the input again.
+      for _ in range(2):
+        self.assertAllClose(1., sess.run(get_next))
+        with self.assertRaises(errors.InvalidArgumentError):
+          sess.run(get_next)
+        self.assertAllClose(0.5, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+
+if __name__ == "__main__":
+  test.main()
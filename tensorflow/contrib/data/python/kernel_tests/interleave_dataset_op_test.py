@@ -0,0 +1,194 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import itertools
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+
+def _interleave(lists, cycle_length, block_length):
+  """Reference implementation of interleave used for testing.
+
+  Args:
+    lists: a list of lists to interleave
+    cycle_length: the length of the interleave cycle
+    block_length: the length of the interleave block
+
+  Yields:
+    Elements of `lists` interleaved in the order determined by `cycle_length`
+    and `block_length`.
+  """
+  num_open = 0
+
+  # `all_iterators` acts as a queue of iterators over each element of `lists`.
+  all_iterators = [iter(l) for l in lists]
+
+  # `open_iterators` are the iterators whose elements are currently being
+  # interleaved.
+  open_iterators = []
+  for i in range(cycle_length):
+    if all_iterators:
+      open_iterators.append(all_iterators.pop(0))
+      num_open += 1
+    else:
+      open_iterators.append(None)
+
+  while num_open or all_iterators:
+    for i in range(cycle_length):
+      if open_iterators[i] is None:
+        if all_iterators:
+          open_iterators[i] = all_iterators.pop(0)
+          num_open += 1
+        else:
+          continue
+      for _ in range(block_length):
+        try:
+          yield next(open_iterators[i])
+        except StopIteration:
+          open_iterators[i] = None
+          num_open -= 1
+          break
+
+
+class InterleaveDatasetTest(test.TestCase):
+
+  def _buildDataset(self, input_values, cycle_length, block_length,
+                    parallel=False, sloppy=False):
+    """Interleaves `x` repeated `x` times, for each `x` in `input_values`."""
+    dataset = dataset_ops.Dataset.from_tensor_slices(input_values)
+    map_func = lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x)
+    if parallel:
+      return dataset.parallel_interleave(
+          map_func, cycle_length, block_length, sloppy=sloppy,
+          buffer_output_elements=2)
+    return dataset.interleave(map_func, cycle_length, block_length)
+
+  def _testInterleave(self, parallel=False, sloppy=False):
+    input_values = array_ops.placeholder(dtypes.int64, shape=[None])
+    cycle_length = array_ops.placeholder(dtypes.int64, shape=[])
+    block_length = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = self._buildDataset(
+        input_values, cycle_length, block_length, parallel=parallel,
+        sloppy=sloppy).make_initializable_iterator()
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      # Includes an empty input element, and fewer input elements than
+      # `cycle_length`.
+      for values, cycle, block in itertools.product(
+          [[4, 5, 6], [4, 0, 6, 1, 3], [1, 2, 3, 4, 5, 6, 7]], [1, 2, 3, 8],
+          [1, 2, 5]):
+        sess.run(init_op, feed_dict={input_values: values,
+                                     cycle_length: cycle,
+                                     block_length: block})
+        lists = [[x] * x for x in values]
+        expected = list(_interleave(lists, cycle, block))
+        actual = [sess.run(get_next) for _ in range(len(expected))]
+        if sloppy:
+          self.assertEqual(sorted(expected), sorted(actual))
+        else:
+          self.assertEqual(expected, actual)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testInterleaveDataset(self):
+    self._testInterleave()
+
+  def testParallelInterleaveDataset(self):
+    self._testInterleave(parallel=True)
+
+  def testSloppyParallelInterleaveDataset(self):
+    self._testInterleave(parallel=True, sloppy=True)
+
+  def testCycleLengthOneIsFlatMap(self):
+    iterator = (self._buildDataset(np.array([3, 1, 2]), 1, 1)
+                .make_one_shot_iterator())
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for expected in [3, 3, 3, 1, 2, 2]:
+        self.assertEqual(expected, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testInvalidArguments(self):
+    cycle_length = array_ops.placeholder(dtypes.int64, shape=[])
+    block_length = array_ops.placeholder(dtypes.int64, shape=[])
+    for parallel in [False, True]:
+      iterator = self._buildDataset(
+          np.array([1, 2]), cycle_length, block_length,
+          parallel=parallel).make_initializable_iterator()
+      with self.test_session() as sess:
+        with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                     "cycle_length"):
+          sess.run(iterator.initializer,
+                   feed_dict={cycle_length: 0, block_length: 1})
+        with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                     "block_length"):
+          sess.run(iterator.initializer,
+                   feed_dict={cycle_length: 1, block_length: 0})
+
+  def testParallelInterleavePropagatesErrors(self):
+    components = np.array([1., 0., 2.], dtype=np.float32)
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .parallel_interleave(
+                    lambda x: dataset_ops.Dataset.from_tensors(x).map(
+                        lambda y: array_ops.check_numerics(1. / y, "error")),
+                    cycle_length=2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertAllClose(1., sess.run(get_next))
+      # The error is returned in order, and does not end the sequence.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      self.assertAllClose(0.5, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testReinitializeWhileReading(self):
+    # Infinite datasets keep the worker threads blocked on full buffers,
+    # which reinitializing the iterator and closing the session must cancel.
+    iterator = (dataset_ops.Dataset.range(4)
+                .parallel_interleave(
+                    lambda x: dataset_ops.Dataset.from_tensors(x).repeat(),
+                    cycle_length=4)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for _ in range(3):
+        sess.run(init_op)
+        for i in range(10):
+          self.assertEqual(i % 4, sess.run(get_next))
+
+
+if __name__ == "__main__":
+  test.main()
@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import dataset_ops
@@ -25,10 +27,13 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
+from tensorflow.python.lib.io import tf_record
 from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
+from tensorflow.python.training import saver as saver_lib
 from tensorflow.python.training import server_lib
+from tensorflow.python.util import compat
 
 
 class IteratorTest(test.TestCase):
@@ -262,5 +267,169 @@ class IteratorTest(test.TestCase):
                   [4., 5., 6., 7.], dtype=dtypes.float64))))
 
 
+class IteratorCheckpointTest(test.TestCase):
+
+  def _saveAndRestore(self, make_dataset, num_before_save):
+    """Checks that a restored iterator continues where the saved one was.
+
+    Args:
+      make_dataset: A function that builds the dataset in the current graph.
+      num_before_save: The number of elements to get before saving.
+    """
+    checkpoint_prefix = os.path.join(self.get_temp_dir(), "iterator")
+
+    with ops.Graph().as_default():
+      iterator = make_dataset().make_initializable_iterator()
+      get_next = iterator.get_next()
+      saver = saver_lib.Saver([iterator.make_saveable("iterator")])
+      with self.test_session() as sess:
+        sess.run(iterator.initializer)
+        for _ in range(num_before_save):
+          sess.run(get_next)
+        saver.save(sess, checkpoint_prefix)
+        expected = []
+        while True:
+          try:
+            expected.append(sess.run(get_next))
+          except errors.OutOfRangeError:
+            break
+
+    with ops.Graph().as_default():
+      iterator = make_dataset().make_initializable_iterator()
+      get_next = iterator.get_next()
+      saver = saver_lib.Saver([iterator.make_saveable("iterator")])
+      with self.test_session() as sess:
+        sess.run(iterator.initializer)
+        saver.restore(sess, checkpoint_prefix)
+        for element in expected:
+          self.assertAllEqual(element, sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testRangeAndTensorSlices(self):
+    def make_dataset():
+      return dataset_ops.Dataset.zip(
+          (dataset_ops.Dataset.range(10),
+           dataset_ops.Dataset.from_tensor_slices(np.arange(20)))).skip(2)
+
+    for num_before_save in [0, 3, 8]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testRepeatTakeAndBatch(self):
+    def make_dataset():
+      return (dataset_ops.Dataset.range(7).repeat(3).take(19).batch(4)
+              .map(lambda x: x * 2))
+
+    for num_before_save in [0, 2, 5]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testShuffle(self):
+    # The unseeded shuffle also continues with the same order, because the
+    # seeds that it chose are saved.
+    for seed in [None, 37]:
+      def make_dataset(seed=seed):
+        return dataset_ops.Dataset.range(50).shuffle(10, seed=seed).repeat(2)
+
+      for num_before_save in [0, 13, 70]:
+        self._saveAndRestore(make_dataset, num_before_save)
+
+  def testSpillingShuffle(self):
+    scratch_directory = self.get_temp_dir()
+
+    def make_dataset():
+      return dataset_ops.Dataset.range(30).shuffle(
+          8, seed=11, scratch_directory=scratch_directory)
+
+    self._saveAndRestore(make_dataset, 12)
+
+  def testFlatMapAndInterleave(self):
+    def make_dataset():
+      return dataset_ops.Dataset.range(1, 6).interleave(
+          lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x),
+          cycle_length=2, block_length=2).flat_map(
+              lambda x: dataset_ops.Dataset.range(x))
+
+    for num_before_save in [0, 7, 20]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testGroupByWindow(self):
+    def make_dataset():
+      return dataset_ops.Dataset.range(20).group_by_window(
+          lambda x: x % 3, lambda _, xs: xs.batch(4), 4)
+
+    for num_before_save in [0, 2, 4]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testParallelStages(self):
+    def make_dataset():
+      return (dataset_ops.Dataset.range(100)
+              .map(lambda x: x * x, num_threads=4, output_buffer_size=8)
+              .parallel_interleave(
+                  lambda x: dataset_ops.Dataset.from_tensors(x).repeat(2),
+                  cycle_length=3, block_length=2)
+              .map_and_batch(lambda x: x + 1, 7, num_parallel_batches=2)
+              .prefetch(3))
+
+    for num_before_save in [0, 5, 28]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testCache(self):
+    filename = os.path.join(self.get_temp_dir(), "cache")
+
+    for cache_filename in ["", filename]:
+      def make_dataset(cache_filename=cache_filename):
+        return dataset_ops.Dataset.range(10).cache(cache_filename).repeat(3)
+
+      for num_before_save in [4, 15]:
+        self._saveAndRestore(make_dataset, num_before_save)
+
+  def testReaders(self):
+    filenames = []
+    for i in range(3):
+      filename = os.path.join(self.get_temp_dir(), "text_%d.txt" % i)
+      with open(filename, "w") as f:
+        for j in range(5):
+          f.write("%d: %d\n" % (i, j))
+      filenames.append(filename)
+
+    for read_ahead_blocks in [0, 2]:
+      def make_dataset(read_ahead_blocks=read_ahead_blocks):
+        return dataset_ops.TextLineDataset(
+            filenames, buffer_size=4, read_ahead_blocks=read_ahead_blocks)
+
+      for num_before_save in [0, 7, 15]:
+        self._saveAndRestore(make_dataset, num_before_save)
+
+  def testTFRecordRange(self):
+    filenames = []
+    options = tf_record.TFRecordOptions(
+        tf_record.TFRecordCompressionType.NONE, index_interval=2)
+    for i in range(2):
+      filename = os.path.join(self.get_temp_dir(), "records_%d" % i)
+      with tf_record.TFRecordWriter(filename, options) as writer:
+        for j in range(7):
+          writer.write(compat.as_bytes("%d: %d" % (i, j)))
+      filenames.append(filename)
+
+    def make_dataset():
+      return dataset_ops.TFRecordDataset(
+          filenames, start=1, count=4, num_shards=2, shard_index=1)
+
+    for num_before_save in [0, 1, 3]:
+      self._saveAndRestore(make_dataset, num_before_save)
+
+  def testRestoreUninitializedIterator(self):
+    iterator = dataset_ops.Dataset.range(10).make_initializable_iterator()
+    saveable = iterator.make_saveable()
+    restore_op = saveable.restore(
+        [constant_op.constant([], dtype=dtypes.string)], None)
+
+    with self.test_session() as sess:
+      with self.assertRaises(errors.FailedPreconditionError):
+        sess.run(saveable.specs[0].tensor)
+      with self.assertRaises(errors.FailedPreconditionError):
+        sess.run(restore_op)
+
+
 if __name__ == "__main__":
   test.main()
@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import threading
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import dataset_ops
@@ -28,6 +30,7 @@ from tensorflow.python.ops import data_flow_ops
 from tensorflow.python.ops import lookup_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import random_ops
+from tensorflow.python.ops import script_ops
 from tensorflow.python.ops import string_ops
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.platform import test
@@ -167,10 +170,51 @@ class MapDatasetTest(test.TestCase):
                                                    results[i * 18 + j]):
               self.assertAllEqual(component[i]**2, result_component)
 
+      # The output buffer may be smaller than the number of threads.
       for num_threads_val, output_buffer_size_val in [
-          (1, 1), (1, 2), (2, 2), (2, 4), (8, 8), (8, 16)]:
+          (1, 1), (1, 2), (2, 2), (2, 4), (8, 8), (8, 16), (8, 2), (4, 1)]:
         do_test(num_threads_val, output_buffer_size_val)
 
+  def testSloppyParallelMapDataset(self):
+    """Test that a slow element does not delay the elements after it."""
+    slow_element_done = threading.Event()
+
+    def _map_py_func(x):
+      if x == 0:
+        # Blocks until all of the other elements have been produced, which
+        # would deadlock if the output were in order.
+        slow_element_done.wait()
+      return x
+
+    iterator = (dataset_ops.Dataset.range(10)
+                .map(lambda x: script_ops.py_func(_map_py_func, [x],
+                                                  dtypes.int64),
+                     num_threads=2, output_buffer_size=4, sloppy=True)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      results = [sess.run(get_next) for _ in range(9)]
+      self.assertEqual(list(range(1, 10)), sorted(results))
+      slow_element_done.set()
+      self.assertEqual(0, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testParallelMapDatasetInvalidBufferSize(self):
+    output_buffer_size = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.range(10)
+                .map(lambda x: x, num_threads=2,
+                     output_buffer_size=output_buffer_size)
+                .make_initializable_iterator())
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "output_buffer_size"):
+        sess.run(iterator.initializer, feed_dict={output_buffer_size: 0})
+
   def _testDisposeParallelMapDataset(self, explicit_dispose):
     # The pipeline is TensorSliceDataset -> MapDataset(square_3) ->
     # RepeatDataset(1000).
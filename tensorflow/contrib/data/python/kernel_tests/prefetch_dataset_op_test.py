@@ -0,0 +1,146 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import time
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.client import session
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import script_ops
+from tensorflow.python.platform import test
+
+
+class PrefetchDatasetTest(test.TestCase):
+
+  def testPrefetchDataset(self):
+    buffer_size = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.range(100)
+                .map(lambda x: (x, math_ops.square(x)))
+                .prefetch(buffer_size)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([[], []], [t.shape.as_list() for t in get_next])
+
+    with self.test_session() as sess:
+      for size in [1, 5, 100, 1000]:
+        sess.run(init_op, feed_dict={buffer_size: size})
+        for i in range(100):
+          self.assertEqual((i, i * i), sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+        # The end of the sequence is sticky.
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testInvalidBufferSize(self):
+    buffer_size = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.range(10).prefetch(buffer_size)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError, "buffer_size"):
+        sess.run(init_op, feed_dict={buffer_size: 0})
+
+  def testPrefetchPropagatesErrors(self):
+    components = np.array([1., 2., 0., 4.], dtype=np.float32)
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map(lambda x: array_ops.check_numerics(1. / x, "error"))
+                .prefetch(2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertAllClose(1., sess.run(get_next))
+      self.assertAllClose(0.5, sess.run(get_next))
+      # The error is returned in order, and does not end the sequence.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      self.assertAllClose(0.25, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testReinitializeWhilePrefetching(self):
+    # An infinite input keeps the prefetch thread blocked on a full buffer,
+    # which reinitializing the iterator and closing the session must cancel.
+    iterator = (dataset_ops.Dataset.range(10).repeat()
+                .prefetch(5)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for _ in range(3):
+        sess.run(init_op)
+        for i in range(15):
+          self.assertEqual(i % 10, sess.run(get_next))
+
+
+class PrefetchDatasetBenchmark(test.Benchmark):
+
+  def _benchmarkSteps(self, prefetch, num_steps=50, step_seconds=0.005):
+    """Times steps that take as long as producing their input element."""
+
+    def _produce(x):
+      time.sleep(step_seconds)
+      return x
+
+    with ops.Graph().as_default():
+      dataset = dataset_ops.Dataset.range(num_steps + 1).map(
+          lambda x: script_ops.py_func(_produce, [x], dtypes.int64))
+      if prefetch:
+        dataset = dataset.prefetch(1)
+      iterator = dataset.make_initializable_iterator()
+      get_next = iterator.get_next()
+
+      with session.Session() as sess:
+        sess.run(iterator.initializer)
+        # The first element pays for starting the pipeline.
+        sess.run(get_next)
+        start = time.time()
+        for _ in range(num_steps):
+          sess.run(get_next)
+          # Stands in for the training step that consumes the element.
+          time.sleep(step_seconds)
+        wall_time = (time.time() - start) / num_steps
+
+    self.report_benchmark(
+        iters=num_steps,
+        wall_time=wall_time,
+        name="benchmark_steps_%s" % ("prefetch" if prefetch else "no_prefetch"))
+
+  def benchmarkStepsWithoutPrefetch(self):
+    self._benchmarkSteps(prefetch=False)
+
+  def benchmarkStepsWithPrefetch(self):
+    self._benchmarkSteps(prefetch=True)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -114,6 +114,30 @@ class TextLineDatasetTest(test.TestCase):
         self.assertAllEqual([self._lineText(1, i) for i in range(5)],
                             sess.run(get_next))
 
+  def testTextLineDatasetReadAhead(self):
+    test_filenames = self._createFiles(2, 100, crlf=True)
+
+    # Buffers smaller than a line, and read ahead more blocks than a file has.
+    for buffer_size, read_ahead_blocks in [(3, 1), (3, 4), (64, 2),
+                                           (1 << 20, 2)]:
+      with ops.Graph().as_default():
+        dataset = dataset_ops.TextLineDataset(
+            test_filenames, buffer_size=buffer_size,
+            read_ahead_blocks=read_ahead_blocks)
+        get_next = dataset.make_one_shot_iterator().get_next()
+
+        with self.test_session() as sess:
+          for j in range(2):
+            for i in range(100):
+              self.assertEqual(self._lineText(j, i), sess.run(get_next))
+          with self.assertRaises(errors.OutOfRangeError):
+            sess.run(get_next)
+
+    with self.assertRaisesRegexp(ValueError, "buffer_size"):
+      dataset_ops.TextLineDataset(test_filenames, buffer_size=0)
+    with self.assertRaisesRegexp(ValueError, "read_ahead_blocks"):
+      dataset_ops.TextLineDataset(test_filenames, read_ahead_blocks=-1)
+
 
 class FixedLengthRecordReaderTest(test.TestCase):
 
@@ -202,6 +226,24 @@ class FixedLengthRecordReaderTest(test.TestCase):
                                for i in range(self._num_records)],
                               sess.run(get_next))
 
+  def testFixedLengthRecordDatasetReadAhead(self):
+    test_filenames = self._createFiles()
+
+    # Buffers smaller than the header, a record, and the whole file.
+    for buffer_size in [1, 4, 1 << 20]:
+      with ops.Graph().as_default():
+        dataset = dataset_ops.FixedLengthRecordDataset(
+            test_filenames, self._record_bytes, self._header_bytes,
+            self._footer_bytes, buffer_size=buffer_size, read_ahead_blocks=2)
+        get_next = dataset.make_one_shot_iterator().get_next()
+
+        with self.test_session() as sess:
+          for j in range(self._num_files):
+            for i in range(self._num_records):
+              self.assertEqual(self._record(j, i), sess.run(get_next))
+          with self.assertRaises(errors.OutOfRangeError):
+            sess.run(get_next)
+
 
 class TFRecordDatasetTest(test.TestCase):
 
@@ -336,6 +378,90 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(self.get_next)
 
+  def _createIndexedFiles(self, compression_type):
+    filenames = []
+    options = python_io.TFRecordOptions(compression_type, index_interval=3)
+    for i in range(self._num_files):
+      fn = os.path.join(self.get_temp_dir(),
+                        "tf_record.indexed.%d.%d" % (compression_type, i))
+      filenames.append(fn)
+      with python_io.TFRecordWriter(fn, options) as writer:
+        for j in range(self._num_records):
+          writer.write(self._record(i, j))
+      self.assertTrue(os.path.exists(fn + ".ridx"))
+    return filenames
+
+  def _readRecords(self, filenames, compression_type="", **kwargs):
+    iterator = dataset_ops.TFRecordDataset(
+        filenames, compression_type, **kwargs).make_one_shot_iterator()
+    get_next = iterator.get_next()
+    records = []
+    with self.test_session() as sess:
+      while True:
+        try:
+          records.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          return records
+
+  def testReadRange(self):
+    for filenames in [self.test_filenames, self._createIndexedFiles(
+        python_io.TFRecordCompressionType.NONE)]:
+      for start, count in [(0, 3), (2, 4), (3, -1), (5, 10), (7, 1),
+                           (20, -1)]:
+        with ops.Graph().as_default():
+          end = self._num_records if count < 0 else start + count
+          expected = [self._record(j, i)
+                      for j in range(self._num_files)
+                      for i in range(start, min(end, self._num_records))]
+          self.assertAllEqual(
+              expected, self._readRecords(filenames, start=start, count=count))
+
+  def testReadShards(self):
+    none = python_io.TFRecordCompressionType.NONE
+    zlib_type = python_io.TFRecordCompressionType.ZLIB
+    for filenames, compression_type in [
+        (self.test_filenames, ""),
+        (self._createIndexedFiles(none), ""),
+        (self._createIndexedFiles(zlib_type), "ZLIB")]:
+      for num_shards in [1, 2, 3, 8]:
+        for start in [0, 2]:
+          records = []
+          for shard_index in range(num_shards):
+            with ops.Graph().as_default():
+              records.extend(self._readRecords(
+                  filenames[0], compression_type, start=start,
+                  num_shards=num_shards, shard_index=shard_index))
+          # The shards of a file are contiguous, and cover its range.
+          self.assertAllEqual(
+              [self._record(0, i) for i in range(start, self._num_records)],
+              records)
+
+  def testInvalidShardIndex(self):
+    with self.assertRaises(errors.InvalidArgumentError):
+      self._readRecords(self.test_filenames, num_shards=2, shard_index=2)
+
+  def testReadShardsWithMismatchedIndex(self):
+    filename = self._createIndexedFiles(
+        python_io.TFRecordCompressionType.NONE)[0]
+    with open(filename + ".ridx", "rb") as f:
+      index = f.read()
+    # A truncated index, and the index of an earlier version of a file, are
+    # ignored, and the records are counted instead.
+    writer = python_io.TFRecordWriter(filename)
+    for i in range(2 * self._num_records):
+      writer.write(self._record(0, i))
+    writer.close()
+    for stale_index in [index[:-1], index]:
+      with open(filename + ".ridx", "wb") as f:
+        f.write(stale_index)
+      records = []
+      for shard_index in range(2):
+        with ops.Graph().as_default():
+          records.extend(self._readRecords(
+              filename, num_shards=2, shard_index=shard_index))
+      self.assertAllEqual(
+          [self._record(0, i) for i in range(2 * self._num_records)], records)
+
 
 class ReadBatchFeaturesTest(test.TestCase):
 
@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 
 import collections
+import os
 
 import numpy as np
 
@@ -147,6 +148,99 @@ class ShuffleDatasetTest(test.TestCase):
     for i in range(5):
       self.assertEqual(10, counts[i])
 
+  def testSpillingShuffleDataset(self):
+    scratch_directory = self.get_temp_dir()
+    components = [
+        np.arange(50), np.array([[1, 2, 3]]) * np.arange(50)[:, np.newaxis],
+        np.array(["element_%d" % i for i in range(50)])
+    ]
+    buffer_size_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+
+    dataset = dataset_ops.Dataset.from_tensor_slices(components).repeat(2)
+    iterator = dataset_ops.Iterator.from_structure(dataset.output_types,
+                                                   dataset.output_shapes)
+    init_memory_op = iterator.make_initializer(
+        dataset.shuffle(buffer_size_placeholder, seed=37))
+    init_spilling_op = iterator.make_initializer(
+        dataset.shuffle(buffer_size_placeholder, seed=37,
+                        scratch_directory=scratch_directory))
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      for buffer_size in [1, 7, 100, 1000]:
+        feed_dict = {buffer_size_placeholder: buffer_size}
+        sess.run(init_memory_op, feed_dict=feed_dict)
+        expected = [sess.run(get_next) for _ in range(100)]
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+        # Spilling the buffered elements to disk samples the same sequence
+        # as buffering them in memory.
+        sess.run(init_spilling_op, feed_dict=feed_dict)
+        for expected_element in expected:
+          for expected_component, component in zip(expected_element,
+                                                   sess.run(get_next)):
+            self.assertAllEqual(expected_component, component)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+        # The scratch files are deleted as their elements are produced.
+        self.assertEqual([], [f for f in os.listdir(scratch_directory)
+                              if f.startswith("shuffle_")])
+
+  def testSpillingShuffleDatasetDeletesScratchFiles(self):
+    scratch_directory = self.get_temp_dir()
+    iterator = (dataset_ops.Dataset.range(100)
+                .shuffle(50, scratch_directory=scratch_directory)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    def _scratch_files():
+      return [f for f in os.listdir(scratch_directory)
+              if f.startswith("shuffle_")]
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      sess.run(get_next)
+      self.assertTrue(_scratch_files())
+      # Destroying the iterator deletes its scratch files.
+      sess.run(init_op)
+      self.assertEqual([], _scratch_files())
+      sess.run(get_next)
+      self.assertTrue(_scratch_files())
+    # So does closing the session.
+    self.assertEqual([], _scratch_files())
+
+  def testSpillingShuffleDatasetBoundsScratchSpace(self):
+    scratch_directory = self.get_temp_dir()
+    buffer_size = 20
+    iterator = (dataset_ops.Dataset.range(1000)
+                .map(lambda x: array_ops.fill([256], x))
+                .shuffle(buffer_size, seed=37,
+                         scratch_directory=scratch_directory)
+                .make_one_shot_iterator())
+    get_next = iterator.get_next()
+
+    def _scratch_bytes():
+      return sum(os.path.getsize(os.path.join(scratch_directory, f))
+                 for f in os.listdir(scratch_directory)
+                 if f.startswith("shuffle_"))
+
+    with self.test_session() as sess:
+      peak_scratch_bytes = 0
+      for _ in range(1000):
+        sess.run(get_next)
+        peak_scratch_bytes = max(peak_scratch_bytes, _scratch_bytes())
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+    # Each element takes a little over 256 * 8 bytes. Elements that stay in
+    # the buffer for long would keep about ln(buffer_size) + 1 segments of
+    # `buffer_size` elements alive, but the live elements are compacted once
+    # the scratch files grow to twice their size.
+    element_bytes = 256 * 8 + 64
+    self.assertLessEqual(peak_scratch_bytes,
+                         3 * buffer_size * element_bytes)
+
 
 if __name__ == "__main__":
   test.main()
@@ -38,6 +38,7 @@ from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops import random_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.platform import gfile
+from tensorflow.python.training import saver
 from tensorflow.python.util import nest
 
 
@@ -260,6 +261,38 @@ class Iterator(object):
     """
     return gen_dataset_ops.iterator_dispose(self._iterator_resource, name=name)
 
+  def make_saveable(self, name=None):
+    """Returns a `SaveableObject` for saving and restoring this iterator.
+
+    The saved state is the position of the iterator in its input pipeline,
+    such as the offsets in the files being read, the elements buffered by
+    shuffling and prefetching, and the state of the random number generators,
+    so that after a restart the iterator resumes where it stopped, without
+    replaying the elements that it has already produced. For example, to
+    save the iterator with the variables in a checkpoint:
+
+    ```python
+    iterator = dataset.make_initializable_iterator()
+    tf.add_to_collection(tf.GraphKeys.SAVEABLE_OBJECTS,
+                         iterator.make_saveable())
+    saver = tf.train.Saver()
+    ```
+
+    Restoring the iterator replaces its state, so its initializer must run
+    before the checkpoint is restored, with the same dataset as when the
+    checkpoint was saved.
+
+    Args:
+      name: (Optional.) The name under which the iterator is saved. Defaults
+        to the name of the iterator resource.
+
+    Returns:
+      A `tf.train.Saver` compatible `SaveableObject`.
+    """
+    if name is None:
+      name = self._iterator_resource.op.name
+    return _IteratorSaveable(self._iterator_resource, name)
+
   @property
   def output_shapes(self):
     """Returns the shape of each component of an element of this iterator.
@@ -357,6 +390,19 @@ def _estimate_data_distribution(c, num_examples_per_class_seen):
   return math_ops.cast(init_prob_estimate, dtypes.float32)
 
 
+class _IteratorSaveable(saver.BaseSaverBuilder.SaveableObject):
+  """A `SaveableObject` that saves the state of an iterator."""
+
+  def __init__(self, iterator_resource, name):
+    serialized = gen_dataset_ops.serialize_iterator(iterator_resource)
+    specs = [saver.BaseSaverBuilder.SaveSpec(serialized, "", name)]
+    super(_IteratorSaveable, self).__init__(iterator_resource, specs, name)
+
+  def restore(self, restored_tensors, restored_shapes):
+    with ops.colocate_with(self.op):
+      return gen_dataset_ops.deserialize_iterator(self.op, restored_tensors[0])
+
+
 class Dataset(object):
   """Represents a potentially large set of elements.
 
@@ -641,9 +687,21 @@ class Dataset(object):
     max_value = np.iinfo(dtypes.int64.as_numpy_dtype).max
     return Dataset.zip((Dataset.range(start, max_value), self))
 
-  def shuffle(self, buffer_size, seed=None):
+  def shuffle(self, buffer_size, seed=None, scratch_directory=None):
     """Randomly shuffles the elements of this dataset.
 
+    The buffered elements are kept in memory, unless `scratch_directory` is
+    specified. For a dataset of many large elements, you can also shuffle the
+    files that contain them, which only buffers the filenames, before reading
+    them with a smaller element buffer:
+
+    ```python
+    dataset = (Dataset.from_tensor_slices(filenames)
+               .shuffle(len(filenames))
+               .interleave(TFRecordDataset, cycle_length=4)
+               .shuffle(1000))
+    ```
+
     Args:
       buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
         number of elements from this dataset from which the new
@@ -651,11 +709,15 @@ class Dataset(object):
       seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
         random seed that will be used to create the distribution. See
         @{tf.set_random_seed} for behavior.
+      scratch_directory: (Optional.) A `tf.string` scalar `tf.Tensor`,
+        representing a local directory. If specified, the buffered elements
+        are written to scratch files in this directory, and only their
+        locations are kept in memory.
 
     Returns:
       A `Dataset`.
     """
-    return ShuffleDataset(self, buffer_size, seed)
+    return ShuffleDataset(self, buffer_size, seed, scratch_directory)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -793,7 +855,8 @@ class Dataset(object):
     """
     return GroupByWindowDataset(self, key_func, reduce_func, window_size)
 
-  def map(self, map_func, num_threads=None, output_buffer_size=None):
+  def map(self, map_func, num_threads=None, output_buffer_size=None,
+          sloppy=False):
     """Maps `map_func` across this datset.
 
     Args:
@@ -801,17 +864,43 @@ class Dataset(object):
         shapes and types defined by `self.output_shapes` and
        `self.output_types`) to another nested structure of tensors.
       num_threads: (Optional.) A `tf.int32` scalar `tf.Tensor`, representing
-        the number of threads to use for processing elements in parallel. If
-        not specified, elements will be processed sequentially without
-        buffering.
+        the number of elements to process in parallel. If not specified,
+        elements will be processed sequentially without buffering.
       output_buffer_size: (Optional.) A `tf.int64` scalar `tf.Tensor`,
         representing the maximum number of processed elements that will be
-        buffered when processing in parallel.
+        buffered when processing in parallel. It may be smaller than
+        `num_threads`. If not specified, it defaults to `num_threads`.
+      sloppy: (Optional.) If `True` and `num_threads` is specified, elements
+        are produced as soon as they are processed, rather than in the order
+        of this dataset, so that a slow element does not delay the elements
+        after it.
 
     Returns:
       A `Dataset`.
     """
-    return MapDataset(self, map_func, num_threads, output_buffer_size)
+    return MapDataset(self, map_func, num_threads, output_buffer_size, sloppy)
+
+  def map_and_batch(self, map_func, batch_size, num_parallel_batches=1):
+    """Maps `map_func` across this dataset, and combines the results in batches.
+
+    This is equivalent to `Dataset.map(map_func).batch(batch_size)`, but each
+    application of `map_func` writes its result directly into the batch,
+    instead of being buffered as an element and copied into the batch later.
+    `map_func` is applied to the elements of each batch in parallel.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having
+        shapes and types defined by `self.output_shapes` and
+       `self.output_types`) to another nested structure of tensors.
+      batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+        consecutive elements of this dataset to combine in a single batch.
+      num_parallel_batches: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+        representing the number of batches to compute in parallel.
+
+    Returns:
+      A `Dataset`.
+    """
+    return MapAndBatchDataset(self, map_func, batch_size, num_parallel_batches)
 
   def flat_map(self, map_func):
     """Maps `map_func` across this dataset and flattens the result.
@@ -826,6 +915,75 @@ class Dataset(object):
     """
     return FlatMapDataset(self, map_func)
 
+  def interleave(self, map_func, cycle_length, block_length=1):
+    """Maps `map_func` across this dataset, and interleaves the results.
+
+    For example, you can use `Dataset.interleave()` to process many input files
+    concurrently:
+
+    ```python
+    # Preprocess 4 files concurrently, and interleave blocks of 16 records from
+    # each file.
+    filenames = ["/var/data/file1.txt", "/var/data/file2.txt", ...]
+    dataset = (Dataset.from_tensor_slices(filenames)
+               .interleave(lambda x: TextLineDataset(x).map(parse_fn, ...),
+                           cycle_length=4, block_length=16))
+    ```
+
+    The `cycle_length` and `block_length` arguments control the order in which
+    elements are produced. `cycle_length` controls the number of input elements
+    that are processed concurrently. If you set `cycle_length` to 1, this
+    transformation will handle one input element at a time, and will produce
+    identical results to `Dataset.flat_map()`. In general, this transformation
+    will apply `map_func` to `cycle_length` input elements, open iterators on
+    the returned `Dataset` objects, and cycle through them producing
+    `block_length` consecutive elements from each iterator, and consuming the
+    next input element each time it reaches the end of an iterator.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having shapes
+        and types defined by `self.output_shapes` and `self.output_types`) to a
+        `Dataset`.
+      cycle_length: The number of elements from this dataset that will be
+        processed concurrently.
+      block_length: The number of consecutive elements to produce from each
+        input element before cycling to another input element.
+
+    Returns:
+      A `Dataset`.
+    """
+    return InterleaveDataset(self, map_func, cycle_length, block_length)
+
+  def parallel_interleave(self, map_func, cycle_length, block_length=1,
+                          sloppy=False, buffer_output_elements=1):
+    """Maps `map_func` across this dataset, and interleaves the results.
+
+    Unlike `Dataset.interleave()`, the `Dataset` objects returned by `map_func`
+    for the `cycle_length` input elements are read concurrently, each by its
+    own background thread. This is useful when `map_func` reads from a
+    high-latency source, such as files on networked storage.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having shapes
+        and types defined by `self.output_shapes` and `self.output_types`) to a
+        `Dataset`.
+      cycle_length: The number of elements from this dataset that will be
+        processed concurrently.
+      block_length: The number of consecutive elements to produce from each
+        input element before cycling to another input element.
+      sloppy: If false, elements are produced in the same deterministic order
+        as by `Dataset.interleave()`. If true, the transformation may produce
+        an element from another input element when the next one in order is
+        not ready yet, which trades determinism for throughput.
+      buffer_output_elements: The number of elements that each background
+        thread buffers ahead of their consumption.
+
+    Returns:
+      A `Dataset`.
+    """
+    return ParallelInterleaveDataset(self, map_func, cycle_length, block_length,
+                                     sloppy, buffer_output_elements)
+
   def unbatch(self):
     """Splits elements of this dataset into sequences of consecutive elements.
 
@@ -852,6 +1010,41 @@ class Dataset(object):
     """
     return FilterDataset(self, predicate)
 
+  def prefetch(self, buffer_size):
+    """Creates a `Dataset` that prefetches elements from this dataset.
+
+    Iterating over the new dataset gets elements from this dataset in a
+    background thread, ahead of their consumption, so that producing them
+    overlaps with the steps that consume them.
+
+    Args:
+      buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
+        maximum number of elements that will be buffered when prefetching.
+
+    Returns:
+      A `Dataset`.
+    """
+    return PrefetchDataset(self, buffer_size)
+
+  def cache(self, filename=""):
+    """Caches the elements in this dataset.
+
+    The first iterator over the new dataset that reaches its end records the
+    elements of this dataset, and the iterators created afterwards (for
+    example, by `Dataset.repeat()` for later epochs) replay them instead of
+    evaluating this dataset again.
+
+    Args:
+      filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
+        file on the filesystem in which to cache the elements. A complete
+        cache file is reused by later runs of the program. If a filename is
+        not provided, the elements are cached in memory.
+
+    Returns:
+      A `Dataset`.
+    """
+    return CacheDataset(self, filename)
+
 
 class TensorDataset(Dataset):
   """A `Dataset` with a single element, viz. a nested structure of tensors."""
@@ -1055,7 +1248,8 @@ class RangeDataset(Dataset):
 class ShuffleDataset(Dataset):
   """A `Dataset` that randomly shuffles the elements of its input."""
 
-  def __init__(self, input_dataset, buffer_size, seed=None):
+  def __init__(self, input_dataset, buffer_size, seed=None,
+               scratch_directory=None):
     """See `Dataset.shuffle()` for details."""
     super(ShuffleDataset, self).__init__()
     self._input_dataset = input_dataset
@@ -1071,15 +1265,30 @@ class ShuffleDataset(Dataset):
     else:
       self._seed2 = ops.convert_to_tensor(seed2, dtype=dtypes.int64,
                                           name="seed2")
+    if scratch_directory is None:
+      self._scratch_directory = None
+    else:
+      self._scratch_directory = ops.convert_to_tensor(
+          scratch_directory, dtype=dtypes.string, name="scratch_directory")
 
   def make_dataset_resource(self):
-    return gen_dataset_ops.shuffle_dataset(
-        self._input_dataset.make_dataset_resource(),
-        buffer_size=self._buffer_size,
-        seed=self._seed,
-        seed2=self._seed2,
-        output_shapes=nest.flatten(self.output_shapes),
-        output_types=nest.flatten(self.output_types))
+    if self._scratch_directory is None:
+      return gen_dataset_ops.shuffle_dataset(
+          self._input_dataset.make_dataset_resource(),
+          buffer_size=self._buffer_size,
+          seed=self._seed,
+          seed2=self._seed2,
+          output_shapes=nest.flatten(self.output_shapes),
+          output_types=nest.flatten(self.output_types))
+    else:
+      return gen_dataset_ops.spilling_shuffle_dataset(
+          self._input_dataset.make_dataset_resource(),
+          buffer_size=self._buffer_size,
+          seed=self._seed,
+          seed2=self._seed2,
+          scratch_directory=self._scratch_directory,
+          output_shapes=nest.flatten(self.output_shapes),
+          output_types=nest.flatten(self.output_types))
 
   @property
   def output_shapes(self):
@@ -1402,10 +1611,12 @@ class MapDataset(Dataset):
                input_dataset,
                map_func,
                num_threads=None,
-               output_buffer_size=None):
+               output_buffer_size=None,
+               sloppy=False):
     """See `Dataset.map()` for details."""
     super(MapDataset, self).__init__()
     self._input_dataset = input_dataset
+    self._sloppy = sloppy
 
     self._output_shapes = None
     self._output_types = None
@@ -1465,7 +1676,8 @@ class MapDataset(Dataset):
           num_threads=self._num_threads,
           output_buffer_size=self._output_buffer_size,
           output_types=nest.flatten(self.output_types),
-          output_shapes=nest.flatten(self.output_shapes))
+          output_shapes=nest.flatten(self.output_shapes),
+          sloppy=self._sloppy)
 
   @property
   def output_shapes(self):
@@ -1476,6 +1688,35 @@ class MapDataset(Dataset):
     return self._output_types
 
 
+class MapAndBatchDataset(MapDataset):
+  """A `Dataset` that maps a function over its input and batches the results."""
+
+  def __init__(self, input_dataset, map_func, batch_size, num_parallel_batches):
+    """See `Dataset.map_and_batch()` for details."""
+    super(MapAndBatchDataset, self).__init__(input_dataset, map_func)
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._num_parallel_batches = ops.convert_to_tensor(
+        num_parallel_batches, dtype=dtypes.int64, name="num_parallel_batches")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.map_and_batch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        f=self._map_func,
+        batch_size=self._batch_size,
+        num_parallel_batches=self._num_parallel_batches,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    return nest.pack_sequence_as(self._output_shapes, [
+        tensor_shape.vector(None).concatenate(s)
+        for s in nest.flatten(self._output_shapes)
+    ])
+
+
 class FlatMapDataset(Dataset):
   """A `Dataset` that maps a function over its input and flattens the result."""
 
@@ -1528,6 +1769,58 @@ class FlatMapDataset(Dataset):
     return self._output_types
 
 
+class InterleaveDataset(FlatMapDataset):
+  """A `Dataset` that maps a function over its input and interleaves it."""
+
+  def __init__(self, input_dataset, map_func, cycle_length, block_length):
+    """See `Dataset.interleave()` for details."""
+    super(InterleaveDataset, self).__init__(input_dataset, map_func)
+    self._cycle_length = ops.convert_to_tensor(
+        cycle_length, dtype=dtypes.int64, name="cycle_length")
+    self._block_length = ops.convert_to_tensor(
+        block_length, dtype=dtypes.int64, name="block_length")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.interleave_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        self._cycle_length,
+        self._block_length,
+        f=self._map_func,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+
+class ParallelInterleaveDataset(FlatMapDataset):
+  """A `Dataset` that interleaves the results of a function in parallel."""
+
+  def __init__(self, input_dataset, map_func, cycle_length, block_length,
+               sloppy, buffer_output_elements):
+    """See `Dataset.parallel_interleave()` for details."""
+    super(ParallelInterleaveDataset, self).__init__(input_dataset, map_func)
+    self._cycle_length = ops.convert_to_tensor(
+        cycle_length, dtype=dtypes.int64, name="cycle_length")
+    self._block_length = ops.convert_to_tensor(
+        block_length, dtype=dtypes.int64, name="block_length")
+    self._sloppy = ops.convert_to_tensor(
+        sloppy, dtype=dtypes.bool, name="sloppy")
+    self._buffer_output_elements = ops.convert_to_tensor(
+        buffer_output_elements, dtype=dtypes.int64,
+        name="buffer_output_elements")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.parallel_interleave_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        self._cycle_length,
+        self._block_length,
+        self._sloppy,
+        self._buffer_output_elements,
+        f=self._map_func,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+
 class FilterDataset(Dataset):
   """A `Dataset` that filters its input according to a predicate function."""
 
@@ -1577,21 +1870,95 @@ class FilterDataset(Dataset):
     return self._input_dataset.output_types
 
 
+class PrefetchDataset(Dataset):
+  """A `Dataset` that asynchronously prefetches its input."""
+
+  def __init__(self, input_dataset, buffer_size):
+    """See `Dataset.prefetch()` for details."""
+    super(PrefetchDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.prefetch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        buffer_size=self._buffer_size,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+class CacheDataset(Dataset):
+  """A `Dataset` that caches elements of its input."""
+
+  def __init__(self, input_dataset, filename):
+    """See `Dataset.cache()` for details."""
+    super(CacheDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._filename = ops.convert_to_tensor(
+        filename, dtype=dtypes.string, name="filename")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.cache_dataset(
+        self._input_dataset.make_dataset_resource(),
+        filename=self._filename,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+_DEFAULT_READER_BUFFER_SIZE_BYTES = 256 * 1024  # 256 KB
+
+
+def _int64_argument(value, default, name):
+  """Converts an optional argument of a reader dataset to a `tf.int64`."""
+  if value is None:
+    return constant_op.constant(default, dtype=dtypes.int64, name=name)
+  return ops.convert_to_tensor(value, dtype=dtypes.int64, name=name)
+
+
 class TextLineDataset(Dataset):
   """A `Dataset` comprising lines from one or more text files."""
 
-  def __init__(self, filenames):
+  def __init__(self, filenames, buffer_size=None, read_ahead_blocks=None):
     """Creates a `TextLineDataset`.
 
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
+      buffer_size: (Optional.) A Python integer representing the number of
+        bytes to buffer when reading a file. Defaults to 256 KB.
+      read_ahead_blocks: (Optional.) A Python integer representing the number
+        of blocks of `buffer_size` bytes to read ahead on a background thread,
+        which hides the latency of slow file systems at the cost of that much
+        memory per open file. Defaults to 0.
     """
     super(TextLineDataset, self).__init__()
     self._filenames = ops.convert_to_tensor(
         filenames, dtype=dtypes.string, name="filenames")
+    self._buffer_size = (_DEFAULT_READER_BUFFER_SIZE_BYTES
+                         if buffer_size is None else buffer_size)
+    self._read_ahead_blocks = (0 if read_ahead_blocks is None
+                               else read_ahead_blocks)
 
   def make_dataset_resource(self):
-    return gen_dataset_ops.text_line_dataset(self._filenames)
+    return gen_dataset_ops.text_line_dataset(
+        self._filenames, buffer_size=self._buffer_size,
+        read_ahead_blocks=self._read_ahead_blocks)
 
   @property
   def output_shapes(self):
@@ -1605,13 +1972,35 @@ class TextLineDataset(Dataset):
 class TFRecordDataset(Dataset):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None):
+  def __init__(self, filenames, compression_type=None, start=None,
+               count=None, num_shards=None, shard_index=None):
     """Creates a `TFRecordDataset`.
 
+    From each file, the dataset reads the records numbered in the range
+    `[start, start + count)`. If `num_shards` is given, that range is split
+    into `num_shards` contiguous shards, and the dataset reads only the
+    `shard_index`-th of them, so that several workers can read disjoint
+    parts of a single large file.
+
+    If an uncompressed file has a record index, which
+    `tf.python_io.TFRecordWriter` writes when its options have a positive
+    `index_interval`, it is used to find the first record to read. Otherwise,
+    or if the file was rewritten without its index, the records before it are
+    skipped sequentially.
+
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: A `tf.string` scalar evaluating to one of `""` (no
         compression), `"ZLIB"`, or `"GZIP"`.
+      start: (Optional.) A `tf.int64` scalar representing the number of the
+        first record to read from each file. Defaults to 0.
+      count: (Optional.) A `tf.int64` scalar representing the number of
+        records to read from each file. Defaults to reading all the records
+        after `start`.
+      num_shards: (Optional.) A `tf.int64` scalar representing the number of
+        shards into which the records of each file are split. Defaults to 1.
+      shard_index: (Optional.) A `tf.int64` scalar representing the shard of
+        each file to read, in the range `[0, num_shards)`. Defaults to 0.
     """
     super(TFRecordDataset, self).__init__()
     self._filenames = ops.convert_to_tensor(filenames, name="filenames")
@@ -1620,10 +2009,23 @@ class TFRecordDataset(Dataset):
           compression_type, dtype=dtypes.string, name="compression_type")
     else:
       self._compression_type = constant_op.constant("", name="compression_type")
+    # A range of records is read with a separate op, so that the graphs that
+    # read every record keep using the original op.
+    if (start is None and count is None and num_shards is None and
+        shard_index is None):
+      self._range = None
+    else:
+      self._range = (_int64_argument(start, 0, "start"),
+                     _int64_argument(count, -1, "count"),
+                     _int64_argument(num_shards, 1, "num_shards"),
+                     _int64_argument(shard_index, 0, "shard_index"))
 
   def make_dataset_resource(self):
-    return gen_dataset_ops.tf_record_dataset(self._filenames,
-                                             self._compression_type)
+    if self._range is None:
+      return gen_dataset_ops.tf_record_dataset(self._filenames,
+                                               self._compression_type)
+    return gen_dataset_ops.tf_record_range_dataset(
+        self._filenames, self._compression_type, *self._range)
 
   @property
   def output_shapes(self):
@@ -1641,7 +2043,9 @@ class FixedLengthRecordDataset(Dataset):
                filenames,
                record_bytes,
                header_bytes=None,
-               footer_bytes=None):
+               footer_bytes=None,
+               buffer_size=None,
+               read_ahead_blocks=None):
     """Creates a `FixedLengthRecordDataset`.
 
     Args:
@@ -1652,6 +2056,12 @@ class FixedLengthRecordDataset(Dataset):
         bytes to skip at the start of a file.
       footer_bytes: (Optional.) A `tf.int64` scalar representing the number of
         bytes to ignore at the end of a file.
+      buffer_size: (Optional.) A Python integer representing the number of
+        bytes to buffer when reading a file. Defaults to 256 KB.
+      read_ahead_blocks: (Optional.) A Python integer representing the number
+        of blocks of `buffer_size` bytes to read ahead on a background thread,
+        which hides the latency of slow file systems at the cost of that much
+        memory per open file. Defaults to 0.
     """
     super(FixedLengthRecordDataset, self).__init__()
     self._filenames = ops.convert_to_tensor(
@@ -1670,11 +2080,16 @@ class FixedLengthRecordDataset(Dataset):
     else:
       self._footer_bytes = constant_op.constant(
           0, dtype=dtypes.int64, name="footer_bytes")
+    self._buffer_size = (_DEFAULT_READER_BUFFER_SIZE_BYTES
+                         if buffer_size is None else buffer_size)
+    self._read_ahead_blocks = (0 if read_ahead_blocks is None
+                               else read_ahead_blocks)
 
   def make_dataset_resource(self):
     return gen_dataset_ops.fixed_length_record_dataset(
         self._filenames, self._header_bytes, self._record_bytes,
-        self._footer_bytes)
+        self._footer_bytes, buffer_size=self._buffer_size,
+        read_ahead_blocks=self._read_ahead_blocks)
 
   @property
   def output_shapes(self):
@@ -0,0 +1,249 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include <string.h>
+
+#include "grpc++/alarm.h"
+#include "grpc++/grpc++.h"
+#include "grpc++/server_builder.h"
+
+#include "tensorflow/contrib/shm/grpc_shm_service.h"
+#include "tensorflow/contrib/shm/shm_service.pb.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_util.h"
+#endif  // GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Smaller tensors are sent inline, since writing them to the ring saves
+// less than it costs.
+const size_t kMinShmTensorBytes = 1024;
+
+}  // namespace
+
+GrpcShmService::GrpcShmService(const WorkerEnv* worker_env,
+                               ::grpc::ServerBuilder* builder)
+    : is_shutdown_(false), worker_env_(worker_env) {
+  builder->RegisterService(&shm_service_);
+  cq_ = builder->AddCompletionQueue().release();
+}
+
+GrpcShmService::~GrpcShmService() {
+  delete shutdown_alarm_;
+  delete cq_;
+}
+
+void GrpcShmService::Shutdown() {
+  bool did_shutdown = false;
+  {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      LOG(INFO) << "Shutting down GrpcShmService.";
+      is_shutdown_ = true;
+      did_shutdown = true;
+    }
+  }
+  if (did_shutdown) {
+    shutdown_alarm_ =
+        new ::grpc::Alarm(cq_, gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+  }
+}
+
+// This macro creates a new request for the given RPC method name
+// (e.g., `ENQUEUE_REQUEST(RecvTensor, true);`), and enqueues it on
+// `this->cq_`.
+//
+// This macro is invoked one or more times for each RPC method to
+// ensure that there are sufficient completion queue entries to
+// handle incoming requests without blocking.
+//
+// The implementation of the request handler for each RPC method
+// must ensure that it calls ENQUEUE_REQUEST() for that RPC method,
+// to keep accepting new requests.
+#define ENQUEUE_REQUEST(method, supports_cancel)                           \
+  do {                                                                     \
+    mutex_lock l(shutdown_mu_);                                            \
+    if (!is_shutdown_) {                                                   \
+      Call<GrpcShmService, grpc::ShmService::AsyncService,                 \
+           method##Request, method##Response>::                            \
+          EnqueueRequest(&shm_service_, cq_,                               \
+                         &grpc::ShmService::AsyncService::Request##method, \
+                         &GrpcShmService::method##Handler,                 \
+                         (supports_cancel));                               \
+    }                                                                      \
+  } while (0)
+
+// This method blocks forever handling requests from the completion queue.
+void GrpcShmService::HandleRPCsLoop() {
+  for (int i = 0; i < 1000; ++i) {
+    ENQUEUE_REQUEST(RecvTensor, true);
+  }
+
+  void* tag;
+  bool ok;
+
+  while (cq_->Next(&tag, &ok)) {
+    UntypedCall<GrpcShmService>::Tag* callback_tag =
+        static_cast<UntypedCall<GrpcShmService>::Tag*>(tag);
+    if (callback_tag) {
+      callback_tag->OnCompleted(this, ok);
+    } else {
+      cq_->Shutdown();
+    }
+  }
+}
+
+void GrpcShmService::RecvTensorHandler(
+    WorkerCall<RecvTensorRequest, RecvTensorResponse>* call) {
+  worker_env_->compute_pool->Schedule([this, call]() {
+    CallOptions* call_opts = new CallOptions;
+    call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+    RecvTensorAsync(call_opts, &call->request, &call->response,
+                    [call, call_opts](const Status& s) {
+                      call->ClearCancelCallback();
+                      delete call_opts;
+                      call->SendResponse(ToGrpcStatus(s));
+                    });
+  });
+  ENQUEUE_REQUEST(RecvTensor, true);
+}
+
+void GrpcShmService::RecvTensorAsync(CallOptions* opts,
+                                     const RecvTensorRequest* request,
+                                     RecvTensorResponse* response,
+                                     StatusCallback done) {
+  const int64 step_id = request->step_id();
+  Rendezvous::ParsedKey parsed;
+  Status s = Rendezvous::ParseKey(request->rendezvous_key(), &parsed);
+  Device* src_dev = nullptr;
+  if (s.ok()) {
+    s = PrepareRecvTensor(parsed, &src_dev);
+  }
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  // As in GrpcWorker::RecvTensorAsync(), an RPC cancellation aborts the
+  // rendezvous until the tensor has been written to the response.
+  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  StatusCallback response_ready = [opts, response, done](const Status& s) {
+    opts->ClearCancelCallback();
+    response->set_send_start_micros(Env::Default()->NowMicros());
+    done(s);
+  };
+  const bool dma_ok = request->dma_ok();
+  worker_env_->rendezvous_mgr->RecvLocalAsync(
+      step_id, parsed,
+      [this, dma_ok, response, response_ready, src_dev](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
+        if (!status.ok()) {
+          response_ready(status);
+          return;
+        }
+        if (src_dev->tensorflow_gpu_device_info() &&
+            !send_args.alloc_attrs.on_host()) {
+#if GOOGLE_CUDA
+          // "val" is on a GPU. Uses GPUUtil to fill the response proto.
+          response->set_is_dead(is_dead);
+          GPUUtil::SetProtoFromGPU(val, src_dev, send_args.device_context,
+                                   response->mutable_tensor(), is_dead,
+                                   response_ready);
+#else
+          response_ready(errors::Internal("No GPU device in process"));
+#endif  // GOOGLE_CUDA
+          return;
+        }
+        FillResponse(val, is_dead, dma_ok, response);
+        response_ready(Status::OK());
+      });
+}
+
+void GrpcShmService::FillResponse(const Tensor& val, bool is_dead,
+                                  bool dma_ok, RecvTensorResponse* response) {
+  response->set_is_dead(is_dead);
+  ShmRing* ring = shm_mgr_->local_ring();
+  const StringPiece data = val.tensor_data();
+  ShmRing::Slot slot;
+  if (!dma_ok || is_dead || ring == nullptr ||
+      !DataTypeCanUseMemcpy(val.dtype()) ||
+      data.size() < kMinShmTensorBytes ||
+      !ring->Allocate(data.size(), &slot)) {
+    val.AsProtoTensorContent(response->mutable_tensor());
+    return;
+  }
+  memcpy(slot.data, data.data(), data.size());
+  TensorProto* proto = response->mutable_tensor();
+  proto->set_dtype(val.dtype());
+  val.shape().AsProto(proto->mutable_tensor_shape());
+  ShmTensorLocation location;
+  location.set_ring_name(ring->name());
+  location.set_offset(slot.offset);
+  location.set_size(slot.size);
+  location.set_sequence(slot.sequence);
+  response->mutable_transport_options()->PackFrom(location);
+}
+
+Status GrpcShmService::PrepareRecvTensor(const Rendezvous::ParsedKey& parsed,
+                                         Device** src_dev) {
+  // Figures out which device the tensor is hosted on.
+  string local_name = DeviceNameUtils::LocalName(parsed.src_device);
+  TF_RETURN_IF_ERROR(
+      worker_env_->device_mgr->LookupDevice(local_name, src_dev));
+
+  // Does the device have the right incarnation number we expect?
+  if ((*src_dev)->attributes().incarnation() != parsed.src_incarnation) {
+    return errors::Aborted(
+        "RecvTensor expects a different device incarnation: ",
+        parsed.src_incarnation, " vs. ", (*src_dev)->attributes().incarnation(),
+        ". Your worker job was probably restarted. Check your "
+        "worker job for the reason why it was restarted.");
+  }
+
+  return Status::OK();
+}
+
+void GrpcShmService::AbortStep(int64 step_id) {
+  Rendezvous* rendez = worker_env_->rendezvous_mgr->Find(step_id);
+  SchedNonBlockingClosureAfter(1000000, [rendez, step_id]() {
+    // Delay a bit before aborting the step, as in Worker::AbortStep().
+    rendez->StartAbort(errors::Aborted("Step ", step_id));
+    rendez->Unref();
+  });
+}
+
+// Create a GrpcShmService, then assign it to a given handle.
+void SetNewShmService(GrpcShmService** handle, const WorkerEnv* worker_env,
+                      ::grpc::ServerBuilder* builder) {
+  *handle = new GrpcShmService(worker_env, builder);
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
@@ -0,0 +1,85 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_H_
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/grpc_shm_service_impl.h"
+#include "tensorflow/contrib/shm/shm_mgr.h"
+#include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+
+namespace grpc {
+class ServerBuilder;
+class ServerCompletionQueue;
+class Alarm;
+}  // namespace grpc
+
+namespace tensorflow {
+
+class Device;
+
+class GrpcShmService : public AsyncServiceInterface {
+ public:
+  GrpcShmService(const WorkerEnv* worker_env, ::grpc::ServerBuilder* builder);
+  ~GrpcShmService();
+  void HandleRPCsLoop() override;
+  void Shutdown() override;
+  void SetShmMgr(ShmMgr* shm_mgr) { shm_mgr_ = shm_mgr; }
+
+ private:
+  template <class RequestMessage, class ResponseMessage>
+  using WorkerCall = Call<GrpcShmService, grpc::ShmService::AsyncService,
+                          RequestMessage, ResponseMessage>;
+  void RecvTensorHandler(
+      WorkerCall<RecvTensorRequest, RecvTensorResponse>* call);
+  void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                       RecvTensorResponse* response, StatusCallback done);
+
+  // Fills "response" with the tensor "val", which is in host memory.
+  // The content of "val" is written to the local ring if "dma_ok", and
+  // there is room for it there.
+  void FillResponse(const Tensor& val, bool is_dead, bool dma_ok,
+                    RecvTensorResponse* response);
+
+  Status PrepareRecvTensor(const Rendezvous::ParsedKey& parsed,
+                           Device** src_dev);
+  void AbortStep(int64 step_id);
+
+  ::grpc::ServerCompletionQueue* cq_;
+  grpc::ShmService::AsyncService shm_service_;
+  mutex shutdown_mu_;
+  bool is_shutdown_ GUARDED_BY(shutdown_mu_);
+  ::grpc::Alarm* shutdown_alarm_ = nullptr;
+  // not owned
+  ShmMgr* shm_mgr_ = nullptr;
+  const WorkerEnv* const worker_env_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcShmService);
+};
+
+// Create a GrpcShmService, then assign it to a given handle.
+void SetNewShmService(GrpcShmService** handle, const WorkerEnv* worker_env,
+                      ::grpc::ServerBuilder* builder);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_H_
@@ -0,0 +1,69 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_IMPL_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_IMPL_H_
+
+#include "grpc++/impl/codegen/async_stream.h"
+#include "grpc++/impl/codegen/async_unary_call.h"
+#include "grpc++/impl/codegen/proto_utils.h"
+#include "grpc++/impl/codegen/rpc_method.h"
+#include "grpc++/impl/codegen/service_type.h"
+#include "grpc++/impl/codegen/status.h"
+
+#include "tensorflow/contrib/shm/shm_service.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace grpc {
+class CompletionQueue;
+class ServerCompletionQueue;
+class ServerContext;
+}  // namespace grpc
+
+namespace tensorflow {
+
+namespace grpc {
+
+// Implementation of `tensorflow.ShmService`, based on the
+// definition in "//tensorflow/contrib/shm/shm_service.proto",
+// and the gRPC generated service class.
+// See the proto file for the definition of methods and messages.
+//
+// Clients issue calls with a ::grpc::RpcMethod for
+// RecvTensorMethodName() (see ShmRemoteWorker).
+class ShmService GRPC_FINAL {
+ public:
+  static const char* RecvTensorMethodName();
+
+  class AsyncService : public ::grpc::Service {
+   public:
+    AsyncService();
+    virtual ~AsyncService();
+    void RequestRecvTensor(
+        ::grpc::ServerContext* context, RecvTensorRequest* request,
+        ::grpc::ServerAsyncResponseWriter<RecvTensorResponse>* response,
+        ::grpc::CompletionQueue* new_call_cq,
+        ::grpc::ServerCompletionQueue* notification_cq, void* tag) {
+      ::grpc::Service::RequestAsyncUnary(0, context, request, response,
+                                         new_call_cq, notification_cq, tag);
+    }
+  };
+};
+
+}  // namespace grpc
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_GRPC_SHM_SERVICE_IMPL_H_
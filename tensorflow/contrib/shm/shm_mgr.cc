@@ -0,0 +1,116 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/shm_mgr.h"
+
+#include <unistd.h>
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/session_mgr.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Size of the ring of each task, which bounds the bytes of tensors that
+// it can have in flight through shared memory. The pages of the ring are
+// only backed by memory once they are first used.
+const int64 kDefaultRingBytes = 256LL << 20;
+
+// How long a tensor is kept in the ring for a receiver that does not
+// read it, e.g. because its call was cancelled.
+const int64 kSlotLeaseMicros = 60LL * 1000 * 1000;
+
+// Returns the host in "host_port".
+string HostOf(const string& host_port) {
+  const size_t colon = host_port.rfind(':');
+  return colon == string::npos ? host_port : host_port.substr(0, colon);
+}
+
+}  // namespace
+
+ShmMgr::ShmMgr(const WorkerEnv* worker_env, GrpcChannelCache* channel_cache)
+    : worker_env_(worker_env), channel_cache_(channel_cache) {
+  // hardcoded to default session (legacy_session_), as in RdmaMgr.
+  local_worker_ = worker_env_->session_mgr->LegacySession()->worker_name;
+  const string local_host_port = channel_cache_->TranslateTask(local_worker_);
+  local_hosts_ = {"localhost", "127.0.0.1", "[::1]", port::Hostname(),
+                  HostOf(local_host_port)};
+
+  int64 ring_bytes;
+  Status s = ReadInt64FromEnvVar("TF_SHM_RING_BYTES", kDefaultRingBytes,
+                                 &ring_bytes);
+  if (s.ok() && ring_bytes > 0) {
+    const string port = local_host_port.substr(local_host_port.rfind(':') + 1);
+    s = ShmRing::Create(strings::StrCat("/tensorflow_", getpid(), "_", port),
+                        ring_bytes, kSlotLeaseMicros, &local_ring_);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Sending tensors from " << local_worker_
+                 << " without shared memory: " << s;
+  } else if (local_ring_) {
+    VLOG(1) << "Sending tensors from " << local_worker_ << " through "
+            << local_ring_->name();
+  }
+
+  polling_thread_.reset(worker_env_->env->StartThread(
+      ThreadOptions(), "TF_shm_mgr", [this]() {
+        void* tag;
+        bool ok;
+        while (completion_queue_.Next(&tag, &ok)) {
+          GrpcClientCQTag* callback_tag = static_cast<GrpcClientCQTag*>(tag);
+          callback_tag->OnCompleted(ok);
+        }
+      }));
+}
+
+ShmMgr::~ShmMgr() {
+  completion_queue_.Shutdown();
+  polling_thread_.reset();  // Blocks until thread exits.
+}
+
+bool ShmMgr::IsLocalHost(const string& host_port) const {
+  return local_hosts_.count(HostOf(host_port)) > 0;
+}
+
+WorkerInterface* ShmMgr::FindWorker(const string& worker_name) {
+  mutex_lock l(mu_);
+  auto it = workers_.find(worker_name);
+  if (it == workers_.end()) {
+    std::unique_ptr<ShmRemoteWorker> worker;
+    // Checks that the worker is known before translating its name, which
+    // fails hard otherwise.
+    SharedGrpcChannelPtr channel =
+        channel_cache_->FindWorkerChannel(worker_name);
+    if (channel && worker_name != local_worker_ &&
+        IsLocalHost(channel_cache_->TranslateTask(worker_name))) {
+      VLOG(1) << "Receiving tensors from " << worker_name
+              << " through shared memory";
+      worker.reset(new ShmRemoteWorker(std::move(channel), &completion_queue_));
+    }
+    it = workers_.emplace(worker_name, std::move(worker)).first;
+  }
+  return it->second.get();
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
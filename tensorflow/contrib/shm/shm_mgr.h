@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_MGR_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_MGR_H_
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "grpc++/grpc++.h"
+
+#include "tensorflow/contrib/shm/shm_remote_worker.h"
+#include "tensorflow/contrib/shm/shm_ring.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+
+// Holds the shared memory state of a task: the ring that it sends
+// tensors through, and the workers through which it receives tensors
+// from the other tasks on the same host.
+class ShmMgr {
+ public:
+  ShmMgr(const WorkerEnv* worker_env, GrpcChannelCache* channel_cache);
+  ~ShmMgr();
+
+  const string& local_worker() const { return local_worker_; }
+
+  // The ring that tensors sent by this task are written to, or nullptr
+  // if it could not be created, in which case they are sent inline.
+  ShmRing* local_ring() const { return local_ring_.get(); }
+
+  // Returns a worker that receives tensors from "worker_name" through
+  // shared memory if it runs on this host, or nullptr otherwise. The
+  // worker is owned by this ShmMgr.
+  WorkerInterface* FindWorker(const string& worker_name);
+
+ private:
+  bool IsLocalHost(const string& host_port) const;
+
+  const WorkerEnv* const worker_env_;
+  GrpcChannelCache* const channel_cache_;  // Not owned.
+  string local_worker_;
+  std::unordered_set<string> local_hosts_;
+  std::unique_ptr<ShmRing> local_ring_;
+
+  // Completion queue for the calls issued by the workers, and the thread
+  // that polls it.
+  ::grpc::CompletionQueue completion_queue_;
+  std::unique_ptr<Thread> polling_thread_;
+
+  mutex mu_;
+  // A null entry records that the worker does not run on this host.
+  std::unordered_map<string, std::unique_ptr<ShmRemoteWorker>> workers_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmMgr);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_MGR_H_
@@ -0,0 +1,217 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/shm_remote_worker.h"
+
+#include "grpc++/grpc++.h"
+
+#include "tensorflow/contrib/shm/grpc_shm_service_impl.h"
+#include "tensorflow/contrib/shm/shm_service.pb.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+// Object allocated per active RecvTensor call, as in GrpcRemoteWorker.
+class ShmRemoteWorker::RecvTensorCall final : public GrpcClientCQTag {
+ public:
+  RecvTensorCall(::grpc::ChannelInterface* channel,
+                 ::grpc::CompletionQueue* cq, const ::grpc::RpcMethod& method,
+                 const RecvTensorRequest& request, StatusCallback done,
+                 CallOptions* call_opts)
+      : call_opts_(call_opts),
+        reader_(channel, cq, method, InitContext(call_opts), request),
+        done_(std::move(done)) {}
+
+  void StartRPC(RecvTensorResponse* response) {
+    reader_.Finish(response, &status_, this);
+  }
+
+  void OnCompleted(bool ok) override {
+    if (!ok) {
+      VLOG(2) << "Call returned with non-ok status: "
+              << status_.error_message();
+    }
+    if (call_opts_) {
+      call_opts_->ClearCancelCallback();
+    }
+    done_(FromGrpcStatus(status_));
+    delete this;
+  }
+
+ private:
+  CallOptions* call_opts_;
+  ::grpc::ClientContext context_;
+  ::grpc::ClientAsyncResponseReader<RecvTensorResponse> reader_;
+  ::grpc::Status status_;
+  StatusCallback done_;
+
+  ::grpc::ClientContext* InitContext(CallOptions* call_opts) {
+    context_.set_fail_fast(false);
+    if (call_opts) {
+      call_opts->SetCancelCallback([this]() { context_.TryCancel(); });
+    }
+    return &context_;
+  }
+};
+
+ShmRemoteWorker::ShmRemoteWorker(SharedGrpcChannelPtr channel,
+                                 ::grpc::CompletionQueue* completion_queue)
+    : channel_(std::move(channel)),
+      cq_(completion_queue),
+      recvtensor_(grpc::ShmService::RecvTensorMethodName(),
+                  ::grpc::RpcMethod::NORMAL_RPC, channel_) {}
+
+ShmRemoteWorker::~ShmRemoteWorker() {}
+
+void ShmRemoteWorker::RecvTensorAsync(CallOptions* call_opts,
+                                      const RecvTensorRequest* request,
+                                      TensorResponse* response,
+                                      StatusCallback done) {
+  VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
+  RecvTensorResponse* meta = new RecvTensorResponse;
+  auto call = new RecvTensorCall(
+      channel_.get(), cq_, recvtensor_, *request,
+      [this, meta, response, done](const Status& s) {
+        Status status = s;
+        if (status.ok()) {
+          status = ReadResponse(meta, response);
+        }
+        delete meta;
+        done(status);
+      },
+      call_opts);
+  call->StartRPC(meta);
+}
+
+Status ShmRemoteWorker::ReadResponse(RecvTensorResponse* meta,
+                                     TensorResponse* response) {
+  if (!meta->has_transport_options()) {
+    return response->InitFrom(meta);
+  }
+  ShmTensorLocation location;
+  if (!meta->transport_options().UnpackTo(&location)) {
+    return errors::Internal("Unexpected transport options in RecvTensor "
+                            "response: ",
+                            meta->transport_options().type_url());
+  }
+  meta->clear_transport_options();
+  if (!DataTypeCanUseMemcpy(meta->tensor().dtype())) {
+    return errors::Internal("Cannot receive tensor of type ",
+                            DataTypeString(meta->tensor().dtype()),
+                            " through shared memory");
+  }
+  response->InitPartial(*meta);
+  const StringPiece buf = response->tensor().tensor_data();
+  if (buf.size() != location.size()) {
+    return errors::Internal("Expected ", buf.size(),
+                            " bytes of tensor data in shared memory, got ",
+                            location.size());
+  }
+  std::shared_ptr<ShmRing> ring;
+  TF_RETURN_IF_ERROR(GetRing(location.ring_name(), &ring));
+  return ring->Read(location.offset(), location.size(), location.sequence(),
+                    const_cast<char*>(buf.data()));
+}
+
+Status ShmRemoteWorker::GetRing(const string& name,
+                                std::shared_ptr<ShmRing>* ring) {
+  mutex_lock l(mu_);
+  if (ring_ == nullptr || ring_->name() != name) {
+    std::unique_ptr<ShmRing> opened;
+    TF_RETURN_IF_ERROR(ShmRing::Open(name, &opened));
+    ring_ = std::move(opened);
+  }
+  *ring = ring_;
+  return Status::OK();
+}
+
+void ShmRemoteWorker::GetStatusAsync(const GetStatusRequest* request,
+                                     GetStatusResponse* response,
+                                     StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::GetStatusAsync()"));
+}
+
+void ShmRemoteWorker::CreateWorkerSessionAsync(
+    const CreateWorkerSessionRequest* request,
+    CreateWorkerSessionResponse* response, StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::CreateWorkerSessionAsync()"));
+}
+
+void ShmRemoteWorker::RegisterGraphAsync(const RegisterGraphRequest* request,
+                                         RegisterGraphResponse* response,
+                                         StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::RegisterGraphAsync()"));
+}
+
+void ShmRemoteWorker::DeregisterGraphAsync(
+    const DeregisterGraphRequest* request, DeregisterGraphResponse* response,
+    StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::DeregisterGraphAsync()"));
+}
+
+void ShmRemoteWorker::RunGraphAsync(CallOptions* call_opts,
+                                    RunGraphRequestWrapper* request,
+                                    MutableRunGraphResponseWrapper* response,
+                                    StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::RunGraphAsync()"));
+}
+
+void ShmRemoteWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
+                                        CleanupGraphResponse* response,
+                                        StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::CleanupGraphAsync()"));
+}
+
+void ShmRemoteWorker::CleanupAllAsync(const CleanupAllRequest* request,
+                                      CleanupAllResponse* response,
+                                      StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::CleanupAllAsync()"));
+}
+
+void ShmRemoteWorker::RecvTensorsAsync(CallOptions* call_opts,
+                                       const RecvTensorsRequest* request,
+                                       TensorResponses* response,
+                                       StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::RecvTensorsAsync()"));
+}
+
+void ShmRemoteWorker::PushTensorAsync(CallOptions* call_opts,
+                                      const PushedTensor* request,
+                                      PushTensorResponse* response,
+                                      StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::PushTensorAsync()"));
+}
+
+void ShmRemoteWorker::LoggingAsync(const LoggingRequest* request,
+                                   LoggingResponse* response,
+                                   StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::LoggingAsync()"));
+}
+
+void ShmRemoteWorker::TracingAsync(const TracingRequest* request,
+                                   TracingResponse* response,
+                                   StatusCallback done) {
+  done(errors::Unimplemented("ShmRemoteWorker::TracingAsync()"));
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
@@ -0,0 +1,112 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_REMOTE_WORKER_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_REMOTE_WORKER_H_
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include <memory>
+
+#include "grpc++/impl/codegen/rpc_method.h"
+
+#include "tensorflow/contrib/shm/shm_ring.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace grpc {
+class CompletionQueue;
+}  // namespace grpc
+
+namespace tensorflow {
+
+// A worker on the same host, from which tensors are received through
+// its shared memory ring.
+//
+// Only RecvTensorAsync() is implemented, as a call to the
+// ShmService of the worker; all other calls go to the worker through
+// the worker cache of the session.
+//
+// If "request->dma_ok()" is true, the tensor content may be read from
+// shared memory straight into "response->tensor()", so it must only be
+// set if "response" was initialized for host memory.
+class ShmRemoteWorker : public WorkerInterface {
+ public:
+  ShmRemoteWorker(SharedGrpcChannelPtr channel,
+                  ::grpc::CompletionQueue* completion_queue);
+  ~ShmRemoteWorker() override;
+
+  void RecvTensorAsync(CallOptions* call_opts, const RecvTensorRequest* request,
+                       TensorResponse* response, StatusCallback done) override;
+
+  void GetStatusAsync(const GetStatusRequest* request,
+                      GetStatusResponse* response,
+                      StatusCallback done) override;
+  void CreateWorkerSessionAsync(const CreateWorkerSessionRequest* request,
+                                CreateWorkerSessionResponse* response,
+                                StatusCallback done) override;
+  void RegisterGraphAsync(const RegisterGraphRequest* request,
+                          RegisterGraphResponse* response,
+                          StatusCallback done) override;
+  void DeregisterGraphAsync(const DeregisterGraphRequest* request,
+                            DeregisterGraphResponse* response,
+                            StatusCallback done) override;
+  void RunGraphAsync(CallOptions* call_opts, RunGraphRequestWrapper* request,
+                     MutableRunGraphResponseWrapper* response,
+                     StatusCallback done) override;
+  void CleanupGraphAsync(const CleanupGraphRequest* request,
+                         CleanupGraphResponse* response,
+                         StatusCallback done) override;
+  void CleanupAllAsync(const CleanupAllRequest* request,
+                       CleanupAllResponse* response,
+                       StatusCallback done) override;
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        TensorResponses* response,
+                        StatusCallback done) override;
+  void PushTensorAsync(CallOptions* call_opts, const PushedTensor* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override;
+  void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
+                    StatusCallback done) override;
+  void TracingAsync(const TracingRequest* request, TracingResponse* response,
+                    StatusCallback done) override;
+
+ private:
+  class RecvTensorCall;
+
+  // Fills "response" from "meta", reading the tensor content from
+  // shared memory if "meta" locates it there.
+  Status ReadResponse(RecvTensorResponse* meta, TensorResponse* response);
+
+  // Returns the shared memory ring "name" of the worker, which is
+  // mapped on first use and again if the worker restarts.
+  Status GetRing(const string& name, std::shared_ptr<ShmRing>* ring);
+
+  SharedGrpcChannelPtr channel_;
+  ::grpc::CompletionQueue* cq_;
+  const ::grpc::RpcMethod recvtensor_;
+
+  mutex mu_;
+  std::shared_ptr<ShmRing> ring_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRemoteWorker);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_REMOTE_WORKER_H_
@@ -0,0 +1,181 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/shm_rendezvous_mgr.h"
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/call_options.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+class ShmRemoteRendezvous : public BaseRemoteRendezvous {
+ public:
+  ShmRemoteRendezvous(const WorkerEnv* env, int64 step_id, ShmMgr* shm_mgr)
+      : BaseRemoteRendezvous(env, step_id, false), shm_mgr_(shm_mgr) {}
+
+ protected:
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args,
+                           DoneCallback done) override;
+
+ private:
+  ~ShmRemoteRendezvous() override {}
+  ShmMgr* shm_mgr_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRemoteRendezvous);
+};
+
+// A RecvTensor call that can be aborted, as in RpcRemoteRendezvous.
+class ShmRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  ShmRecvTensorCall(WorkerInterface* wi, int64 step_id, StringPiece key,
+                    bool dma_ok, Device* dst_device,
+                    const AllocatorAttributes& alloc_attrs)
+      : wi_(wi) {
+    req_.set_step_id(step_id);
+    req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_dma_ok(dma_ok);
+    resp_.InitAlloc(dst_device, alloc_attrs);
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    wi_->RecvTensorAsync(&opts_, &req_, &resp_,
+                         [this, recv_done](const Status& s) {
+                           if (!s.ok()) {
+                             mutex_lock l(mu_);
+                             status_.Update(s);
+                           }
+                           recv_done();
+                         });
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  WorkerInterface* wi() const { return wi_; }
+  const Tensor& tensor() const { return resp_.tensor(); }
+  bool is_dead() const { return resp_.metadata().is_dead(); }
+
+ private:
+  WorkerInterface* const wi_;
+  CallOptions opts_;
+  RecvTensorRequest req_;
+  TensorResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRecvTensorCall);
+};
+
+void ShmRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  CHECK(is_initialized());
+
+  // key.src_device identifies a remote device.
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    done(errors::Internal(parsed.src_device,
+                          " is invalid remote source device."),
+         Args(), recv_args, Tensor{}, false);
+    return;
+  }
+  WorkerSession* sess = session();
+  Device* dst_device;
+  Status s = sess->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
+  if (!s.ok()) {
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  // Workers on this host are owned by "shm_mgr_"; all others are
+  // released to the worker cache once the call is done.
+  WorkerCacheInterface* worker_cache = nullptr;
+  WorkerInterface* wi = shm_mgr_->FindWorker(src_worker);
+  if (wi == nullptr) {
+    worker_cache = sess->worker_cache.get();
+    wi = worker_cache->CreateWorker(src_worker);
+    if (wi == nullptr) {
+      done(errors::Internal("No worker known as ", src_worker), Args(),
+           recv_args, Tensor{}, false);
+      return;
+    }
+  }
+  // Tensor content can only be read from shared memory straight into
+  // host memory.
+  const bool dma_ok =
+      worker_cache == nullptr &&
+      (recv_args.alloc_attrs.on_host() ||
+       dst_device->attributes().device_type() == DEVICE_CPU);
+  ShmRecvTensorCall* call =
+      new ShmRecvTensorCall(wi, step_id_, parsed.FullKey(), dma_ok,
+                            dst_device, recv_args.alloc_attrs);
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call);
+
+  // Start "call".
+  Ref();
+  call->Start([this, call, worker_cache, src_worker, recv_args, done]() {
+    // Removes "call" from active_. Prevent StartAbort().
+    DeregisterCall(call);
+    // If StartAbort was called prior to DeregisterCall, then the
+    // current status should be bad.
+    done(call->status(), Args(), recv_args, call->tensor(), call->is_dead());
+    if (worker_cache != nullptr) {
+      worker_cache->ReleaseWorker(src_worker, call->wi());
+    }
+    delete call;
+    Unref();
+  });
+}
+
+}  // namespace
+
+ShmRendezvousMgr::ShmRendezvousMgr(const WorkerEnv* env)
+    : BaseRendezvousMgr(env) {}
+
+BaseRemoteRendezvous* ShmRendezvousMgr::Create(int64 step_id,
+                                               const WorkerEnv* worker_env) {
+  return new ShmRemoteRendezvous(worker_env, step_id, shm_mgr_);
+}
+
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
@@ -0,0 +1,58 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RENDEZVOUS_MGR_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RENDEZVOUS_MGR_H_
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/shm_mgr.h"
+#include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+
+// RendezvousMgr keeps track of a set of local rendezvous instances.
+// All tensors sent by this worker are buffered in a RendezvousMgr
+// until the tensor is received.  Each global unique "step_id"
+// corresponds to one local rendezvous instance managed by a
+// RendezvousMgr.
+//
+// Tensors are received from workers on the same host through the
+// ShmRemoteWorker that "shm_mgr" holds for them, and from all other
+// workers through the worker cache of the session, as in
+// RpcRendezvousMgr.
+//
+// Tensors sent and recved through rendezvous managed by this
+// RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+class ShmRendezvousMgr : public BaseRendezvousMgr {
+ public:
+  explicit ShmRendezvousMgr(const WorkerEnv* env);
+  void SetShmMgr(ShmMgr* shm_mgr) { shm_mgr_ = shm_mgr; }
+
+ protected:
+  BaseRemoteRendezvous* Create(int64 step_id,
+                               const WorkerEnv* worker_env) override;
+
+ private:
+  ShmMgr* shm_mgr_ = nullptr;
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRendezvousMgr);
+};
+
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RENDEZVOUS_MGR_H_
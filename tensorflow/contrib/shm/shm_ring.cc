@@ -0,0 +1,285 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/posix/error.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Headers and slots are aligned to (and headers padded to) this many
+// bytes.
+const uint64 kAlignment = 64;
+
+const uint64 kMagic = 0x314752485346540aULL;
+
+// Each slot state word holds the state of the slot that starts at its
+// offset, tagged with the sequence number of that slot in the upper bits.
+// A consumer thus only claims a slot that was allocated at the offset and
+// with the sequence number it was given.
+enum SlotState : uint64 { kFree = 0, kInUse = 1, kReading = 2 };
+const int kSlotStateBits = 2;
+
+uint64 StateWord(uint64 sequence, SlotState state) {
+  return sequence << kSlotStateBits | state;
+}
+
+SlotState StateOf(uint64 word) {
+  return static_cast<SlotState>(word & ((1 << kSlotStateBits) - 1));
+}
+
+uint64 SequenceOf(uint64 word) { return word >> kSlotStateBits; }
+
+uint64 RoundUp(uint64 n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// The bytes of the state words of a ring of "capacity" bytes, which has
+// a slot boundary every kAlignment bytes.
+uint64 StateBytes(uint64 capacity) {
+  return RoundUp(capacity / kAlignment * sizeof(std::atomic<uint64>));
+}
+
+uint64 MappedBytes(uint64 capacity) {
+  return kAlignment + StateBytes(capacity) + capacity;
+}
+
+}  // namespace
+
+struct ShmRing::RingHeader {
+  uint64 magic;
+  uint64 capacity;
+};
+
+// Written by the producer before it hands out the location of the slot,
+// and only read by consumers.
+struct ShmRing::SlotHeader {
+  uint64 slot_bytes;  // Including this header.
+  uint64 size;
+  int64 alloc_micros;
+};
+
+ShmRing::ShmRing(const string& name, bool is_producer, char* base,
+                 uint64 capacity, int64 slot_lease_micros)
+    : name_(name),
+      is_producer_(is_producer),
+      base_(base),
+      capacity_(capacity),
+      slot_lease_micros_(slot_lease_micros) {
+  static_assert(sizeof(RingHeader) <= kAlignment,
+                "RingHeader does not fit its alignment");
+  static_assert(sizeof(SlotHeader) <= kAlignment,
+                "SlotHeader does not fit its alignment");
+  static_assert(sizeof(std::atomic<uint64>) == sizeof(uint64) &&
+                    kAlignment % sizeof(uint64) == 0,
+                "Slot state words are not packed");
+}
+
+ShmRing::~ShmRing() {
+  munmap(base_, MappedBytes(capacity_));
+  if (is_producer_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+/* static */
+Status ShmRing::Create(const string& name, uint64 capacity,
+                       int64 slot_lease_micros,
+                       std::unique_ptr<ShmRing>* ring) {
+  capacity = RoundUp(capacity);
+  if (capacity == 0) {
+    return errors::InvalidArgument("Shared memory ring ", name, " is empty");
+  }
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    // Left behind by a process that did not exit cleanly.
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  }
+  if (fd < 0) {
+    return IOError(name, errno);
+  }
+  const uint64 mapped_bytes = MappedBytes(capacity);
+  void* base = MAP_FAILED;
+  if (ftruncate(fd, mapped_bytes) == 0) {
+    base = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  const int err = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return IOError(name, err);
+  }
+  // The object is zero-filled, so all slots start out free.
+  RingHeader* header = static_cast<RingHeader*>(base);
+  header->capacity = capacity;
+  header->magic = kMagic;
+  ring->reset(new ShmRing(name, true, static_cast<char*>(base), capacity,
+                          slot_lease_micros));
+  return Status::OK();
+}
+
+/* static */
+Status ShmRing::Open(const string& name, std::unique_ptr<ShmRing>* ring) {
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return IOError(name, errno);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    const int err = errno;
+    close(fd);
+    return IOError(name, err);
+  }
+  const uint64 mapped_bytes = st.st_size;
+  void* base = MAP_FAILED;
+  if (mapped_bytes > kAlignment) {
+    base = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  const int err = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    if (mapped_bytes <= kAlignment) {
+      return errors::DataLoss("Shared memory ring ", name, " is truncated");
+    }
+    return IOError(name, err);
+  }
+  const RingHeader* header = static_cast<const RingHeader*>(base);
+  if (header->magic != kMagic || header->capacity % kAlignment != 0 ||
+      MappedBytes(header->capacity) != mapped_bytes) {
+    munmap(base, mapped_bytes);
+    return errors::DataLoss(name, " is not a shared memory ring");
+  }
+  ring->reset(new ShmRing(name, false, static_cast<char*>(base),
+                          header->capacity, 0));
+  return Status::OK();
+}
+
+ShmRing::SlotHeader* ShmRing::slot_header(uint64 offset) const {
+  return reinterpret_cast<SlotHeader*>(base_ + kAlignment +
+                                       StateBytes(capacity_) + offset);
+}
+
+std::atomic<uint64>* ShmRing::slot_state(uint64 offset) const {
+  return reinterpret_cast<std::atomic<uint64>*>(base_ + kAlignment) +
+         offset / kAlignment;
+}
+
+bool ShmRing::Allocate(uint64 size, Slot* slot) {
+  DCHECK(is_producer_);
+  if (size > capacity_ - kAlignment) return false;
+  const uint64 slot_bytes = RoundUp(kAlignment + size);
+  mutex_lock l(mu_);
+  Reclaim();
+  uint64 offset = head_ % capacity_;
+  if (offset + slot_bytes > capacity_) {
+    // Skips the rest of the ring with a free slot, so that the data is
+    // contiguous.
+    const uint64 padding = capacity_ - offset;
+    if (head_ + padding + slot_bytes - tail_ > capacity_) return false;
+    SlotHeader* header = slot_header(offset);
+    header->slot_bytes = padding;
+    header->size = 0;
+    slot_state(offset)->store(StateWord(0, kFree), std::memory_order_release);
+    head_ += padding;
+    offset = 0;
+  } else if (head_ + slot_bytes - tail_ > capacity_) {
+    return false;
+  }
+  SlotHeader* header = slot_header(offset);
+  header->slot_bytes = slot_bytes;
+  header->size = size;
+  header->alloc_micros = Env::Default()->NowMicros();
+  const uint64 sequence = next_sequence_++;
+  slot_state(offset)->store(StateWord(sequence, kInUse),
+                            std::memory_order_release);
+  head_ += slot_bytes;
+
+  slot->offset = offset;
+  slot->size = size;
+  slot->sequence = sequence;
+  slot->data = reinterpret_cast<char*>(header) + kAlignment;
+  return true;
+}
+
+void ShmRing::Reclaim() {
+  int64 now_micros = 0;
+  while (tail_ < head_) {
+    const uint64 offset = tail_ % capacity_;
+    SlotHeader* header = slot_header(offset);
+    std::atomic<uint64>* state = slot_state(offset);
+    uint64 word = state->load(std::memory_order_acquire);
+    if (StateOf(word) == kInUse) {
+      if (now_micros == 0) now_micros = Env::Default()->NowMicros();
+      const uint64 sequence = SequenceOf(word);
+      if (now_micros - header->alloc_micros >= slot_lease_micros_ &&
+          state->compare_exchange_strong(word, StateWord(sequence, kFree),
+                                         std::memory_order_acquire)) {
+        VLOG(1) << "Lease of shared memory slot " << sequence << " in "
+                << name_ << " expired";
+        word = StateWord(sequence, kFree);
+      }
+    }
+    if (StateOf(word) != kFree) break;
+    tail_ += header->slot_bytes;
+  }
+}
+
+Status ShmRing::Read(uint64 offset, uint64 size, uint64 sequence, char* dst) {
+  DCHECK(!is_producer_);
+  if (offset % kAlignment != 0 || offset >= capacity_ ||
+      size > capacity_ - offset - kAlignment) {
+    return errors::InvalidArgument("Bad slot at ", offset, " of ", size,
+                                   " bytes in shared memory ring ", name_);
+  }
+  // Only succeeds if the slot with this sequence number starts at
+  // "offset" and is still in use, so a stale or bogus location never
+  // lands inside the data of another slot.
+  std::atomic<uint64>* state = slot_state(offset);
+  uint64 word = StateWord(sequence, kInUse);
+  if (!state->compare_exchange_strong(word, StateWord(sequence, kReading),
+                                      std::memory_order_acquire)) {
+    return errors::Aborted("Slot ", sequence, " in shared memory ring ",
+                           name_, " expired before it was read");
+  }
+  SlotHeader* header = slot_header(offset);
+  if (header->size != size) {
+    state->store(StateWord(sequence, kInUse), std::memory_order_release);
+    return errors::InvalidArgument("Slot ", sequence, " in shared memory ring ",
+                                   name_, " holds ", header->size,
+                                   " bytes, not ", size);
+  }
+  memcpy(dst, reinterpret_cast<char*>(header) + kAlignment, size);
+  state->store(StateWord(sequence, kFree), std::memory_order_release);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
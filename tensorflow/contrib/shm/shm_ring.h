@@ -0,0 +1,114 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
+
+#include <atomic>
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A ring of variable-sized slots in a POSIX shared memory object,
+// through which one process (the producer) hands data to other
+// processes on the same host (the consumers).
+//
+// Only the producer allocates slots, and it tells a consumer where the
+// data is by other means (e.g. in an RPC response). The consumer copies
+// the data out of the slot and frees it; the producer reuses freed slots
+// in allocation order. A slot that is not read within the lease given
+// to Create() is taken back by the producer, and reading it fails.
+//
+// The producer unlinks the shared memory object when its ShmRing is
+// destroyed. Consumers keep their mapping until theirs is.
+class ShmRing {
+ public:
+  // An allocated slot.
+  struct Slot {
+    uint64 offset = 0;
+    uint64 size = 0;
+    uint64 sequence = 0;
+    char* data = nullptr;  // "size" bytes, to be filled by the producer.
+  };
+
+  ~ShmRing();
+
+  // Creates the shared memory object "name" (e.g. "/tensorflow_1234")
+  // with room for "capacity" bytes of slots, and maps it into this
+  // process as its producer.
+  static Status Create(const string& name, uint64 capacity,
+                       int64 slot_lease_micros, std::unique_ptr<ShmRing>* ring);
+
+  // Maps the existing shared memory object "name", which was created by
+  // Create() in another process, into this process as a consumer.
+  static Status Open(const string& name, std::unique_ptr<ShmRing>* ring);
+
+  const string& name() const { return name_; }
+  uint64 capacity() const { return capacity_; }
+
+  // Producer only. Allocates a slot for "size" bytes of data, which the
+  // caller must write to "slot->data" before handing out the location
+  // of the slot. Returns false if the ring has no room for it.
+  bool Allocate(uint64 size, Slot* slot);
+
+  // Consumer only. Copies the "size" bytes of data in the slot at
+  // "offset", which was allocated with "sequence", into "dst" and frees
+  // the slot.
+  Status Read(uint64 offset, uint64 size, uint64 sequence, char* dst);
+
+ private:
+  struct RingHeader;
+  struct SlotHeader;
+
+  ShmRing(const string& name, bool is_producer, char* base, uint64 capacity,
+          int64 slot_lease_micros);
+
+  SlotHeader* slot_header(uint64 offset) const;
+
+  // The state word of the slot at "offset". These are kept apart from
+  // the slots, so that a consumer never writes into the data of a slot,
+  // whatever offset it is asked to read.
+  std::atomic<uint64>* slot_state(uint64 offset) const;
+
+  // Advances tail_ past the slots that have been freed, or whose lease
+  // has expired.
+  void Reclaim() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string name_;
+  const bool is_producer_;
+  // The mapping: a RingHeader, the state words, and then the slots.
+  char* const base_;
+  const uint64 capacity_;
+  const int64 slot_lease_micros_;
+
+  // Producer state. Positions count bytes from the creation of the ring,
+  // so that head_ - tail_ is the number of bytes in use.
+  mutex mu_;
+  uint64 head_ GUARDED_BY(mu_) = 0;
+  uint64 tail_ GUARDED_BY(mu_) = 0;
+  uint64 next_sequence_ GUARDED_BY(mu_) = 1;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRing);
+};
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
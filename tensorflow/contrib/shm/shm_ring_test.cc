@@ -0,0 +1,211 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_ring.h"
+
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const int64 kNoExpiry = 3600LL * 1000 * 1000;
+
+string RingName(const string& test) {
+  return strings::StrCat("/tf_shm_ring_test_", test, "_", getpid());
+}
+
+// Allocates a slot holding "data" in "ring".
+bool Put(ShmRing* ring, const string& data, ShmRing::Slot* slot) {
+  if (!ring->Allocate(data.size(), slot)) return false;
+  memcpy(slot->data, data.data(), data.size());
+  return true;
+}
+
+Status Get(ShmRing* ring, const ShmRing::Slot& slot, string* data) {
+  data->resize(slot.size);
+  return ring->Read(slot.offset, slot.size, slot.sequence, &(*data)[0]);
+}
+
+TEST(ShmRingTest, ReadWrite) {
+  std::unique_ptr<ShmRing> producer;
+  TF_ASSERT_OK(ShmRing::Create(RingName("rw"), 1024, kNoExpiry, &producer));
+  std::unique_ptr<ShmRing> consumer;
+  TF_ASSERT_OK(ShmRing::Open(producer->name(), &consumer));
+  EXPECT_EQ(1024u, consumer->capacity());
+
+  ShmRing::Slot a, b;
+  ASSERT_TRUE(Put(producer.get(), "hello", &a));
+  ASSERT_TRUE(Put(producer.get(), string(300, 'x'), &b));
+  string data;
+  TF_EXPECT_OK(Get(consumer.get(), b, &data));
+  EXPECT_EQ(string(300, 'x'), data);
+  TF_EXPECT_OK(Get(consumer.get(), a, &data));
+  EXPECT_EQ("hello", data);
+  // Each slot can only be read once.
+  EXPECT_TRUE(errors::IsAborted(Get(consumer.get(), a, &data)));
+  // Locations outside of the ring are rejected.
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      consumer->Read(1024, 0, a.sequence, &data[0])));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      consumer->Read(0, 1024, a.sequence, &data[0])));
+}
+
+TEST(ShmRingTest, ReadInsideSlot) {
+  std::unique_ptr<ShmRing> producer;
+  TF_ASSERT_OK(ShmRing::Create(RingName("inside"), 1024, kNoExpiry, &producer));
+  std::unique_ptr<ShmRing> consumer;
+  TF_ASSERT_OK(ShmRing::Open(producer->name(), &consumer));
+
+  // Data that looks like a slot in use, whatever the slot layout.
+  string contents(256, '\0');
+  for (size_t i = 0; i < contents.size(); i += sizeof(uint64)) {
+    const uint64 one = 1;
+    memcpy(&contents[i], &one, sizeof(one));
+  }
+  ShmRing::Slot a;
+  ASSERT_TRUE(Put(producer.get(), contents, &a));
+  // A location inside "a" is not a slot, and reading it leaves the data
+  // of "a" alone.
+  string data(1, '\0');
+  EXPECT_FALSE(consumer->Read(a.offset + 64, 1, 1, &data[0]).ok());
+  EXPECT_FALSE(consumer->Read(a.offset + 64, 1, a.sequence, &data[0]).ok());
+  // Neither is "a" with the wrong size.
+  EXPECT_FALSE(consumer->Read(a.offset, 1, a.sequence, &data[0]).ok());
+  TF_EXPECT_OK(Get(consumer.get(), a, &data));
+  EXPECT_EQ(contents, data);
+}
+
+TEST(ShmRingTest, FullAndWrapAround) {
+  std::unique_ptr<ShmRing> producer;
+  TF_ASSERT_OK(ShmRing::Create(RingName("full"), 1024, kNoExpiry, &producer));
+  std::unique_ptr<ShmRing> consumer;
+  TF_ASSERT_OK(ShmRing::Open(producer->name(), &consumer));
+
+  ShmRing::Slot slot;
+  EXPECT_FALSE(producer->Allocate(1024, &slot));
+
+  // Each slot takes 64 bytes of header and 320 of data.
+  ShmRing::Slot a, b, c;
+  ASSERT_TRUE(Put(producer.get(), string(300, 'a'), &a));
+  ASSERT_TRUE(Put(producer.get(), string(300, 'b'), &b));
+  EXPECT_FALSE(producer->Allocate(300, &slot));
+
+  // Freeing "b" does not make room, since slots are reused in order.
+  string data;
+  TF_EXPECT_OK(Get(consumer.get(), b, &data));
+  EXPECT_FALSE(producer->Allocate(300, &slot));
+
+  // "c" wraps around to the start of the ring.
+  TF_EXPECT_OK(Get(consumer.get(), a, &data));
+  ASSERT_TRUE(Put(producer.get(), string(600, 'c'), &c));
+  EXPECT_EQ(0u, c.offset);
+  TF_EXPECT_OK(Get(consumer.get(), c, &data));
+  EXPECT_EQ(string(600, 'c'), data);
+}
+
+TEST(ShmRingTest, LeaseExpiry) {
+  std::unique_ptr<ShmRing> producer;
+  TF_ASSERT_OK(ShmRing::Create(RingName("lease"), 1024, 0, &producer));
+  std::unique_ptr<ShmRing> consumer;
+  TF_ASSERT_OK(ShmRing::Open(producer->name(), &consumer));
+
+  ShmRing::Slot a, b;
+  ASSERT_TRUE(Put(producer.get(), string(600, 'a'), &a));
+  // "a" is taken back, and its space reused, since it was not read in
+  // time.
+  ASSERT_TRUE(Put(producer.get(), string(600, 'b'), &b));
+  EXPECT_EQ(a.offset, b.offset);
+  string data;
+  EXPECT_TRUE(errors::IsAborted(Get(consumer.get(), a, &data)));
+  TF_EXPECT_OK(Get(consumer.get(), b, &data));
+  EXPECT_EQ(string(600, 'b'), data);
+}
+
+TEST(ShmRingTest, OpenMissing) {
+  std::unique_ptr<ShmRing> consumer;
+  EXPECT_FALSE(ShmRing::Open(RingName("missing"), &consumer).ok());
+}
+
+// Passes data from this process to a child process through the ring,
+// sending the slot locations through a pipe.
+TEST(ShmRingTest, MultiProcess) {
+  const int kNumSlots = 1000;
+  std::unique_ptr<ShmRing> producer;
+  TF_ASSERT_OK(
+      ShmRing::Create(RingName("multi"), 64 * 1024, kNoExpiry, &producer));
+  int locations[2];
+  int acks[2];
+  ASSERT_EQ(0, pipe(locations));
+  ASSERT_EQ(0, pipe(acks));
+
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // In the child: read every slot, and check its contents.
+    close(locations[1]);
+    close(acks[0]);
+    std::unique_ptr<ShmRing> consumer;
+    if (!ShmRing::Open(producer->name(), &consumer).ok()) _exit(1);
+    for (int i = 0; i < kNumSlots; ++i) {
+      ShmRing::Slot slot;
+      if (read(locations[0], &slot, sizeof(slot)) != sizeof(slot)) _exit(2);
+      string data;
+      if (!Get(consumer.get(), slot, &data).ok()) _exit(3);
+      if (data != string(slot.size, 'a' + i % 26)) _exit(4);
+      char ack = 0;
+      if (write(acks[1], &ack, 1) != 1) _exit(5);
+    }
+    _exit(0);
+  }
+
+  close(locations[0]);
+  close(acks[1]);
+  int in_flight = 0;
+  for (int i = 0; i < kNumSlots; ++i) {
+    ShmRing::Slot slot;
+    const string data(1 + (i * 997) % 20000, 'a' + i % 26);
+    // Waits for the child to free slots while the ring is full.
+    while (!Put(producer.get(), data, &slot)) {
+      ASSERT_GT(in_flight, 0);
+      char ack;
+      ASSERT_EQ(1, read(acks[0], &ack, 1));
+      --in_flight;
+    }
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(slot)),
+              write(locations[1], &slot, sizeof(slot)));
+    ++in_flight;
+  }
+  close(locations[1]);
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  close(acks[0]);
+
+  // All slots were freed by the child, so there is room for half of the
+  // ring wherever its head is.
+  ShmRing::Slot slot;
+  EXPECT_TRUE(producer->Allocate(32 * 1024 - 64, &slot));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,164 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/shm_server_lib.h"
+
+#include "tensorflow/contrib/shm/shm_mgr.h"
+#include "tensorflow/contrib/shm/shm_rendezvous_mgr.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+namespace {
+// static utility function
+RendezvousMgrInterface* NewShmRendezvousMgr(const WorkerEnv* env) {
+  return new ShmRendezvousMgr(env);
+}
+
+}  // namespace
+
+ShmServer::ShmServer(const ServerDef& server_def, Env* env)
+    : GrpcServer(server_def, env), shm_state_(STOPPED) {}
+
+ShmServer::~ShmServer() {
+  TF_CHECK_OK(Stop());
+  TF_CHECK_OK(Join());
+  delete shm_mgr_;
+  delete shm_service_;
+  delete channel_cache_;
+}
+
+Status ShmServer::ChannelCacheFactory(const ServerDef& server_def,
+                                      GrpcChannelCache** channel_cache) {
+  string name_prefix =
+      strings::StrCat("/job:", server_def.job_name(), "/replica:0",
+                      "/task:", server_def.task_index());
+
+  GrpcChannelSpec channel_spec;
+  TF_RETURN_IF_ERROR(ParseChannelSpec(server_def, &channel_spec));
+
+  *channel_cache =
+      NewGrpcChannelCache(channel_spec, GetChannelCreationFunction());
+
+  const string host_port = (*channel_cache)->TranslateTask(name_prefix);
+  int requested_port;
+
+  if (!strings::safe_strto32(str_util::Split(host_port, ':')[1],
+                             &requested_port)) {
+    return errors::Internal("Could not parse port for local server from \"",
+                            (*channel_cache)->TranslateTask(name_prefix),
+                            "\".");
+  }
+  if (requested_port != bound_port()) {
+    return errors::InvalidArgument("Requested port ", requested_port,
+                                   " differs from expected port ",
+                                   bound_port());
+  }
+
+  return Status::OK();
+}
+
+Status ShmServer::Init(ServiceInitFunction service_func,
+                       RendezvousMgrCreationFunction rendezvous_mgr_func) {
+  TF_RETURN_IF_ERROR(GrpcServer::Init(service_func, rendezvous_mgr_func));
+  mutex_lock l(mu_);
+  CHECK_EQ(shm_state_, STOPPED);
+  TF_RETURN_IF_ERROR(ChannelCacheFactory(server_def(), &channel_cache_));
+  shm_mgr_ = new ShmMgr(worker_env(), channel_cache_);
+  // set shm_mgr for shm_service and shm_rendezvous_mgr
+  shm_service_->SetShmMgr(shm_mgr_);
+  dynamic_cast<ShmRendezvousMgr*>(worker_env()->rendezvous_mgr)
+      ->SetShmMgr(shm_mgr_);
+  return Status::OK();
+}
+
+Status ShmServer::Start() {
+  Status s = GrpcServer::Start();
+  {
+    mutex_lock l(mu_);
+    if (shm_state_ == STOPPED) {
+      shm_thread_.reset(worker_env()->env->StartThread(
+          ThreadOptions(), "TF_shm_service",
+          [this] { shm_service_->HandleRPCsLoop(); }));
+      shm_state_ = STARTED;
+    }
+  }
+  return s;
+}
+
+Status ShmServer::Join() {
+  Status s = GrpcServer::Join();
+  {
+    mutex_lock l(mu_);
+    if (shm_state_ == STARTED) {
+      shm_state_ = STOPPED;
+      shm_thread_.reset();
+    }
+  }
+  return s;
+}
+
+/* static */
+Status ShmServer::Create(const ServerDef& server_def, Env* env,
+                         std::unique_ptr<ServerInterface>* out_server) {
+  std::unique_ptr<ShmServer> ret(new ShmServer(server_def, Env::Default()));
+  ServiceInitFunction service_func = [&ret](const WorkerEnv* worker_env,
+                                            ::grpc::ServerBuilder* builder) {
+    return SetNewShmService(&ret->shm_service_, worker_env, builder);
+  };
+  TF_RETURN_IF_ERROR(ret->Init(service_func, NewShmRendezvousMgr));
+  *out_server = std::move(ret);
+  return Status::OK();
+}
+
+namespace {
+
+class ShmServerFactory : public ServerFactory {
+ public:
+  bool AcceptsOptions(const ServerDef& server_def) override {
+    return server_def.protocol() == "grpc+shm";
+  }
+
+  Status NewServer(const ServerDef& server_def,
+                   std::unique_ptr<ServerInterface>* out_server) override {
+    return ShmServer::Create(server_def, Env::Default(), out_server);
+  }
+};
+
+// Registers a `ServerFactory` for `ShmServer` instances.
+class ShmServerRegistrar {
+ public:
+  ShmServerRegistrar() {
+    gpr_allocation_functions alloc_fns;
+    alloc_fns.malloc_fn = port::Malloc;
+    alloc_fns.realloc_fn = port::Realloc;
+    alloc_fns.free_fn = port::Free;
+    gpr_set_allocation_functions(alloc_fns);
+    ServerFactory::Register("SHM_SERVER", new ShmServerFactory());
+  }
+};
+static ShmServerRegistrar registrar;
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
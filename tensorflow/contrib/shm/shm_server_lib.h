@@ -0,0 +1,66 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_SERVER_LIB_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_SERVER_LIB_H_
+
+#ifdef TENSORFLOW_USE_SHM
+
+#include "tensorflow/contrib/shm/grpc_shm_service.h"
+#include "tensorflow/contrib/shm/shm_mgr.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_server_lib.h"
+
+namespace tensorflow {
+
+class ShmServer : public GrpcServer {
+ protected:
+  ShmServer(const ServerDef& server_def, Env* env);
+
+ public:
+  static Status Create(const ServerDef& server_def, Env* env,
+                       std::unique_ptr<ServerInterface>* out_server);
+
+  // Destruction is only supported in the factory method. Clean
+  // shutdown is not currently implemented for this server type.
+  virtual ~ShmServer() override;
+
+  // Implementations of ServerInterface methods.
+  Status Start() override;
+  Status Join() override;
+
+ protected:
+  Status Init(ServiceInitFunction service_func,
+              RendezvousMgrCreationFunction rendezvous_mgr_func);
+  Status ChannelCacheFactory(const ServerDef& server_def,
+                             GrpcChannelCache** channel_cache);
+
+ private:
+  ShmMgr* shm_mgr_ = nullptr;
+
+  // Guards state transitions.
+  mutex mu_;
+
+  enum State { STOPPED, STARTED };
+  State shm_state_ GUARDED_BY(mu_);
+
+  GrpcShmService* shm_service_ = nullptr;
+  std::unique_ptr<Thread> shm_thread_ GUARDED_BY(mu_);
+  GrpcChannelCache* channel_cache_ = nullptr;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_USE_SHM
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_SHM_SHM_SERVER_LIB_H_
@@ -0,0 +1,302 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace {
+
+// The ops that the _FusedCwise kernel evaluates, and their number of inputs.
+const std::unordered_map<string, int>& FusibleOps() {
+  static const auto* ops = new std::unordered_map<string, int>({
+      {"Add", 2},
+      {"Sub", 2},
+      {"Mul", 2},
+      {"RealDiv", 2},
+      {"Maximum", 2},
+      {"Minimum", 2},
+      {"SquaredDifference", 2},
+      {"Neg", 1},
+      {"Abs", 1},
+      {"Square", 1},
+      {"Sqrt", 1},
+      {"Rsqrt", 1},
+      {"Exp", 1},
+      {"Log", 1},
+      {"Tanh", 1},
+      {"Sigmoid", 1},
+      {"Relu", 1},
+  });
+  return *ops;
+}
+
+// Returns the dimensions of "shape", or false if it is not fully defined.
+bool StaticShape(shape_inference::InferenceContext* c,
+                 shape_inference::ShapeHandle shape, std::vector<int64>* dims) {
+  if (!c->FullyDefined(shape)) return false;
+  dims->clear();
+  for (int i = 0; i < c->Rank(shape); ++i) {
+    dims->push_back(c->Value(c->Dim(shape, i)));
+  }
+  return true;
+}
+
+// Returns true if "n" is a supported element-wise op of float or double on a
+// CPU device whose inputs are scalars or have the same static, non-scalar
+// shape as its output.
+bool IsFusible(const Node* n, const ShapeRefiner& refiner, DataType* dtype) {
+  if (!n->IsOp()) return false;
+  auto it = FusibleOps().find(n->type_string());
+  if (it == FusibleOps().end() || n->num_inputs() != it->second ||
+      n->num_outputs() != 1) {
+    return false;
+  }
+  DeviceNameUtils::ParsedName device;
+  if (!DeviceNameUtils::ParseFullName(n->assigned_device_name(), &device) ||
+      device.type != DEVICE_CPU) {
+    return false;
+  }
+  if (!GetNodeAttr(n->attrs(), "T", dtype).ok() ||
+      (*dtype != DT_FLOAT && *dtype != DT_DOUBLE)) {
+    return false;
+  }
+  shape_inference::InferenceContext* c = refiner.GetContext(n);
+  if (c == nullptr) return false;
+  std::vector<int64> output_dims;
+  if (!StaticShape(c, c->output(0), &output_dims) || output_dims.empty()) {
+    return false;
+  }
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    std::vector<int64> input_dims;
+    if (!StaticShape(c, c->input(i), &input_dims)) return false;
+    if (!input_dims.empty() && input_dims != output_dims) return false;
+  }
+  return true;
+}
+
+// A cluster of fusible nodes: a tree rooted at "root" in which every other
+// node has a single out edge, to another node of the cluster.
+struct Cluster {
+  Node* root;
+  DataType dtype;
+  std::unordered_set<const Node*> members;
+};
+
+// Builds the attrs of the _FusedCwise node of a cluster.
+class TapeBuilder {
+ public:
+  explicit TapeBuilder(const Cluster& cluster) : cluster_(cluster) {}
+
+  Status Build(std::vector<NodeBuilder::NodeOut>* inputs,
+               std::vector<string>* ops, std::vector<int>* operands) {
+    int root_op;
+    TF_RETURN_IF_ERROR(Emit(cluster_.root, &root_op));
+    // Operation i is register N + i, where N is the number of inputs.
+    const int num_inputs = inputs_.size();
+    for (const auto& operand : operands_) {
+      if (operand.index < 0) {
+        operands->push_back(-1);
+      } else {
+        operands->push_back(operand.is_input ? operand.index
+                                             : num_inputs + operand.index);
+      }
+    }
+    *inputs = std::move(inputs_);
+    *ops = std::move(ops_);
+    return Status::OK();
+  }
+
+ private:
+  struct Operand {
+    bool is_input;
+    int index;  // -1 for the second operand of unary ops.
+  };
+
+  // Emits the operations of the subtree rooted at "n" in post-order, and
+  // sets "*op" to the index of the operation of "n".
+  Status Emit(const Node* n, int* op) {
+    Operand args[2] = {{true, -1}, {true, -1}};
+    for (int i = 0; i < n->num_inputs(); ++i) {
+      const Edge* e;
+      TF_RETURN_IF_ERROR(n->input_edge(i, &e));
+      if (cluster_.members.count(e->src()) > 0) {
+        int src_op;
+        TF_RETURN_IF_ERROR(Emit(e->src(), &src_op));
+        args[i] = {false, src_op};
+      } else {
+        args[i] = {true, InputIndex(e->src(), e->src_output())};
+      }
+    }
+    ops_.push_back(n->type_string());
+    operands_.push_back(args[0]);
+    operands_.push_back(args[1]);
+    *op = static_cast<int>(ops_.size()) - 1;
+    return Status::OK();
+  }
+
+  int InputIndex(Node* src, int src_output) {
+    for (int i = 0; i < inputs_.size(); ++i) {
+      if (inputs_[i].node == src && inputs_[i].index == src_output) return i;
+    }
+    inputs_.emplace_back(src, src_output);
+    return static_cast<int>(inputs_.size()) - 1;
+  }
+
+  const Cluster& cluster_;
+  std::vector<NodeBuilder::NodeOut> inputs_;
+  std::vector<string> ops_;
+  std::vector<Operand> operands_;
+};
+
+// Replaces the nodes of "cluster" with a single _FusedCwise node that takes
+// the name, device and out edges of its root.
+Status FuseCluster(const Cluster& cluster, Graph* g) {
+  std::vector<NodeBuilder::NodeOut> inputs;
+  std::vector<string> ops;
+  std::vector<int> operands;
+  TF_RETURN_IF_ERROR(TapeBuilder(cluster).Build(&inputs, &ops, &operands));
+
+  std::unordered_set<Node*> control_inputs;
+  for (const Node* n : cluster.members) {
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) control_inputs.insert(e->src());
+    }
+  }
+  std::vector<Node*> out_control_edges;
+  std::vector<std::pair<Node*, int>> out_edges;
+  for (const Edge* e : cluster.root->out_edges()) {
+    if (e->IsControlEdge()) {
+      out_control_edges.push_back(e->dst());
+    } else {
+      out_edges.push_back({e->dst(), e->dst_input()});
+    }
+  }
+  const string name = cluster.root->name();
+  const string requested_device = cluster.root->requested_device();
+  const string assigned_device = cluster.root->assigned_device_name();
+  for (const Node* n : cluster.members) {
+    g->RemoveNode(const_cast<Node*>(n));
+  }
+
+  NodeBuilder builder(name, "_FusedCwise");
+  builder.Input(inputs)
+      .Attr("T", cluster.dtype)
+      .Attr("ops", ops)
+      .Attr("operands", operands)
+      .Device(requested_device);
+  for (Node* n : control_inputs) {
+    builder.ControlInput(n);
+  }
+  Node* fused;
+  TF_RETURN_IF_ERROR(builder.Finalize(g, &fused));
+  fused->set_assigned_device_name(assigned_device);
+  for (Node* n : out_control_edges) {
+    g->AddControlEdge(fused, n);
+  }
+  for (const std::pair<Node*, int>& p : out_edges) {
+    g->AddEdge(fused, 0, p.first, p.second);
+  }
+  VLOG(2) << "Fused " << ops.size() << " element-wise ops into " << name;
+  return Status::OK();
+}
+
+// Replaces chains of element-wise ops on CPU devices with _FusedCwise nodes,
+// which evaluate them in one pass over cache-sized blocks instead of making a
+// round-trip through memory for each op. Only ops with static shapes are
+// fused, so that the fused node never has to broadcast.
+class CwiseFusionPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override {
+    if (options.session_options == nullptr ||
+        !options.session_options->config.graph_options()
+             .optimizer_options()
+             .do_elementwise_fusion()) {
+      return Status::OK();
+    }
+    if (options.graph == nullptr || options.graph->get() == nullptr) {
+      return errors::Internal(
+          "Element-wise fusion should happen before partitioning and a graph "
+          "should be available.");
+    }
+    Graph* g = options.graph->get();
+
+    // Shape inference fails for the nodes downstream of unsupported ops,
+    // which are then not fused.
+    ShapeRefiner refiner(g->versions().producer(), g->op_registry());
+    refiner.set_require_shape_inference_fns(false);
+    std::vector<Node*> order;
+    GetReversePostOrder(*g, &order);
+    for (Node* n : order) {
+      refiner.AddNode(n).IgnoreError();
+    }
+
+    // Grow a cluster from every fusible node not yet in a cluster, visiting
+    // consumers before producers, into the fusible producers whose only out
+    // edge is to the cluster.
+    std::unordered_set<const Node*> clustered;
+    std::vector<Cluster> clusters;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      Node* root = *it;
+      DataType dtype;
+      if (clustered.count(root) > 0 || !IsFusible(root, refiner, &dtype)) {
+        continue;
+      }
+      Cluster cluster{root, dtype, {root}};
+      std::vector<const Node*> stack = {root};
+      while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+        for (const Edge* e : n->in_edges()) {
+          const Node* src = e->src();
+          DataType src_dtype;
+          if (e->IsControlEdge() || src->out_edges().size() != 1 ||
+              clustered.count(src) > 0 ||
+              src->assigned_device_name() != root->assigned_device_name() ||
+              !IsFusible(src, refiner, &src_dtype) || src_dtype != dtype) {
+            continue;
+          }
+          cluster.members.insert(src);
+          clustered.insert(src);
+          stack.push_back(src);
+        }
+      }
+      clustered.insert(root);
+      if (cluster.members.size() > 1) {
+        clusters.push_back(std::move(cluster));
+      }
+    }
+
+    for (const Cluster& cluster : clusters) {
+      TF_RETURN_IF_ERROR(FuseCluster(cluster, g));
+    }
+    return Status::OK();
+  }
+};
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, 1,
+                      CwiseFusionPass);
+
+}  // namespace
+}  // namespace tensorflow
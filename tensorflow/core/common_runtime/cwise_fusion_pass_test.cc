@@ -0,0 +1,145 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+const char* const kDevice = "/job:localhost/replica:0/task:0/cpu:0";
+
+class CwiseFusionPassTest : public ::testing::Test {
+ protected:
+  CwiseFusionPassTest() : g_(new Graph(OpRegistry::Global())) {
+    session_options_.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_do_elementwise_fusion(true);
+  }
+
+  Node* Constant(const TensorShape& shape) {
+    Tensor t(DT_FLOAT, shape);
+    t.flat<float>().setZero();
+    return Place(test::graph::Constant(g_.get(), t));
+  }
+
+  Node* Place(Node* n) {
+    n->set_assigned_device_name(kDevice);
+    return n;
+  }
+
+  void Fetch(Node* n) {
+    Place(test::graph::Send(g_.get(), n, "out", kDevice, 1, kDevice));
+  }
+
+  Status Optimize() {
+    FixupSourceAndSinkEdges(g_.get());
+    GraphOptimizationPassOptions options;
+    options.session_options = &session_options_;
+    options.graph = &g_;
+    return OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, options);
+  }
+
+  std::vector<const Node*> NodesOfType(const string& type) {
+    std::vector<const Node*> nodes;
+    for (const Node* n : g_->op_nodes()) {
+      if (n->type_string() == type) nodes.push_back(n);
+    }
+    return nodes;
+  }
+
+  SessionOptions session_options_;
+  std::unique_ptr<Graph> g_;
+};
+
+TEST_F(CwiseFusionPassTest, FusesChain) {
+  Node* x = Constant(TensorShape({2, 3}));
+  Node* y = Constant(TensorShape({2, 3}));
+  Node* one = Constant(TensorShape({}));
+  Node* mul = Place(test::graph::Binary(g_.get(), "Mul", x, y));
+  Node* add = Place(test::graph::Binary(g_.get(), "Add", mul, one));
+  Node* relu = Place(test::graph::Unary(g_.get(), "Relu", add));
+  const string relu_name = relu->name();
+  Fetch(relu);
+  TF_ASSERT_OK(Optimize());
+
+  EXPECT_TRUE(NodesOfType("Mul").empty());
+  EXPECT_TRUE(NodesOfType("Add").empty());
+  EXPECT_TRUE(NodesOfType("Relu").empty());
+  std::vector<const Node*> fused = NodesOfType("_FusedCwise");
+  ASSERT_EQ(1, fused.size());
+  const Node* f = fused[0];
+  EXPECT_EQ(relu_name, f->name());
+  EXPECT_EQ(kDevice, f->assigned_device_name());
+  ASSERT_EQ(3, f->num_inputs());
+  std::vector<string> ops;
+  TF_ASSERT_OK(GetNodeAttr(f->attrs(), "ops", &ops));
+  EXPECT_EQ(std::vector<string>({"Mul", "Add", "Relu"}), ops);
+  std::vector<int> operands;
+  TF_ASSERT_OK(GetNodeAttr(f->attrs(), "operands", &operands));
+  EXPECT_EQ(std::vector<int>({0, 1, 3, 2, 4, -1}), operands);
+  ASSERT_EQ(1, f->out_edges().size());
+  EXPECT_TRUE((*f->out_edges().begin())->dst()->IsSend());
+}
+
+TEST_F(CwiseFusionPassTest, DoesNotFuseSharedOutputs) {
+  Node* x = Constant(TensorShape({4}));
+  Node* neg = Place(test::graph::Unary(g_.get(), "Neg", x));
+  Node* exp = Place(test::graph::Unary(g_.get(), "Exp", neg));
+  Node* abs = Place(test::graph::Unary(g_.get(), "Abs", neg));
+  Fetch(exp);
+  Fetch(abs);
+  TF_ASSERT_OK(Optimize());
+
+  // Neg has two consumers, so each of Neg, Exp and Abs is its own cluster.
+  EXPECT_TRUE(NodesOfType("_FusedCwise").empty());
+  EXPECT_EQ(1, NodesOfType("Neg").size());
+}
+
+TEST_F(CwiseFusionPassTest, DoesNotFuseBroadcasts) {
+  Node* x = Constant(TensorShape({2, 3}));
+  Node* y = Constant(TensorShape({3}));
+  Node* add = Place(test::graph::Binary(g_.get(), "Add", x, y));
+  Node* tanh = Place(test::graph::Unary(g_.get(), "Tanh", add));
+  Fetch(tanh);
+  TF_ASSERT_OK(Optimize());
+
+  EXPECT_TRUE(NodesOfType("_FusedCwise").empty());
+}
+
+TEST_F(CwiseFusionPassTest, Disabled) {
+  session_options_.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_do_elementwise_fusion(false);
+  Node* x = Constant(TensorShape({4}));
+  Node* neg = Place(test::graph::Unary(g_.get(), "Neg", x));
+  Fetch(Place(test::graph::Unary(g_.get(), "Exp", neg)));
+  TF_ASSERT_OK(Optimize());
+
+  EXPECT_TRUE(NodesOfType("_FusedCwise").empty());
+}
+
+}  // namespace
+}  // namespace tensorflow
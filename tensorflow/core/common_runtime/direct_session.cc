@@ -25,6 +25,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
+#include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/simple_placer.h"
@@ -36,11 +38,14 @@ limitations under the License.
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/refcount.h"
@@ -55,6 +60,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/env_var.h"
@@ -98,6 +104,43 @@ thread::ThreadPool* NewThreadPoolFromThreadPoolOptions(
       options.env, strings::StrCat("Compute", pool_number), num_threads);
 }
 
+WorkStealingThreadPool* NewWorkStealingThreadPool(const SessionOptions& options,
+                                                  int32 num_threads,
+                                                  int pool_number) {
+  if (num_threads == 0) {
+    num_threads = NumInterOpThreadsFromSessionOptions(options);
+  }
+  VLOG(1) << "Direct session work-stealing inter op parallelism threads for "
+          << "pool " << pool_number << ": " << num_threads;
+  return new WorkStealingThreadPool(
+      options.env, strings::StrCat("Compute", pool_number), num_threads);
+}
+
+// Creates one pool of type "Pool" per NUMA node for inter-op pool
+// "pool_number", with its "num_threads" threads split evenly between the
+// nodes.
+template <typename Pool>
+void NewNUMAThreadPools(const SessionOptions& options, int32 num_threads,
+                        int pool_number,
+                        std::vector<std::unique_ptr<Pool>>* pools) {
+  if (num_threads == 0) {
+    num_threads = NumInterOpThreadsFromSessionOptions(options);
+  }
+  const int num_numa_nodes = port::NUMANumNodes();
+  const int32 num_threads_per_node =
+      (num_threads + num_numa_nodes - 1) / num_numa_nodes;
+  VLOG(1) << "Direct session inter op parallelism threads per NUMA node for "
+          << "pool " << pool_number << ": " << num_threads_per_node;
+  for (int i = 0; i < num_numa_nodes; ++i) {
+    ThreadOptions thread_options;
+    thread_options.numa_node = i;
+    pools->emplace_back(
+        new Pool(options.env, thread_options,
+                 strings::StrCat("Compute", pool_number, "_numa", i),
+                 num_threads_per_node));
+  }
+}
+
 thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   static thread::ThreadPool* const thread_pool =
       NewThreadPoolFromSessionOptions(options);
@@ -116,6 +159,28 @@ string GetRendezvousKey(const string& tensor_name,
                          frame_iter.frame_id, ":", frame_iter.iter_id);
 }
 
+// Computes the size in bytes of the outputs of the nodes of "graph_def"
+// whose shapes can be inferred statically, for planning their memory.
+Status InferOutputSizes(const GraphDef& graph_def, OutputSizes* sizes) {
+  grappler::GrapplerItem item;
+  item.graph = graph_def;
+  grappler::GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  for (const NodeDef& node : graph_def.node()) {
+    if (!properties.HasOutputProperties(node.name())) continue;
+    std::vector<int64>& node_sizes = (*sizes)[node.name()];
+    for (const OpInfo::TensorProperties& output :
+         properties.GetOutputProperties(node.name())) {
+      const PartialTensorShape shape(output.shape());
+      node_sizes.push_back(shape.IsFullyDefined()
+                               ? shape.num_elements() *
+                                     DataTypeSize(output.dtype())
+                               : -1);
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 class DirectSessionFactory : public SessionFactory {
@@ -221,6 +286,56 @@ void DirectSession::SchedClosure(thread::ThreadPool* pool,
 #endif  // __ANDROID__
 }
 
+int DirectSession::NumInterOpThreadPools() const {
+  if (!work_stealing_pools_.empty()) return work_stealing_pools_.size();
+  return thread_pools_.size();
+}
+
+Executor::Args::Runner DirectSession::NUMARunner(int pool_index,
+                                                 int numa_node) {
+  if (numa_node < 0) return nullptr;
+  const size_t node = static_cast<size_t>(numa_node);
+  if (!numa_work_stealing_pools_.empty()) {
+    if (node >= numa_work_stealing_pools_[pool_index].size()) return nullptr;
+    WorkStealingThreadPool* pool =
+        numa_work_stealing_pools_[pool_index][node].get();
+    return [pool](Executor::Args::Closure c) { pool->Schedule(std::move(c)); };
+  }
+  if (numa_thread_pools_.empty() ||
+      node >= numa_thread_pools_[pool_index].size()) {
+    return nullptr;
+  }
+  thread::ThreadPool* pool = numa_thread_pools_[pool_index][node].get();
+  return [this, pool](Executor::Args::Closure c) {
+    SchedClosure(pool, std::move(c));
+  };
+}
+
+void DirectSession::RunPartitionAsync(const PerPartitionExecutorsAndLib& item,
+                                      int pool_index,
+                                      const Executor::Args& args,
+                                      Executor::DoneCallback done) {
+  Executor::Args::Runner numa_runner = NUMARunner(pool_index, item.numa_node);
+  if (numa_runner == nullptr) {
+    item.executor->RunAsync(args, std::move(done));
+    return;
+  }
+  Executor::Args numa_args = args;
+  numa_args.runner = std::move(numa_runner);
+  item.executor->RunAsync(numa_args, std::move(done));
+}
+
+Executor::Args::Runner DirectSession::InterOpRunner(int pool_index) {
+  if (!work_stealing_pools_.empty()) {
+    WorkStealingThreadPool* pool = work_stealing_pools_[pool_index].get();
+    return [pool](Executor::Args::Closure c) { pool->Schedule(std::move(c)); };
+  }
+  thread::ThreadPool* pool = thread_pools_[pool_index];
+  return [this, pool](Executor::Args::Closure c) {
+    SchedClosure(pool, std::move(c));
+  };
+}
+
 DirectSession::DirectSession(const SessionOptions& options,
                              const DeviceMgr* device_mgr,
                              DirectSessionFactory* const factory)
@@ -229,7 +344,19 @@ DirectSession::DirectSession(const SessionOptions& options,
       factory_(factory),
       cancellation_manager_(new CancellationManager()),
       operation_timeout_in_ms_(options_.config.operation_timeout_in_ms()) {
-  if (options_.config.session_inter_op_thread_pool_size() > 0) {
+  if (options_.config.use_work_stealing_inter_op_scheduler()) {
+    if (options_.config.session_inter_op_thread_pool_size() > 0) {
+      for (int i = 0; i < options_.config.session_inter_op_thread_pool_size();
+           ++i) {
+        work_stealing_pools_.emplace_back(NewWorkStealingThreadPool(
+            options_,
+            options_.config.session_inter_op_thread_pool(i).num_threads(), i));
+      }
+    } else {
+      work_stealing_pools_.emplace_back(NewWorkStealingThreadPool(
+          options_, options_.config.inter_op_parallelism_threads(), 0));
+    }
+  } else if (options_.config.session_inter_op_thread_pool_size() > 0) {
     for (int i = 0; i < options_.config.session_inter_op_thread_pool_size();
          ++i) {
       thread_pools_.push_back(NewThreadPoolFromThreadPoolOptions(
@@ -243,6 +370,26 @@ DirectSession::DirectSession(const SessionOptions& options,
     thread_pools_.push_back(GlobalThreadPool(options));
     owns_thread_pools_ = false;
   }
+  if (options_.config.use_numa_affinity() && port::NUMANumNodes() > 1) {
+    // Each inter-op pool is split into one pool per NUMA node, of the same
+    // kind, so that RunOptions.inter_op_thread_pool and the work-stealing
+    // scheduler apply to the partitions of the NUMA devices too.
+    for (int i = 0; i < NumInterOpThreadPools(); ++i) {
+      const int32 num_threads =
+          options_.config.session_inter_op_thread_pool_size() > 0
+              ? options_.config.session_inter_op_thread_pool(i).num_threads()
+              : options_.config.inter_op_parallelism_threads();
+      if (!work_stealing_pools_.empty()) {
+        numa_work_stealing_pools_.emplace_back();
+        NewNUMAThreadPools(options_, num_threads, i,
+                           &numa_work_stealing_pools_.back());
+      } else {
+        numa_thread_pools_.emplace_back();
+        NewNUMAThreadPools(options_, num_threads, i,
+                           &numa_thread_pools_.back());
+      }
+    }
+  }
   // The default value of sync_on_finish will be flipped soon and this
   // environment variable will be removed as well.
   Status status =
@@ -293,6 +440,9 @@ DirectSession::~DirectSession() {
   if (owns_thread_pools_) {
     for (auto* p : thread_pools_) delete p;
   }
+  work_stealing_pools_.clear();
+  numa_thread_pools_.clear();
+  numa_work_stealing_pools_.clear();
 
   execution_state_.reset(nullptr);
   flib_def_.reset(nullptr);
@@ -419,11 +569,10 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 
   if (run_options.inter_op_thread_pool() < 0 ||
-      run_options.inter_op_thread_pool() >= thread_pools_.size()) {
+      run_options.inter_op_thread_pool() >= NumInterOpThreadPools()) {
     return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
                                    run_options.inter_op_thread_pool());
   }
-  thread::ThreadPool* pool = thread_pools_[run_options.inter_op_thread_pool()];
 
   // Check if we already have an executor for these arguments.
   ExecutorsAndKeys* executors_and_keys;
@@ -432,9 +581,9 @@ Status DirectSession::Run(const RunOptions& run_options,
   Executor::Args args;
   args.step_id = step_id_counter_.fetch_add(1);
 
-  TF_RETURN_IF_ERROR(
-      GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
-                           &executors_and_keys, &run_state_args));
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(input_tensor_names, output_names,
+                                          target_nodes, &executors_and_keys,
+                                          &run_state_args));
   const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
 
   std::unique_ptr<DebuggerStateInterface> debugger_state;
@@ -486,9 +635,8 @@ Status DirectSession::Run(const RunOptions& run_options,
 
   args.rendezvous = run_state.rendez;
   args.cancellation_manager = &step_cancellation_manager;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  const int pool_index = run_options.inter_op_thread_pool();
+  args.runner = InterOpRunner(pool_index);
   args.session_state = &session_state_;
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
@@ -545,7 +693,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   }
 
   for (const auto& item : executors_and_keys->items) {
-    item.executor->RunAsync(args, barrier->Get());
+    RunPartitionAsync(item, pool_index, args, barrier->Get());
   }
 
   WaitForNotification(&run_state, &step_cancellation_manager,
@@ -608,6 +756,19 @@ Status DirectSession::Run(const RunOptions& run_options,
     }
     args.stats_collector->BuildCostModel(&cost_model_manager_, device_to_graph);
 
+    if (options_.config.graph_options().schedule_by_cost_model()) {
+      for (const PerPartitionExecutorsAndLib& partition :
+           executors_and_keys->items) {
+        const CostModel* cost_model =
+            cost_model_manager_.FindOrCreateCostModel(partition.graph);
+        std::vector<int64> costs(partition.graph->num_node_ids(), 0);
+        for (const Node* n : partition.graph->op_nodes()) {
+          costs[n->id()] = cost_model->TimeEstimate(n).value();
+        }
+        partition.executor->SetNodeCosts(costs);
+      }
+    }
+
     // annotate stats onto cost graph.
     CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
     for (const auto& item : executors_and_keys->items) {
@@ -643,16 +804,13 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
     }
   }
 
-  // RunOptions is not available in PRunSetup, so use thread pool 0.
-  thread::ThreadPool* pool = thread_pools_[0];
-
   // Check if we already have an executor for these arguments.
   ExecutorsAndKeys* executors_and_keys;
   // TODO(cais): TFDBG support for partial runs.
   DebugOptions debug_options;
   RunStateArgs run_state_args(debug_options);
   run_state_args.is_partial_run = true;
-  TF_RETURN_IF_ERROR(GetOrCreateExecutors(pool, input_names, output_names,
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(input_names, output_names,
                                           target_nodes, &executors_and_keys,
                                           &run_state_args));
 
@@ -686,9 +844,8 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
 
   args.rendezvous = run_state->rendez;
   args.cancellation_manager = cancellation_manager_;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  // RunOptions is not available in PRunSetup, so use thread pool 0.
+  args.runner = InterOpRunner(0);
   args.session_state = &session_state_;
   args.tensor_store = &run_state->tensor_store;
   args.step_container = &run_state->step_container;
@@ -703,7 +860,7 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   }
 
   for (auto& item : executors_and_keys->items) {
-    item.executor->RunAsync(args, barrier->Get());
+    RunPartitionAsync(item, 0, args, barrier->Get());
   }
 
   *handle = run_state_args.handle;
@@ -978,9 +1135,9 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
 }
 
 Status DirectSession::GetOrCreateExecutors(
-    thread::ThreadPool* pool, gtl::ArraySlice<string> inputs,
-    gtl::ArraySlice<string> outputs, gtl::ArraySlice<string> target_nodes,
-    ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args) {
+    gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
+    gtl::ArraySlice<string> target_nodes, ExecutorsAndKeys** executors_and_keys,
+    RunStateArgs* run_state_args) {
   int64 handle_name_counter_value = -1;
   if (LogMemory::IsEnabled() || run_state_args->is_partial_run) {
     handle_name_counter_value = handle_name_counter_.fetch_add(1);
@@ -1084,6 +1241,24 @@ Status DirectSession::GetOrCreateExecutors(
       }
     }
   }
+  // The shapes of the placeholders are only known in the original graph,
+  // where the fed nodes have not been replaced yet.
+  std::unique_ptr<OutputSizes> output_sizes;
+  if (options_.config.use_static_memory_plan() &&
+      !run_state_args->is_partial_run) {
+    output_sizes.reset(new OutputSizes);
+    Status s;
+    {
+      mutex_lock l(graph_def_lock_);
+      s = InferOutputSizes(execution_state_->original_graph_def(),
+                           output_sizes.get());
+    }
+    if (!s.ok()) {
+      VLOG(1) << "Not planning memory: " << s;
+      output_sizes.reset();
+    }
+  }
+
   ek->items.reserve(graphs.size());
   const auto& optimizer_opts =
       options_.config.graph_options().optimizer_options();
@@ -1098,6 +1273,7 @@ Status DirectSession::GetOrCreateExecutors(
 
     ek->items.resize(ek->items.size() + 1);
     auto* item = &(ek->items.back());
+    item->numa_node = NUMANodeOfDevice(device->attributes());
     item->flib.reset(NewFunctionLibraryRuntime(
         device_mgr_.get(), options_.env, device, graph_def_version,
         ek->flib_def.get(), optimizer_opts));
@@ -1129,6 +1305,10 @@ Status DirectSession::GetOrCreateExecutors(
       }
     };
     params.node_outputs_cb = node_outputs_callback_;
+    params.use_step_arena_allocator =
+        options_.config.use_step_arena_allocator();
+    params.inline_kernel_budget_ns =
+        options_.config.inline_kernel_budget_usecs() * 1000;
 
     optimizer.Optimize(lib, options_.env, device, &iter->second);
 
@@ -1141,6 +1321,11 @@ Status DirectSession::GetOrCreateExecutors(
     TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(device->device_type()),
                                          device->name(),
                                          partition_graph.get()));
+    if (output_sizes != nullptr && device->device_type() == DEVICE_CPU) {
+      MemoryPlan* plan = new MemoryPlan;
+      params.memory_plan.reset(plan);
+      PlanMemory(*partition_graph, *output_sizes, plan);
+    }
     // NewLocalExecutor takes ownership of partition_graph.
     item->graph = partition_graph.get();
     item->executor = nullptr;
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
 #include "tensorflow/core/common_runtime/simple_graph_execution_state.h"
+#include "tensorflow/core/common_runtime/work_stealing_thread_pool.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/session_state.h"
@@ -39,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
@@ -112,6 +114,8 @@ class DirectSession : public Session {
     Graph* graph = nullptr;
     std::unique_ptr<FunctionLibraryRuntime> flib;
     std::unique_ptr<Executor> executor;
+    // The NUMA node of the partition's device, or port::kNUMANoAffinity.
+    int numa_node = port::kNUMANoAffinity;
   };
 
   // An ExecutorsAndKeys is created for a given set of feeds/fetches.
@@ -188,8 +192,8 @@ class DirectSession : public Session {
   // Retrieves an already existing set of executors to run 'inputs' and
   // 'outputs', or creates and caches them for future use.
   ::tensorflow::Status GetOrCreateExecutors(
-      thread::ThreadPool* pool, gtl::ArraySlice<string> inputs,
-      gtl::ArraySlice<string> outputs, gtl::ArraySlice<string> target_nodes,
+      gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
+      gtl::ArraySlice<string> target_nodes,
       ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
 
   // Creates several graphs given the existing graph_def_ and the
@@ -270,11 +274,44 @@ class DirectSession : public Session {
   std::vector<thread::ThreadPool*> thread_pools_;
   bool owns_thread_pools_ = false;
 
+  // The work-stealing thread-pools to use for running ops, if
+  // ConfigProto.use_work_stealing_inter_op_scheduler is set. In that case
+  // thread_pools_ is empty.
+  std::vector<std::unique_ptr<WorkStealingThreadPool>> work_stealing_pools_;
+
+  // If ConfigProto.use_numa_affinity is set, one thread-pool per inter-op
+  // pool and NUMA node, pinned to that node, which runs the partitions of
+  // the node's CPU device: numa_thread_pools_[i][node] splits
+  // thread_pools_[i], and numa_work_stealing_pools_[i][node] splits
+  // work_stealing_pools_[i]. Empty otherwise.
+  std::vector<std::vector<std::unique_ptr<thread::ThreadPool>>>
+      numa_thread_pools_;
+  std::vector<std::vector<std::unique_ptr<WorkStealingThreadPool>>>
+      numa_work_stealing_pools_;
+
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
   // Schedules 'c' for execution on pool.
   void SchedClosure(thread::ThreadPool* pool, std::function<void()> c);
 
+  // Returns the number of inter-op thread pools that a Run() call can select
+  // with RunOptions.inter_op_thread_pool.
+  int NumInterOpThreadPools() const;
+
+  // Returns a runner that schedules closures on inter-op pool 'pool_index'.
+  Executor::Args::Runner InterOpRunner(int pool_index);
+
+  // Returns a runner that schedules closures on the part of inter-op pool
+  // 'pool_index' pinned to NUMA node 'numa_node', or nullptr if there is no
+  // such pool.
+  Executor::Args::Runner NUMARunner(int pool_index, int numa_node);
+
+  // Starts the executor of 'item' with 'args', on the threads of inter-op
+  // pool 'pool_index' of the partition's NUMA node if it has one.
+  void RunPartitionAsync(const PerPartitionExecutorsAndLib& item,
+                         int pool_index, const Executor::Args& args,
+                         Executor::DoneCallback done);
+
   mutex executor_lock_;  // protects executors_
   // Holds mappings from signature to the executors that process
   // it. The reason for a level of indirection around mapped_type is
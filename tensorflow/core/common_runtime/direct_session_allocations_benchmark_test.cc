@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks that report the number of heap allocations made by each
+// `DirectSession::Run()`. They count these by replacing the global operator
+// new, and so live in their own binary rather than in direct_session_test.
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/direct_session.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+
+// The number of calls to the global operator new in this process.
+static std::atomic<tensorflow::int64> num_heap_allocations(0);
+
+void* operator new(std::size_t size) {
+  num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) std::abort();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+namespace tensorflow {
+namespace {
+
+// Runs `sess` `iters` times, and labels the benchmark with the number of heap
+// allocations per run.
+void RunAndCountAllocations(
+    int iters, Session* sess,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& outputs, const std::vector<string>& targets) {
+  // Ignore the first run, which will incur the graph partitioning/pruning
+  // overhead.
+  {
+    std::vector<Tensor> output_values;
+    TF_CHECK_OK(sess->Run(inputs, outputs, targets, &output_values));
+  }
+  const int64 start_allocations = num_heap_allocations;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    std::vector<Tensor> output_values;
+    TF_CHECK_OK(sess->Run(inputs, outputs, targets, &output_values));
+  }
+  testing::StopTiming();
+  testing::SetLabel(strings::StrCat(
+      (num_heap_allocations - start_allocations) / iters, " allocs/run"));
+}
+
+void BM_FeedFetchAllocations(int iters, int num_feeds) {
+  testing::StopTiming();
+  Graph g(OpRegistry::Global());
+  Tensor value(DT_FLOAT, TensorShape());
+  value.flat<float>()(0) = 37.0;
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> outputs;
+  for (int i = 0; i < num_feeds; ++i) {
+    Node* placeholder;
+    TF_CHECK_OK(NodeBuilder(g.NewName("Placeholder"), "Placeholder")
+                    .Attr("shape", TensorShape())
+                    .Attr("dtype", DT_FLOAT)
+                    .Device("/cpu:0")
+                    .Finalize(&g, &placeholder));
+    Node* identity;
+    TF_CHECK_OK(NodeBuilder(g.NewName("Identity"), "Identity")
+                    .Input(placeholder)
+                    .Attr("T", DT_FLOAT)
+                    .Device("/cpu:0")
+                    .Finalize(&g, &identity));
+    inputs.push_back({placeholder->name() + ":0", value});
+    outputs.push_back(identity->name() + ":0");
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  std::unique_ptr<Session> sess(NewSession(SessionOptions()));
+  TF_CHECK_OK(sess->Create(gd));
+  RunAndCountAllocations(iters, sess.get(), inputs, outputs, {});
+}
+
+// Runs a graph of "width" independent chains of "depth" small additions each.
+void GraphAllocationsBenchmarkHelper(int iters, int width, int depth) {
+  testing::StopTiming();
+  Tensor value(DT_FLOAT, TensorShape({16}));
+  value.flat<float>().setConstant(1.0);
+  Graph g(OpRegistry::Global());
+  Node* input = test::graph::Constant(&g, value);
+  std::vector<string> targets;
+  for (int i = 0; i < width; ++i) {
+    Node* node = input;
+    for (int j = 0; j < depth; ++j) {
+      node = test::graph::Add(&g, node, input);
+    }
+    targets.push_back(node->name());
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  opts.config.set_use_per_session_threads(true);
+  std::unique_ptr<Session> sess(NewSession(opts));
+  TF_CHECK_OK(sess->Create(gd));
+  testing::ItemsProcessed(static_cast<int64>(iters) * width * depth);
+  RunAndCountAllocations(iters, sess.get(), {}, {}, targets);
+}
+
+void BM_WideGraphAllocations(int iters, int width) {
+  GraphAllocationsBenchmarkHelper(iters, width, 1);
+}
+
+void BM_DeepGraphAllocations(int iters, int depth) {
+  GraphAllocationsBenchmarkHelper(iters, 1, depth);
+}
+
+BENCHMARK(BM_FeedFetchAllocations)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_WideGraphAllocations)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphAllocations)->Arg(16)->Arg(256)->Arg(1024);
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/direct_session.h"
 
+#include <atomic>
 #include <map>
+#include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -36,6 +39,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
@@ -205,6 +210,155 @@ TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, TestWorkStealingInterOpScheduler) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.set_use_work_stealing_inter_op_scheduler(true);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+
+  // Run the graph 1000 times in 4 different threads concurrently.
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  auto fn = [&session, output_names, target_nodes]() {
+    for (int i = 0; i < 1000; ++i) {
+      std::vector<std::pair<string, Tensor>> inputs;
+      std::vector<Tensor> outputs;
+      // Run the graph
+      Status s = session->Run(inputs, output_names, target_nodes, &outputs);
+      TF_ASSERT_OK(s);
+      ASSERT_EQ(1, outputs.size());
+      auto mat = outputs[0].matrix<float>();
+      EXPECT_FLOAT_EQ(3.0, mat(0, 0));
+    }
+  };
+
+  for (int i = 0; i < 4; ++i) {
+    tp->Schedule(fn);
+  }
+
+  // Wait for the functions to finish.
+  delete tp;
+
+  // Only one inter-op pool is configured.
+  RunOptions run_options;
+  run_options.set_inter_op_thread_pool(1);
+  RunMetadata run_metadata;
+  std::vector<Tensor> outputs;
+  Status s = session->Run(run_options, {}, output_names, {}, &outputs,
+                          &run_metadata);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
+TEST_F(DirectSessionMinusAXTest, TestStepArenaAllocator) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.set_use_step_arena_allocator(true);
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+
+  // Run the graph 1000 times in 4 different threads concurrently, keeping
+  // the outputs of every step alive, so that they escape their step.
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<std::vector<Tensor>> all_outputs(4);
+  for (int t = 0; t < 4; ++t) {
+    tp->Schedule([&session, &all_outputs, output_names, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        std::vector<Tensor> outputs;
+        TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+        ASSERT_EQ(1, outputs.size());
+        all_outputs[t].push_back(outputs[0]);
+      }
+    });
+  }
+
+  // Wait for the functions to finish.
+  delete tp;
+
+  // The outputs are still valid after the session is gone.
+  session.reset();
+  for (const auto& outputs : all_outputs) {
+    ASSERT_EQ(1000, outputs.size());
+    for (const Tensor& output : outputs) {
+      auto mat = output.matrix<float>();
+      EXPECT_FLOAT_EQ(3.0, mat(0, 0));
+    }
+  }
+}
+
+TEST(DirectSessionTest, TestStaticMemoryPlan) {
+  // A chain of negations of a placeholder with a static shape, some of
+  // whose intermediate values are fetched.
+  Graph g(OpRegistry::Global());
+  Node* placeholder;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("shape", TensorShape({2, 2}))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &placeholder));
+  std::vector<string> output_names;
+  Node* node = placeholder;
+  for (int i = 0; i < 8; ++i) {
+    node = test::graph::Unary(&g, "Neg", node);
+    if (i % 3 == 2) output_names.push_back(node->name() + ":0");
+  }
+  output_names.push_back(node->name() + ":0");
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.set_use_static_memory_plan(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // Run the graph in 4 threads concurrently, keeping all the outputs alive.
+  std::vector<std::vector<Tensor>> all_outputs(4);
+  {
+    thread::ThreadPool tp(Env::Default(), "test", 4);
+    for (int t = 0; t < 4; ++t) {
+      tp.Schedule([&session, &all_outputs, &output_names, t]() {
+        for (int i = 0; i < 100; ++i) {
+          Tensor x(DT_FLOAT, TensorShape({2, 2}));
+          x.flat<float>().setConstant(t * 100 + i);
+          std::vector<Tensor> outputs;
+          TF_ASSERT_OK(session->Run({{"x", x}}, output_names, {}, &outputs));
+          ASSERT_EQ(output_names.size(), outputs.size());
+          all_outputs[t].insert(all_outputs[t].end(), outputs.begin(),
+                                outputs.end());
+        }
+      });
+    }
+  }
+
+  session.reset();
+  for (int t = 0; t < 4; ++t) {
+    ASSERT_EQ(100 * output_names.size(), all_outputs[t].size());
+    for (int i = 0; i < 100; ++i) {
+      // The outputs are the 3rd, 6th and 8th negations.
+      const float x = t * 100 + i;
+      const float expected[] = {-x, x, x};
+      for (int j = 0; j < 3; ++j) {
+        test::ExpectTensorEqual<float>(
+            all_outputs[t][i * 3 + j],
+            test::AsTensor<float>({expected[j], expected[j], expected[j],
+                                   expected[j]},
+                                  {2, 2}));
+      }
+    }
+  }
+}
+
 TEST_F(DirectSessionMinusAXTest, TwoCreateCallsFails) {
   Initialize({1, 2, 3, 4});
   std::unique_ptr<Session> session(CreateSession());
@@ -293,6 +447,241 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+// Sets TF_NUMA_SIMULATED_NODES, which makes the port layer simulate that
+// many NUMA nodes whatever the topology of the machine, and restores its
+// previous value when it goes out of scope.
+class ScopedSimulatedNUMANodes {
+ public:
+  explicit ScopedSimulatedNUMANodes(const char* num_nodes) {
+    const char* previous = getenv("TF_NUMA_SIMULATED_NODES");
+    had_previous_ = previous != nullptr;
+    if (had_previous_) previous_ = previous;
+    setenv("TF_NUMA_SIMULATED_NODES", num_nodes, 1);
+  }
+  ~ScopedSimulatedNUMANodes() {
+    if (had_previous_) {
+      setenv("TF_NUMA_SIMULATED_NODES", previous_.c_str(), 1);
+    } else {
+      unsetenv("TF_NUMA_SIMULATED_NODES");
+    }
+  }
+
+ private:
+  bool had_previous_;
+  string previous_;
+};
+
+TEST(DirectSessionTest, TestNUMAAffinity) {
+  ScopedSimulatedNUMANodes simulated_nodes("2");
+
+  // Two chains of negations, each rooted at a placeholder placed on the CPU
+  // device of one node.
+  Graph g(OpRegistry::Global());
+  std::vector<string> output_names;
+  for (int i = 0; i < 2; ++i) {
+    Node* node;
+    TF_ASSERT_OK(NodeBuilder(strings::StrCat("x", i), "Placeholder")
+                     .Attr("shape", TensorShape({2}))
+                     .Attr("dtype", DT_FLOAT)
+                     .Device(strings::StrCat("/cpu:", i))
+                     .Finalize(&g, &node));
+    for (int j = 0; j < 4; ++j) {
+      node = test::graph::Unary(&g, "Neg", node);
+    }
+    output_names.push_back(node->name() + ":0");
+  }
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  // The second session runs on the NUMA parts of the second of two
+  // work-stealing inter-op pools.
+  for (bool work_stealing : {false, true}) {
+    SessionOptions options;
+    options.config.set_use_numa_affinity(true);
+    RunOptions run_options;
+    if (work_stealing) {
+      options.config.set_use_work_stealing_inter_op_scheduler(true);
+      options.config.add_session_inter_op_thread_pool()->set_num_threads(2);
+      options.config.add_session_inter_op_thread_pool()->set_num_threads(4);
+      run_options.set_inter_op_thread_pool(1);
+    }
+    std::unique_ptr<Session> session(NewSession(options));
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def));
+
+    run_options.set_output_partition_graphs(true);
+    RunMetadata run_metadata;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(
+        run_options,
+        {{"x0", test::AsTensor<float>({1.0, 2.0})},
+         {"x1", test::AsTensor<float>({3.0, 4.0})}},
+        output_names, {}, &outputs, &run_metadata));
+    ASSERT_EQ(2, outputs.size());
+    test::ExpectTensorEqual<float>(outputs[0],
+                                   test::AsTensor<float>({1.0, 2.0}));
+    test::ExpectTensorEqual<float>(outputs[1],
+                                   test::AsTensor<float>({3.0, 4.0}));
+
+    // Each chain follows its placeholder to the device of its NUMA node.
+    ASSERT_EQ(2, run_metadata.partition_graphs_size());
+    for (const GraphDef& partition : run_metadata.partition_graphs()) {
+      int num_negs = 0;
+      for (const NodeDef& node : partition.node()) {
+        if (node.op() == "Neg") ++num_negs;
+      }
+      EXPECT_EQ(4, num_negs);
+    }
+  }
+}
+
+// The threads that ran SleepAndRecord kernels, and the names of their nodes
+// in the order they ran, when not null.
+static mutex recorded_mu;
+static std::set<std::thread::id>* recorded_threads = nullptr;
+static std::vector<string>* recorded_nodes = nullptr;
+
+// Sleeps for 200us, and records the thread and the node it ran.
+class SleepAndRecordOp : public OpKernel {
+ public:
+  explicit SleepAndRecordOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  void Compute(OpKernelContext* ctx) override {
+    Env::Default()->SleepForMicroseconds(200);
+    {
+      mutex_lock l(recorded_mu);
+      if (recorded_threads != nullptr) {
+        recorded_threads->insert(std::this_thread::get_id());
+      }
+      if (recorded_nodes != nullptr) recorded_nodes->push_back(name());
+    }
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("SleepAndRecord").Device(DEVICE_CPU),
+                        SleepAndRecordOp);
+REGISTER_OP("SleepAndRecord").Input("x: float").Output("y: float").Doc("");
+
+TEST(DirectSessionTest, TestInlineKernelBudget) {
+  // 4 chains of 4 kernels of about 200us each, which are expensive by
+  // default. With a budget of 500us, a thread hands its inline nodes back to
+  // the pool after a few kernels; with a large one, all the kernels of a step
+  // run inline on the thread that ran the constant.
+  Tensor value(DT_FLOAT, TensorShape({4}));
+  value.flat<float>().setConstant(1.0);
+  Graph g(OpRegistry::Global());
+  Node* input = test::graph::Constant(&g, value);
+  std::vector<string> output_names;
+  for (int i = 0; i < 4; ++i) {
+    Node* node = input;
+    for (int j = 0; j < 4; ++j) {
+      TF_ASSERT_OK(NodeBuilder(g.NewName("n"), "SleepAndRecord")
+                       .Input(node)
+                       .Finalize(&g, &node));
+    }
+    output_names.push_back(node->name() + ":0");
+  }
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  std::set<std::thread::id> threads;
+  recorded_threads = &threads;
+  for (const int64 budget_usecs : {500, 1000000}) {
+    SessionOptions options;
+    options.config.set_use_per_session_threads(true);
+    options.config.set_inter_op_parallelism_threads(4);
+    options.config.set_inline_kernel_budget_usecs(budget_usecs);
+    // Constant folding would otherwise run the kernels at graph creation.
+    options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_opt_level(OptimizerOptions::L0);
+    std::unique_ptr<Session> session(NewSession(options));
+    ASSERT_TRUE(session != nullptr);
+    TF_ASSERT_OK(session->Create(def));
+    // The first step measures the costs of the kernels.
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+    {
+      mutex_lock l(recorded_mu);
+      threads.clear();
+    }
+    TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+    ASSERT_EQ(4, outputs.size());
+    for (const Tensor& output : outputs) {
+      test::ExpectTensorEqual<float>(output, value);
+    }
+    mutex_lock l(recorded_mu);
+    if (budget_usecs == 500) {
+      EXPECT_GT(threads.size(), 1);
+    } else {
+      EXPECT_EQ(1, threads.size());
+    }
+  }
+  recorded_threads = nullptr;
+}
+
+TEST(DirectSessionTest, TestScheduleByCostModel) {
+  // A chain of 16 kernels next to 16 single kernels of the same input, all
+  // ready after the constant. Once the cost model has been built, the head
+  // of the chain is scheduled first: on a single inter-op thread, the whole
+  // chain runs before any of the single kernels.
+  Tensor value(DT_FLOAT, TensorShape({4}));
+  value.flat<float>().setConstant(1.0);
+  Graph g(OpRegistry::Global());
+  Node* input = test::graph::Constant(&g, value);
+  std::vector<string> output_names;
+  for (int i = 0; i < 16; ++i) {
+    Node* node;
+    TF_ASSERT_OK(NodeBuilder(strings::StrCat("single", i), "SleepAndRecord")
+                     .Input(input)
+                     .Finalize(&g, &node));
+    output_names.push_back(node->name() + ":0");
+  }
+  std::vector<string> chain_names;
+  Node* chain = input;
+  for (int i = 0; i < 16; ++i) {
+    TF_ASSERT_OK(NodeBuilder(strings::StrCat("chain", i), "SleepAndRecord")
+                     .Input(chain)
+                     .Finalize(&g, &chain));
+    chain_names.push_back(chain->name());
+  }
+  output_names.push_back(chain->name() + ":0");
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.set_use_per_session_threads(true);
+  options.config.set_inter_op_parallelism_threads(1);
+  GraphOptions* graph_options = options.config.mutable_graph_options();
+  graph_options->set_build_cost_model(4);
+  graph_options->set_build_cost_model_after(2);
+  graph_options->set_schedule_by_cost_model(true);
+  // Constant folding would otherwise run the kernels at graph creation.
+  graph_options->mutable_optimizer_options()->set_opt_level(
+      OptimizerOptions::L0);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<string> nodes;
+  for (int step = 0; step < 20; ++step) {
+    {
+      mutex_lock l(recorded_mu);
+      nodes.clear();
+      recorded_nodes = &nodes;
+    }
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+    ASSERT_EQ(17, outputs.size());
+    for (const Tensor& output : outputs) {
+      test::ExpectTensorEqual<float>(output, value);
+    }
+  }
+  mutex_lock l(recorded_mu);
+  recorded_nodes = nullptr;
+  ASSERT_EQ(32, nodes.size());
+  const std::vector<string> first_nodes(nodes.begin(), nodes.begin() + 16);
+  EXPECT_EQ(chain_names, first_nodes);
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -1220,5 +1609,208 @@ void BM_FeedFetch(int iters, int num_feeds) {
 
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
+// Benchmarks the inter-op scheduling overhead of `DirectSession::Run()` on a
+// graph of "width" independent chains of "depth" small additions each, with
+// and without the work-stealing inter-op scheduler, the per-step arena
+// allocator, the static memory plan and the inlining of cheap kernels.
+void InterOpSchedulingBenchmarkHelper(int iters, int width, int depth,
+                                      bool work_stealing,
+                                      bool step_arena = false,
+                                      bool static_memory_plan = false,
+                                      int64 inline_kernel_budget_usecs = 0) {
+  testing::StopTiming();
+
+  Tensor value(DT_FLOAT, TensorShape({16}));
+  value.flat<float>().setConstant(1.0);
+
+  Graph g(OpRegistry::Global());
+  Node* input = test::graph::Constant(&g, value);
+  std::vector<string> targets;
+  for (int i = 0; i < width; ++i) {
+    Node* node = input;
+    for (int j = 0; j < depth; ++j) {
+      node = test::graph::Add(&g, node, input);
+    }
+    targets.push_back(node->name());
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  opts.config.set_use_per_session_threads(true);
+  opts.config.set_use_work_stealing_inter_op_scheduler(work_stealing);
+  opts.config.set_use_step_arena_allocator(step_arena);
+  opts.config.set_use_static_memory_plan(static_memory_plan);
+  opts.config.set_inline_kernel_budget_usecs(inline_kernel_budget_usecs);
+  // Constant folding would otherwise compute the chains at graph creation.
+  opts.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  std::unique_ptr<Session> sess(NewSession(opts));
+  TF_CHECK_OK(sess->Create(gd));
+  // Ignore the first run, which will incur the graph partitioning/pruning
+  // overhead.
+  TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  testing::ItemsProcessed(static_cast<int64>(iters) * width * depth);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  }
+  testing::StopTiming();
+}
+
+void BM_WideGraph(int iters, int width) {
+  InterOpSchedulingBenchmarkHelper(iters, width, 4, false);
+}
+
+void BM_WideGraphWorkStealing(int iters, int width) {
+  InterOpSchedulingBenchmarkHelper(iters, width, 4, true);
+}
+
+void BM_DeepGraph(int iters, int depth) {
+  InterOpSchedulingBenchmarkHelper(iters, 4, depth, false);
+}
+
+void BM_DeepGraphWorkStealing(int iters, int depth) {
+  InterOpSchedulingBenchmarkHelper(iters, 4, depth, true);
+}
+
+void BM_DeepGraphStepArena(int iters, int depth) {
+  InterOpSchedulingBenchmarkHelper(iters, 4, depth, false, true);
+}
+
+void BM_DeepGraphStaticMemoryPlan(int iters, int depth) {
+  InterOpSchedulingBenchmarkHelper(iters, 4, depth, false, false, true);
+}
+
+void BM_WideGraphInlineKernels(int iters, int width) {
+  InterOpSchedulingBenchmarkHelper(iters, width, 4, false, false, false, 100);
+}
+
+void BM_DeepGraphInlineKernels(int iters, int depth) {
+  InterOpSchedulingBenchmarkHelper(iters, 4, depth, false, false, false, 100);
+}
+
+// Benchmarks a graph of a chain of 16 64x64 matrix multiplications next to
+// "width" single ones, all ready at the start of the step, with a cost model
+// built every 10 steps that is or is not used to run the chain first.
+void CriticalPathBenchmarkHelper(int iters, int width,
+                                 bool schedule_by_cost_model) {
+  testing::StopTiming();
+  Tensor value(DT_FLOAT, TensorShape({64, 64}));
+  value.flat<float>().setConstant(1.0 / 64);
+  Graph g(OpRegistry::Global());
+  Node* input = test::graph::Constant(&g, value);
+  std::vector<string> targets;
+  for (int i = 0; i < width; ++i) {
+    targets.push_back(
+        test::graph::Matmul(&g, input, input, false, false)->name());
+  }
+  Node* chain = input;
+  for (int i = 0; i < 16; ++i) {
+    chain = test::graph::Matmul(&g, chain, input, false, false);
+  }
+  targets.push_back(chain->name());
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  opts.config.set_use_per_session_threads(true);
+  GraphOptions* graph_options = opts.config.mutable_graph_options();
+  graph_options->set_build_cost_model(10);
+  graph_options->set_schedule_by_cost_model(schedule_by_cost_model);
+  // Constant folding would otherwise compute the products at graph creation.
+  graph_options->mutable_optimizer_options()->set_opt_level(
+      OptimizerOptions::L0);
+  std::unique_ptr<Session> sess(NewSession(opts));
+  TF_CHECK_OK(sess->Create(gd));
+  // Ignore the first runs, which build the first cost model.
+  for (int i = 0; i < 10; ++i) {
+    TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * (width + 16));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  }
+  testing::StopTiming();
+}
+
+void BM_CriticalPath(int iters, int width) {
+  CriticalPathBenchmarkHelper(iters, width, false);
+}
+
+void BM_CriticalPathScheduleByCostModel(int iters, int width) {
+  CriticalPathBenchmarkHelper(iters, width, true);
+}
+
+// Benchmarks a graph of 4 chains of "depth" 64x64 matrix multiplications on
+// two simulated NUMA nodes, with one CPU device per node whose threads are
+// pinned to the node and the roots of two chains placed on each device, or
+// with a single unpinned CPU device.
+void NUMAAffinityBenchmarkHelper(int iters, int depth, bool numa_affinity) {
+  testing::StopTiming();
+  ScopedSimulatedNUMANodes simulated_nodes("2");
+
+  Tensor value(DT_FLOAT, TensorShape({64, 64}));
+  value.flat<float>().setConstant(1.0 / 64);
+
+  Graph g(OpRegistry::Global());
+  std::vector<string> targets;
+  for (int i = 0; i < 4; ++i) {
+    Node* input;
+    TF_CHECK_OK(NodeBuilder(g.NewName("n"), "Const")
+                    .Attr("dtype", DT_FLOAT)
+                    .Attr("value", value)
+                    .Device(numa_affinity ? strings::StrCat("/cpu:", i % 2)
+                                          : "/cpu:0")
+                    .Finalize(&g, &input));
+    Node* node = input;
+    for (int j = 0; j < depth; ++j) {
+      node = test::graph::Matmul(&g, node, input, false, false);
+    }
+    targets.push_back(node->name());
+  }
+  GraphDef gd;
+  g.ToGraphDef(&gd);
+  SessionOptions opts;
+  opts.config.set_use_per_session_threads(true);
+  opts.config.set_use_numa_affinity(numa_affinity);
+  // Constant folding would otherwise compute the products at graph creation.
+  opts.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  std::unique_ptr<Session> sess(NewSession(opts));
+  TF_CHECK_OK(sess->Create(gd));
+  // Ignore the first run, which will incur the graph partitioning/pruning
+  // overhead.
+  TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  testing::ItemsProcessed(static_cast<int64>(iters) * 4 * depth);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(sess->Run({}, {}, targets, nullptr));
+  }
+  testing::StopTiming();
+}
+
+void BM_DeepGraphNUMA(int iters, int depth) {
+  NUMAAffinityBenchmarkHelper(iters, depth, false);
+}
+
+void BM_DeepGraphNUMAAffinity(int iters, int depth) {
+  NUMAAffinityBenchmarkHelper(iters, depth, true);
+}
+
+BENCHMARK(BM_WideGraph)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_WideGraphWorkStealing)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraph)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphWorkStealing)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphStepArena)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphStaticMemoryPlan)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_WideGraphInlineKernels)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphInlineKernels)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(BM_DeepGraphNUMA)->Arg(16)->Arg(256);
+BENCHMARK(BM_DeepGraphNUMAAffinity)->Arg(16)->Arg(256);
+BENCHMARK(BM_CriticalPath)->Arg(16)->Arg(64);
+BENCHMARK(BM_CriticalPathScheduleByCostModel)->Arg(16)->Arg(64);
+
 }  // namespace
 }  // namespace tensorflow
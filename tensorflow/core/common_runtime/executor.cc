@@ -24,6 +24,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -55,6 +58,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
@@ -66,6 +70,10 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Once the cost of a kernel has been measured, it is only measured again in
+// one step out of this many (see LocalExecutorParams.inline_kernel_budget_ns).
+static const int64 kKernelCostSampleSteps = 16;
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -193,6 +201,7 @@ void SetReferencedTensors(NodeExecStats* nt,
 }  // namespace nodestats
 
 class ExecutorImpl;
+class ExecutorState;
 class GraphView;
 
 struct EdgeInfo {
@@ -219,6 +228,9 @@ struct NodeItem {
   bool is_exit : 1;              // True iff IsExit(node)
   bool is_control_trigger : 1;   // True iff IsControlTrigger(node)
   bool is_sink : 1;              // True iff IsSink(node)
+  // True iff the node may keep its inputs beyond the step: sends, return
+  // values, stateful ops, and ops that take a ref (e.g. to a variable).
+  bool keeps_inputs : 1;
   // True iff IsEnter(node) || IsExit(node) || IsNextIteration(node)
   bool is_enter_exit_or_next_iter : 1;
 
@@ -337,18 +349,7 @@ class ExecutorImpl : public Executor {
     CHECK(p.delete_kernel != nullptr);
   }
 
-  ~ExecutorImpl() override {
-    for (int i = 0; i < graph_->num_node_ids(); i++) {
-      NodeItem* item = gview_.node(i);
-      if (item != nullptr) {
-        params_.delete_kernel(item->kernel);
-      }
-    }
-    for (auto fiter : frame_info_) {
-      delete fiter.second;
-    }
-    delete graph_;
-  }
+  ~ExecutorImpl() override;
 
   Status Initialize();
 
@@ -359,9 +360,15 @@ class ExecutorImpl : public Executor {
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
+  void SetNodeCosts(const std::vector<int64>& costs) override;
+
  private:
   friend class ExecutorState;
 
+  // Deletes "state", which has finished its step with status "s", or keeps
+  // it for reuse by a later step.
+  void ReleaseExecutorState(ExecutorState* state, const Status& s);
+
   struct ControlFlowInfo {
     gtl::FlatSet<string, HashStr> unique_frame_names;
     std::vector<string> frame_names;
@@ -417,6 +424,11 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // True iff the graph contains Merge, Enter, Exit or NextIteration nodes.
+  // If false, the graph has a single frame and iteration, and outputs are
+  // propagated without taking the frame lock.
+  bool requires_control_flow_ = false;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -425,6 +437,35 @@ class ExecutorImpl : public Executor {
   // the overhead of constructing it for each executor instance.
   gtl::FlatMap<string, FrameInfo*, HashStr> frame_info_;
 
+  // ExecutorStates of steps that finished successfully, which are reused by
+  // later steps so that a steady-state step does not allocate its root frame
+  // and iteration state. Only used if !requires_control_flow_.
+  mutex free_states_mu_;
+  std::vector<ExecutorState*> free_states_ GUARDED_BY(free_states_mu_);
+
+  // The allocator for the intermediate tensors of all the steps, if
+  // params_.use_step_arena_allocator and the device is a CPU. Owned.
+  StepArenaAllocator* step_arena_ = nullptr;
+
+  // The slabs of params_.memory_plan for the steps, if any and the device
+  // is a CPU. Owned.
+  MemoryPlanSlabPool* memory_plan_slabs_ = nullptr;
+
+  // params_.inline_kernel_budget_ns in CPU clock cycles, which kernel costs
+  // are measured in, or 0 if cheap kernels are not inlined.
+  int64 inline_budget_cycles_ = 0;
+
+  // The average compute time in CPU clock cycles of the kernel of each node,
+  // or 0 if it has not been measured yet. Only allocated if
+  // inline_budget_cycles_ > 0.
+  std::unique_ptr<std::atomic<int64>[]> kernel_cost_cycles_;
+
+  // The priority of each node, which is the measured cost of the longest
+  // path from the node to a sink of the graph, and whether it has been set
+  // by SetNodeCosts(). Nodes of higher priority are scheduled first.
+  std::unique_ptr<std::atomic<int64>[]> node_priorities_;
+  std::atomic<bool> has_node_priorities_{false};
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -603,6 +644,16 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_dead_count = num_in_edges;
 }
 
+// The range of the sizes of the chunks of the step arena of an executor,
+// which grow from the minimum to fit the memory used by its steps. Tensors
+// of more than a quarter of the maximum are not allocated from the arena.
+static const size_t kMinStepArenaChunkSize = 64 << 10;
+static const size_t kMaxStepArenaChunkSize = 1 << 20;
+
+// The maximum number of idle MemoryPlanSlabs kept by an executor. A single
+// one suffices for steps that do not overlap.
+static const size_t kMaxFreeMemoryPlanSlabs = 1;
+
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_);
 
@@ -619,6 +670,45 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
+  if (params_.inline_kernel_budget_ns > 0) {
+    // The clock cycle counter is much cheaper to read than the time.
+    const int64 frequency =
+        profile_utils::CpuUtils::GetCycleCounterFrequency();
+    if (frequency > 0) {
+      inline_budget_cycles_ = std::max<int64>(
+          1, params_.inline_kernel_budget_ns * (frequency / 1e9));
+      kernel_cost_cycles_.reset(
+          new std::atomic<int64>[graph_->num_node_ids()]);
+      for (int i = 0; i < graph_->num_node_ids(); ++i) {
+        kernel_cost_cycles_[i].store(0, std::memory_order_relaxed);
+      }
+    } else {
+      LOG(WARNING) << "Not inlining cheap kernels: the CPU clock cycle "
+                   << "counter is not available.";
+    }
+  }
+
+  if (params_.device->device_type() == DEVICE_CPU) {
+    if (params_.use_step_arena_allocator) {
+      step_arena_ = new StepArenaAllocator(
+          params_.device->GetAllocator(AllocatorAttributes()),
+          kMinStepArenaChunkSize, kMaxStepArenaChunkSize);
+    }
+    if (params_.memory_plan != nullptr) {
+      Allocator* base = step_arena_;
+      if (base == nullptr) {
+        base = params_.device->GetAllocator(AllocatorAttributes());
+      }
+      memory_plan_slabs_ = new MemoryPlanSlabPool(
+          params_.memory_plan.get(), base, kMaxFreeMemoryPlanSlabs);
+    }
+  }
+
+  node_priorities_.reset(new std::atomic<int64>[graph_->num_node_ids()]);
+  for (int i = 0; i < graph_->num_node_ids(); ++i) {
+    node_priorities_[i].store(0, std::memory_order_relaxed);
+  }
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
   for (const Node* n : graph_->nodes()) {
@@ -652,8 +742,16 @@ Status ExecutorImpl::Initialize() {
     item->is_exit = IsExit(n);
     item->is_control_trigger = IsControlTrigger(n);
     item->is_sink = IsSink(n);
+    item->keeps_inputs = IsSend(n) || n->type_string() == "_Retval" ||
+                         n->op_def().is_stateful();
+    for (int i = 0; i < n->num_inputs() && !item->keeps_inputs; ++i) {
+      item->keeps_inputs = IsRefType(n->input_type(i));
+    }
     item->is_enter_exit_or_next_iter =
         (IsEnter(n) || IsExit(n) || IsNextIteration(n));
+    if (item->is_merge || item->is_enter_exit_or_next_iter) {
+      requires_control_flow_ = true;
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -784,6 +882,12 @@ class ExecutorState {
   ExecutorState(const Executor::Args& args, ExecutorImpl* impl);
   ~ExecutorState();
 
+  // Prepares this state, whose previous step finished successfully, to run
+  // another step with "args".
+  //
+  // REQUIRES: !impl->requires_control_flow_.
+  void ResetForReuse(const Executor::Args& args);
+
   void RunAsync(Executor::DoneCallback done);
 
  private:
@@ -895,8 +999,11 @@ class ExecutorState {
     // edge. The latter node is never run concurrently with the former node.
     Entry* input_tensors;
 
-    // The number of outstanding ops for each iteration.
-    size_t outstanding_ops;
+    // The number of outstanding ops for each iteration. This is
+    // protected by the frame lock. It is not maintained for graphs without
+    // control flow (see FrameState::ActivateNodesFastPath), whose single
+    // iteration is done when the step is.
+    std::atomic<size_t> outstanding_ops;
 
     // The number of outstanding frames for each iteration.
     int outstanding_frame_count;
@@ -924,6 +1031,24 @@ class ExecutorState {
       counts_.adjust_for_activation(h, increment_dead, pending_result,
                                     dead_result);
     }
+    void adjust_for_activation_atomic(PendingCounts::Handle h,
+                                      bool increment_dead,
+                                      int* pending_result, int* dead_result) {
+      counts_.adjust_for_activation_atomic(h, increment_dead, pending_result,
+                                           dead_result);
+    }
+
+    // Resets this iteration state for reuse by another step. The input
+    // tensors of dead nodes are not consumed, so they are released here.
+    void ResetForReuse(const PendingCounts* pending_counts,
+                       int total_input_tensors) {
+      for (int i = 0; i < total_input_tensors; ++i) {
+        input_tensors[i].ClearVal();
+      }
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.CopyFrom(*pending_counts);
+    }
 
     ~IterationState() { delete[] input_tensors; }
 
@@ -1100,6 +1225,17 @@ class ExecutorState {
                        EntryVector* outputs, TaggedNodeSeq* ready)
         EXCLUSIVE_LOCKS_REQUIRED(mu);
 
+    // Like ActivateNodes(), but without holding the frame lock: the pending
+    // counts of the successors are updated atomically, and the outstanding
+    // op count of the iteration is not maintained. The frame is never done
+    // before the end of the step, so that it can be reused by the next one
+    // (see ExecutorImpl::ReleaseExecutorState()).
+    //
+    // REQUIRES: !executor->requires_control_flow_.
+    void ActivateNodesFastPath(const NodeItem* item, const bool is_dead,
+                               int64 iter, EntryVector* outputs,
+                               TaggedNodeSeq* ready);
+
     // Cleanup iterations of this frame starting from iteration iter.
     bool CleanupIterations(const GraphView* gview, int64 iter,
                            TaggedNodeSeq* ready) EXCLUSIVE_LOCKS_REQUIRED(mu);
@@ -1155,6 +1291,10 @@ class ExecutorState {
       }
     }
     bool empty() const { return ready_.empty(); }
+    void clear() {
+      ready_.clear();
+      front_index_ = 0;
+    }
     const TaggedNode* begin() const { return ready_.begin() + front_index_; }
     const TaggedNode* end() const { return ready_.end(); }
 
@@ -1165,10 +1305,10 @@ class ExecutorState {
 
   struct AsyncState;
 
-  const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
+  bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
 
   // true if LogMemory::IsEnabled(). Used to check memory enabled cheaply.
-  const bool log_memory_;
+  bool log_memory_;
 
   int64 step_id_;
   // Not owned.
@@ -1178,17 +1318,22 @@ class ExecutorState {
   // Step-local container.
   ScopedStepContainer* step_container_;
   StepStatsCollector* stats_collector_;
-  // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
-  // instead of a pointer?  (avoids having to delete).
-  checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
+  // Constructed in place, and reconstructed when the state is reused, so
+  // that each step starts with an empty cache without a heap allocation.
+  ManualConstructor<checkpoint::TensorSliceReaderCacheWrapper>
+      slice_reader_cache_;
   FunctionCallFrame* call_frame_;
-  const ExecutorImpl* impl_;
+  ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
 
   // Owned.
 
+  // The buffers of impl_->params_.memory_plan for this step, if any, which
+  // are handed back to the executor when the step finishes.
+  MemoryPlanSlab* memory_plan_slab_ = nullptr;
+
   // A flag that is set on error after the frame state has been
   // dumped for diagnostic purposes.
   bool dumped_on_error_ = false;
@@ -1234,6 +1379,11 @@ class ExecutorState {
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_usec);
 
+  // Replaces "*tensor" with a copy from the device's allocator if it was
+  // carved out of a chunk of impl_->step_arena_, so that a tensor that
+  // outlives the step does not keep the whole chunk alive.
+  void CopyOutOfStepArena(Tensor* tensor);
+
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
                        TensorValueVec* inputs,
@@ -1253,13 +1403,30 @@ class ExecutorState {
 
   // "node" just finishes. Takes ownership of "stats". Returns true if
   // execution has completed.
-  bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
+  // The nodes in "ready" may be reordered.
+  bool NodeDone(const Status& s, const Node* node, TaggedNodeSeq* ready,
                 NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
-  // nodes in 'ready' into 'inline_ready'.
-  void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+  // nodes in 'ready' into 'inline_ready'. The nodes in 'ready' are sorted in
+  // place by priority once the executor knows the node costs.
+  void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
+
+  // Returns true if the kernel of the node with id "id" is known to take at
+  // most the inline budget, and can therefore run inline.
+  bool IsCheapKernel(int id) const {
+    if (impl_->kernel_cost_cycles_ == nullptr) return false;
+    const int64 cost =
+        impl_->kernel_cost_cycles_[id].load(std::memory_order_relaxed);
+    return cost > 0 && cost <= impl_->inline_budget_cycles_;
+  }
+
+  // Records that the kernel of the node with id "id" took "cycles".
+  void UpdateKernelCost(int id, int64 cycles);
+
+  // Hands all the nodes in 'inline_ready' but the first one to the runner.
+  void DispatchInlineReady(TaggedNodeReadyQueue* inline_ready,
+                           int64 scheduled_usec);
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1299,13 +1466,14 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
       stats_collector_(args.stats_collector),
-      slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
       call_frame_(args.call_frame),
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       num_outstanding_ops_(0) {
+  slice_reader_cache_.Init();
+
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
@@ -1328,7 +1496,37 @@ ExecutorState::~ExecutorState() {
   for (auto it : device_context_map_) {
     it->Unref();
   }
-  delete slice_reader_cache_;
+  slice_reader_cache_.Destroy();
+  DCHECK(memory_plan_slab_ == nullptr);
+}
+
+void ExecutorState::ResetForReuse(const Executor::Args& args) {
+  DCHECK(!impl_->requires_control_flow_);
+  vlog_ = VLOG_IS_ON(1);
+  log_memory_ = LogMemory::IsEnabled();
+  step_id_ = args.step_id;
+  rendezvous_ = args.rendezvous;
+  session_state_ = args.session_state;
+  tensor_store_ = args.tensor_store;
+  step_container_ = args.step_container;
+  stats_collector_ = args.stats_collector;
+  slice_reader_cache_.Destroy();
+  slice_reader_cache_.Init();
+  call_frame_ = args.call_frame;
+  cancellation_manager_ = args.cancellation_manager;
+  runner_ = args.runner;
+  sync_on_finish_ = args.sync_on_finish;
+  dumped_on_error_ = false;
+  for (auto it : device_context_map_) {
+    it->Unref();
+  }
+  device_context_map_.clear();
+
+  // The root frame is the only frame, and it is kept with its only iteration
+  // at the end of a step (see FrameState::ActivateNodesFastPath()).
+  DCHECK_EQ(outstanding_frames_.size(), 1);
+  root_frame_->iterations[0]->ResetForReuse(root_frame_->pending_counts,
+                                            root_frame_->total_input_tensors);
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1436,8 +1634,11 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     num_outstanding_ops_ = ready.size();
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
+    if (impl_->memory_plan_slabs_ != nullptr) {
+      memory_plan_slab_ = impl_->memory_plan_slabs_->Acquire();
+    }
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(&ready, nullptr);
   }
 }
 
@@ -1510,7 +1711,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   params.function_library = impl_->params_.function_library;
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
-  params.slice_reader_cache = slice_reader_cache_;
+  params.slice_reader_cache = slice_reader_cache_.get();
+  params.step_allocator = impl_->step_arena_;
   params.inputs = &inputs;
   params.input_device_contexts = &input_device_contexts;
   params.input_alloc_attrs = &input_alloc_attrs;
@@ -1520,6 +1722,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   NodeExecStats* stats = nullptr;
   EntryVector outputs;
   bool completed = false;
+  // The cycles taken by the kernels this thread ran inline since it last
+  // handed nodes to the runner.
+  const int64 inline_budget_cycles = impl_->inline_budget_cycles_;
+  int64 inline_cost_cycles = 0;
   inline_ready.push_back(tagged_node);
   while (!inline_ready.empty()) {
     tagged_node = inline_ready.front();
@@ -1542,6 +1748,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.op_device_context = device_context_map_[id];
     }
 
+    if (memory_plan_slab_ != nullptr) {
+      params.output_allocators = memory_plan_slab_->OutputAllocators(id);
+    }
+
     params.track_allocations = false;
     stats = nullptr;
     if (stats_collector_ && !tagged_node.is_dead) {
@@ -1583,7 +1793,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed = NodeDone(s, item.node, &ready, stats, &inline_ready);
         continue;
       }
 
@@ -1639,7 +1849,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                                                  accessed);
           }
           bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, &ready, stats, nullptr);
           delete state;
           if (completed) Finish();
         };
@@ -1649,7 +1859,24 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         if (stats) nodestats::SetOpStart(stats);
-        device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        if (inline_budget_cycles > 0) {
+          const int64 cost =
+              impl_->kernel_cost_cycles_[id].load(std::memory_order_relaxed);
+          if (cost == 0 || step_id_ % kKernelCostSampleSteps == 0) {
+            const uint64 start =
+                profile_utils::CpuUtils::GetCurrentClockCycle();
+            device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+            const int64 elapsed =
+                profile_utils::CpuUtils::GetCurrentClockCycle() - start;
+            UpdateKernelCost(id, elapsed);
+            inline_cost_cycles += elapsed;
+          } else {
+            device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+            inline_cost_cycles += cost;
+          }
+        } else {
+          device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        }
         if (stats) nodestats::SetOpEnd(stats);
 
         s = ProcessOutputs(item, &ctx, &outputs, stats);
@@ -1683,7 +1910,14 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed = NodeDone(s, item.node, &ready, stats, &inline_ready);
+      if (inline_budget_cycles > 0 &&
+          inline_cost_cycles >= inline_budget_cycles && !inline_ready.empty()) {
+        // This thread has used up its inline budget: let the other threads
+        // run the nodes it would have run after the next one.
+        DispatchInlineReady(&inline_ready, scheduled_usec);
+        inline_cost_cycles = 0;
+      }
     }
   }  // while !inline_ready.empty()
 
@@ -1691,6 +1925,24 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   if (completed) Finish();
 }
 
+void ExecutorState::CopyOutOfStepArena(Tensor* tensor) {
+  const DataType dtype = tensor->dtype();
+  if (!tensor->IsInitialized() || tensor->NumElements() == 0 ||
+      !(DataTypeCanUseMemcpy(dtype) || dtype == DT_STRING) ||
+      !impl_->step_arena_->Contains(tensor->tensor_data().data())) {
+    return;
+  }
+  Tensor copy(impl_->params_.device->GetAllocator(AllocatorAttributes()),
+              dtype, tensor->shape());
+  if (dtype == DT_STRING) {
+    copy.flat<string>() = tensor->flat<string>();
+  } else {
+    memcpy(const_cast<char*>(copy.tensor_data().data()),
+           tensor->tensor_data().data(), tensor->TotalBytes());
+  }
+  *tensor = std::move(copy);
+}
+
 Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
                                     TensorValueVec* inputs,
                                     DeviceContextVec* input_device_contexts,
@@ -1736,6 +1988,9 @@ Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
             errors::InvalidArgument(i, "-th input expects a ref type"),
             item.kernel->def());
       }
+      if (item.keeps_inputs && impl_->step_arena_ != nullptr) {
+        CopyOutOfStepArena(entry->val.get());
+      }
       inp->tensor = entry->val.get();
     } else {
       {
@@ -1907,11 +2162,19 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
   if (!item->is_enter_exit_or_next_iter) {
     // Fast path for nodes types that don't need special handling
     DCHECK_EQ(input_frame, output_frame);
-    // Normal path for most nodes
-    mutex_lock l(input_frame->mu);
-    output_frame->ActivateNodes(item, is_dead, output_iter, outputs, ready);
-    is_frame_done = input_frame->DecrementOutstandingOpsLocked(
-        &impl_->gview_, input_iter, ready);
+    if (!impl_->requires_control_flow_) {
+      // Graphs without control flow have neither merge nodes nor more than
+      // one frame and iteration, so the frame lock is not needed, and the
+      // end of the step is tracked by num_outstanding_ops_ alone.
+      output_frame->ActivateNodesFastPath(item, is_dead, output_iter, outputs,
+                                          ready);
+    } else {
+      // Normal path for most nodes
+      mutex_lock l(input_frame->mu);
+      output_frame->ActivateNodes(item, is_dead, output_iter, outputs, ready);
+      is_frame_done = input_frame->DecrementOutstandingOpsLocked(
+          &impl_->gview_, input_iter, ready);
+    }
   } else if (item->is_enter) {
     bool is_constant;
     Status s = GetNodeAttr(node->attrs(), "is_constant", &is_constant);
@@ -1995,7 +2258,7 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
 }
 
 bool ExecutorState::NodeDone(const Status& s, const Node* node,
-                             const TaggedNodeSeq& ready, NodeExecStats* stats,
+                             TaggedNodeSeq* ready, NodeExecStats* stats,
                              TaggedNodeReadyQueue* inline_ready) {
   if (stats) {
     nodestats::SetAllEnd(stats);
@@ -2027,7 +2290,7 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
   }
 
   bool completed = false;
-  size_t ready_size = ready.size();
+  size_t ready_size = ready->size();
   if (ready_size == 0 || !s.ok()) {
     completed = (num_outstanding_ops_.fetch_sub(1) == 1);
   } else if (ready_size > 1) {
@@ -2041,49 +2304,80 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
   return completed;
 }
 
-void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
+void ExecutorState::ScheduleReady(TaggedNodeSeq* ready,
                                   TaggedNodeReadyQueue* inline_ready) {
-  if (ready.empty()) return;
+  if (ready->empty()) return;
 
   int64 scheduled_usec = 0;
   if (stats_collector_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  // Once the executor knows the node costs, run the nodes on the longest
+  // remaining paths first instead of in the order they became ready.
+  if (ready->size() > 1 &&
+      impl_->has_node_priorities_.load(std::memory_order_acquire)) {
+    const std::atomic<int64>* priorities = impl_->node_priorities_.get();
+    std::stable_sort(ready->begin(), ready->end(),
+                     [priorities](const TaggedNode& a, const TaggedNode& b) {
+                       return priorities[a.node->id()].load(
+                                  std::memory_order_relaxed) >
+                              priorities[b.node->id()].load(
+                                  std::memory_order_relaxed);
+                     });
+  }
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
-    for (auto& tagged_node : ready) {
+    for (auto& tagged_node : *ready) {
       runner_([=]() { Process(tagged_node, scheduled_usec); });
     }
     return;
   }
   const GraphView& gview = impl_->gview_;
-  const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
+  gtl::InlinedVector<const TaggedNode*, 8> expensive_nodes;
+  for (auto& tagged_node : *ready) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
-    if (tagged_node.is_dead || !item.kernel_is_expensive) {
+    if (tagged_node.is_dead || !item.kernel_is_expensive ||
+        IsCheapKernel(tagged_node.node->id())) {
       // Inline this inexpensive node.
       inline_ready->push_back(tagged_node);
     } else {
-      if (curr_expensive_node) {
-        // Dispatch to another thread since there is plenty of work to
-        // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
-      }
-      curr_expensive_node = &tagged_node;
+      expensive_nodes.push_back(&tagged_node);
     }
   }
-  if (curr_expensive_node) {
-    if (inline_ready->empty()) {
-      // Tail recursion optimization
-      inline_ready->push_back(*curr_expensive_node);
-    } else {
-      // There are inline nodes to run already. We dispatch this expensive
-      // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
-    }
+  size_t first_dispatched = 0;
+  if (!expensive_nodes.empty() && inline_ready->empty()) {
+    // Tail recursion optimization: run the first expensive node on this
+    // thread.
+    inline_ready->push_back(*expensive_nodes[0]);
+    first_dispatched = 1;
+  }
+  // Dispatch the other expensive nodes to other threads since there is
+  // plenty of work to do for this thread.
+  for (size_t i = first_dispatched; i < expensive_nodes.size(); ++i) {
+    runner_(std::bind(&ExecutorState::Process, this, *expensive_nodes[i],
+                      scheduled_usec));
+  }
+}
+
+void ExecutorState::UpdateKernelCost(int id, int64 cycles) {
+  // An exponential moving average, which is racy across concurrent steps
+  // but only needs to be roughly right. 0 means not measured yet.
+  std::atomic<int64>* average = &impl_->kernel_cost_cycles_[id];
+  const int64 old_cycles = average->load(std::memory_order_relaxed);
+  const int64 new_cycles =
+      old_cycles == 0 ? cycles : old_cycles + (cycles - old_cycles) / 8;
+  average->store(std::max<int64>(new_cycles, 1), std::memory_order_relaxed);
+}
+
+void ExecutorState::DispatchInlineReady(TaggedNodeReadyQueue* inline_ready,
+                                        int64 scheduled_usec) {
+  const TaggedNode next = inline_ready->front();
+  for (const TaggedNode* it = inline_ready->begin() + 1;
+       it != inline_ready->end(); ++it) {
+    runner_(std::bind(&ExecutorState::Process, this, *it, scheduled_usec));
   }
+  inline_ready->clear();
+  inline_ready->push_back(next);
 }
 
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
@@ -2230,7 +2524,11 @@ void ExecutorState::Finish() {
     // the user until the step (and its side-effects) has actually completed.
     status = impl_->params_.device->Sync();
   }
-  delete this;
+  if (memory_plan_slab_ != nullptr) {
+    impl_->memory_plan_slabs_->Release(memory_plan_slab_);
+    memory_plan_slab_ = nullptr;
+  }
+  impl_->ReleaseExecutorState(this, status);
   CHECK(done_cb != nullptr);
   runner([=]() { done_cb(status); });
 }
@@ -2462,6 +2760,55 @@ void ExecutorState::FrameState::ActivateNodes(const NodeItem* item,
   }
 }
 
+void ExecutorState::FrameState::ActivateNodesFastPath(const NodeItem* item,
+                                                      const bool is_dead,
+                                                      int64 iter,
+                                                      EntryVector* outputs,
+                                                      TaggedNodeSeq* ready)
+    NO_THREAD_SAFETY_ANALYSIS {
+  DCHECK(!executor->requires_control_flow_);
+  const GraphView& gview = executor->gview_;
+  // The iterations array of the root frame is not modified during a step,
+  // so it is safe to read without the lock.
+  IterationState* iter_state = GetIteration(iter);
+  const size_t num_output_edges = item->num_output_edges;
+  const EdgeInfo* edges = item->output_edge_list();
+  Entry* input_tensors = iter_state->input_tensors;
+  for (size_t out_index = 0; out_index < num_output_edges; out_index++) {
+    const EdgeInfo& e = edges[out_index];
+    const int dst_id = e.dst_id;
+    const NodeItem* dst_item = gview.node(dst_id);
+    const int src_slot = e.output_slot;
+
+    if (dst_item->is_sink) continue;
+    DCHECK(!dst_item->is_merge);
+
+    const bool is_control_edge = (src_slot == Graph::kControlSlot);
+    const bool increment_dead =
+        (is_dead || (!is_control_edge && !(*outputs)[src_slot].has_value));
+    if (!is_control_edge) {
+      // The input must be written before the pending count is decremented,
+      // since another producer of dst may observe the count reaching zero
+      // and run dst.
+      const int dst_loc = dst_item->input_start + e.input_slot;
+      if (e.is_last) {
+        input_tensors[dst_loc] = std::move((*outputs)[src_slot]);
+      } else {
+        input_tensors[dst_loc] = (*outputs)[src_slot];
+      }
+    }
+
+    // Only the producer that observes a zero pending count makes dst ready.
+    int pending, dead;
+    iter_state->adjust_for_activation_atomic(dst_item->pending_id,
+                                             increment_dead, &pending, &dead);
+    if (pending == 0) {
+      const bool dst_dead = (dead > 0) && !dst_item->is_control_trigger;
+      ready->push_back(TaggedNode(dst_item->node, this, iter, dst_dead));
+    }
+  }
+}
+
 void ExecutorState::FrameState::ActivateNexts(const GraphView* gview,
                                               int64 iter,
                                               TaggedNodeSeq* ready) {
@@ -2559,8 +2906,83 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
   return IsFrameDone();
 }
 
+ExecutorImpl::~ExecutorImpl() {
+  for (ExecutorState* state : free_states_) {
+    delete state;
+  }
+  delete memory_plan_slabs_;
+  if (step_arena_ != nullptr) {
+    step_arena_->Release();
+  }
+  for (int i = 0; i < graph_->num_node_ids(); i++) {
+    NodeItem* item = gview_.node(i);
+    if (item != nullptr) {
+      params_.delete_kernel(item->kernel);
+    }
+  }
+  for (auto fiter : frame_info_) {
+    delete fiter.second;
+  }
+  delete graph_;
+}
+
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
-  (new ExecutorState(args, this))->RunAsync(std::move(done));
+  ExecutorState* state = nullptr;
+  if (!requires_control_flow_) {
+    mutex_lock l(free_states_mu_);
+    if (!free_states_.empty()) {
+      state = free_states_.back();
+      free_states_.pop_back();
+    }
+  }
+  if (state != nullptr) {
+    state->ResetForReuse(args);
+  } else {
+    state = new ExecutorState(args, this);
+  }
+  state->RunAsync(std::move(done));
+}
+
+void ExecutorImpl::SetNodeCosts(const std::vector<int64>& costs) {
+  // Visit the consumers of each node before the node. Every node counts for
+  // at least 1 so that unmeasured nodes still favor the longer paths.
+  std::vector<Node*> order;
+  GetPostOrder(*graph_, &order);
+  std::vector<int64> path_costs(graph_->num_node_ids(), 0);
+  for (const Node* n : order) {
+    int64 longest_consumer_path = 0;
+    for (const Edge* e : n->out_edges()) {
+      longest_consumer_path =
+          std::max(longest_consumer_path, path_costs[e->dst()->id()]);
+    }
+    const int id = n->id();
+    const int64 cost = static_cast<size_t>(id) < costs.size()
+                           ? std::max<int64>(costs[id], 0)
+                           : 0;
+    path_costs[id] = longest_consumer_path + cost + 1;
+  }
+  for (int i = 0; i < graph_->num_node_ids(); ++i) {
+    node_priorities_[i].store(path_costs[i], std::memory_order_relaxed);
+  }
+  has_node_priorities_.store(true, std::memory_order_release);
+}
+
+// The maximum number of idle ExecutorStates kept by an executor, which bounds
+// the memory held after a burst of concurrent steps.
+static const size_t kMaxFreeExecutorStates = 16;
+
+void ExecutorImpl::ReleaseExecutorState(ExecutorState* state,
+                                        const Status& s) {
+  // A failed step may have left tensors in its input entries, so its state
+  // is not reused.
+  if (!requires_control_flow_ && s.ok()) {
+    mutex_lock l(free_states_mu_);
+    if (free_states_.size() < kMaxFreeExecutorStates) {
+      free_states_.push_back(state);
+      return;
+    }
+  }
+  delete state;
 }
 
 }  // end namespace
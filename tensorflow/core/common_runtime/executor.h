@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_EXECUTOR_H_
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/session_state.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -118,6 +119,13 @@ class Executor {
     n.WaitForNotification();
     return ret;
   }
+
+  // Sets the measured cost in microseconds of each node of the graph,
+  // indexed by node id, which later steps use to run the nodes on the
+  // longest remaining paths first among the nodes that become ready
+  // together. May be called concurrently with RunAsync(). Executors that
+  // do not prioritize nodes ignore the costs.
+  virtual void SetNodeCosts(const std::vector<int64>& costs) {}
 };
 
 // Creates an Executor that computes the given "graph".
@@ -141,6 +149,24 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // If true and "device" is a CPU device, the tensors of the steps are
+  // allocated from a StepArenaAllocator shared by the steps of the
+  // executor, whose memory is reused by later steps (see
+  // ConfigProto.use_step_arena_allocator).
+  bool use_step_arena_allocator = false;
+
+  // If not null and "device" is a CPU device, the planned outputs of the
+  // nodes of the graph are allocated from the buffers of this plan (see
+  // ConfigProto.use_static_memory_plan).
+  std::shared_ptr<const MemoryPlan> memory_plan;
+
+  // If positive, the executor measures the compute time of its synchronous
+  // kernels, runs ready kernels that take at most this many nanoseconds on
+  // average inline on the thread that made them ready, and a thread hands
+  // the nodes it would run inline to the runner once the kernels it ran
+  // inline took this long (see ConfigProto.inline_kernel_budget_usecs).
+  int64 inline_kernel_budget_ns = 0;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
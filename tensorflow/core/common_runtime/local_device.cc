@@ -18,10 +18,14 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -30,18 +34,37 @@ namespace tensorflow {
 /* static */
 bool LocalDevice::use_global_threadpool_ = true;
 
+int NUMANodeOfDevice(const DeviceAttributes& attributes) {
+  if (attributes.device_type() != DEVICE_CPU ||
+      attributes.locality().bus_id() <= 0) {
+    return port::kNUMANoAffinity;
+  }
+  return attributes.locality().bus_id() - 1;
+}
+
 struct LocalDevice::EigenThreadPoolInfo {
-  explicit EigenThreadPoolInfo(const SessionOptions& options) {
+  // If "numa_node" is not port::kNUMANoAffinity, the threads are pinned to
+  // that node and the intra-op threads are split evenly between the nodes.
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
     if (intra_op_parallelism_threads == 0) {
       intra_op_parallelism_threads = port::NumSchedulableCPUs();
     }
+    ThreadOptions thread_options;
+    string name = "Eigen";
+    if (numa_node != port::kNUMANoAffinity) {
+      const int num_numa_nodes = port::NUMANumNodes();
+      intra_op_parallelism_threads =
+          (intra_op_parallelism_threads + num_numa_nodes - 1) / num_numa_nodes;
+      thread_options.numa_node = numa_node;
+      name = strings::StrCat("Eigen_numa", numa_node);
+    }
     VLOG(1) << "Local device intra op parallelism threads: "
             << intra_op_parallelism_threads;
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
     eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+        options.env, thread_options, name, intra_op_parallelism_threads);
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -66,16 +89,34 @@ LocalDevice::LocalDevice(const SessionOptions& options,
   // best flags for performance.
   port::WarnAboutUnusedCPUFeatures();
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  const int numa_node = NUMANodeOfDevice(attributes);
+  if (use_global_threadpool_ && numa_node != port::kNUMANoAffinity) {
+    // The ThreadPoolDevices of a NUMA node share a threadpool pinned to that
+    // node.
+    static mutex mu(LINKER_INITIALIZED);
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_infos =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>;
+    mutex_lock l(mu);
+    if (numa_tp_infos->size() <= static_cast<size_t>(numa_node)) {
+      numa_tp_infos->resize(numa_node + 1, nullptr);
+    }
+    if ((*numa_tp_infos)[numa_node] == nullptr) {
+      (*numa_tp_infos)[numa_node] =
+          new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+    }
+    tp_info = (*numa_tp_infos)[numa_node];
+  } else if (use_global_threadpool_) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options,
+                                             port::kNUMANoAffinity);
     tp_info = global_tp_info;
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
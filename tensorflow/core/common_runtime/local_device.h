@@ -27,6 +27,11 @@ class Benchmark;
 }
 struct SessionOptions;
 
+// Returns the NUMA node of a CPU device created with
+// ConfigProto.use_numa_affinity, which is recorded in the bus_id of its
+// locality, or port::kNUMANoAffinity for any other device.
+int NUMANodeOfDevice(const DeviceAttributes& attributes);
+
 // This class is shared by ThreadPoolDevice and GPUDevice and
 // initializes a shared Eigen compute device used by both.  This
 // should eventually be removed once we refactor ThreadPoolDevice and
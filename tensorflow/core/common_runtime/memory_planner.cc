@@ -0,0 +1,278 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// An output of a node, live from the position of its producer to the
+// position of its last consumer in a topological order of the graph.
+struct Value {
+  int output;  // Index in MemoryPlan::output_buffers.
+  int64 size;
+  int start;
+  int end;
+};
+
+// The values assigned to one buffer, sorted by start.
+struct BufferValues {
+  int64 size = 0;
+  std::vector<std::pair<int, int>> intervals;
+
+  bool Overlaps(int start, int end) const {
+    auto it = std::lower_bound(intervals.begin(), intervals.end(),
+                               std::make_pair(start, start));
+    if (it != intervals.end() && it->first <= end) return true;
+    return it != intervals.begin() && std::prev(it)->second >= start;
+  }
+
+  void Add(int start, int end) {
+    intervals.insert(std::lower_bound(intervals.begin(), intervals.end(),
+                                      std::make_pair(start, end)),
+                     std::make_pair(start, end));
+  }
+};
+
+bool IsStateful(const Node* n) { return n->op_def().is_stateful(); }
+
+// Returns true if the kernel of "n" does not allocate its outputs, or if
+// they live beyond the step.
+bool SkipOutputsOf(const Node* n) {
+  return !n->IsOp() || n->IsConstant() || n->IsIdentity() || IsStateful(n) ||
+         n->type_string() == "_Arg";
+}
+
+// Returns true if "n" may keep its inputs beyond the step.
+bool MayKeepInputs(const Node* n) {
+  return n->IsSend() || IsStateful(n) || n->type_string() == "_Retval";
+}
+
+// Sets "*end" to the position of the last consumer of output "index" of
+// "n", following the Identity nodes that forward it. Returns false if the
+// output may escape the step.
+bool LastUse(const Node* n, int index, const std::vector<int>& position,
+             int* end) {
+  std::vector<const Node*> forwarders;
+  for (const Edge* e : n->out_edges()) {
+    if (e->IsControlEdge() || e->src_output() != index) continue;
+    forwarders.push_back(e->dst());
+  }
+  while (!forwarders.empty()) {
+    const Node* dst = forwarders.back();
+    forwarders.pop_back();
+    if (MayKeepInputs(dst)) return false;
+    *end = std::max(*end, position[dst->id()]);
+    if (dst->IsIdentity()) {
+      for (const Edge* e : dst->out_edges()) {
+        if (!e->IsControlEdge()) forwarders.push_back(e->dst());
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void PlanMemory(const Graph& graph, const OutputSizes& output_sizes,
+                MemoryPlan* plan) {
+  *plan = MemoryPlan();
+  plan->output_starts.assign(graph.num_node_ids() + 1, 0);
+  for (const Node* n : graph.nodes()) {
+    if (n->IsEnter() || n->IsExit() || n->IsNextIteration()) return;
+  }
+
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<int> position(graph.num_node_ids(), 0);
+  for (int i = 0; i < order.size(); ++i) {
+    position[order[i]->id()] = i;
+  }
+
+  // Collect the values to plan, and give the outputs of each node with at
+  // least one of them a range in output_buffers.
+  std::vector<Value> values;
+  std::vector<int> num_outputs(graph.num_node_ids(), 0);
+  for (const Node* n : order) {
+    if (SkipOutputsOf(n)) continue;
+    auto it = output_sizes.find(n->name());
+    if (it == output_sizes.end()) continue;
+    for (int i = 0; i < n->num_outputs() && i < it->second.size(); ++i) {
+      const DataType dtype = n->output_type(i);
+      const int64 size = it->second[i];
+      if (size <= 0 || IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype)) {
+        continue;
+      }
+      int end = position[n->id()];
+      if (!LastUse(n, i, position, &end)) continue;
+      // Holds the index of the output until the ranges are known.
+      values.push_back({i, size, position[n->id()], end});
+      num_outputs[n->id()] = n->num_outputs();
+    }
+  }
+  for (int id = 0; id < graph.num_node_ids(); ++id) {
+    plan->output_starts[id + 1] = plan->output_starts[id] + num_outputs[id];
+  }
+  plan->output_buffers.assign(plan->output_starts.back(), -1);
+  for (Value& value : values) {
+    value.output += plan->output_starts[order[value.start]->id()];
+  }
+  if (values.empty()) return;
+
+  // Assign the largest values first, each to the smallest buffer that is
+  // free for its lifetime and large enough to hold it, or to a new buffer.
+  std::sort(values.begin(), values.end(), [](const Value& a, const Value& b) {
+    return a.size != b.size ? a.size > b.size : a.start < b.start;
+  });
+  std::vector<BufferValues> buffers;
+  for (const Value& value : values) {
+    int best = -1;
+    for (int b = 0; b < buffers.size(); ++b) {
+      if (buffers[b].size < value.size) continue;
+      if (best >= 0 && buffers[best].size <= buffers[b].size) continue;
+      if (!buffers[b].Overlaps(value.start, value.end)) best = b;
+    }
+    if (best < 0) {
+      best = buffers.size();
+      buffers.emplace_back();
+      buffers.back().size = value.size;
+    }
+    buffers[best].Add(value.start, value.end);
+    plan->output_buffers[value.output] = best;
+    plan->planned_bytes += value.size;
+  }
+
+  const int64 alignment = Allocator::kAllocatorAlignment;
+  for (const BufferValues& buffer : buffers) {
+    plan->buffers.push_back({plan->slab_size, buffer.size});
+    plan->slab_size += (buffer.size + alignment - 1) / alignment * alignment;
+  }
+  VLOG(1) << "Planned " << values.size() << " outputs ("
+          << plan->planned_bytes << " bytes) into " << plan->buffers.size()
+          << " buffers (" << plan->slab_size << " bytes)";
+}
+
+// Hands out the buffer of a planned output while it is not in use, and
+// forwards other allocations to the underlying allocator. Every allocation
+// holds a reference to the slab.
+class MemoryPlanSlab::BufferAllocator : public Allocator {
+ public:
+  BufferAllocator(MemoryPlanSlab* slab, char* ptr, size_t size)
+      : slab_(slab), ptr_(ptr), size_(size), in_use_(false) {}
+
+  string Name() override { return "memory_plan"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    void* ptr;
+    if (ptr_ != nullptr && num_bytes <= size_ &&
+        alignment <= kAllocatorAlignment &&
+        !in_use_.exchange(true, std::memory_order_acq_rel)) {
+      ptr = ptr_;
+    } else {
+      ptr = slab_->base_->AllocateRaw(alignment, num_bytes);
+      if (ptr == nullptr) return nullptr;
+    }
+    slab_->Ref();
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == ptr_) {
+      in_use_.store(false, std::memory_order_release);
+    } else {
+      slab_->base_->DeallocateRaw(ptr);
+    }
+    // May delete the slab, and this allocator with it.
+    slab_->Unref();
+  }
+
+ private:
+  MemoryPlanSlab* const slab_;
+  char* const ptr_;
+  const size_t size_;
+  std::atomic<bool> in_use_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BufferAllocator);
+};
+
+MemoryPlanSlab::MemoryPlanSlab(const MemoryPlan* plan, Allocator* base)
+    : plan_(plan), base_(base) {
+  if (plan->slab_size > 0) {
+    slab_ = base_->AllocateRaw(Allocator::kAllocatorAlignment,
+                               plan->slab_size);
+  }
+  // Without a slab, every allocation is forwarded to "base".
+  for (const MemoryPlan::Buffer& buffer : plan->buffers) {
+    char* ptr =
+        slab_ == nullptr ? nullptr : static_cast<char*>(slab_) + buffer.offset;
+    buffer_allocators_.push_back(new BufferAllocator(this, ptr, buffer.size));
+  }
+  output_allocators_.reserve(plan->output_buffers.size());
+  for (int b : plan->output_buffers) {
+    output_allocators_.push_back(b < 0 ? nullptr : buffer_allocators_[b]);
+  }
+}
+
+MemoryPlanSlab::~MemoryPlanSlab() {
+  for (BufferAllocator* a : buffer_allocators_) {
+    delete a;
+  }
+  if (slab_ != nullptr) {
+    base_->DeallocateRaw(slab_);
+  }
+}
+
+MemoryPlanSlabPool::MemoryPlanSlabPool(const MemoryPlan* plan,
+                                       Allocator* base,
+                                       size_t max_free_slabs)
+    : plan_(plan), base_(base), max_free_slabs_(max_free_slabs) {}
+
+MemoryPlanSlabPool::~MemoryPlanSlabPool() {
+  for (MemoryPlanSlab* slab : free_slabs_) {
+    slab->Unref();
+  }
+}
+
+MemoryPlanSlab* MemoryPlanSlabPool::Acquire() {
+  {
+    mutex_lock l(mu_);
+    if (!free_slabs_.empty()) {
+      MemoryPlanSlab* slab = free_slabs_.back();
+      free_slabs_.pop_back();
+      return slab;
+    }
+  }
+  return new MemoryPlanSlab(plan_, base_);
+}
+
+void MemoryPlanSlabPool::Release(MemoryPlanSlab* slab) {
+  {
+    mutex_lock l(mu_);
+    if (free_slabs_.size() < max_free_slabs_) {
+      free_slabs_.push_back(slab);
+      return;
+    }
+  }
+  slab->Unref();
+}
+
+}  // namespace tensorflow
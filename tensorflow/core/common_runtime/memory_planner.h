@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A static assignment of the outputs of the nodes of a graph to buffers
+// in a single slab of memory. Outputs whose lifetimes do not overlap in a
+// topological order of the graph share a buffer, in the spirit of XLA's
+// buffer assignment.
+struct MemoryPlan {
+  struct Buffer {
+    // The offset of the buffer in the slab, aligned to
+    // Allocator::kAllocatorAlignment.
+    int64 offset;
+    int64 size;
+  };
+  std::vector<Buffer> buffers;
+  int64 slab_size = 0;
+
+  // output_buffers[output_starts[id] + i] is the index in "buffers" of the
+  // buffer assigned to output i of the node with id "id", or -1 if that
+  // output has no buffer. output_starts has graph.num_node_ids() + 1
+  // entries, and the range of a node is empty if none of its outputs has a
+  // buffer.
+  std::vector<int> output_starts;
+  std::vector<int> output_buffers;
+
+  // The total size of the planned outputs, which is at least slab_size.
+  int64 planned_bytes = 0;
+};
+
+// The size in bytes of each output of a node, keyed by node name, or -1 for
+// the outputs whose size is not known statically.
+typedef std::unordered_map<string, std::vector<int64>> OutputSizes;
+
+// Computes a plan for the outputs of the nodes of "graph" that have a size
+// in "output_sizes". Only the outputs of non-ref, memcpy-able types of
+// stateless ops are planned, and outputs that are sent or returned out of
+// the graph are not, nor are the nodes that cannot be reached from the
+// source node. The plan is empty for graphs with loops, since their nodes
+// may run several times per step.
+void PlanMemory(const Graph& graph, const OutputSizes& output_sizes,
+                MemoryPlan* plan);
+
+// The memory of a MemoryPlan for one executor, which provides an allocator
+// for each planned output that returns the buffer of that output.
+//
+// The plan assumes that the kernels run in a topological order and that
+// their outputs die after their last consumer has run, but neither needs to
+// hold: kernels run concurrently, forward their inputs to their outputs,
+// and outputs can escape the step. A buffer is therefore only handed out
+// while it is not in use, and allocations that find their buffer in use or
+// that do not fit it are forwarded to the underlying allocator, so that the
+// plan only affects performance.
+//
+// The slab deletes itself once its owner has called Unref() and all the
+// tensors allocated from it have been deallocated.
+class MemoryPlanSlab : public core::RefCounted {
+ public:
+  // "plan" and "base" are not owned. "plan" must stay valid until the
+  // owner calls Unref(), and "base" must outlive all the tensors allocated
+  // from this object.
+  MemoryPlanSlab(const MemoryPlan* plan, Allocator* base);
+
+  // Returns an array with an allocator for each output of the node with id
+  // "node_id", or nullptr for the outputs without a buffer. Returns nullptr
+  // if no output of that node has a buffer.
+  Allocator* const* OutputAllocators(int node_id) const {
+    const int start = plan_->output_starts[node_id];
+    return start < plan_->output_starts[node_id + 1]
+               ? &output_allocators_[start]
+               : nullptr;
+  }
+
+ private:
+  class BufferAllocator;
+
+  ~MemoryPlanSlab() override;
+
+  const MemoryPlan* const plan_;
+  Allocator* const base_;
+  void* slab_ = nullptr;
+  std::vector<BufferAllocator*> buffer_allocators_;
+  std::vector<Allocator*> output_allocators_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanSlab);
+};
+
+// The slabs of a MemoryPlan shared by the steps of one executor. A step
+// acquires a slab when it starts and releases it when it finishes, so that
+// steps that run one after the other share a single slab and a slab per
+// step is only allocated while steps run concurrently. Thread-safe.
+class MemoryPlanSlabPool {
+ public:
+  // "plan" and "base" are not owned, and must outlive this object. At most
+  // "max_free_slabs" released slabs are kept for later steps.
+  MemoryPlanSlabPool(const MemoryPlan* plan, Allocator* base,
+                     size_t max_free_slabs);
+  ~MemoryPlanSlabPool();
+
+  // Returns a slab that no other step uses, which must be handed back with
+  // Release().
+  MemoryPlanSlab* Acquire();
+  void Release(MemoryPlanSlab* slab);
+
+ private:
+  const MemoryPlan* const plan_;
+  Allocator* const base_;
+  const size_t max_free_slabs_;
+
+  mutex mu_;
+  std::vector<MemoryPlanSlab*> free_slabs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanSlabPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
@@ -0,0 +1,222 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const int64 kSize = 1024;
+
+// Builds a chain of "length" Neg nodes, the last of which is sent out of the
+// graph, and gives all the nodes an output of kSize bytes.
+std::vector<Node*> Chain(Graph* g, int length, OutputSizes* sizes) {
+  Tensor t(DT_FLOAT, TensorShape({kSize / 4}));
+  t.flat<float>().setZero();
+  std::vector<Node*> nodes;
+  nodes.push_back(test::graph::Constant(g, t));
+  for (int i = 0; i < length; ++i) {
+    nodes.push_back(test::graph::Unary(g, "Neg", nodes.back()));
+  }
+  test::graph::Send(g, nodes.back(), "out", "/job:a/replica:0/task:0/cpu:0",
+                    1, "/job:a/replica:0/task:0/cpu:0");
+  FixupSourceAndSinkEdges(g);
+  for (Node* n : nodes) {
+    (*sizes)[n->name()] = {kSize};
+  }
+  return nodes;
+}
+
+int BufferOf(const MemoryPlan& plan, const Node* n, int index) {
+  const int start = plan.output_starts[n->id()];
+  if (start == plan.output_starts[n->id() + 1]) return -1;
+  return plan.output_buffers[start + index];
+}
+
+TEST(MemoryPlannerTest, ChainUsesTwoBuffers) {
+  Graph g(OpRegistry::Global());
+  OutputSizes sizes;
+  std::vector<Node*> nodes = Chain(&g, 8, &sizes);
+  MemoryPlan plan;
+  PlanMemory(g, sizes, &plan);
+
+  // Constants and the sent output are not planned.
+  EXPECT_EQ(-1, BufferOf(plan, nodes.front(), 0));
+  EXPECT_EQ(-1, BufferOf(plan, nodes.back(), 0));
+  // Each output only overlaps with its producer's and consumer's, so the
+  // other 7 outputs alternate between two buffers.
+  ASSERT_EQ(2, plan.buffers.size());
+  EXPECT_EQ(2 * kSize, plan.slab_size);
+  EXPECT_EQ(7 * kSize, plan.planned_bytes);
+  for (int i = 1; i + 3 < nodes.size(); ++i) {
+    EXPECT_NE(BufferOf(plan, nodes[i], 0), BufferOf(plan, nodes[i + 1], 0));
+    EXPECT_EQ(BufferOf(plan, nodes[i], 0), BufferOf(plan, nodes[i + 2], 0));
+  }
+  for (const MemoryPlan::Buffer& buffer : plan.buffers) {
+    EXPECT_EQ(kSize, buffer.size);
+    EXPECT_EQ(0, buffer.offset % Allocator::kAllocatorAlignment);
+  }
+}
+
+TEST(MemoryPlannerTest, OutputsWithUnknownSizeAreNotPlanned) {
+  Graph g(OpRegistry::Global());
+  OutputSizes sizes;
+  std::vector<Node*> nodes = Chain(&g, 4, &sizes);
+  sizes[nodes[2]->name()] = {-1};
+  MemoryPlan plan;
+  PlanMemory(g, sizes, &plan);
+  EXPECT_EQ(-1, BufferOf(plan, nodes[2], 0));
+  EXPECT_NE(-1, BufferOf(plan, nodes[1], 0));
+  EXPECT_NE(-1, BufferOf(plan, nodes[3], 0));
+}
+
+TEST(MemoryPlannerTest, LoopsAreNotPlanned) {
+  Graph g(OpRegistry::Global());
+  OutputSizes sizes;
+  std::vector<Node*> nodes = Chain(&g, 4, &sizes);
+  test::graph::Enter(&g, nodes[1], "frame");
+  FixupSourceAndSinkEdges(&g);
+  MemoryPlan plan;
+  PlanMemory(g, sizes, &plan);
+  EXPECT_TRUE(plan.buffers.empty());
+  EXPECT_EQ(-1, BufferOf(plan, nodes[1], 0));
+}
+
+TEST(MemoryPlanSlabTest, BuffersAreHandedOutOnceAtATime) {
+  Graph g(OpRegistry::Global());
+  OutputSizes sizes;
+  std::vector<Node*> nodes = Chain(&g, 4, &sizes);
+  MemoryPlan plan;
+  PlanMemory(g, sizes, &plan);
+
+  MemoryPlanSlab* slab = new MemoryPlanSlab(&plan, cpu_allocator());
+  Allocator* a = slab->OutputAllocators(nodes[1]->id())[0];
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(nullptr, slab->OutputAllocators(nodes[0]->id()));
+
+  Tensor t1(a, DT_FLOAT, TensorShape({kSize / 4}));
+  t1.flat<float>().setConstant(1.0);
+  // The buffer is in use, and outputs that do not fit it are forwarded.
+  Tensor t2(a, DT_FLOAT, TensorShape({kSize / 4}));
+  Tensor t3(a, DT_FLOAT, TensorShape({kSize}));
+  EXPECT_NE(t1.tensor_data().data(), t2.tensor_data().data());
+  t2.flat<float>().setConstant(2.0);
+  t3.flat<float>().setConstant(3.0);
+
+  // Once deallocated, the buffer is handed out again.
+  const char* buffer = t1.tensor_data().data();
+  t1 = Tensor();
+  Tensor t4(a, DT_FLOAT, TensorShape({kSize / 8}));
+  EXPECT_EQ(buffer, t4.tensor_data().data());
+
+  // The tensors outlive the owner's reference to the slab.
+  slab->Unref();
+  t4.flat<float>().setConstant(4.0);
+  EXPECT_EQ(2.0, t2.flat<float>()(0));
+  EXPECT_EQ(3.0, t3.flat<float>()(kSize - 1));
+  EXPECT_EQ(4.0, t4.flat<float>()(0));
+}
+
+// Counts the bytes allocated from cpu_allocator() through it.
+class PeakBytesAllocator : public Allocator {
+ public:
+  string Name() override { return "peak_bytes"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    void* ptr = cpu_allocator()->AllocateRaw(alignment, num_bytes);
+    mutex_lock l(mu_);
+    sizes_[ptr] = num_bytes;
+    bytes_in_use_ += num_bytes;
+    peak_bytes_ = std::max(peak_bytes_, bytes_in_use_);
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    {
+      mutex_lock l(mu_);
+      bytes_in_use_ -= sizes_[ptr];
+      sizes_.erase(ptr);
+    }
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+
+  size_t bytes_in_use() {
+    mutex_lock l(mu_);
+    return bytes_in_use_;
+  }
+
+  size_t peak_bytes() {
+    mutex_lock l(mu_);
+    return peak_bytes_;
+  }
+
+ private:
+  mutex mu_;
+  std::unordered_map<void*, size_t> sizes_ GUARDED_BY(mu_);
+  size_t bytes_in_use_ GUARDED_BY(mu_) = 0;
+  size_t peak_bytes_ GUARDED_BY(mu_) = 0;
+};
+
+TEST(MemoryPlanSlabPoolTest, SlabsAreOnlyMultipliedByConcurrentSteps) {
+  Graph g(OpRegistry::Global());
+  OutputSizes sizes;
+  std::vector<Node*> nodes = Chain(&g, 8, &sizes);
+  MemoryPlan plan;
+  PlanMemory(g, sizes, &plan);
+  ASSERT_EQ(2 * kSize, plan.slab_size);
+
+  PeakBytesAllocator base;
+  {
+    MemoryPlanSlabPool pool(&plan, &base, 1);
+    // Steps that run one after the other share a slab.
+    for (int i = 0; i < 10; ++i) {
+      MemoryPlanSlab* slab = pool.Acquire();
+      Tensor t(slab->OutputAllocators(nodes[1]->id())[0], DT_FLOAT,
+               TensorShape({kSize / 4}));
+      t.flat<float>().setConstant(i);
+      pool.Release(slab);
+    }
+    EXPECT_EQ(plan.slab_size, base.peak_bytes());
+    EXPECT_EQ(plan.slab_size, base.bytes_in_use());
+
+    // Concurrent steps each get their own slab, and only one is kept once
+    // they have finished.
+    std::vector<MemoryPlanSlab*> slabs;
+    for (int i = 0; i < 3; ++i) {
+      slabs.push_back(pool.Acquire());
+    }
+    EXPECT_EQ(3 * plan.slab_size, base.peak_bytes());
+    for (MemoryPlanSlab* slab : slabs) {
+      pool.Release(slab);
+    }
+    EXPECT_EQ(plan.slab_size, base.bytes_in_use());
+  }
+  EXPECT_EQ(0, base.bytes_in_use());
+}
+
+}  // namespace
+}  // namespace tensorflow
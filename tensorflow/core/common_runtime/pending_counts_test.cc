@@ -13,10 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -75,6 +78,31 @@ TEST(PendingCounts, CopyConstructor) {
   }
 }
 
+TEST(PendingCounts, CopyFrom) {
+  const int C = 300;
+  PendingCounts::Layout layout;
+  std::vector<PendingCounts::Handle> h(C);
+  for (int id = 0; id < C; id++) {
+    h[id] = layout.CreateHandle(id, id);
+  }
+  PendingCounts c(layout);
+  for (int id = 0; id < C; id++) {
+    c.set_initial_count(h[id], id);
+  }
+  PendingCounts c2(c);
+  for (int id = 0; id < C; id++) {
+    c2.decrement_pending(h[id], id);
+    c2.increment_dead_count(h[id]);
+    c2.mark_started(h[id]);
+  }
+  c2.CopyFrom(c);
+  for (int id = 0; id < C; id++) {
+    EXPECT_EQ(id, c2.pending(h[id]));
+    EXPECT_EQ(0, c2.dead_count(h[id]));
+    EXPECT_EQ(c.node_state(h[id]), c2.node_state(h[id]));
+  }
+}
+
 TEST(PendingCounts, MarkLiveShowsUpAsCount) {
   PendingCounts::Layout layout;
   PendingCounts::Handle handles[2];
@@ -166,4 +194,67 @@ TEST(PendingCounts, AdjustForActivation) {
   }
 }
 
+TEST(PendingCounts, AdjustForActivationAtomic) {
+  PendingCounts::Layout layout;
+  PendingCounts::Handle handles[2];
+  const int kCount[2] = {5, 100};
+  handles[0] = layout.CreateHandle(kCount[0], 0);
+  handles[1] = layout.CreateHandle(kCount[1], 0);
+  PendingCounts c(layout);
+  c.set_initial_count(handles[0], kCount[0]);
+  c.set_initial_count(handles[1], kCount[1]);
+
+  // Decrement both counts concurrently, one thread per pending input.
+  std::atomic<int> num_ready[2];
+  num_ready[0] = 0;
+  num_ready[1] = 0;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int id = 0; id < 2; id++) {
+      for (int i = 0; i < kCount[id]; i++) {
+        pool.Schedule([&c, &handles, &num_ready, id]() {
+          int pending, dead;
+          c.adjust_for_activation_atomic(handles[id], false, &pending, &dead);
+          EXPECT_EQ(dead, 0);
+          if (pending == 0) num_ready[id]++;
+        });
+      }
+    }
+  }
+  for (int id = 0; id < 2; id++) {
+    // Exactly one caller observes the count reaching zero.
+    EXPECT_EQ(num_ready[id], 1);
+    EXPECT_EQ(c.pending(handles[id]), 0);
+    EXPECT_EQ(c.node_state(handles[id]), PendingCounts::PENDING_READY);
+  }
+}
+
+TEST(PendingCounts, AdjustForActivationAtomicDeadCount) {
+  PendingCounts::Layout layout;
+  PendingCounts::Handle handles[2];
+  handles[0] = layout.CreateHandle(5, 4);
+  handles[1] = layout.CreateHandle(15, 4);
+  for (int id = 0; id < 2; id++) {
+    PendingCounts::Handle h = handles[id];
+    // Test for both packed and large.
+    int count = (id == 0) ? 5 : 15;
+    int pending, dead;
+
+    PendingCounts c(layout);
+    c.set_initial_count(h, count);
+
+    c.adjust_for_activation_atomic(h, false, &pending, &dead);
+    EXPECT_EQ(c.pending(h), count - 1);
+    EXPECT_EQ(c.pending(h), pending);
+    EXPECT_EQ(c.dead_count(h), 0);
+    EXPECT_EQ(c.dead_count(h), dead);
+
+    c.adjust_for_activation_atomic(h, true, &pending, &dead);
+    EXPECT_EQ(c.pending(h), count - 2);
+    EXPECT_EQ(c.pending(h), pending);
+    EXPECT_EQ(c.dead_count(h), dead);
+    EXPECT_EQ(c.dead_count(h), 1);
+  }
+}
+
 }  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/numa.h"
 
 namespace tensorflow {
 
@@ -614,6 +616,30 @@ bool IsGeneratorNode(const Node* node) {
          !IsRefType(node->output_type(0));
 }
 
+// Returns the device of the data inputs of "node" that have been assigned or
+// that can only be assigned to one device, or the empty string if there are
+// none or if they are on different devices.
+string CommonDataInputDevice(const Node* node,
+                             ColocationGraph* colocation_graph) {
+  string device_name;
+  std::vector<Device*> input_devices;
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge() || !e->src()->IsOp()) continue;
+    string input_device_name = e->src()->assigned_device_name();
+    if (input_device_name.empty() &&
+        colocation_graph->GetDevicesForNode(e->src(), &input_devices).ok() &&
+        input_devices.size() == 1) {
+      input_device_name = input_devices[0]->name();
+    }
+    if (input_device_name.empty()) continue;
+    if (!device_name.empty() && device_name != input_device_name) {
+      return "";
+    }
+    device_name = input_device_name;
+  }
+  return device_name;
+}
+
 }  // namespace
 
 SimplePlacer::SimplePlacer(Graph* graph, const DeviceSet* devices,
@@ -765,6 +791,17 @@ Status SimplePlacer::Run() {
       if (CanAssignToDevice(input_device_name, devices)) {
         assigned_device = input_device_name;
       }
+    } else if (NUMANodeOfDevice(devices[0]->attributes()) !=
+               port::kNUMANoAffinity) {
+      // Heuristic C: If the node would go to the CPU device of a NUMA node
+      // (see ConfigProto.use_numa_affinity), place it with its data inputs
+      // when they are all on one device, so that subgraphs rooted at nodes
+      // placed on another NUMA node stay on that node.
+      const string input_device_name =
+          CommonDataInputDevice(node, &colocation_graph);
+      if (CanAssignToDevice(input_device_name, devices)) {
+        assigned_device = input_device_name;
+      }
     }
 
     AssignAndLog(assigned_device, node);
@@ -0,0 +1,281 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+// A chunk starts with this header, which is followed by the allocations.
+struct StepArenaAllocator::Chunk {
+  // One reference for the allocator while the chunk is current_, in
+  // used_chunks_ or in free_chunks_, plus one for each live allocation in
+  // the chunk.
+  std::atomic<int64> refs;
+  // The size of the chunk, including this header.
+  size_t size;
+  // The offset of the first free byte in the chunk.
+  size_t next;
+};
+
+namespace {
+
+// The most chunks without allocations that are kept for reuse.
+const size_t kMaxFreeChunks = 4;
+
+// Precedes every allocation returned by StepArenaAllocator.
+struct AllocationHeader {
+  // The chunk the allocation was carved from, or nullptr if it was
+  // forwarded to the underlying allocator.
+  void* chunk;
+  // The pointer returned by the underlying allocator, if chunk is nullptr.
+  void* base_ptr;
+};
+
+inline uintptr_t RoundUp(uintptr_t value, size_t alignment) {
+  return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+}
+
+inline AllocationHeader* HeaderOf(void* ptr) {
+  return reinterpret_cast<AllocationHeader*>(ptr) - 1;
+}
+
+}  // namespace
+
+StepArenaAllocator::StepArenaAllocator(Allocator* base, size_t min_chunk_size,
+                                       size_t max_chunk_size)
+    : base_(base),
+      max_chunk_size_(max_chunk_size),
+      max_arena_allocation_size_(max_chunk_size / 4),
+      chunk_size_(min_chunk_size),
+      num_chunks_(0) {
+  CHECK_GE(min_chunk_size, 4096);
+  CHECK_LE(min_chunk_size, max_chunk_size);
+}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  DCHECK(current_ == nullptr);
+  DCHECK(used_chunks_.empty());
+  DCHECK(free_chunks_.empty());
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  DCHECK_EQ(alignment & (alignment - 1), 0);
+  if (num_bytes + alignment + sizeof(AllocationHeader) >
+      max_arena_allocation_size_) {
+    // Forward large allocations to the underlying allocator. The allocation
+    // holds a reference to this allocator, since the tensor will call
+    // DeallocateRaw() on it.
+    const size_t offset = RoundUp(sizeof(AllocationHeader), alignment);
+    void* base_ptr = base_->AllocateRaw(alignment, num_bytes + offset);
+    if (base_ptr == nullptr) return nullptr;
+    Ref();
+    void* ptr = static_cast<char*>(base_ptr) + offset;
+    AllocationHeader* header = HeaderOf(ptr);
+    header->chunk = nullptr;
+    header->base_ptr = base_ptr;
+    return ptr;
+  }
+
+  Chunk* chunk = nullptr;
+  uintptr_t ptr = 0;
+  std::vector<Chunk*> to_delete;
+  {
+    mutex_lock l(mu_);
+    if (current_ != nullptr) {
+      const uintptr_t start = reinterpret_cast<uintptr_t>(current_);
+      ptr = RoundUp(start + current_->next + sizeof(AllocationHeader),
+                    alignment);
+      if (ptr + num_bytes <= start + current_->size) {
+        chunk = current_;
+      } else {
+        // No allocation can race with this check, so a chunk that only
+        // holds the reference of this allocator stays empty.
+        if (current_->refs.load(std::memory_order_acquire) == 1) {
+          RecycleChunk(current_, &to_delete);
+        } else {
+          used_chunks_.insert(current_);
+        }
+        current_ = nullptr;
+      }
+    }
+    if (chunk == nullptr) {
+      current_ = GetChunk(sizeof(Chunk) + sizeof(AllocationHeader) +
+                              alignment + num_bytes,
+                          &to_delete);
+      if (current_ != nullptr) {
+        chunk = current_;
+        ptr = RoundUp(reinterpret_cast<uintptr_t>(chunk) + sizeof(Chunk) +
+                          sizeof(AllocationHeader),
+                      alignment);
+      }
+    }
+    if (chunk != nullptr) {
+      chunk->next = ptr + num_bytes - reinterpret_cast<uintptr_t>(chunk);
+      chunk->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  for (Chunk* c : to_delete) {
+    UnrefChunk(c);
+  }
+  if (chunk == nullptr) return nullptr;
+  AllocationHeader* header = HeaderOf(reinterpret_cast<void*>(ptr));
+  header->chunk = chunk;
+  header->base_ptr = nullptr;
+  return reinterpret_cast<void*>(ptr);
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  AllocationHeader* header = HeaderOf(ptr);
+  if (header->chunk == nullptr) {
+    base_->DeallocateRaw(header->base_ptr);
+    Unref();
+    return;
+  }
+  Chunk* chunk = static_cast<Chunk*>(header->chunk);
+  const int64 refs = chunk->refs.fetch_sub(1, std::memory_order_acq_rel);
+  if (refs == 2) {
+    ChunkEmptied(chunk);
+  } else if (refs == 1) {
+    FreeChunk(chunk);
+  }
+}
+
+bool StepArenaAllocator::Contains(const void* ptr) {
+  auto in_chunk = [ptr](const Chunk* chunk) {
+    const char* start = reinterpret_cast<const char*>(chunk);
+    return ptr >= start && ptr < start + chunk->size;
+  };
+  mutex_lock l(mu_);
+  if (current_ != nullptr && in_chunk(current_)) return true;
+  for (const Chunk* chunk : used_chunks_) {
+    if (in_chunk(chunk)) return true;
+  }
+  return false;
+}
+
+StepArenaAllocator::Chunk* StepArenaAllocator::GetChunk(
+    size_t min_size, std::vector<Chunk*>* to_delete) {
+  if (!used_chunks_.empty()) {
+    // The live allocations do not fit one chunk.
+    chunk_size_ = std::min(2 * chunk_size_, max_chunk_size_);
+  }
+  while (chunk_size_ < min_size) {
+    chunk_size_ *= 2;
+  }
+  while (!free_chunks_.empty()) {
+    Chunk* chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+    if (chunk->size == chunk_size_) return chunk;
+    to_delete->push_back(chunk);
+  }
+  void* mem = base_->AllocateRaw(Allocator::kAllocatorAlignment, chunk_size_);
+  if (mem == nullptr) return nullptr;
+  // Each chunk holds a reference to this allocator, which must outlive the
+  // tensors allocated from it.
+  Ref();
+  num_chunks_.fetch_add(1, std::memory_order_relaxed);
+  Chunk* chunk = new (mem) Chunk;
+  chunk->refs.store(1, std::memory_order_relaxed);
+  chunk->size = chunk_size_;
+  chunk->next = sizeof(Chunk);
+  return chunk;
+}
+
+void StepArenaAllocator::RecycleChunk(Chunk* chunk,
+                                      std::vector<Chunk*>* to_delete) {
+  if (chunk->size == chunk_size_ && free_chunks_.size() < kMaxFreeChunks) {
+    chunk->next = sizeof(Chunk);
+    free_chunks_.push_back(chunk);
+  } else {
+    to_delete->push_back(chunk);
+  }
+}
+
+void StepArenaAllocator::ChunkEmptied(Chunk* chunk) {
+  std::vector<Chunk*> to_delete;
+  {
+    mutex_lock l(mu_);
+    // Unless this allocator still holds its reference to "chunk", the
+    // chunk may already have been returned to the underlying allocator.
+    // Otherwise allocations only add references to current_, under mu_, so
+    // the check below cannot race with them.
+    if (chunk == current_) {
+      if (chunk->refs.load(std::memory_order_acquire) == 1) {
+        // Allocate from the start of the chunk again.
+        chunk->next = sizeof(Chunk);
+      }
+    } else {
+      auto it = used_chunks_.find(chunk);
+      if (it != used_chunks_.end() &&
+          chunk->refs.load(std::memory_order_acquire) == 1) {
+        used_chunks_.erase(it);
+        RecycleChunk(chunk, &to_delete);
+      }
+    }
+  }
+  for (Chunk* c : to_delete) {
+    UnrefChunk(c);
+  }
+}
+
+void StepArenaAllocator::UnrefChunk(Chunk* chunk) {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    FreeChunk(chunk);
+  }
+}
+
+void StepArenaAllocator::FreeChunk(Chunk* chunk) {
+  chunk->~Chunk();
+  base_->DeallocateRaw(chunk);
+  num_chunks_.fetch_sub(1, std::memory_order_relaxed);
+  // May delete this allocator.
+  Unref();
+}
+
+void StepArenaAllocator::Release() {
+  std::vector<Chunk*> chunks;
+  {
+    mutex_lock l(mu_);
+    chunks.assign(used_chunks_.begin(), used_chunks_.end());
+    used_chunks_.clear();
+    chunks.insert(chunks.end(), free_chunks_.begin(), free_chunks_.end());
+    free_chunks_.clear();
+    if (current_ != nullptr) {
+      chunks.push_back(current_);
+      current_ = nullptr;
+    }
+  }
+  // The chunks that still contain live allocations are returned to the
+  // underlying allocator when the last of them is deallocated.
+  for (Chunk* chunk : chunks) {
+    UnrefChunk(chunk);
+  }
+  Unref();
+}
+
+int64 StepArenaAllocator::NumChunks() {
+  return num_chunks_.load(std::memory_order_relaxed);
+}
+
+size_t StepArenaAllocator::ChunkSize() {
+  mutex_lock l(mu_);
+  return chunk_size_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,131 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for the tensors of the steps run by one executor, which
+// carves small allocations out of large chunks obtained from an underlying
+// allocator by bumping a pointer, instead of going to the underlying
+// allocator (typically malloc) for every tensor.
+//
+// All the steps of the executor share the allocator. A chunk is reused as
+// soon as all the tensors allocated from it have been deallocated, which is
+// the case for all the intermediate tensors of a step, so steps that run
+// one after the other keep reusing the same memory. Tensors that escape the
+// step, like fetched outputs or buffers forwarded to a variable, keep their
+// chunk alive until they are deallocated; this is always safe, but holds on
+// to the whole chunk, so the executor copies small escaping tensors out of
+// the arena (see Contains()).
+//
+// New chunks start at "min_chunk_size" bytes, and double up to
+// "max_chunk_size" whenever a chunk is needed while another one still holds
+// live allocations, so that the chunks fit the memory the steps actually
+// use. Allocations larger than a quarter of "max_chunk_size" are forwarded
+// to the underlying allocator.
+//
+// All methods are thread-safe. The allocator deletes itself once its owner
+// has called Release() and all the tensors allocated from it have been
+// deallocated.
+class StepArenaAllocator : public Allocator, public core::RefCounted {
+ public:
+  // "base" is not owned, and must outlive all the tensors allocated from
+  // this allocator.
+  StepArenaAllocator(Allocator* base, size_t min_chunk_size,
+                     size_t max_chunk_size);
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+
+  // Returns true if "ptr" points into a chunk of this allocator, as opposed
+  // to memory that was forwarded to the underlying allocator.
+  bool Contains(const void* ptr);
+
+  // Drops the reference of the owner, which must not use the allocator
+  // afterwards. Owners call this instead of Unref().
+  void Release();
+
+  // Returns the number of chunks obtained from the underlying allocator
+  // that have not been returned to it. For testing.
+  int64 NumChunks();
+
+  // Returns the size of the next chunk to be obtained from the underlying
+  // allocator. For testing.
+  size_t ChunkSize();
+
+ private:
+  struct Chunk;
+
+  ~StepArenaAllocator() override;
+
+  // Returns a chunk of at least "min_size" bytes with no allocations in it,
+  // reusing a free one if possible. Returns nullptr if the underlying
+  // allocator is out of memory. Appends the free chunks that are too small
+  // to be reused to "*to_delete".
+  Chunk* GetChunk(size_t min_size, std::vector<Chunk*>* to_delete)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Makes "chunk", which holds no allocations and is not current_, free
+  // for reuse, or appends it to "*to_delete" if enough chunks are free.
+  void RecycleChunk(Chunk* chunk, std::vector<Chunk*>* to_delete)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called when only the reference of this allocator to "chunk" is left.
+  void ChunkEmptied(Chunk* chunk);
+
+  // Drops a reference to "chunk", and returns it to the underlying
+  // allocator if it was the last one.
+  void UnrefChunk(Chunk* chunk);
+
+  // Returns "chunk", which has no references left, to the underlying
+  // allocator.
+  void FreeChunk(Chunk* chunk);
+
+  Allocator* const base_;
+  const size_t max_chunk_size_;
+  const size_t max_arena_allocation_size_;
+
+  mutex mu_;
+  // The size of the next chunk to obtain from base_.
+  size_t chunk_size_ GUARDED_BY(mu_);
+  // The chunk that allocations are carved from.
+  Chunk* current_ GUARDED_BY(mu_) = nullptr;
+  // The other chunks that contain live allocations.
+  std::unordered_set<Chunk*> used_chunks_ GUARDED_BY(mu_);
+  // Chunks without allocations, of chunk_size_ bytes.
+  std::vector<Chunk*> free_chunks_ GUARDED_BY(mu_);
+
+  std::atomic<int64> num_chunks_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,191 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+static const size_t kMinChunkSize = 1 << 16;
+static const size_t kMaxChunkSize = 1 << 18;
+
+StepArenaAllocator* NewArena() {
+  return new StepArenaAllocator(cpu_allocator(), kMinChunkSize, kMaxChunkSize);
+}
+
+TEST(StepArenaAllocatorTest, AllocationsAreAligned) {
+  StepArenaAllocator* a = NewArena();
+  std::vector<void*> ptrs;
+  for (size_t size = 1; size < 2 * kMaxChunkSize; size = size * 3 + 1) {
+    for (size_t alignment : {8, 16, 64, 256}) {
+      void* p = a->AllocateRaw(alignment, size);
+      ASSERT_NE(p, nullptr);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0);
+      memset(p, 0xab, size);
+      ptrs.push_back(p);
+    }
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, ChunksAreReusedAcrossSteps) {
+  StepArenaAllocator* a = NewArena();
+  int64 num_chunks = 0;
+  for (int step = 0; step < 10; ++step) {
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 100; ++i) {
+      ptrs.push_back(a->AllocateRaw(Allocator::kAllocatorAlignment, 1000));
+    }
+    for (void* p : ptrs) {
+      a->DeallocateRaw(p);
+    }
+    if (step == 1) {
+      num_chunks = a->NumChunks();
+    } else if (step > 1) {
+      EXPECT_EQ(num_chunks, a->NumChunks());
+    }
+  }
+  // The steps need about 100KB, so the chunks grew to hold a whole step.
+  EXPECT_EQ(2 * kMinChunkSize, a->ChunkSize());
+  EXPECT_EQ(1, num_chunks);
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, ChunksFitSmallSteps) {
+  StepArenaAllocator* a = NewArena();
+  for (int step = 0; step < 10; ++step) {
+    Tensor t(a, DT_FLOAT, TensorShape({16}));
+    Tensor u(a, DT_FLOAT, TensorShape({16}));
+  }
+  EXPECT_EQ(kMinChunkSize, a->ChunkSize());
+  EXPECT_EQ(1, a->NumChunks());
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, FreeChunksAreBounded) {
+  StepArenaAllocator* a = NewArena();
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(
+        a->AllocateRaw(Allocator::kAllocatorAlignment, kMaxChunkSize / 8));
+  }
+  EXPECT_GT(a->NumChunks(), 8);
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  // The current chunk, and a few free ones.
+  EXPECT_LE(a->NumChunks(), 5);
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, EscapingTensorsPinTheirChunk) {
+  StepArenaAllocator* a = NewArena();
+  Tensor escaped;
+  {
+    Tensor t(a, DT_FLOAT, TensorShape({16}));
+    t.flat<float>().setConstant(42.0);
+    escaped = t;
+  }
+  EXPECT_TRUE(a->Contains(escaped.tensor_data().data()));
+  // The next step does not overwrite "escaped".
+  {
+    Tensor t(a, DT_FLOAT, TensorShape({16}));
+    t.flat<float>().setConstant(0.0);
+  }
+  EXPECT_EQ(1, a->NumChunks());
+  // The escaped tensor outlives the release of the allocator.
+  a->Release();
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(42.0, escaped.flat<float>()(i));
+  }
+  // Deallocating the escaped tensor deletes the allocator.
+  escaped = Tensor();
+}
+
+TEST(StepArenaAllocatorTest, LargeAllocationsAreForwarded) {
+  StepArenaAllocator* a = NewArena();
+  Tensor large(a, DT_UINT8, TensorShape({kMaxChunkSize}));
+  Tensor small(a, DT_UINT8, TensorShape({16}));
+  EXPECT_FALSE(a->Contains(large.tensor_data().data()));
+  EXPECT_TRUE(a->Contains(small.tensor_data().data()));
+  EXPECT_EQ(1, a->NumChunks());
+  a->Release();
+}
+
+TEST(StepArenaAllocatorTest, ConcurrentAllocations) {
+  StepArenaAllocator* a = NewArena();
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int i = 0; i < 64; ++i) {
+      pool.Schedule([a, i]() {
+        std::vector<Tensor> tensors;
+        for (int j = 0; j < 100; ++j) {
+          tensors.emplace_back(a, DT_INT32, TensorShape({(i + j) % 50 + 1}));
+          tensors.back().flat<int32>().setConstant(i);
+        }
+        for (const Tensor& t : tensors) {
+          for (int k = 0; k < t.NumElements(); ++k) {
+            EXPECT_EQ(i, t.flat<int32>()(k));
+          }
+        }
+      });
+    }
+  }
+  a->Release();
+}
+
+static void BM_Allocate(int iters, int num_tensors, bool arena) {
+  testing::StopTiming();
+  StepArenaAllocator* a = NewArena();
+  Allocator* allocator = arena ? static_cast<Allocator*>(a) : cpu_allocator();
+  std::vector<Tensor> tensors(num_tensors);
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_tensors);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < num_tensors; ++j) {
+      tensors[j] = Tensor(allocator, DT_FLOAT, TensorShape({j % 64 + 1}));
+    }
+    for (int j = 0; j < num_tensors; ++j) {
+      tensors[j] = Tensor();
+    }
+  }
+  testing::StopTiming();
+  a->Release();
+}
+
+static void BM_AllocateCPU(int iters, int num_tensors) {
+  BM_Allocate(iters, num_tensors, false);
+}
+BENCHMARK(BM_AllocateCPU)->Arg(16)->Arg(256);
+
+static void BM_AllocateStepArena(int iters, int num_tensors) {
+  BM_Allocate(iters, num_tensors, true);
+}
+BENCHMARK(BM_AllocateStepArena)->Arg(16)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,19 +17,79 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
 #include <vector>
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
 
+namespace {
+
+// Allocates the regions of a BFCAllocator on the memory of one NUMA node.
+class NUMASubAllocator : public SubAllocator {
+ public:
+  explicit NUMASubAllocator(int numa_node) : numa_node_(numa_node) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::NUMAMalloc(numa_node_, num_bytes, alignment);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    port::NUMAFree(ptr, num_bytes);
+  }
+
+ private:
+  const int numa_node_;
+};
+
+// Returns the process-wide allocator of the CPU device of NUMA node
+// "numa_node". The allocators are never deleted, like cpu_allocator().
+Allocator* NUMACPUAllocator(int numa_node) {
+  // Effectively unlimited: the regions grow on demand.
+  const size_t kMaxMemoryPerNode = size_t{1} << 40;
+  static mutex mu(LINKER_INITIALIZED);
+  static std::vector<Allocator*>* allocators = new std::vector<Allocator*>;
+  mutex_lock l(mu);
+  if (allocators->size() <= static_cast<size_t>(numa_node)) {
+    allocators->resize(numa_node + 1, nullptr);
+  }
+  Allocator*& allocator = (*allocators)[numa_node];
+  if (allocator == nullptr) {
+    allocator = new BFCAllocator(new NUMASubAllocator(numa_node),
+                                 kMaxMemoryPerNode, /*allow_growth=*/true,
+                                 strings::StrCat("numa_cpu_", numa_node));
+  }
+  return allocator;
+}
+
+}  // namespace
+
 // TODO(zhifengc/tucker): Figure out the bytes of available RAM.
 class ThreadPoolDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    // TODO(zhifengc/tucker): Figure out the number of available CPUs
-    // and/or NUMA configuration.
+    // With ConfigProto.use_numa_affinity, expose one CPU device per NUMA
+    // node, whose intra-op threads are pinned to the node (see LocalDevice)
+    // and whose memory is allocated on the node. The node is recorded in the
+    // bus_id of the device locality.
+    const int num_numa_nodes = port::NUMANumNodes();
+    if (options.config.use_numa_affinity() && num_numa_nodes > 1) {
+      for (int i = 0; i < num_numa_nodes; ++i) {
+        string name = strings::StrCat(name_prefix, "/cpu:", i);
+        DeviceLocality locality;
+        locality.set_bus_id(i + 1);
+        devices->push_back(new ThreadPoolDevice(options, name,
+                                                Bytes(256 << 20), locality,
+                                                NUMACPUAllocator(i)));
+      }
+      return Status::OK();
+    }
+
+    // TODO(zhifengc/tucker): Figure out the number of available CPUs.
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
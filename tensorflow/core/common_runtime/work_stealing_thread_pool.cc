@@ -0,0 +1,183 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_thread_pool.h"
+
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/denormal.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/setround.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Identifies the pool (if any) that owns the current thread, and the index
+// of the current thread in that pool.
+struct PerThread {
+  const WorkStealingThreadPool* pool = nullptr;
+  int id = -1;
+};
+
+thread_local PerThread per_thread;
+
+// A xorshift generator, used to pick the first victim of a steal so that
+// idle workers do not all hammer the same deque.
+inline uint32 NextRandom(uint32* state) {
+  uint32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(Env* env, const string& name,
+                                               int num_threads)
+    : WorkStealingThreadPool(env, ThreadOptions(), name, num_threads) {}
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    Env* env, const ThreadOptions& thread_options, const string& name,
+    int num_threads)
+    : num_queued_(0), num_waiting_(0), next_external_(0) {
+  CHECK_GE(num_threads, 1);
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(new Worker);
+  }
+  // Start the threads only once every deque exists, since any worker may
+  // steal from any other.
+  for (int i = 0; i < num_threads; ++i) {
+    workers_[i]->thread.reset(
+        env->StartThread(thread_options, strings::StrCat("tf_", name),
+                         [this, i, thread_options]() {
+                           if (thread_options.numa_node !=
+                               port::kNUMANoAffinity) {
+                             port::NUMASetThreadNodeAffinity(
+                                 thread_options.numa_node);
+                           }
+                           // Set the processor flag to flush denormals to
+                           // zero.
+                           port::ScopedFlushDenormal flush;
+                           // Set the processor rounding mode to ROUND TO
+                           // NEAREST.
+                           port::ScopedSetRound round(FE_TONEAREST);
+                           WorkerLoop(i);
+                         }));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+  // Workers drain all queued closures before exiting; the Thread destructor
+  // joins.
+  for (auto& worker : workers_) {
+    worker->thread.reset();
+  }
+}
+
+int WorkStealingThreadPool::CurrentThreadId() const {
+  return per_thread.pool == this ? per_thread.id : -1;
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> fn) {
+  CHECK(fn != nullptr);
+  int id = CurrentThreadId();
+  if (id < 0) {
+    id = next_external_.fetch_add(1, std::memory_order_relaxed) %
+         workers_.size();
+  }
+  Worker* worker = workers_[id].get();
+  {
+    mutex_lock l(worker->mu);
+    worker->closures.push_back(std::move(fn));
+  }
+  num_queued_.fetch_add(1);
+  // Pairs with the re-check of num_queued_ in WorkerLoop(): either a worker
+  // that is about to block observes the new closure, or we observe the
+  // worker and wake it up.
+  if (num_waiting_.load() > 0) {
+    mutex_lock l(mu_);
+    cond_var_.notify_one();
+  }
+}
+
+bool WorkStealingThreadPool::PopLocal(int id, std::function<void()>* fn) {
+  Worker* worker = workers_[id].get();
+  mutex_lock l(worker->mu);
+  if (worker->closures.empty()) return false;
+  *fn = std::move(worker->closures.back());
+  worker->closures.pop_back();
+  num_queued_.fetch_sub(1);
+  return true;
+}
+
+bool WorkStealingThreadPool::Steal(int id, uint32* rng_state,
+                                   std::function<void()>* fn) {
+  if (num_queued_.load(std::memory_order_relaxed) <= 0) return false;
+  const int num_workers = workers_.size();
+  const int start = NextRandom(rng_state) % num_workers;
+  for (int i = 0; i < num_workers; ++i) {
+    const int victim = (start + i) % num_workers;
+    if (victim == id) continue;
+    Worker* worker = workers_[victim].get();
+    mutex_lock l(worker->mu);
+    if (!worker->closures.empty()) {
+      *fn = std::move(worker->closures.front());
+      worker->closures.pop_front();
+      num_queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::WorkerLoop(int id) {
+  per_thread.pool = this;
+  per_thread.id = id;
+  uint32 rng_state = 2654435761u * (id + 1);
+  std::function<void()> fn;
+  while (true) {
+    if (PopLocal(id, &fn) || Steal(id, &rng_state, &fn)) {
+      fn();
+      fn = nullptr;
+      continue;
+    }
+    mutex_lock l(mu_);
+    num_waiting_.fetch_add(1);
+    if (num_queued_.load() > 0) {
+      // A closure was scheduled after we last looked at the deques.
+      num_waiting_.fetch_sub(1);
+      continue;
+    }
+    if (cancelled_) {
+      num_waiting_.fetch_sub(1);
+      break;
+    }
+    cond_var_.wait(l);
+    num_waiting_.fetch_sub(1);
+  }
+  per_thread.pool = nullptr;
+  per_thread.id = -1;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,116 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_THREAD_POOL_H_
+#define TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A thread pool in which every worker thread owns a deque of closures.
+//
+// A closure scheduled from one of the pool's own threads is pushed onto the
+// back of that thread's deque, and the thread pops closures from the back of
+// its deque first (LIFO), so that a node made ready by a kernel usually runs
+// on the same core, with its inputs still in cache. A closure scheduled from
+// any other thread is distributed round-robin over the workers. A worker
+// whose deque is empty steals from the front of the other workers' deques.
+//
+// Compared to a pool with a single shared queue, the only shared state
+// touched on the fast path is an atomic counter of queued closures, which
+// avoids queue contention when many threads schedule work concurrently.
+//
+// This is used as the inter-op "runner" of an executor (see
+// ConfigProto.use_work_stealing_inter_op_scheduler).
+class WorkStealingThreadPool {
+ public:
+  // Constructs a pool that contains "num_threads" threads with specified
+  // "name". env->StartThread() is used to create individual threads.
+  //
+  // REQUIRES: num_threads > 0
+  WorkStealingThreadPool(Env* env, const string& name, int num_threads);
+
+  // Constructs a pool that contains "num_threads" threads with specified
+  // "name", created with the given ThreadOptions. The threads are pinned to
+  // thread_options.numa_node if it is set.
+  //
+  // REQUIRES: num_threads > 0
+  WorkStealingThreadPool(Env* env, const ThreadOptions& thread_options,
+                         const string& name, int num_threads);
+
+  // Waits until all scheduled work has finished and then destroys the
+  // set of threads.
+  ~WorkStealingThreadPool();
+
+  // Schedules fn() for execution in the pool of threads.
+  void Schedule(std::function<void()> fn);
+
+  // Returns the number of threads in the pool.
+  int NumThreads() const { return static_cast<int>(workers_.size()); }
+
+  // Returns current thread id between 0 and NumThreads() - 1, if called from a
+  // thread in the pool. Returns -1 otherwise.
+  int CurrentThreadId() const;
+
+ private:
+  struct Worker {
+    mutex mu;
+    std::deque<std::function<void()>> closures GUARDED_BY(mu);
+    std::unique_ptr<Thread> thread;
+  };
+
+  // The main loop of worker thread "id".
+  void WorkerLoop(int id);
+
+  // Pops a closure from the back of the deque of worker "id" into "*fn".
+  // Returns false if the deque is empty.
+  bool PopLocal(int id, std::function<void()>* fn);
+
+  // Steals a closure from the front of the deque of a worker other than
+  // "id" into "*fn". Returns false if no closure could be found.
+  bool Steal(int id, uint32* rng_state, std::function<void()>* fn);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // The number of closures that have been scheduled but not yet popped.
+  std::atomic<int64> num_queued_;
+
+  // The number of workers that are blocked on "cond_var_", or are about to.
+  std::atomic<int> num_waiting_;
+
+  // Next worker to receive a closure scheduled from outside the pool.
+  std::atomic<uint32> next_external_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingThreadPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_THREAD_POOL_H_
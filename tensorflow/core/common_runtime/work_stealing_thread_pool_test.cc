@@ -0,0 +1,156 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_thread_pool.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+static const int kNumThreads = 30;
+
+TEST(WorkStealingThreadPool, Empty) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    WorkStealingThreadPool pool(Env::Default(), "test", num_threads);
+    EXPECT_EQ(num_threads, pool.NumThreads());
+    EXPECT_EQ(-1, pool.CurrentThreadId());
+  }
+}
+
+TEST(WorkStealingThreadPool, DoWork) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    const int kWorkItems = 15;
+    bool work[kWorkItems];
+    for (int i = 0; i < kWorkItems; i++) {
+      work[i] = false;
+    }
+    {
+      WorkStealingThreadPool pool(Env::Default(), "test", num_threads);
+      for (int i = 0; i < kWorkItems; i++) {
+        pool.Schedule([&work, i]() {
+          ASSERT_FALSE(work[i]);
+          work[i] = true;
+        });
+      }
+    }
+    for (int i = 0; i < kWorkItems; i++) {
+      ASSERT_TRUE(work[i]);
+    }
+  }
+}
+
+TEST(WorkStealingThreadPool, NestedSchedule) {
+  // Closures scheduled from a worker go to that worker's deque, and must
+  // all have run by the time the pool is destroyed.
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    std::atomic<int> count(0);
+    {
+      WorkStealingThreadPool pool(Env::Default(), "test", num_threads);
+      for (int i = 0; i < 10; ++i) {
+        pool.Schedule([&pool, &count, num_threads]() {
+          const int id = pool.CurrentThreadId();
+          ASSERT_LE(0, id);
+          ASSERT_LT(id, num_threads);
+          for (int j = 0; j < 10; ++j) {
+            pool.Schedule([&count]() { count++; });
+          }
+        });
+      }
+    }
+    EXPECT_EQ(100, count);
+  }
+}
+
+TEST(WorkStealingThreadPool, IdleThreadsSteal) {
+  // A single closure schedules closures on its own worker's deque that
+  // block until all of them are running at once. This can only finish if
+  // the other workers steal them.
+  for (int num_threads = 2; num_threads < kNumThreads; num_threads++) {
+    WorkStealingThreadPool pool(Env::Default(), "test", num_threads);
+    BlockingCounter all_running(num_threads);
+    BlockingCounter done(num_threads);
+    pool.Schedule([&pool, &all_running, &done, num_threads]() {
+      for (int i = 0; i < num_threads - 1; ++i) {
+        pool.Schedule([&all_running, &done]() {
+          all_running.DecrementCount();
+          all_running.Wait();
+          done.DecrementCount();
+        });
+      }
+      all_running.DecrementCount();
+      all_running.Wait();
+      done.DecrementCount();
+    });
+    done.Wait();
+  }
+}
+
+static void BM_Sequential(int iters) {
+  WorkStealingThreadPool pool(Env::Default(), "test", kNumThreads);
+  // Decrement count sequentially until 0.
+  int count = iters;
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+  std::function<void()> work = [&pool, &count, &done_lock, &done, &done_flag,
+                                &work]() {
+    if (count--) {
+      pool.Schedule(work);
+    } else {
+      mutex_lock l(done_lock);
+      done_flag = true;
+      done.notify_all();
+    }
+  };
+  work();
+  mutex_lock l(done_lock);
+  if (!done_flag) {
+    done.wait(l);
+  }
+}
+BENCHMARK(BM_Sequential);
+
+static void BM_Parallel(int iters) {
+  WorkStealingThreadPool pool(Env::Default(), "test", kNumThreads);
+  // Decrement count concurrently until 0.
+  std::atomic_int_fast32_t count(iters);
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+  for (int i = 0; i < iters; ++i) {
+    pool.Schedule([&count, &done_lock, &done, &done_flag]() {
+      if (count.fetch_sub(1) == 1) {
+        mutex_lock l(done_lock);
+        done_flag = true;
+        done.notify_all();
+      }
+    });
+  }
+  mutex_lock l(done_lock);
+  if (!done_flag) {
+    done.wait(l);
+  }
+}
+BENCHMARK(BM_Parallel);
+
+}  // namespace
+}  // namespace tensorflow
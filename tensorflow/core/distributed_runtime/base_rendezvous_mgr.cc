@@ -52,6 +52,10 @@ RemoteRendezvous* BaseRendezvousMgr::Find(int64 step_id) {
 
 BaseRemoteRendezvous* BaseRendezvousMgr::FindOrCreate(int64 step_id) {
   mutex_lock l(mu_);
+  return FindOrCreateLocked(step_id);
+}
+
+BaseRemoteRendezvous* BaseRendezvousMgr::FindOrCreateLocked(int64 step_id) {
   Table::iterator iter = table_.find(step_id);
   if (iter == table_.end()) {
     auto rr = Create(step_id, worker_env_);
@@ -97,6 +101,46 @@ Status BaseRendezvousMgr::RecvLocal(int64 step_id,
   return ret;
 }
 
+bool BaseRendezvousMgr::RecvLocalIfReadyAsync(
+    int64 step_id, const Rendezvous::ParsedKey& parsed,
+    Rendezvous::DoneCallback done) {
+  BaseRemoteRendezvous* rendez = FindOrCreate(step_id);
+  using namespace std::placeholders;
+  Rendezvous::DoneCallback done_cb = std::bind(
+      [rendez](Rendezvous::DoneCallback done,
+               // Begin unbound arguments.
+               const Status& s, const Rendezvous::Args& send_args,
+               const Rendezvous::Args& recv_args, const Tensor& v, bool dead) {
+        rendez->Unref();
+        done(s, send_args, recv_args, v, dead);
+      },
+      std::move(done), _1, _2, _3, _4, _5);
+  if (!rendez->RecvLocalIfReadyAsync(parsed, std::move(done_cb))) {
+    rendez->Unref();
+    return false;
+  }
+  return true;
+}
+
+Status BaseRendezvousMgr::AcceptPushedTensor(
+    int64 step_id, const Rendezvous::ParsedKey& parsed, const Tensor& val,
+    bool is_dead) {
+  BaseRemoteRendezvous* rendez;
+  {
+    mutex_lock l(mu_);
+    // A tensor pushed after its step ended would otherwise create a
+    // rendezvous that nothing cleans up.
+    if (cleaned_up_steps_.count(step_id) > 0) {
+      return errors::Aborted("Step ", step_id,
+                             " was cleaned up before a tensor was pushed");
+    }
+    rendez = FindOrCreateLocked(step_id);
+  }
+  Status s = rendez->AcceptPushedTensor(parsed, val, is_dead);
+  rendez->Unref();
+  return s;
+}
+
 void BaseRendezvousMgr::Cleanup(int64 step_id) {
   Rendezvous* rendez = nullptr;
   {
@@ -106,6 +150,7 @@ void BaseRendezvousMgr::Cleanup(int64 step_id) {
       rendez = iter->second;
       table_.erase(iter);
     }
+    RecordCleanupLocked(step_id);
   }
   if (!rendez) return;
   rendez->StartAbort(errors::Aborted("Cleanup ", step_id));
@@ -118,6 +163,7 @@ void BaseRendezvousMgr::CleanupAll() {
     mutex_lock l(mu_);
     for (const auto& entry : table_) {
       rendezs.push_back(entry.second);
+      RecordCleanupLocked(entry.first);
     }
     table_.clear();
   }
@@ -127,6 +173,15 @@ void BaseRendezvousMgr::CleanupAll() {
   }
 }
 
+void BaseRendezvousMgr::RecordCleanupLocked(int64 step_id) {
+  if (!cleaned_up_steps_.insert(step_id).second) return;
+  cleaned_up_order_.push_back(step_id);
+  if (cleaned_up_order_.size() > kMaxCleanedUpSteps) {
+    cleaned_up_steps_.erase(cleaned_up_order_.front());
+    cleaned_up_order_.pop_front();
+  }
+}
+
 BaseRemoteRendezvous::BaseRemoteRendezvous(const WorkerEnv* env, int64 step_id,
                                            bool tolerate_dup_recv)
     : env_(env),
@@ -196,10 +251,49 @@ Status BaseRemoteRendezvous::Send(const Rendezvous::ParsedKey& parsed,
           session_->worker_name);
     }
   }
+  if (PushesToRemote() && !IsSameWorker(parsed.src, parsed.dst)) {
+    // The consumer will not request "val", so push it now. Send() must not
+    // block, so errors abort the step instead of being returned.
+    Ref();
+    SendToRemoteAsync(parsed, args, val, is_dead, [this](const Status& s) {
+      if (!s.ok()) {
+        StartAbort(s);
+      }
+      Unref();
+    });
+    return Status::OK();
+  }
   // Buffers "val" and "device_context" in local_.
   return local_->Send(parsed, args, val, is_dead);
 }
 
+void BaseRemoteRendezvous::SendToRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& args,
+    const Tensor& val, bool is_dead, StatusCallback done) {
+  done(errors::Unimplemented("Pushing tensors to remote workers: ",
+                             parsed.FullKey()));
+}
+
+Status BaseRemoteRendezvous::AcceptPushedTensor(const ParsedKey& parsed,
+                                                const Tensor& val,
+                                                bool is_dead) {
+  VLOG(1) << "BaseRemoteRendezvous AcceptPushedTensor " << this << " "
+          << parsed.FullKey();
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok()) return status_;
+    if (is_initialized_locked() &&
+        !IsLocalDevice(session_->worker_name, parsed.dst_device)) {
+      return errors::InvalidArgument("Invalid rendezvous key (dst): ",
+                                     parsed.FullKey(), " @ ",
+                                     session_->worker_name);
+    }
+  }
+  Rendezvous::Args send_args;
+  send_args.alloc_attrs.set_on_host(true);
+  return local_->Send(parsed, send_args, val, is_dead);
+}
+
 Status BaseRemoteRendezvous::ValidateDevices(const ParsedKey& parsed,
                                              bool is_src) {
   // Cache session pointer to avoid repeatedly taking & releasing the lock
@@ -276,6 +370,42 @@ void BaseRemoteRendezvous::SameWorkerRecvDone(
                      done);
 }
 
+void BaseRemoteRendezvous::PushedRecvDone(const Rendezvous::ParsedKey& parsed,
+                                          const Rendezvous::Args& recv_args,
+                                          const Tensor& in, Tensor* out,
+                                          StatusCallback done) {
+  if (recv_args.alloc_attrs.on_host() || parsed.dst.type == "CPU") {
+    *out = in;
+    done(Status::OK());
+    return;
+  }
+
+  if (!DMAHelper::CanUseDMA(&in)) {
+    done(errors::InvalidArgument("Non-DMA-safe ", DataTypeString(in.dtype()),
+                                 " tensor may not be copied to a GPU."));
+    return;
+  }
+
+  Device* dst_device;
+  Status s = env_->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  Tensor copy(dst_device->GetAllocator(recv_args.alloc_attrs), in.dtype(),
+              in.shape());
+  *out = copy;
+
+  // "in" is in host memory of this process, so only the destination device
+  // takes part in the copy.
+  AllocatorAttributes host_attrs;
+  host_attrs.set_on_host(true);
+  CopyTensor::ViaDMA(parsed.edge_name, nullptr /* send_dev_context */,
+                     recv_args.device_context, dst_device, dst_device,
+                     host_attrs, recv_args.alloc_attrs, &in, out, done);
+}
+
 bool BaseRemoteRendezvous::IsSameWorker(DeviceNameUtils::ParsedName src,
                                         DeviceNameUtils::ParsedName dst) {
   return DeviceNameUtils::IsSameAddressSpace(src, dst);
@@ -315,6 +445,24 @@ void BaseRemoteRendezvous::RecvAsync(const ParsedKey& parsed,
           }
         });
     return;
+  } else if (PushesToRemote()) {
+    // Wait for the remote producer to push the tensor to local_.
+    local_->RecvAsync(
+        parsed, recv_args,
+        [this, parsed, done](
+            const Status& status, const Rendezvous::Args& send_args,
+            const Rendezvous::Args& recv_args, const Tensor& in, bool is_dead) {
+          if (!status.ok() || is_dead) {
+            done(status, send_args, recv_args, in, is_dead);
+            return;
+          }
+          Tensor* out = new Tensor;
+          PushedRecvDone(parsed, recv_args, in, out,
+                         [done, send_args, recv_args, out](const Status& s) {
+                           done(s, send_args, recv_args, *out, false);
+                           delete out;
+                         });
+        });
   } else {
     RecvFromRemoteAsync(parsed, recv_args, std::move(done));
   }
@@ -340,6 +488,23 @@ void BaseRemoteRendezvous::RecvLocalAsync(const ParsedKey& parsed,
   RecvLocalAsyncInternal(parsed, std::move(done));
 }
 
+bool BaseRemoteRendezvous::RecvLocalIfReadyAsync(const ParsedKey& parsed,
+                                                 DoneCallback done) {
+  {
+    mutex_lock l(mu_);
+    if (!is_initialized_locked()) {
+      // The step has not started, so it has not sent anything yet.
+      return false;
+    }
+  }
+  Status s = ValidateDevices(parsed, true /* is_src */);
+  if (!s.ok()) {
+    done(s, Args(), Args(), Tensor(), false);
+    return true;
+  }
+  return local_->RecvIfReadyAsync(parsed, Args(), std::move(done));
+}
+
 void BaseRemoteRendezvous::RecvLocalAsyncInternal(const ParsedKey& parsed,
                                                   DoneCallback done) {
   Status s = ValidateDevices(parsed, true /* is_src */);
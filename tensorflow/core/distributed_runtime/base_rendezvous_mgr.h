@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_BASE_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_BASE_RENDEZVOUS_MGR_H_
 
+#include <deque>
 #include <string>
 #include <unordered_set>
 
@@ -82,6 +83,21 @@ class BaseRendezvousMgr : public RendezvousMgrInterface {
   Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                    Tensor* val, bool* is_dead) override;
 
+  // Like RecvLocalAsync, but returns false without running "done" if the
+  // tensor for "key" has not been produced yet.
+  //
+  // This method is used by the rpc handler of RecvTensors.
+  bool RecvLocalIfReadyAsync(int64 step_id, const Rendezvous::ParsedKey& parsed,
+                             Rendezvous::DoneCallback done) override;
+
+  // Finds the local rendezvous instance for the "step_id", and buffers
+  // "val" there for the local consumer of "parsed". Fails if "step_id" was
+  // cleaned up recently, since the tensor can no longer be received.
+  //
+  // This method is used by the rpc handler of PushTensor.
+  Status AcceptPushedTensor(int64 step_id, const Rendezvous::ParsedKey& parsed,
+                            const Tensor& val, bool is_dead) override;
+
   // Removes rendezvous for "step_id".
   //
   // TODO(zhifengc): Have a background thread in worker that
@@ -102,10 +118,21 @@ class BaseRendezvousMgr : public RendezvousMgrInterface {
   // Not owned.
   const WorkerEnv* const worker_env_;
 
+  // The number of cleaned up steps that are remembered.
+  static constexpr size_t kMaxCleanedUpSteps = 1024;
+
   mutex mu_;
   Table table_ GUARDED_BY(mu_);
 
+  // The most recently cleaned up steps, to which tensors can no longer be
+  // pushed, and the order in which they were cleaned up.
+  gtl::FlatSet<int64> cleaned_up_steps_ GUARDED_BY(mu_);
+  std::deque<int64> cleaned_up_order_ GUARDED_BY(mu_);
+
   BaseRemoteRendezvous* FindOrCreate(int64 step_id);
+  BaseRemoteRendezvous* FindOrCreateLocked(int64 step_id)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RecordCleanupLocked(int64 step_id) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   TF_DISALLOW_COPY_AND_ASSIGN(BaseRendezvousMgr);
 };
@@ -125,14 +152,16 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   Status Initialize(WorkerSession* session) override;
 
   // Forwards to local_, where the Tensor "val" will be buffered and
-  // any waiting callback stored.
+  // any waiting callback stored. In push mode, a tensor whose consumer is
+  // in a remote process is instead pushed to it by SendToRemoteAsync().
   Status Send(const ParsedKey& key, const Rendezvous::Args& args,
               const Tensor& val, const bool is_dead) override;
 
   // This method is called only by the RecvOp.  It tests to see
   // whether the value will be produced by a local or remote device
   // and handles accordingly.  In the local case it forwards to
-  // local_, in the remote case it initiates an RPC request.
+  // local_, in the remote case it initiates an RPC request, unless the
+  // value will be pushed to local_ by the remote producer.
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
 
@@ -150,11 +179,40 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   // REQUIRES: "parsed" is one that will be Saved into the local rendezvous.
   void RecvLocalAsync(const ParsedKey& parsed, DoneCallback done);
 
+  // Like RecvLocalAsync, but returns false without running "done" if the
+  // tensor for "parsed" has not been sent yet, including when this
+  // rendezvous has not been initialized.
+  bool RecvLocalIfReadyAsync(const ParsedKey& parsed, DoneCallback done);
+
+  // This method is called only by the local Worker, forwarded through
+  // the same method on RendezvousMgr, when it has received a PushTensor
+  // request from the remote producer of "val". It buffers "val", which
+  // must be in host memory, in local_ until the consumer receives it.
+  //
+  // May be called before Initialize().
+  Status AcceptPushedTensor(const ParsedKey& parsed, const Tensor& val,
+                            bool is_dead);
+
  protected:
   virtual void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
                                    const Rendezvous::Args& args,
                                    DoneCallback done) = 0;
 
+  // Returns true if tensors whose consumer is in a remote process are
+  // pushed to it when they are sent, instead of being buffered until the
+  // consumer requests them. The rendezvous of every worker in a step must
+  // agree on this.
+  virtual bool PushesToRemote() { return false; }
+
+  // Pushes "val" to the remote process of the consumer of "parsed", which
+  // passes it to AcceptPushedTensor(). Calls "done" once the push is
+  // complete; an error aborts this rendezvous. Only called if
+  // PushesToRemote() is true.
+  virtual void SendToRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                                 const Rendezvous::Args& args,
+                                 const Tensor& val, bool is_dead,
+                                 StatusCallback done);
+
   // Returns true if "src" and "dst" are located in the same worker,
   // and hence may use a local rendezvous.
   virtual bool IsSameWorker(DeviceNameUtils::ParsedName src,
@@ -193,7 +251,7 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   };
   std::vector<DeferredCall> deferred_calls_ GUARDED_BY(mu_);
 
-  // Active outstanding RecvTensor calls.
+  // Active outstanding RecvTensor and PushTensor calls.
   gtl::FlatSet<BaseRecvTensorCall*> active_ GUARDED_BY(mu_);
 
   bool is_initialized_locked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -214,6 +272,13 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
                           const Rendezvous::Args& out_args, const Tensor& in,
                           Tensor* out, StatusCallback done);
 
+  // Callback handling the case when a tensor that was pushed by a remote
+  // producer has been received from local_. Tensor "in", which is in host
+  // memory, will be copied into "out" on the destination device.
+  void PushedRecvDone(const Rendezvous::ParsedKey& parsed,
+                      const Rendezvous::Args& recv_args, const Tensor& in,
+                      Tensor* out, StatusCallback done);
+
   // Must be called only if fully initialized.
   void RecvLocalAsyncInternal(const ParsedKey& parsed, DoneCallback done);
 
@@ -85,6 +85,23 @@ class RendezvousMgrInterface {
   virtual Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                            Tensor* val, bool* is_dead) = 0;
 
+  // Like RecvLocalAsync, but returns false without running "done" if the
+  // tensor for "key" has not been produced yet.
+  //
+  // This method is used by the rpc handler of RecvTensors.
+  virtual bool RecvLocalIfReadyAsync(int64 step_id,
+                                     const Rendezvous::ParsedKey& parsed,
+                                     Rendezvous::DoneCallback done) = 0;
+
+  // Finds the local rendezvous instance for the "step_id", and buffers
+  // "val", which a remote worker pushed to this worker, until it is
+  // received by the local consumer of "parsed".
+  //
+  // This method is used by the rpc handler of PushTensor.
+  virtual Status AcceptPushedTensor(int64 step_id,
+                                    const Rendezvous::ParsedKey& parsed,
+                                    const Tensor& val, bool is_dead) = 0;
+
   // Removes rendezvous for "step_id".
   //
   // TODO(zhifengc): Have a background thread in worker that
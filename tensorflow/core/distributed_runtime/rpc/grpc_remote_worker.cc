@@ -49,6 +49,8 @@ class GrpcRemoteWorker : public WorkerInterface {
         cleanupgraph_(Method(GrpcWorkerMethod::kCleanupGraph)),
         cleanupall_(Method(GrpcWorkerMethod::kCleanupAll)),
         recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
+        pushtensor_(Method(GrpcWorkerMethod::kPushTensor)),
         logging_(Method(GrpcWorkerMethod::kLogging)),
         tracing_(Method(GrpcWorkerMethod::kTracing)),
         logger_(logger) {}
@@ -129,40 +131,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       wrapper_done = [this, request, req_copy, response, done,
                       start_usec](Status s) {
         if (logger_->LoggingActive()) {
-          int64 end_usec = Env::Default()->NowMicros();
-          int64 step_id = request->step_id();
-          int64 bytes = response->tensor().TotalBytes();
-          int64 send_start_usec = start_usec;
-          // If a send start time was reported by the other side, use
-          // that instead.  Maybe we should mark the display if we're using
-          // our local time instead of the remote start time?
-          if (response->metadata().send_start_micros()) {
-            // send_start_micros is the timestamp taken when the
-            // remote machine began to send the RecvTensor response.
-            // Due to clock skew between source and dest machines, it
-            // is possible that send_start_micros can be larger than
-            // end_usec or less than start_usec.
-            //
-            // To respect causality, we enforce the invariants that
-            // the RecvTensor response can not have been sent before
-            // the RecvTensor request, and must have been sent before
-            // it was received.
-            send_start_usec = std::max(
-                start_usec,
-                static_cast<int64>(response->metadata().send_start_micros()));
-            send_start_usec = std::min(send_start_usec, end_usec - 1);
-          }
-          const string& key = request->rendezvous_key();
-          std::vector<string> key_parts = str_util::Split(key, ';');
-          if (key_parts.size() != 5) {
-            LOG(WARNING) << "Bad key: " << key;
-          } else {
-            logger_->RecordRecvTensor(step_id, send_start_usec, end_usec,
-                                      key_parts[3],  // tensor name
-                                      key_parts[0],  // src_device
-                                      key_parts[2],  // dst_device
-                                      bytes);
-          }
+          LogRecvTensor(request->step_id(), request->rendezvous_key(),
+                        *response, start_usec);
         }
         VLOG(2) << "done callback, req: " << request->DebugString()
                 << " response " << response->metadata().DebugString();
@@ -176,6 +146,41 @@ class GrpcRemoteWorker : public WorkerInterface {
                  std::move(*cb_to_use), call_opts);
   }
 
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        TensorResponses* response,
+                        StatusCallback done) override {
+    VLOG(1) << "RecvTensorsAsync req: " << request->DebugString();
+    if (!logger_->LoggingActive()) {
+      IssueRequest(request, response, recvtensors_, std::move(done),
+                   call_opts);
+      return;
+    }
+    int64 start_usec = Env::Default()->NowMicros();
+    IssueRequest(request, response, recvtensors_,
+                 [this, request, response, done, start_usec](Status s) {
+                   if (logger_->LoggingActive()) {
+                     for (int i = 0; i < response->size(); ++i) {
+                       LogRecvTensor(request->step_id(),
+                                     request->rendezvous_key(i),
+                                     *response->response(i), start_usec);
+                     }
+                   }
+                   done(s);
+                 },
+                 call_opts);
+  }
+
+  void PushTensorAsync(CallOptions* call_opts, const PushedTensor* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override {
+    // The request is serialized when it is issued, and shares rather than
+    // copies the data of large tensors.
+    ::grpc::ByteBuffer buf;
+    grpc::EncodePushedTensorToByteBuffer(*request, &buf);
+    IssueRequest(&buf, response, pushtensor_, std::move(done), call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -187,6 +192,44 @@ class GrpcRemoteWorker : public WorkerInterface {
   }
 
  private:
+  // Records the receipt of the tensor for "key" in "response", which was
+  // requested at "start_usec".
+  void LogRecvTensor(int64 step_id, const string& key,
+                     const TensorResponse& response, int64 start_usec) {
+    int64 end_usec = Env::Default()->NowMicros();
+    int64 bytes = response.tensor().TotalBytes();
+    int64 send_start_usec = start_usec;
+    // If a send start time was reported by the other side, use
+    // that instead.  Maybe we should mark the display if we're using
+    // our local time instead of the remote start time?
+    if (response.metadata().send_start_micros()) {
+      // send_start_micros is the timestamp taken when the
+      // remote machine began to send the RecvTensor response.
+      // Due to clock skew between source and dest machines, it
+      // is possible that send_start_micros can be larger than
+      // end_usec or less than start_usec.
+      //
+      // To respect causality, we enforce the invariants that
+      // the RecvTensor response can not have been sent before
+      // the RecvTensor request, and must have been sent before
+      // it was received.
+      send_start_usec = std::max(
+          start_usec,
+          static_cast<int64>(response.metadata().send_start_micros()));
+      send_start_usec = std::min(send_start_usec, end_usec - 1);
+    }
+    std::vector<string> key_parts = str_util::Split(key, ';');
+    if (key_parts.size() != 5) {
+      LOG(WARNING) << "Bad key: " << key;
+    } else {
+      logger_->RecordRecvTensor(step_id, send_start_usec, end_usec,
+                                key_parts[3],  // tensor name
+                                key_parts[0],  // src_device
+                                key_parts[2],  // dst_device
+                                bytes);
+    }
+  }
+
   // Object allocated per active RPC.
   template <class RequestMessage, class ResponseMessage>
   class RPCState final : public GrpcClientCQTag {
@@ -262,6 +305,8 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::RpcMethod cleanupgraph_;
   const ::grpc::RpcMethod cleanupall_;
   const ::grpc::RpcMethod recvtensor_;
+  const ::grpc::RpcMethod recvtensors_;
+  const ::grpc::RpcMethod pushtensor_;
   const ::grpc::RpcMethod logging_;
   const ::grpc::RpcMethod tracing_;
 
@@ -62,11 +62,6 @@ class NoReusePortOption : public ::grpc::ServerBuilderOption {
                          plugins) override {}
 };
 
-// static utility function
-RendezvousMgrInterface* NewRpcRendezvousMgr(const WorkerEnv* env) {
-  return new RpcRendezvousMgr(env);
-}
-
 }  // namespace
 
 GrpcServer::GrpcServer(const ServerDef& server_def, Env* env)
@@ -123,9 +118,13 @@ Status GrpcServer::Init(
                                                &master_env_.local_devices));
   worker_env_.local_devices = master_env_.local_devices;
   worker_env_.device_mgr = new DeviceMgr(worker_env_.local_devices);
-  worker_env_.rendezvous_mgr = rendezvous_mgr_func == nullptr
-                                   ? new RpcRendezvousMgr(&worker_env_)
-                                   : rendezvous_mgr_func(&worker_env_);
+  worker_env_.rendezvous_mgr =
+      rendezvous_mgr_func == nullptr
+          ? new RpcRendezvousMgr(
+                &worker_env_, config.rpc_options().push_remote_tensors(),
+                config.rpc_options().recv_tensors_batch_window_micros(),
+                config.rpc_options().tensor_transfer_options())
+          : rendezvous_mgr_func(&worker_env_);
   string unused;
   string default_worker_name;
   if (!DeviceNameUtils::SplitDeviceName(master_env_.local_devices[0]->name(),
@@ -384,8 +383,7 @@ Status GrpcServer::Create(const ServerDef& server_def, Env* env,
                           std::unique_ptr<ServerInterface>* out_server) {
   std::unique_ptr<GrpcServer> ret(
       new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
-  ServiceInitFunction service_func = nullptr;
-  TF_RETURN_IF_ERROR(ret->Init(service_func, NewRpcRendezvousMgr));
+  TF_RETURN_IF_ERROR(ret->Init());
   *out_server = std::move(ret);
   return Status::OK();
 }
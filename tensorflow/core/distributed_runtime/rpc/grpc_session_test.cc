@@ -388,6 +388,60 @@ TEST(GrpcSessionTest, LargeTensorSend) {
   TF_CHECK_OK(session->Close());
 }
 
+TEST(GrpcSessionTest, PushRemoteTensors) {
+  SessionOptions options = Devices(1, 0);
+  options.config.mutable_rpc_options()->set_push_remote_tensors(true);
+  std::unique_ptr<test::TestCluster> cluster;
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(options, 2, &cluster));
+
+  // Each tensor is produced on task 0 and pushed to task 1: a large tensor,
+  // whose data is shared rather than copied when it is encoded, a small
+  // one, and a string one, which is encoded as a proto.
+  Graph graph(OpRegistry::Global());
+  Tensor large_tensor(DT_FLOAT, TensorShape({256, 1024}));
+  test::FillIota<float>(&large_tensor, 1.0);
+  Node* large = test::graph::Constant(&graph, large_tensor);
+  Node* max_axes =
+      test::graph::Constant(&graph, test::AsTensor<int32>({0, 1}, {2}));
+  Node* large_max = test::graph::Reduce(&graph, "Max", large, max_axes);
+
+  Node* small = test::graph::Constant(
+      &graph, test::AsTensor<float>({1.0, 2.0, 3.0}, {3}));
+  Node* small_neg = test::graph::Unary(&graph, "Neg", small);
+
+  Tensor string_tensor(DT_STRING, TensorShape({2}));
+  string_tensor.flat<string>()(0) = "hello";
+  string_tensor.flat<string>()(1) = "world";
+  Node* str = test::graph::Constant(&graph, string_tensor);
+  Node* str_copy = test::graph::Identity(&graph, str);
+
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  for (Node* n : {large, max_axes, small, str}) {
+    SetDevice(&def, n->name(), cluster->devices()[0].name());
+  }
+  for (Node* n : {large_max, small_neg, str_copy}) {
+    SetDevice(&def, n->name(), cluster->devices()[1].name());
+  }
+
+  std::unique_ptr<Session> session(
+      NewRemote(Options(cluster->targets()[0], 1000)));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(def));
+  for (int iters = 0; iters < 10; ++iters) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run(
+        {}, {large_max->name(), small_neg->name(), str_copy->name()}, {},
+        &outputs));
+    ASSERT_EQ(3, outputs.size());
+    IsSingleFloatValue(outputs[0], 256 * 1024);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({-1.0, -2.0, -3.0}, {3}), outputs[1]);
+    test::ExpectTensorEqual<string>(string_tensor, outputs[2]);
+  }
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, MultiDevices_String) {
   std::unique_ptr<test::TestCluster> cluster;
   TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 1), 2, &cluster));
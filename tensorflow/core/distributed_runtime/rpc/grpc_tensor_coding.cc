@@ -17,8 +17,12 @@ limitations under the License.
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
 #include "tensorflow/core/platform/env.h"
@@ -32,6 +36,7 @@ static void unref_tensorbuffer(void* raw) {
   TensorBuffer* buf = static_cast<TensorBuffer*>(raw);
   buf->Unref();
 }
+static void delete_string(void* raw) { delete static_cast<string*>(raw); }
 
 void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
                                           ::grpc::ByteBuffer* result) {
@@ -140,6 +145,13 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val,
+                           TensorTransferOptions::default_instance(), result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorTransferOptions& options,
+                              ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   RecvTensorResponse response;
   if (is_dead) {
@@ -161,7 +173,22 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
     io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
     EncodeSkeleton(val, &e_skeleton);
 
+    // If "options" asks for it, "tdata" is the encoded data instead, which
+    // is owned by "encoded".
     StringPiece tdata = val.tensor_data();
+    string* encoded = nullptr;
+    if (options.policy_size() > 0 && !is_dead) {
+      encoded = new string;
+      TensorTransferOptions::Codec codec =
+          EncodeTensorData(options, val, encoded);
+      if (codec == TensorTransferOptions::NONE) {
+        delete encoded;
+        encoded = nullptr;
+      } else {
+        response.set_codec(codec);
+        tdata = *encoded;
+      }
+    }
     uint32 overall_tensor_proto_bytesize =
         (e_skeleton.size() +
          VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
@@ -241,18 +268,26 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
 
       // (E) Encode tensor data, but by sharing backing store
 
-      const TensorBuffer* buf = DMAHelper::buffer(&val);
-      buf->Ref();
       gpr_slice s1 = gpr_slice_new(
           const_cast<void*>(static_cast<const void*>(tdata.data())),
           tdata.size(), do_nothing);
       slices[1] = ::grpc::Slice(s1, ::grpc::Slice::STEAL_REF);
 
-      gpr_slice s2 =
-          gpr_slice_new(const_cast<TensorBuffer*>(buf), 0, unref_tensorbuffer);
+      gpr_slice s2;
+      if (encoded != nullptr) {
+        // The backing store is the encoded data.
+        s2 = gpr_slice_new(encoded, 0, delete_string);
+        encoded = nullptr;
+      } else {
+        const TensorBuffer* buf = DMAHelper::buffer(&val);
+        buf->Ref();
+        s2 = gpr_slice_new(const_cast<TensorBuffer*>(buf), 0,
+                           unref_tensorbuffer);
+      }
       slices[2] = ::grpc::Slice(s2, ::grpc::Slice::STEAL_REF);
       num_slices += 2;
     }
+    delete encoded;  // Non-null only if it was copied into slices[0].
     size_t total_bytes = 0;
     for (int i = 0; i < num_slices; i++) {
       total_bytes += slices[i].size();
@@ -263,5 +298,165 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
   }
 }
 
+void EncodeRecvTensorsResponseToByteBuffer(
+    const std::vector<::grpc::ByteBuffer>& responses,
+    ::grpc::ByteBuffer* result) {
+  // Small responses are copied, along with the tag and varint32 length
+  // of their RecvTensorsResponse::response entries, into as few slices
+  // as possible.  The slices of larger responses are shared instead, to
+  // avoid copying their tensor data.
+  const size_t kLargeResponseBytes = 1024;
+  std::vector<::grpc::Slice> slices;
+  string copied;  // Data not yet added to "slices"
+  auto add_copied_slice = [&slices, &copied]() {
+    if (copied.empty()) return;
+    gpr_slice s = gpr_slice_malloc(copied.size());
+    memcpy(GPR_SLICE_START_PTR(s), copied.data(), copied.size());
+    slices.emplace_back(s, ::grpc::Slice::STEAL_REF);
+    copied.clear();
+  };
+  std::vector<::grpc::Slice> response_slices;
+  for (const ::grpc::ByteBuffer& response : responses) {
+    const size_t response_bytes = response.Length();
+    char header[1 + core::kMaxVarint32Bytes];
+    io::ProtoEncodeHelper e(header, sizeof(header));
+    e.WriteVarlengthBeginning(RecvTensorsResponse::kResponseFieldNumber,
+                              response_bytes);
+    copied.append(e.data(), e.size());
+    response_slices.clear();
+    (void)response.Dump(&response_slices);
+    if (response_bytes <= kLargeResponseBytes) {
+      for (const ::grpc::Slice& s : response_slices) {
+        copied.append(reinterpret_cast<const char*>(s.begin()), s.size());
+      }
+    } else {
+      // The slices keep sharing the tensor buffers that back them, and
+      // are released in the same order as in "response".
+      add_copied_slice();
+      slices.insert(slices.end(), response_slices.begin(),
+                    response_slices.end());
+    }
+  }
+  add_copied_slice();
+  *result = ::grpc::ByteBuffer(slices.data(), slices.size());
+}
+
+void EncodePushedTensorToByteBuffer(const PushedTensor& pushed,
+                                    ::grpc::ByteBuffer* result) {
+  ::grpc::ByteBuffer response;
+  EncodeTensorToByteBuffer(pushed.is_dead(), pushed.tensor(), &response);
+  const size_t response_bytes = response.Length();
+
+  // All of PushTensorRequest except the response field.
+  PushTensorRequest request;
+  request.set_step_id(pushed.step_id());
+  request.set_rendezvous_key(pushed.rendezvous_key());
+  string header;
+  request.AppendToString(&header);
+
+  // The header is followed by the tag and length of the response, and
+  // then by the slices of the response, which keep sharing the tensor
+  // buffer that backs them.
+  const size_t header_bytes =
+      header.size() +
+      VarLengthEncodingSize(PushTensorRequest::kResponseFieldNumber,
+                            response_bytes) -
+      response_bytes;
+  gpr_slice s0 = gpr_slice_malloc(header_bytes);
+  io::ProtoEncodeHelper e(reinterpret_cast<char*>(GPR_SLICE_START_PTR(s0)),
+                          header_bytes);
+  e.WriteRawBytes(header);
+  e.WriteVarlengthBeginning(PushTensorRequest::kResponseFieldNumber,
+                            response_bytes);
+  CHECK_EQ(e.size(), header_bytes);
+  std::vector<::grpc::Slice> slices;
+  slices.emplace_back(s0, ::grpc::Slice::STEAL_REF);
+  std::vector<::grpc::Slice> response_slices;
+  (void)response.Dump(&response_slices);
+  slices.insert(slices.end(), response_slices.begin(), response_slices.end());
+  *result = ::grpc::ByteBuffer(slices.data(), slices.size());
+}
+
+namespace {
+
+// A TensorBuffer over data received in gRPC slices, which are
+// unreferenced when the buffer is.
+class GrpcSliceBuffer : public TensorBuffer {
+ public:
+  // Takes ownership of a reference to each of "slices".
+  GrpcSliceBuffer(const gtl::InlinedVector<gpr_slice, 2>& slices, void* data,
+                  size_t size)
+      : slices_(slices), data_(data), size_(size) {}
+
+  ~GrpcSliceBuffer() override {
+    for (const gpr_slice& s : slices_) {
+      gpr_slice_unref(s);
+    }
+  }
+
+  void* data() const override { return data_; }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(cpu_allocator()->Name());
+  }
+
+  // The slices may be shared with gRPC, or with the sender of the data if
+  // it is in this process, so the data must not be changed in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const gtl::InlinedVector<gpr_slice, 2> slices_;
+  void* const data_;
+  const size_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcSliceBuffer);
+};
+
+}  // namespace
+
+TensorBuffer* ShareByteBufferData(grpc_byte_buffer* buffer, int64 offset,
+                                  int64 size) {
+  if (size <= 0 || buffer->type != GRPC_BB_RAW ||
+      buffer->data.raw.compression != GRPC_COMPRESS_NONE) {
+    return nullptr;
+  }
+  const gpr_slice_buffer& slice_buffer = buffer->data.raw.slice_buffer;
+  char* data = nullptr;
+  gtl::InlinedVector<gpr_slice, 2> slices;
+  for (size_t i = 0; i < slice_buffer.count; ++i) {
+    gpr_slice s = slice_buffer.slices[i];
+    const int64 len = GPR_SLICE_LENGTH(s);
+    if (len == 0) {
+      // Empty slices carry no data, but may keep the data of other slices
+      // alive, like those made by EncodeTensorToByteBuffer() do.
+      if (s.refcount != nullptr) slices.push_back(s);
+      continue;
+    }
+    if (data != nullptr || offset >= len) {
+      offset -= len;
+      continue;
+    }
+    // The data must lie in one slice that is not inlined: an inlined
+    // slice holds its data in the gpr_slice itself, which does not
+    // outlive "buffer".
+    if (offset < 0 || offset + size > len || s.refcount == nullptr ||
+        size < len / 2) {
+      return nullptr;
+    }
+    data = reinterpret_cast<char*>(GPR_SLICE_START_PTR(s)) + offset;
+    if (reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+      return nullptr;
+    }
+    slices.push_back(s);
+  }
+  if (data == nullptr) return nullptr;
+  for (gpr_slice& s : slices) {
+    s = gpr_slice_ref(s);
+  }
+  return new GrpcSliceBuffer(slices, data, size);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
@@ -16,12 +16,21 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include <vector>
+
+#include "tensorflow/core/platform/types.h"
+
+struct grpc_byte_buffer;
+
 namespace grpc {
 class ByteBuffer;
 }  // namespace grpc
 
 namespace tensorflow {
+class PushedTensor;
 class Tensor;
+class TensorBuffer;
+class TensorTransferOptions;
 class RecvTensorResponse;
 
 // TODO(jeff,sanjay): this should not be grpc specific.  Instead of
@@ -51,6 +60,44 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result);
 
+// As above, but encodes the data of "val" with the codec that "options"
+// chooses for it (see EncodeTensorData()), and records that codec as
+// "RecvTensorResponse::codec".
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              const TensorTransferOptions& options,
+                              ::grpc::ByteBuffer* result);
+
+// Encode byte buffers that each hold an encoded RecvTensorResponse
+// (e.g. as produced by EncodeTensorToByteBuffer) into a byte buffer in a
+// format that is parseable as a RecvTensorsResponse protocol buffer
+// holding the responses in the same order.  The data in "responses" is
+// shared, not copied.
+//
+// Discards original contents of *result.
+void EncodeRecvTensorsResponseToByteBuffer(
+    const std::vector<::grpc::ByteBuffer>& responses,
+    ::grpc::ByteBuffer* result);
+
+// Encode "pushed" into a byte buffer in a format that is parseable as a
+// PushTensorRequest protocol buffer, whose response holds the tensor as
+// EncodeTensorToByteBuffer() encodes it.  Large tensor data is shared,
+// not copied.
+//
+// Discards original contents of *result.
+void EncodePushedTensorToByteBuffer(const PushedTensor& pushed,
+                                    ::grpc::ByteBuffer* result);
+
+// Return a TensorBuffer that shares the "size" bytes at "offset" in the
+// uncompressed data of "buffer", or nullptr if they are not part of a
+// single gRPC slice, or are not aligned to EIGEN_MAX_ALIGN_BYTES.  The
+// TensorBuffer keeps the slice alive after "buffer" is destroyed.  The
+// caller owns one reference to the result.
+//
+// Slices much larger than "size" are not shared either, so that a small
+// tensor does not pin a large message.
+TensorBuffer* ShareByteBufferData(grpc_byte_buffer* buffer, int64 offset,
+                                  int64 size);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -17,10 +17,15 @@ limitations under the License.
 
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
+#include "grpc/byte_buffer.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
@@ -100,4 +105,128 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, TransferOptions) {
+  TensorTransferOptions options;
+  TensorTransferOptions::Policy* policy = options.add_policy();
+  policy->set_dtype(DT_FLOAT);
+  policy->set_codec(TensorTransferOptions::SPARSE);
+  // Small and large encoded data, which is copied and shared respectively.
+  for (int64 stride : {1000, 3}) {
+    Tensor t(DT_FLOAT, TensorShape({3000}));
+    t.flat<float>().setZero();
+    for (int64 i = 0; i < t.NumElements(); i += stride) {
+      t.flat<float>()(i) = i + 1;
+    }
+    ::grpc::ByteBuffer buf;
+    grpc::EncodeTensorToByteBuffer(false, t, options, &buf);
+
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+    RecvTensorResponse response;
+    EXPECT_TRUE(response.ParseFromString(tmp));
+    EXPECT_EQ(TensorTransferOptions::SPARSE, response.codec());
+    EXPECT_EQ(DT_FLOAT, response.tensor().dtype());
+    Tensor result(DT_FLOAT, TensorShape(response.tensor().tensor_shape()));
+    TF_EXPECT_OK(DecodeTensorData(response.codec(),
+                                  response.tensor().tensor_content(), &result));
+    test::ExpectTensorEqual<float>(t, result);
+  }
+}
+
+TEST_F(GrpcTensorCodingTest, RecvTensorsResponse) {
+  std::vector<Tensor> tensors;
+  tensors.push_back(test::AsTensor<float>({1.0, 2.0, 3.0}, {3}));
+  tensors.push_back(test::AsTensor<string>({"a", "bc"}, {2, 1}));
+  tensors.push_back(Tensor(DT_FLOAT, TensorShape({100, 30})));
+  test::FillIota<float>(&tensors.back(), 0.5);
+  tensors.push_back(Tensor(DT_INT32, TensorShape({0})));
+  std::vector<::grpc::ByteBuffer> responses(tensors.size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    grpc::EncodeTensorToByteBuffer(i == 3, tensors[i], &responses[i]);
+  }
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeRecvTensorsResponseToByteBuffer(responses, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+
+  RecvTensorsResponse response;
+  EXPECT_TRUE(response.ParseFromString(tmp));
+  ASSERT_EQ(tensors.size(), response.response_size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    EXPECT_EQ(i == 3, response.response(i).is_dead());
+    Tensor result_tensor;
+    EXPECT_TRUE(result_tensor.FromProto(response.response(i).tensor()));
+    EXPECT_EQ(tensors[i].DebugString(), result_tensor.DebugString());
+  }
+}
+
+TEST_F(GrpcTensorCodingTest, PushedTensor) {
+  for (bool is_dead : {false, true}) {
+    Tensor t(DT_FLOAT, TensorShape({100, 30}));
+    test::FillIota<float>(&t, 0.5);
+    PushedTensor pushed;
+    pushed.set_step_id(-7);
+    pushed.set_rendezvous_key("key");
+    *pushed.mutable_tensor() = t;
+    pushed.set_is_dead(is_dead);
+    ::grpc::ByteBuffer buf;
+    grpc::EncodePushedTensorToByteBuffer(pushed, &buf);
+
+    std::vector<::grpc::Slice> slices;
+    (void)buf.Dump(&slices);
+    string tmp;
+    for (const auto& s : slices) {
+      tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+    }
+
+    PushTensorRequest request;
+    EXPECT_TRUE(request.ParseFromString(tmp));
+    EXPECT_EQ(-7, request.step_id());
+    EXPECT_EQ("key", request.rendezvous_key());
+    EXPECT_EQ(is_dead, request.response().is_dead());
+    Tensor result_tensor;
+    EXPECT_TRUE(result_tensor.FromProto(request.response().tensor()));
+    EXPECT_EQ(t.DebugString(), result_tensor.DebugString());
+  }
+}
+
+TEST_F(GrpcTensorCodingTest, ShareByteBufferData) {
+  const int64 kDataBytes = 4096;
+  char* data = static_cast<char*>(
+      port::AlignedMalloc(kDataBytes, EIGEN_MAX_ALIGN_BYTES));
+  memset(data, 'x', kDataBytes);
+  gpr_slice slices[2] = {gpr_slice_from_copied_string("header"),
+                         gpr_slice_new(data, kDataBytes, port::AlignedFree)};
+  grpc_byte_buffer* buffer = grpc_raw_byte_buffer_create(slices, 2);
+  gpr_slice_unref(slices[0]);
+  gpr_slice_unref(slices[1]);
+
+  // Misaligned data, data spanning both slices, and data much smaller
+  // than its slice are not shared.
+  EXPECT_EQ(nullptr, grpc::ShareByteBufferData(buffer, 7, kDataBytes - 1));
+  EXPECT_EQ(nullptr, grpc::ShareByteBufferData(buffer, 0, 6 + kDataBytes));
+  EXPECT_EQ(nullptr, grpc::ShareByteBufferData(buffer, 6, 64));
+  EXPECT_EQ(nullptr, grpc::ShareByteBufferData(buffer, 6, kDataBytes + 1));
+
+  TensorBuffer* shared = grpc::ShareByteBufferData(buffer, 6, kDataBytes);
+  ASSERT_NE(nullptr, shared);
+  EXPECT_EQ(data, shared->data());
+  EXPECT_EQ(kDataBytes, shared->size());
+  EXPECT_FALSE(shared->OwnsMemory());
+  // The shared data outlives the byte buffer.
+  grpc_byte_buffer_destroy(buffer);
+  EXPECT_EQ(string(kDataBytes, 'x'),
+            string(static_cast<char*>(shared->data()), shared->size()));
+  shared->Unref();
+}
+
 }  // namespace tensorflow
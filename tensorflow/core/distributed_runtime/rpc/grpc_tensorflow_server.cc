@@ -38,8 +38,9 @@ namespace tensorflow {
 namespace {
 
 Status FillServerDef(const string& cluster_spec, const string& job_name,
-                     int task_index, ServerDef* options) {
-  options->set_protocol("grpc");
+                     int task_index, const string& protocol,
+                     ServerDef* options) {
+  options->set_protocol(protocol);
   options->set_job_name(job_name);
   options->set_task_index(task_index);
 
@@ -85,23 +86,28 @@ Status FillServerDef(const string& cluster_spec, const string& job_name,
 
 void Usage(char* const argv_0) {
   std::cerr << "Usage: " << argv_0
-            << " --cluster_spec=SPEC --job_name=NAME --task_id=ID" << std::endl;
+            << " --cluster_spec=SPEC --job_name=NAME --task_id=ID"
+            << " [--protocol=PROTOCOL]" << std::endl;
   std::cerr << "Where:" << std::endl;
   std::cerr << "    SPEC is <JOB>(,<JOB>)*" << std::endl;
   std::cerr << "    JOB  is <NAME>|<HOST:PORT>(;<HOST:PORT>)*" << std::endl;
   std::cerr << "    NAME is a valid job name ([a-z][0-9a-z]*)" << std::endl;
   std::cerr << "    HOST is a hostname or IP address" << std::endl;
   std::cerr << "    PORT is a port number" << std::endl;
+  std::cerr << "    PROTOCOL is a server protocol, e.g. grpc (the default)"
+            << std::endl;
 }
 
 int main(int argc, char* argv[]) {
   tensorflow::string cluster_spec;
   tensorflow::string job_name;
   int task_index = 0;
+  tensorflow::string protocol = "grpc";
   std::vector<tensorflow::Flag> flag_list = {
       tensorflow::Flag("cluster_spec", &cluster_spec, "cluster spec"),
       tensorflow::Flag("job_name", &job_name, "job name"),
       tensorflow::Flag("task_id", &task_index, "task id"),
+      tensorflow::Flag("protocol", &protocol, "server protocol"),
   };
   tensorflow::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
   const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
@@ -112,8 +118,8 @@ int main(int argc, char* argv[]) {
     return -1;
   }
   tensorflow::ServerDef server_def;
-  tensorflow::Status s = tensorflow::FillServerDef(cluster_spec, job_name,
-                                                   task_index, &server_def);
+  tensorflow::Status s = tensorflow::FillServerDef(
+      cluster_spec, job_name, task_index, protocol, &server_def);
   if (!s.ok()) {
     std::cerr << "ERROR: " << s.error_message() << std::endl;
     Usage(argv[0]);
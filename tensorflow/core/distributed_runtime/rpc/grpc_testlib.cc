@@ -48,6 +48,8 @@ Status TestCluster::MakeTestCluster(const SessionOptions& options, int n,
   if (iter != options.config.device_count().end()) {
     num_gpus = iter->second;
   }
+  const char* push_remote_tensors =
+      options.config.rpc_options().push_remote_tensors() ? "true" : "false";
 
   for (int i = 0; i < n; ++i) {
     const std::vector<string> argv(
@@ -56,7 +58,8 @@ Status TestCluster::MakeTestCluster(const SessionOptions& options, int n,
          /* see grpc_testlib_server.cc for flags */
          tf_jobs, "--tf_job=localhost", strings::StrCat("--tf_task=", i),
          strings::StrCat("--num_cpus=", num_cpus),
-         strings::StrCat("--num_gpus=", num_gpus)});
+         strings::StrCat("--num_gpus=", num_gpus),
+         strings::StrCat("--push_remote_tensors=", push_remote_tensors)});
     ret->subprocesses_.emplace_back(testing::CreateSubProcess(argv));
     bool success = ret->subprocesses_[i]->Start();
     if (!success) {
@@ -36,7 +36,7 @@ namespace {
 
 Status FillServerDef(const string& job_spec, const string& job_name,
                      int num_cpus, int num_gpus, int task_index,
-                     ServerDef* options) {
+                     bool push_remote_tensors, ServerDef* options) {
   options->set_protocol("grpc");
   options->set_job_name(job_name);
   options->set_task_index(task_index);
@@ -68,6 +68,7 @@ Status FillServerDef(const string& job_spec, const string& job_name,
   ConfigProto* config = options->mutable_default_session_config();
   (*config->mutable_device_count())["CPU"] = num_cpus;
   (*config->mutable_device_count())["GPU"] = num_gpus;
+  config->mutable_rpc_options()->set_push_remote_tensors(push_remote_tensors);
   return Status::OK();
 }
 
@@ -81,12 +82,15 @@ int main(int argc, char* argv[]) {
   int num_cpus = 1;
   int num_gpus = 0;
   int task_index = 0;
+  bool push_remote_tensors = false;
   std::vector<tensorflow::Flag> flag_list = {
       tensorflow::Flag("tf_jobs", &job_spec, "job specification"),
       tensorflow::Flag("tf_job", &job_name, "job name"),
       tensorflow::Flag("tf_task", &task_index, "task index"),
       tensorflow::Flag("num_cpus", &num_cpus, "number of CPUs"),
       tensorflow::Flag("num_gpus", &num_gpus, "number of GPUs"),
+      tensorflow::Flag("push_remote_tensors", &push_remote_tensors,
+                       "push tensors to the workers that consume them"),
   };
   tensorflow::string usage = tensorflow::Flags::Usage(argv[0], flag_list);
   const bool parse_result = tensorflow::Flags::Parse(&argc, argv, flag_list);
@@ -96,8 +100,9 @@ int main(int argc, char* argv[]) {
   }
 
   tensorflow::ServerDef def;
-  tensorflow::Status s = tensorflow::FillServerDef(job_spec, job_name, num_cpus,
-                                                   num_gpus, task_index, &def);
+  tensorflow::Status s =
+      tensorflow::FillServerDef(job_spec, job_name, num_cpus, num_gpus,
+                                task_index, push_remote_tensors, &def);
   if (!s.ok()) {
     LOG(ERROR) << "Could not parse job spec: " << s.error_message() << "\n"
                << usage;
@@ -123,12 +123,18 @@ class GrpcWorkerService : public AsyncServiceInterface {
     for (int i = 0; i < 1000; ++i) {
       EnqueueRecvTensorRequestRaw();
     }
+    for (int i = 0; i < 100; ++i) {
+      EnqueueRecvTensorsRequestRaw();
+    }
     for (int i = 0; i < 100; ++i) {
       ENQUEUE_REQUEST(RunGraph, true);
     }
     for (int i = 0; i < 100; ++i) {
       ENQUEUE_REQUEST(CleanupGraph, false);
     }
+    for (int i = 0; i < 1000; ++i) {
+      EnqueuePushTensorRequest();
+    }
 
     ENQUEUE_REQUEST(Logging, false);
     ENQUEUE_REQUEST(Tracing, false);
@@ -255,6 +261,31 @@ class GrpcWorkerService : public AsyncServiceInterface {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandlerRaw(
+      WorkerCall<RecvTensorsRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorsAsync(call_opts, &call->request, &call->response,
+                                [call, call_opts](const Status& s) {
+                                  call->ClearCancelCallback();
+                                  delete call_opts;
+                                  call->SendResponse(ToGrpcStatus(s));
+                                });
+    });
+    EnqueueRecvTensorsRequestRaw();
+  }
+
+  void PushTensorHandler(WorkerCall<PushedTensor, PushTensorResponse>* call) {
+    Schedule([this, call]() {
+      worker_->PushTensorAsync(nullptr, &call->request, &call->response,
+                               [call](const Status& s) {
+                                 call->SendResponse(ToGrpcStatus(s));
+                               });
+    });
+    EnqueuePushTensorRequest();
+  }
+
   void CleanupGraphHandler(
       WorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
     Schedule([this, call]() {
@@ -294,6 +325,32 @@ class GrpcWorkerService : public AsyncServiceInterface {
     }
   }
 
+  void EnqueueRecvTensorsRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
+           RecvTensorsRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              &worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensors),
+              &GrpcWorkerService::RecvTensorsHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
+  void EnqueuePushTensorRequest() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerService, grpc::WorkerService::AsyncService, PushedTensor,
+           PushTensorResponse>::
+          EnqueueRequestForMethod(
+              &worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kPushTensor),
+              &GrpcWorkerService::PushTensorHandler,
+              false /* supports cancel*/);
+    }
+  }
+
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerService);
 };
 
@@ -323,17 +380,95 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
   }
 
   // Request the tensor associated with the rendezvous key. Any time
-  // while waiting for the tensor to be produced, up until the start
-  // of execution of the callback lambda body below, an RPC
-  // cancellation should abort the rendezvous.
+  // while waiting for the tensor to be produced, up until the tensor
+  // has been encoded, an RPC cancellation should abort the rendezvous.
   opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
-  env_->rendezvous_mgr->RecvLocalAsync(
-      step_id, parsed,
-      [opts, response, done, src_dev](const Status& status,
-                                      const Rendezvous::Args& send_args,
-                                      const Rendezvous::Args& recv_args,
-                                      const Tensor& val, const bool is_dead) {
-        opts->ClearCancelCallback();
+  RecvLocalTensorAsync(step_id, parsed, src_dev, request->transfer_options(),
+                       false /* only_if_ready */, response,
+                       [opts, done](const Status& s) {
+                         opts->ClearCancelCallback();
+                         done(s);
+                       });
+}
+
+void GrpcWorker::RecvTensorsAsync(CallOptions* opts,
+                                  const RecvTensorsRequest* request,
+                                  ::grpc::ByteBuffer* response,
+                                  StatusCallback done) {
+  const int64 step_id = request->step_id();
+  const int num_tensors = request->rendezvous_key_size();
+  TRACEPRINTF("RecvTensors: %lld %d", step_id, num_tensors);
+  std::vector<Rendezvous::ParsedKey> parsed(num_tensors);
+  std::vector<Device*> src_devs(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    Status s = Rendezvous::ParseKey(request->rendezvous_key(i), &parsed[i]);
+    if (s.ok()) {
+      s = PrepareRecvTensor(parsed[i], &src_devs[i]);
+    }
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+
+  if (num_tensors == 0) {
+    grpc::EncodeRecvTensorsResponseToByteBuffer({}, response);
+    done(Status::OK());
+    return;
+  }
+
+  // Each tensor that has already been produced is encoded into its own
+  // byte buffer. The buffers of the others are left empty, and the client
+  // receives them by RecvTensor calls: waiting for them here would delay
+  // the tensors that are ready, and deadlock if producing one of them
+  // depends on the client receiving another. Once all the tensors are
+  // encoded, the buffers are concatenated into the response, or the first
+  // error is returned.
+  struct State {
+    mutex mu;
+    int pending GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+    std::vector<::grpc::ByteBuffer> responses;
+  };
+  State* state = new State;
+  state->pending = num_tensors;
+  state->responses.resize(num_tensors);
+  auto tensor_done = [opts, response, done, state](const Status& s) {
+    Status status;
+    {
+      mutex_lock l(state->mu);
+      state->status.Update(s);
+      if (--state->pending > 0) return;
+      status = state->status;
+    }
+    opts->ClearCancelCallback();
+    if (status.ok()) {
+      grpc::EncodeRecvTensorsResponseToByteBuffer(state->responses, response);
+    }
+    delete state;
+    done(status);
+  };
+  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  for (int i = 0; i < num_tensors; ++i) {
+    RecvLocalTensorAsync(step_id, parsed[i], src_devs[i],
+                         request->transfer_options(), true /* only_if_ready */,
+                         &state->responses[i], tensor_done);
+  }
+}
+
+void GrpcWorker::RecvLocalTensorAsync(int64 step_id,
+                                      const Rendezvous::ParsedKey& parsed,
+                                      Device* src_dev,
+                                      const TensorTransferOptions& options,
+                                      bool only_if_ready,
+                                      ::grpc::ByteBuffer* response,
+                                      StatusCallback done) {
+  const TensorTransferOptions* transfer_options = &options;
+  Rendezvous::DoneCallback recv_done =
+      [transfer_options, response, done, src_dev](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
@@ -377,7 +512,8 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
               done(errors::Internal("No GPU device in process"));
 #endif  // GOOGLE_CUDA
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              grpc::EncodeTensorToByteBuffer(is_dead, val, *transfer_options,
+                                             response);
               done(Status::OK());
             }
           }
@@ -385,7 +521,15 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
           //  !s.ok()
           done(status);
         }
-      });
+      };
+  if (!only_if_ready) {
+    env_->rendezvous_mgr->RecvLocalAsync(step_id, parsed,
+                                         std::move(recv_done));
+  } else if (!env_->rendezvous_mgr->RecvLocalIfReadyAsync(
+                 step_id, parsed, std::move(recv_done))) {
+    // Not produced yet: leave "*response" empty.
+    done(Status::OK());
+  }
 }
 
 WorkerEnv* GrpcWorker::env() { return env_; }
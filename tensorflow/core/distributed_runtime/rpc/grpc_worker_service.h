@@ -37,7 +37,27 @@ class GrpcWorker : public Worker {
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        ::grpc::ByteBuffer* response, StatusCallback done);
 
+  // Specialized version of RecvTensors for gRPC, which shares the
+  // encoding of each tensor with the response instead of copying it.
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        ::grpc::ByteBuffer* response, StatusCallback done);
+
   WorkerEnv* env();
+
+ private:
+  // Encodes the tensor for "parsed", which is produced on "src_dev" in
+  // step "step_id", into "*response" as a RecvTensorResponse once it is
+  // available. Its data is encoded as "options" asks for, unless it is
+  // on a GPU. "options" must stay live until "done" is called.
+  //
+  // If "only_if_ready" is true and the tensor has not been produced yet,
+  // leaves "*response" empty and calls "done" with an OK status instead of
+  // waiting for it.
+  void RecvLocalTensorAsync(int64 step_id, const Rendezvous::ParsedKey& parsed,
+                            Device* src_dev,
+                            const TensorTransferOptions& options,
+                            bool only_if_ready, ::grpc::ByteBuffer* response,
+                            StatusCallback done);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env);
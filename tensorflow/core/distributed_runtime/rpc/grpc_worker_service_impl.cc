@@ -44,6 +44,10 @@ const char* GrpcWorkerMethodName(GrpcWorkerMethod id) {
       return "/tensorflow.WorkerService/CleanupAll";
     case GrpcWorkerMethod::kRecvTensor:
       return "/tensorflow.WorkerService/RecvTensor";
+    case GrpcWorkerMethod::kRecvTensors:
+      return "/tensorflow.WorkerService/RecvTensors";
+    case GrpcWorkerMethod::kPushTensor:
+      return "/tensorflow.WorkerService/PushTensor";
     case GrpcWorkerMethod::kLogging:
       return "/tensorflow.WorkerService/Logging";
     case GrpcWorkerMethod::kTracing:
@@ -27,6 +27,7 @@ limitations under the License.
 #include "grpc++/support/byte_buffer.h"
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_serialization_traits.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
@@ -51,6 +52,12 @@ class GrpcByteSource : public TensorResponse::Source {
     return stream_;
   }
 
+  // Shares the tensor data, which saves copying it, if it arrived in a
+  // single aligned slice.
+  TensorBuffer* ShareBytes(int64 offset, int64 size) override {
+    return grpc::ShareByteBufferData(buffer_, offset, size);
+  }
+
  private:
   void DeleteStream() {
     if (stream_) {
@@ -102,6 +109,72 @@ class SerializationTraits<tensorflow::TensorResponse>
     return result;
   }
 };
+
+// Support parsing of tensorflow::TensorResponses.
+// Wire-format is identical to RecvTensorsResponse.
+template <>
+class SerializationTraits<tensorflow::TensorResponses>
+    : public UnlimitedSizeProtoSerializationTraits<
+          tensorflow::TensorResponses> {
+ public:
+  static Status Serialize(const tensorflow::TensorResponses& msg,
+                          grpc_byte_buffer** bp, bool* own_buffer) {
+    LOG(FATAL) << "TensorResponses are only ever received";
+    return Status();
+  }
+  static Status Deserialize(grpc_byte_buffer* buffer,
+                            tensorflow::TensorResponses* msg,
+                            int max_message_size = INT_MAX) {
+    if (buffer == nullptr) {
+      return Status(StatusCode::INTERNAL, "No payload");
+    }
+    Status result = g_core_codegen_interface->ok();
+    {
+      ::tensorflow::GrpcByteSource source(buffer);
+      auto s = msg->ParseFrom(&source);
+      if (!s.ok()) {
+        result = Status(StatusCode::INTERNAL,
+                        ::tensorflow::strings::StrCat(
+                            "TensorResponses parse error", s.ToString()));
+      }
+    }
+    g_core_codegen_interface->grpc_byte_buffer_destroy(buffer);
+    return result;
+  }
+};
+
+// Support parsing of tensorflow::PushedTensor.
+// Wire-format is identical to PushTensorRequest.
+template <>
+class SerializationTraits<tensorflow::PushedTensor>
+    : public UnlimitedSizeProtoSerializationTraits<tensorflow::PushedTensor> {
+ public:
+  static Status Serialize(const tensorflow::PushedTensor& msg,
+                          grpc_byte_buffer** bp, bool* own_buffer) {
+    LOG(FATAL) << "PushedTensors are sent with "
+                  "EncodePushedTensorToByteBuffer()";
+    return Status();
+  }
+  static Status Deserialize(grpc_byte_buffer* buffer,
+                            tensorflow::PushedTensor* msg,
+                            int max_message_size = INT_MAX) {
+    if (buffer == nullptr) {
+      return Status(StatusCode::INTERNAL, "No payload");
+    }
+    Status result = g_core_codegen_interface->ok();
+    {
+      ::tensorflow::GrpcByteSource source(buffer);
+      auto s = msg->ParseFrom(&source);
+      if (!s.ok()) {
+        result = Status(StatusCode::INTERNAL,
+                        ::tensorflow::strings::StrCat(
+                            "PushedTensor parse error", s.ToString()));
+      }
+    }
+    g_core_codegen_interface->grpc_byte_buffer_destroy(buffer);
+    return result;
+  }
+};
 }  // namespace grpc
 
 namespace tensorflow {
@@ -116,6 +189,8 @@ enum class GrpcWorkerMethod {
   kCleanupGraph,
   kCleanupAll,
   kRecvTensor,
+  kRecvTensors,
+  kPushTensor,
   kLogging,
   kTracing,
 };
@@ -15,13 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <map>
 #include <unordered_set>
+#include <utility>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_util.h"
+#endif  // GOOGLE_CUDA
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/types.h"
@@ -34,19 +40,107 @@ limitations under the License.
 
 namespace tensorflow {
 
+// The keys of the tensors that RecvTensors calls found not produced yet.
+// The receives of a step are issued at about the same point of the step
+// each time, so those tensors are not likely to be produced by the time
+// they are batched in later steps either. Thread-safe.
+class UnreadyRecvKeys {
+ public:
+  UnreadyRecvKeys() {}
+
+  bool Contains(const string& key) {
+    mutex_lock l(mu_);
+    return keys_.count(key) > 0;
+  }
+
+  // Does nothing once "kMaxKeys" keys have been added, so that steps that
+  // receive tensors in new frames and iterations do not grow the set
+  // without bound.
+  void Add(const string& key) {
+    mutex_lock l(mu_);
+    if (keys_.size() < kMaxKeys) {
+      keys_.insert(key);
+    }
+  }
+
+ private:
+  static const size_t kMaxKeys = 1 << 16;
+
+  mutex mu_;
+  std::unordered_set<string> keys_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(UnreadyRecvKeys);
+};
+
 namespace {
 
+class RpcRecvTensorCall;
+class RpcRecvTensorsCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id, false) {}
+  RpcRemoteRendezvous(
+      const WorkerEnv* env, int64 step_id, bool push_remote_tensors,
+      int64 recv_tensors_batch_window_micros,
+      std::shared_ptr<UnreadyRecvKeys> unready_keys,
+      std::shared_ptr<const TensorTransferOptions> tensor_transfer_options)
+      : BaseRemoteRendezvous(env, step_id, false),
+        push_remote_tensors_(push_remote_tensors),
+        recv_tensors_batch_window_micros_(recv_tensors_batch_window_micros),
+        unready_keys_(std::move(unready_keys)),
+        tensor_transfer_options_(std::move(tensor_transfer_options)) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
                            const Rendezvous::Args& args,
                            DoneCallback done) override;
 
+  bool PushesToRemote() override { return push_remote_tensors_; }
+
+  void SendToRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                         const Rendezvous::Args& args, const Tensor& val,
+                         bool is_dead, StatusCallback done) override;
+
  private:
+  // Issues "call", which has been initialized, as a RecvTensor call.
+  void StartCall(RpcRecvTensorCall* call);
+
+  // Runs the done callback of "call" with status "s" and releases "call".
+  void CallDone(RpcRecvTensorCall* call, const Status& s);
+
+  // Calls are only batched with calls to the same source worker that
+  // ask for the same tensor transfer options.
+  typedef std::pair<string, bool> BatchKey;
+
+  // Adds "call", which has been initialized, to the pending batch for its
+  // key. Starts a new batch if there is none, and starts the batch once
+  // it is full.
+  void AddToBatch(RpcRecvTensorCall* call);
+
+  // Starts the pending batch for "key" if it is still the batch numbered
+  // "batch_id".
+  void FlushBatch(const BatchKey& key, int64 batch_id);
+
+  // Issues "batch" as a RecvTensors call, or as a RecvTensor call if it
+  // holds a single call. The calls whose tensors the batch does not
+  // return are then issued as RecvTensor calls, and their keys are not
+  // batched again.
+  void StartBatch(RpcRecvTensorsCall* batch);
+
+  // The most calls that are batched into one RecvTensors call.
+  static const size_t kMaxBatchSize = 64;
+
+  const bool push_remote_tensors_;
+  const int64 recv_tensors_batch_window_micros_;
+  const std::shared_ptr<UnreadyRecvKeys> unready_keys_;
+  const std::shared_ptr<const TensorTransferOptions> tensor_transfer_options_;
+
+  mutex batch_mu_;
+  // Batches of calls that wait for more calls with the same key.
+  std::map<BatchKey, RpcRecvTensorsCall*> pending_batches_
+      GUARDED_BY(batch_mu_);
+  int64 next_batch_id_ GUARDED_BY(batch_mu_) = 0;
+
   ~RpcRemoteRendezvous() override {}
 
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
@@ -121,6 +215,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
 
  private:
   friend class RpcRemoteRendezvous;
+  friend class RpcRecvTensorsCall;
 
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
@@ -197,6 +292,145 @@ class RpcRecvTensorFreeList {
   std::vector<RpcRecvTensorCall*> objects_ GUARDED_BY(mu_);
 };
 
+// Used only to push tensors to remote processes.
+class RpcPushTensorCall : public BaseRecvTensorCall {
+ public:
+  RpcPushTensorCall(WorkerInterface* wi, const string& dst_worker,
+                    int64 step_id, StringPiece key, bool is_dead)
+      : wi_(wi), dst_worker_(dst_worker) {
+    req_.set_step_id(step_id);
+    req_.set_rendezvous_key(key);
+    req_.set_is_dead(is_dead);
+  }
+
+  ~RpcPushTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RpcPushTensorCall destructor.";
+  }
+
+  void Start(std::function<void()> push_done) override {
+    using namespace std::placeholders;
+    StatusCallback cb = std::bind(
+        [this](std::function<void()> push_done,
+               // Begin unbound arguments.
+               const Status& s) {
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            status_.Update(s);
+          }
+          push_done();
+        },
+        std::move(push_done), _1);
+    wi_->PushTensorAsync(&opts_, &req_, &resp_, std::move(cb));
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  // The tensor to push, which must be in host memory.
+  Tensor* mutable_tensor() { return req_.mutable_tensor(); }
+
+  // Releases the worker that the tensor is pushed to.
+  void ReleaseWorker(WorkerCacheInterface* wc) {
+    wc->ReleaseWorker(dst_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+ private:
+  WorkerInterface* wi_;
+  const string dst_worker_;
+  CallOptions opts_;
+  PushedTensor req_;
+  PushTensorResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcPushTensorCall);
+};
+
+// Used only to retrieve several tensors from one remote process in a
+// single RecvTensors call.
+class RpcRecvTensorsCall : public BaseRecvTensorCall {
+ public:
+  RpcRecvTensorsCall(int64 step_id, int64 id) : id_(id) {
+    req_.set_step_id(step_id);
+  }
+
+  // Adds "call", which has been initialized but not started. The calls
+  // of a batch must all be to the same source worker, and must all ask
+  // for the same tensor transfer options.
+  void Add(RpcRecvTensorCall* call) {
+    if (calls_.empty() && call->req_.has_transfer_options()) {
+      *req_.mutable_transfer_options() = call->req_.transfer_options();
+    }
+    calls_.push_back(call);
+    req_.add_rendezvous_key(call->req_.rendezvous_key());
+    call->resp_.InitAlloc(call->dst_device_, call->alloc_attrs_);
+    resp_.Add(&call->resp_);
+  }
+
+  int64 id() const { return id_; }
+  const std::vector<RpcRecvTensorCall*>& calls() const { return calls_; }
+
+  // Whether the tensor of calls()[i] was returned by the batch. The
+  // others had not been produced yet when the call was served.
+  bool available(int i) const { return resp_.available(i); }
+
+  void Start(std::function<void()> recv_done) override {
+    using namespace std::placeholders;
+    StatusCallback cb = std::bind(
+        [this](std::function<void()> recv_done,
+               // Begin unbound arguments.
+               const Status& s) {
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            status_.Update(s);
+          }
+          recv_done();
+        },
+        std::move(recv_done), _1);
+    // Every call holds an interface to the same worker, which outlives
+    // the batch.
+    calls_[0]->wi_->RecvTensorsAsync(&opts_, &req_, &resp_, std::move(cb));
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+ private:
+  const int64 id_;
+  std::vector<RpcRecvTensorCall*> calls_;  // Not owned.
+  CallOptions opts_;
+  RecvTensorsRequest req_;
+  TensorResponses resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorsCall);
+};
+
 static RpcRecvTensorFreeList* get_call_freelist() {
   static RpcRecvTensorFreeList* call_freelist = new RpcRecvTensorFreeList();
   return call_freelist;
@@ -238,7 +472,22 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
+  if (TensorTransferOptionsApplyToEdge(*tensor_transfer_options_,
+                                       parsed.edge_name)) {
+    *call->req_.mutable_transfer_options() = *tensor_transfer_options_;
+  }
+
+  // A tensor that was not produced yet when it was batched before would
+  // most likely cost a RecvTensors round trip for nothing.
+  if (recv_tensors_batch_window_micros_ > 0 &&
+      !unready_keys_->Contains(call->req_.rendezvous_key())) {
+    AddToBatch(call);
+  } else {
+    StartCall(call);
+  }
+}
 
+void RpcRemoteRendezvous::StartCall(RpcRecvTensorCall* call) {
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
 
@@ -249,23 +498,194 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
     // current status should be bad.
-    Status s = call->status();
-    call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
-    session()->worker_cache->ReleaseWorker(call->src_worker_, call->wi_);
-    call->wi_ = nullptr;
-    get_call_freelist()->Release(call, session()->worker_cache.get());
+    CallDone(call, call->status());
     Unref();
   });
 }
 
+void RpcRemoteRendezvous::CallDone(RpcRecvTensorCall* call, const Status& s) {
+  call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
+  session()->worker_cache->ReleaseWorker(call->src_worker_, call->wi_);
+  call->wi_ = nullptr;
+  get_call_freelist()->Release(call, session()->worker_cache.get());
+}
+
+void RpcRemoteRendezvous::AddToBatch(RpcRecvTensorCall* call) {
+  RpcRecvTensorsCall* full_batch = nullptr;
+  {
+    const BatchKey key(call->src_worker_, call->req_.has_transfer_options());
+    mutex_lock l(batch_mu_);
+    RpcRecvTensorsCall*& batch = pending_batches_[key];
+    if (batch == nullptr) {
+      batch = new RpcRecvTensorsCall(step_id_, next_batch_id_++);
+      const int64 batch_id = batch->id();
+      Ref();
+      SchedNonBlockingClosureAfter(recv_tensors_batch_window_micros_,
+                                   [this, key, batch_id]() {
+                                     FlushBatch(key, batch_id);
+                                     Unref();
+                                   });
+    }
+    batch->Add(call);
+    if (batch->calls().size() >= kMaxBatchSize) {
+      full_batch = batch;
+      pending_batches_.erase(key);
+    }
+  }
+  if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const BatchKey& key, int64 batch_id) {
+  RpcRecvTensorsCall* batch = nullptr;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(key);
+    if (it == pending_batches_.end() || it->second->id() != batch_id) {
+      // The batch was started when it became full.
+      return;
+    }
+    batch = it->second;
+    pending_batches_.erase(it);
+  }
+  StartBatch(batch);
+}
+
+void RpcRemoteRendezvous::StartBatch(RpcRecvTensorsCall* batch) {
+  if (batch->calls().size() == 1) {
+    StartCall(batch->calls()[0]);
+    delete batch;
+    return;
+  }
+
+  // Record "batch" in active_ so that it can be aborted cleanly.
+  RegisterCall(batch);
+
+  Ref();
+  auto batch_done = [this, batch]() {
+    DeregisterCall(batch);
+    Status s = batch->status();
+    for (int i = 0; i < batch->calls().size(); ++i) {
+      RpcRecvTensorCall* call = batch->calls()[i];
+      if (s.ok() && !batch->available(i)) {
+        // The sender does not wait for a tensor that it has not produced
+        // yet, so wait for it with a call of its own.
+        unready_keys_->Add(call->req_.rendezvous_key());
+        StartCall(call);
+      } else {
+        CallDone(call, s);
+      }
+    }
+    delete batch;
+    Unref();
+  };
+  if (!batch->status().ok()) {
+    // The step was aborted while the batch was pending.
+    batch_done();
+    return;
+  }
+  batch->Start(std::move(batch_done));
+}
+
+void RpcRemoteRendezvous::SendToRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                                            const Rendezvous::Args& args,
+                                            const Tensor& val, bool is_dead,
+                                            StatusCallback done) {
+  CHECK(is_initialized());
+
+  // key.dst_device identifies a remote device.
+  string dst_worker;
+  string dst_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.dst_device, &dst_worker,
+                                        &dst_rel_device)) {
+    done(errors::Internal(parsed.dst_device,
+                          " is invalid remote destination device."));
+    return;
+  }
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(dst_worker);
+  if (rwi == nullptr) {
+    done(errors::Internal("No worker known as ", dst_worker));
+    return;
+  }
+  RpcPushTensorCall* call = new RpcPushTensorCall(
+      rwi, dst_worker, step_id_, parsed.FullKey(), is_dead);
+
+  // Runs "call" once its tensor has been filled in. As with RecvTensor
+  // calls, "call" is recorded in active_ so that it can be aborted cleanly.
+  auto start_call = [this, sess, call, done](const Status& s) {
+    if (!s.ok()) {
+      call->ReleaseWorker(sess->worker_cache.get());
+      delete call;
+      done(s);
+      return;
+    }
+    RegisterCall(call);
+    call->Start([this, sess, call, done]() {
+      DeregisterCall(call);
+      Status s = call->status();
+      call->ReleaseWorker(sess->worker_cache.get());
+      delete call;
+      done(s);
+    });
+  };
+
+  if (is_dead) {
+    start_call(Status::OK());
+    return;
+  }
+  Device* src_device;
+  Status s = env_->device_mgr->LookupDevice(parsed.src_device, &src_device);
+  if (!s.ok()) {
+    start_call(s);
+    return;
+  }
+  if (src_device->tensorflow_gpu_device_info() &&
+      !args.alloc_attrs.on_host()) {
+#if GOOGLE_CUDA
+    // "val" is on a GPU. Copies it to host memory, from which it is
+    // encoded without another copy.
+    AllocatorAttributes alloc_attrs;
+    alloc_attrs.set_on_host(true);
+    alloc_attrs.set_gpu_compatible(true);
+    *call->mutable_tensor() =
+        Tensor(src_device->GetAllocator(alloc_attrs), val.dtype(), val.shape());
+    Tensor* src = new Tensor(val);
+    GPUUtil::CopyGPUTensorToCPU(src_device, args.device_context, src,
+                                call->mutable_tensor(),
+                                [src, start_call](const Status& s) {
+                                  delete src;
+                                  start_call(s);
+                                });
+#else
+    start_call(errors::Internal("No GPU device in process"));
+#endif  // GOOGLE_CUDA
+  } else {
+    *call->mutable_tensor() = val;
+    start_call(Status::OK());
+  }
+}
+
 }  // namespace
 
-RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env,
+                                   bool push_remote_tensors,
+                                   int64 recv_tensors_batch_window_micros,
+                                   const TensorTransferOptions&
+                                       tensor_transfer_options)
+    : BaseRendezvousMgr(env),
+      push_remote_tensors_(push_remote_tensors),
+      recv_tensors_batch_window_micros_(recv_tensors_batch_window_micros),
+      unready_keys_(new UnreadyRecvKeys),
+      tensor_transfer_options_(
+          new TensorTransferOptions(tensor_transfer_options)) {}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id, push_remote_tensors_,
+                                 recv_tensors_batch_window_micros_,
+                                 unready_keys_, tensor_transfer_options_);
 }
 
 }  // end namespace tensorflow
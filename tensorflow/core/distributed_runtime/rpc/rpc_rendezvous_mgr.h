@@ -16,13 +16,17 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RPC_RENDEZVOUS_MGR_H_
 
+#include <memory>
+
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
 class DeviceMgr;
+class UnreadyRecvKeys;
 
 // RendezvousMgr keeps track of a set of local rendezvous instances.
 // All tensors sent by this worker are buffered in a RendezvousMgr
@@ -42,14 +46,40 @@ class DeviceMgr;
 //
 // Tensors sent and recved through rendezvous managed by this
 // RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+//
+// If "push_remote_tensors" is true, tensors sent to remote workers are
+// pushed to them by PushTensor RPCs as soon as they are sent, instead of
+// being buffered until the remote worker requests them by a RecvTensor
+// RPC. All workers in a cluster must use the same mode.
+//
+// If "recv_tensors_batch_window_micros" is positive, tensors received
+// from a remote worker within that many microseconds of each other in
+// the same step are fetched from it by a single RecvTensors RPC. Tensors
+// that a RecvTensors RPC found not produced yet are fetched by a
+// RecvTensor RPC each in later steps, since batching them again would
+// most likely delay them by a round trip.
+//
+// Remote workers are asked to encode the tensors that this worker
+// receives from them as "tensor_transfer_options" says.
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
-  explicit RpcRendezvousMgr(const WorkerEnv* env);
+  explicit RpcRendezvousMgr(
+      const WorkerEnv* env, bool push_remote_tensors = false,
+      int64 recv_tensors_batch_window_micros = 0,
+      const TensorTransferOptions& tensor_transfer_options =
+          TensorTransferOptions());
 
  protected:
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env);
 
  private:
+  const bool push_remote_tensors_;
+  const int64 recv_tensors_batch_window_micros_;
+  // Shared with the rendezvous instances, which may outlive *this.
+  const std::shared_ptr<UnreadyRecvKeys> unready_keys_;
+  // Shared with the rendezvous instances, which may outlive *this.
+  const std::shared_ptr<const TensorTransferOptions> tensor_transfer_options_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
@@ -15,7 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <functional>
+#include <map>
+#include <set>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/control_flow.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -60,6 +68,157 @@ class DummyWorkerCache : public WorkerCacheInterface {
   void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
                               StatusCallback done) override {}
 };
+
+// Records the receive calls of FakeRemoteWorkers, and which of their
+// tensors have not been produced yet.
+struct RecvCalls {
+  mutex mu;
+  int num_recv_tensor GUARDED_BY(mu) = 0;
+  std::vector<int> recv_tensors_sizes GUARDED_BY(mu);
+  std::set<string> unproduced_keys GUARDED_BY(mu);
+  // The RecvTensor calls that wait for an unproduced key to be produced.
+  std::map<string, std::function<void()>> waiting GUARDED_BY(mu);
+
+  // Produces the tensor for "key", and completes the call that waits for
+  // it, if any.
+  void Produce(const string& key) {
+    std::function<void()> call_done;
+    {
+      mutex_lock l(mu);
+      unproduced_keys.erase(key);
+      auto it = waiting.find(key);
+      if (it == waiting.end()) return;
+      call_done = std::move(it->second);
+      waiting.erase(it);
+    }
+    call_done();
+  }
+};
+
+// Fake remote worker, which returns the key of each tensor that is
+// received from it as the tensor. Like a real worker, RecvTensor waits
+// for the tensor to be produced, while RecvTensors leaves the entries of
+// unproduced tensors empty.
+class FakeRemoteWorker : public WorkerInterface {
+ public:
+  explicit FakeRemoteWorker(RecvCalls* calls) : calls_(calls) {}
+
+  void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                       TensorResponse* response,
+                       StatusCallback done) override {
+    const string& key = request->rendezvous_key();
+    {
+      mutex_lock l(calls_->mu);
+      ++calls_->num_recv_tensor;
+      if (calls_->unproduced_keys.count(key) > 0) {
+        calls_->waiting[key] = [key, response, done]() {
+          done(Respond(key, response));
+        };
+        return;
+      }
+    }
+    done(Respond(key, response));
+  }
+
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        TensorResponses* response,
+                        StatusCallback done) override {
+    CHECK_EQ(request->rendezvous_key_size(), response->size());
+    {
+      mutex_lock l(calls_->mu);
+      calls_->recv_tensors_sizes.push_back(request->rendezvous_key_size());
+      for (int i = 0; i < response->size(); ++i) {
+        if (calls_->unproduced_keys.count(request->rendezvous_key(i)) > 0) {
+          response->set_available(i, false);
+        }
+      }
+    }
+    Status s;
+    for (int i = 0; i < response->size(); ++i) {
+      if (response->available(i)) {
+        s.Update(Respond(request->rendezvous_key(i), response->response(i)));
+      }
+    }
+    done(s);
+  }
+
+  void GetStatusAsync(const GetStatusRequest* request,
+                      GetStatusResponse* response,
+                      StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void CreateWorkerSessionAsync(const CreateWorkerSessionRequest* request,
+                                CreateWorkerSessionResponse* response,
+                                StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void RegisterGraphAsync(const RegisterGraphRequest* request,
+                          RegisterGraphResponse* response,
+                          StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void DeregisterGraphAsync(const DeregisterGraphRequest* request,
+                            DeregisterGraphResponse* response,
+                            StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void RunGraphAsync(CallOptions* opts, RunGraphRequestWrapper* request,
+                     MutableRunGraphResponseWrapper* response,
+                     StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void CleanupGraphAsync(const CleanupGraphRequest* request,
+                         CleanupGraphResponse* response,
+                         StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void CleanupAllAsync(const CleanupAllRequest* request,
+                       CleanupAllResponse* response,
+                       StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void PushTensorAsync(CallOptions* opts, const PushedTensor* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
+                    StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+  void TracingAsync(const TracingRequest* request, TracingResponse* response,
+                    StatusCallback done) override {
+    done(errors::Unimplemented(""));
+  }
+
+ private:
+  static Status Respond(const string& key, TensorResponse* response) {
+    RecvTensorResponse proto;
+    Tensor(V(key)).AsProtoTensorContent(proto.mutable_tensor());
+    return response->InitFrom(&proto);
+  }
+
+  RecvCalls* const calls_;  // Not owned.
+};
+
+class FakeWorkerCache : public WorkerCacheInterface {
+ public:
+  explicit FakeWorkerCache(RecvCalls* calls) : calls_(calls) {}
+
+  void ListWorkers(std::vector<string>* workers) const override {}
+  WorkerInterface* CreateWorker(const string& target) override {
+    return new FakeRemoteWorker(calls_);
+  }
+  bool GetDeviceLocalityNonBlocking(const string& device,
+                                    DeviceLocality* locality) override {
+    return false;
+  }
+  void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
+                              StatusCallback done) override {}
+
+ private:
+  RecvCalls* const calls_;  // Not owned.
+};
 }  // namespace
 
 class RpcRendezvousMgrTest : public ::testing::Test {
@@ -70,7 +229,8 @@ class RpcRendezvousMgrTest : public ::testing::Test {
                         std::unique_ptr<WorkerCacheInterface>(cache_),
                         std::unique_ptr<DeviceMgr>(),
                         std::unique_ptr<GraphMgr>()),
-        rmgr_(&env) {
+        rmgr_(&env),
+        push_rmgr_(&env, true /* push_remote_tensors */) {
     env.env = Env::Default();
   }
 
@@ -79,6 +239,7 @@ class RpcRendezvousMgrTest : public ::testing::Test {
 
   WorkerSession worker_session_;
   RpcRendezvousMgr rmgr_;
+  RpcRendezvousMgr push_rmgr_;
 };
 
 TEST_F(RpcRendezvousMgrTest, LocalSendRecv) {
@@ -198,6 +359,265 @@ TEST_F(RpcRendezvousMgrTest, TransferDummyDeviceContext) {
   dc->Unref();
 }
 
+TEST_F(RpcRendezvousMgrTest, PushedRecv) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  // The tensor may be pushed before the step starts on this worker.
+  TF_ASSERT_OK(push_rmgr_.AcceptPushedTensor(step_id, key, V("peach"), false));
+  {
+    RemoteRendezvous* rendez = push_rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+    Tensor val(DT_STRING);
+    bool val_dead = false;
+    Rendezvous::Args args;
+    TF_ASSERT_OK(rendez->Recv(key, args, &val, &val_dead));
+    EXPECT_EQ(V(val), "peach");
+    EXPECT_FALSE(val_dead);
+  }
+  push_rmgr_.Cleanup(step_id);
+}
+
+TEST_F(RpcRendezvousMgrTest, PushedRecvAbort) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  RemoteRendezvous* rendez = push_rmgr_.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+  SchedClosure([this, step_id]() {
+    env.env->SleepForMicroseconds(100 * 1000);
+    push_rmgr_.Cleanup(step_id);
+  });
+  Tensor val(DT_STRING);
+  bool val_dead = false;
+  Rendezvous::Args args;
+  EXPECT_TRUE(errors::IsAborted(rendez->Recv(key, args, &val, &val_dead)));
+  // Tensors pushed after the step was aborted are rejected.
+  EXPECT_TRUE(errors::IsAborted(
+      static_cast<BaseRemoteRendezvous*>(rendez)->AcceptPushedTensor(
+          key, V("peach"), false)));
+}
+
+TEST_F(RpcRendezvousMgrTest, PushedAfterCleanup) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:3/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "foo", FrameAndIter(0, 0)));
+  TF_ASSERT_OK(push_rmgr_.AcceptPushedTensor(step_id, key, V("peach"), false));
+  push_rmgr_.Cleanup(step_id);
+  // A tensor pushed after its step ended does not bring the step back.
+  EXPECT_TRUE(errors::IsAborted(
+      push_rmgr_.AcceptPushedTensor(step_id, key, V("plum"), false)));
+  // Neither does one pushed to a step that ended before any tensor arrived.
+  push_rmgr_.Cleanup(step_id + 1);
+  EXPECT_TRUE(errors::IsAborted(
+      push_rmgr_.AcceptPushedTensor(step_id + 1, key, V("plum"), false)));
+}
+
+TEST_F(RpcRendezvousMgrTest, PushFailureAbortsStep) {
+  const int64 step_id = 123;
+  const Rendezvous::ParsedKey remote_key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:3/cpu:0", "foo", FrameAndIter(0, 0)));
+  const Rendezvous::ParsedKey local_key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:1", "bar", FrameAndIter(0, 0)));
+  RemoteRendezvous* rendez = push_rmgr_.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+  Rendezvous::Args args;
+  // Send() does not wait for the push, which fails because DummyWorkerCache
+  // does not know the remote worker, and aborts the step.
+  TF_ASSERT_OK(rendez->Send(remote_key, args, V("peach"), false));
+  Status s = rendez->Send(local_key, args, V("plum"), false);
+  EXPECT_TRUE(errors::IsInternal(s)) << s;
+  push_rmgr_.Cleanup(step_id);
+}
+
+TEST_F(RpcRendezvousMgrTest, BatchedRemoteRecv) {
+  const int64 step_id = 123;
+  RecvCalls calls;
+  const string worker_name = "/job:mnist/replica:1/task:2";
+  WorkerSession session(
+      worker_name,
+      std::unique_ptr<WorkerCacheInterface>(new FakeWorkerCache(&calls)),
+      std::unique_ptr<DeviceMgr>(
+          new DeviceMgr({DeviceFactory::NewDevice("CPU", {}, worker_name)})),
+      std::unique_ptr<GraphMgr>());
+  // Batch the receives of a whole step into one RecvTensors call.
+  RpcRendezvousMgr batch_rmgr(&env, false /* push_remote_tensors */,
+                              100 * 1000 /* batch_window_micros */);
+  RemoteRendezvous* rendez = batch_rmgr.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(&session));
+
+  auto recv = [rendez](const string& name, Notification* n, string* result) {
+    const string key = Rendezvous::CreateKey(
+        "/job:mnist/replica:1/task:3/cpu:0", 7890,
+        "/job:mnist/replica:1/task:2/cpu:0", name, FrameAndIter(0, 0));
+    rendez->RecvAsync(
+        MakeKey(key), Rendezvous::Args(),
+        [n, result](const Status& s, const Rendezvous::Args& send_args,
+                    const Rendezvous::Args& recv_args, const Tensor& val,
+                    bool is_dead) {
+          TF_EXPECT_OK(s);
+          *result = V(val);
+          n->Notify();
+        });
+    return key;
+  };
+  {
+    // Recvs from the same worker within the window share one call.
+    Notification n_a, n_b;
+    string val_a, val_b;
+    const string key_a = recv("a", &n_a, &val_a);
+    const string key_b = recv("b", &n_b, &val_b);
+    n_a.WaitForNotification();
+    n_b.WaitForNotification();
+    EXPECT_EQ(key_a, val_a);
+    EXPECT_EQ(key_b, val_b);
+    mutex_lock l(calls.mu);
+    EXPECT_EQ(0, calls.num_recv_tensor);
+    EXPECT_EQ(std::vector<int>({2}), calls.recv_tensors_sizes);
+  }
+  {
+    // A lone recv does not need a RecvTensors call.
+    Notification n_c;
+    string val_c;
+    const string key_c = recv("c", &n_c, &val_c);
+    n_c.WaitForNotification();
+    EXPECT_EQ(key_c, val_c);
+    mutex_lock l(calls.mu);
+    EXPECT_EQ(1, calls.num_recv_tensor);
+    EXPECT_EQ(1, calls.recv_tensors_sizes.size());
+  }
+  batch_rmgr.Cleanup(step_id);
+}
+
+TEST_F(RpcRendezvousMgrTest, BatchedRemoteRecvCrossWorkerDependency) {
+  const int64 step_id = 123;
+  RecvCalls calls;
+  const string worker_name = "/job:mnist/replica:1/task:2";
+  WorkerSession session(
+      worker_name,
+      std::unique_ptr<WorkerCacheInterface>(new FakeWorkerCache(&calls)),
+      std::unique_ptr<DeviceMgr>(
+          new DeviceMgr({DeviceFactory::NewDevice("CPU", {}, worker_name)})),
+      std::unique_ptr<GraphMgr>());
+  RpcRendezvousMgr batch_rmgr(&env, false /* push_remote_tensors */,
+                              100 * 1000 /* batch_window_micros */);
+  RemoteRendezvous* rendez = batch_rmgr.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(&session));
+
+  auto make_key = [](const string& name) {
+    return Rendezvous::CreateKey("/job:mnist/replica:1/task:3/cpu:0", 7890,
+                                 "/job:mnist/replica:1/task:2/cpu:0", name,
+                                 FrameAndIter(0, 0));
+  };
+  const string key_a = make_key("a");
+  const string key_b = make_key("b");
+  {
+    // The remote worker only produces "b" once this worker has received
+    // "a", but both recvs land in the same batch.
+    mutex_lock l(calls.mu);
+    calls.unproduced_keys.insert(key_b);
+  }
+  Notification n_a, n_b;
+  string val_a, val_b;
+  rendez->RecvAsync(
+      MakeKey(key_a), Rendezvous::Args(),
+      [&calls, &n_a, &val_a, &key_b](
+          const Status& s, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val, bool is_dead) {
+        TF_EXPECT_OK(s);
+        val_a = V(val);
+        n_a.Notify();
+        calls.Produce(key_b);
+      });
+  rendez->RecvAsync(
+      MakeKey(key_b), Rendezvous::Args(),
+      [&n_b, &val_b](const Status& s, const Rendezvous::Args& send_args,
+                     const Rendezvous::Args& recv_args, const Tensor& val,
+                     bool is_dead) {
+        TF_EXPECT_OK(s);
+        val_b = V(val);
+        n_b.Notify();
+      });
+  n_a.WaitForNotification();
+  n_b.WaitForNotification();
+  EXPECT_EQ(key_a, val_a);
+  EXPECT_EQ(key_b, val_b);
+  {
+    // "b" is fetched by a RecvTensor call of its own.
+    mutex_lock l(calls.mu);
+    EXPECT_EQ(std::vector<int>({2}), calls.recv_tensors_sizes);
+    EXPECT_EQ(1, calls.num_recv_tensor);
+  }
+  batch_rmgr.Cleanup(step_id);
+}
+
+TEST_F(RpcRendezvousMgrTest, BatchedRemoteRecvSkipsUnreadyKeys) {
+  RecvCalls calls;
+  const string worker_name = "/job:mnist/replica:1/task:2";
+  WorkerSession session(
+      worker_name,
+      std::unique_ptr<WorkerCacheInterface>(new FakeWorkerCache(&calls)),
+      std::unique_ptr<DeviceMgr>(
+          new DeviceMgr({DeviceFactory::NewDevice("CPU", {}, worker_name)})),
+      std::unique_ptr<GraphMgr>());
+  RpcRendezvousMgr batch_rmgr(&env, false /* push_remote_tensors */,
+                              100 * 1000 /* batch_window_micros */);
+
+  auto make_key = [](const string& name) {
+    return Rendezvous::CreateKey("/job:mnist/replica:1/task:3/cpu:0", 7890,
+                                 "/job:mnist/replica:1/task:2/cpu:0", name,
+                                 FrameAndIter(0, 0));
+  };
+  const std::vector<string> keys = {make_key("a"), make_key("b"),
+                                    make_key("c")};
+  // In each step, the remote worker only produces "b" once this worker
+  // has received "a".
+  for (int64 step_id = 1; step_id <= 2; ++step_id) {
+    {
+      mutex_lock l(calls.mu);
+      calls.unproduced_keys.insert(keys[1]);
+    }
+    RemoteRendezvous* rendez = batch_rmgr.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_ASSERT_OK(rendez->Initialize(&session));
+    Notification n[3];
+    string vals[3];
+    for (int i = 0; i < 3; ++i) {
+      rendez->RecvAsync(
+          MakeKey(keys[i]), Rendezvous::Args(),
+          [&calls, &keys, &n, &vals, i](
+              const Status& s, const Rendezvous::Args& send_args,
+              const Rendezvous::Args& recv_args, const Tensor& val,
+              bool is_dead) {
+            TF_EXPECT_OK(s);
+            vals[i] = V(val);
+            n[i].Notify();
+            if (i == 0) calls.Produce(keys[1]);
+          });
+    }
+    for (int i = 0; i < 3; ++i) {
+      n[i].WaitForNotification();
+      EXPECT_EQ(keys[i], vals[i]);
+    }
+    batch_rmgr.Cleanup(step_id);
+  }
+  // The first step found "b" not produced yet, so the second one fetched
+  // it by a RecvTensor call from the start instead of batching it again.
+  mutex_lock l(calls.mu);
+  EXPECT_EQ(std::vector<int>({3, 2}), calls.recv_tensors_sizes);
+  EXPECT_EQ(2, calls.num_recv_tensor);
+}
+
 // NOTE: Remote Send/Recv is better tested in worker_test.cc
 
 }  // namespace tensorflow
@@ -15,13 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
 
 namespace tensorflow {
 
 TensorResponse::Source::~Source() {}
 
+TensorBuffer* TensorResponse::Source::ShareBytes(int64 offset, int64 size) {
+  return nullptr;
+}
+
 void TensorResponse::Clear() {
   on_host_ = false;
+  share_ok_ = false;
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
@@ -42,18 +48,31 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   if (alloc_attrs_.on_host() || da.device_type() == "CPU") {
     on_host_ = true;
   }
+  // Memory that the Source shares is neither pinned nor registered with
+  // the NIC.
+  share_ok_ = on_host_ && !alloc_attrs_.gpu_compatible() &&
+              !alloc_attrs_.nic_compatible();
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
+void TensorResponse::InitHostAlloc() {
+  Clear();
+  on_host_ = true;
+  share_ok_ = true;
+  allocator_ = cpu_allocator();
+}
+
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
-  Status s;
   meta_.Swap(response);
-  if (on_host_) {
-    if (!tensor_.FromProto(allocator_, meta_.tensor())) {
-      s = errors::InvalidArgument("Cannot parse tensor from response");
+  Status s = DecodeTensorContent();
+  if (s.ok()) {
+    if (on_host_) {
+      if (!tensor_.FromProto(allocator_, meta_.tensor())) {
+        s = errors::InvalidArgument("Cannot parse tensor from response");
+      }
+    } else {
+      s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     }
-  } else {
-    s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
   }
   {
     TensorProto empty;
@@ -82,8 +101,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
-    Status s =
-        device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    Status s = DecodeTensorContent();
+    if (s.ok()) {
+      s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
+    }
     // Reduce memory usage for big tensors.
     {
       TensorProto empty;
@@ -102,6 +123,21 @@ Status TensorResponse::ParseFrom(Source* source) {
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
 
+Status TensorResponse::DecodeTensorContent() {
+  if (meta_.codec() == TensorTransferOptions::NONE) return Status::OK();
+  TensorProto* proto = meta_.mutable_tensor();
+  if (!DataTypeCanUseMemcpy(proto->dtype()) ||
+      !TensorShape::IsValid(proto->tensor_shape())) {
+    return errors::InvalidArgument("Cannot parse tensor from response");
+  }
+  Tensor t(cpu_allocator(), proto->dtype(), TensorShape(proto->tensor_shape()));
+  TF_RETURN_IF_ERROR(
+      DecodeTensorData(meta_.codec(), proto->tensor_content(), &t));
+  t.AsProtoTensorContent(proto);
+  meta_.set_codec(TensorTransferOptions::NONE);
+  return Status::OK();
+}
+
 // Define some helper routines for decoding protocol buffer wire format data
 namespace {
 // We only need some of the wiretype values for this code
@@ -139,7 +175,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    Source* source, protobuf::io::CodedInputStream* input,
+    TensorProto* tensor_meta) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -190,12 +227,36 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
+        if (share_ok_ && meta_.codec() == TensorTransferOptions::NONE) {
+          // Adopt the received bytes as the tensor buffer if the source
+          // can share them, which saves copying them.
+          if (static_cast<int64>(num_bytes) !=
+              shape.num_elements() * DataTypeSize(tensor_meta->dtype())) {
+            return false;
+          }
+          TensorBuffer* buf =
+              source->ShareBytes(input->CurrentPosition(), num_bytes);
+          if (buf != nullptr) {
+            tensor_ = Tensor(tensor_meta->dtype(), shape, buf);
+            buf->Unref();
+            if (!input->Skip(num_bytes)) return false;
+            break;
+          }
+        }
         Tensor t(allocator_, tensor_meta->dtype(), shape);
+        if (meta_.codec() != TensorTransferOptions::NONE) {
+          // The data has to be decoded, so there is no point in reading
+          // it directly into the tensor.
+          string encoded;
+          if (!input->ReadString(&encoded, num_bytes) ||
+              !DecodeTensorData(meta_.codec(), encoded, &t).ok()) {
+            return false;
+          }
+          tensor_ = std::move(t);
+          break;
+        }
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -229,7 +290,7 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(source, &input, meta_.mutable_tensor())) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -255,6 +316,15 @@ bool TensorResponse::ParseFast(Source* source) {
           return false;
         break;
       }
+      case RecvTensorResponse::kCodecFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        // The fast path can only decode data whose codec is known by the
+        // time the data is read.
+        if (meta_.has_tensor()) return false;
+        meta_.set_codec(static_cast<TensorTransferOptions::Codec>(v));
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -266,7 +336,8 @@ bool TensorResponse::ParseFast(Source* source) {
 }
 
 bool TensorResponse::ParseSlow(Source* source) {
-  if (!meta_.ParseFromZeroCopyStream(source->contents())) {
+  if (!meta_.ParseFromZeroCopyStream(source->contents()) ||
+      !DecodeTensorContent().ok()) {
     return false;
   }
 
@@ -286,4 +357,175 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+namespace {
+
+// A stream over at most "limit" bytes of another stream.
+class LimitedInputStream : public protobuf::io::ZeroCopyInputStream {
+ public:
+  LimitedInputStream(protobuf::io::ZeroCopyInputStream* input, int limit)
+      : input_(input), limit_(limit), count_(0) {}
+
+  bool Next(const void** data, int* size) override {
+    if (limit_ <= 0 || !input_->Next(data, size)) return false;
+    limit_ -= *size;
+    if (limit_ < 0) {
+      // Hide the part of the block that is past the limit. It is not
+      // returned to "input_", since nothing reads "input_" after us.
+      *size += limit_;
+    }
+    count_ += *size;
+    return true;
+  }
+
+  void BackUp(int count) override {
+    if (limit_ < 0) {
+      input_->BackUp(count - limit_);
+      limit_ = count;
+    } else {
+      input_->BackUp(count);
+      limit_ += count;
+    }
+    count_ -= count;
+  }
+
+  bool Skip(int count) override {
+    if (count > limit_) {
+      if (limit_ > 0 && input_->Skip(limit_)) {
+        count_ += limit_;
+        limit_ = 0;
+      }
+      return false;
+    }
+    if (!input_->Skip(count)) return false;
+    limit_ -= count;
+    count_ += count;
+    return true;
+  }
+
+  protobuf_int64 ByteCount() const override { return count_; }
+
+ private:
+  protobuf::io::ZeroCopyInputStream* input_;  // Not owned
+  int limit_;  // Bytes left; negative if the last block overshot.
+  protobuf_int64 count_;
+};
+
+// The data of one entry of a RecvTensorsResponse: "size" bytes starting
+// at "offset" in the data yielded by "source".
+class EntrySource : public TensorResponse::Source {
+ public:
+  EntrySource(TensorResponse::Source* source, int offset, int size)
+      : source_(source), offset_(offset), size_(size) {}
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    protobuf::io::ZeroCopyInputStream* input = source_->contents();
+    // The entries were found by reading through "source", so this
+    // does not fail.
+    input->Skip(offset_);
+    stream_.reset(new LimitedInputStream(input, size_));
+    return stream_.get();
+  }
+
+  TensorBuffer* ShareBytes(int64 offset, int64 size) override {
+    if (offset + size > size_) return nullptr;
+    return source_->ShareBytes(offset_ + offset, size);
+  }
+
+ private:
+  TensorResponse::Source* source_;  // Not owned
+  const int offset_;
+  const int size_;
+  std::unique_ptr<LimitedInputStream> stream_;
+};
+
+}  // namespace
+
+Status TensorResponses::ParseFrom(TensorResponse::Source* source) {
+  // Locate the entries first: parsing an entry restarts the stream, and
+  // the entries are parsed in place instead of being copied out.
+  std::vector<std::pair<int, int>> entries;  // Offset and size
+  {
+    protobuf::io::CodedInputStream input(source->contents());
+    input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+    while (true) {
+      const uint32 tag = input.ReadTag();
+      if (tag == 0) break;
+      int size;
+      if (GetTagFieldNumber(tag) != RecvTensorsResponse::kResponseFieldNumber ||
+          GetTagWireType(tag) != WIRETYPE_LENGTH_DELIMITED ||
+          !ReadVarintSizeAsInt(&input, &size)) {
+        return errors::InvalidArgument("Cannot parse tensors from response");
+      }
+      entries.emplace_back(input.CurrentPosition(), size);
+      if (!input.Skip(size)) {
+        return errors::InvalidArgument("Cannot parse tensors from response");
+      }
+    }
+  }
+  if (entries.size() != responses_.size()) {
+    return errors::InvalidArgument("Expected ", responses_.size(),
+                                   " tensors in response, got ",
+                                   entries.size());
+  }
+  for (size_t i = 0; i < entries.size(); ++i) {
+    available_[i] = entries[i].second > 0;
+    if (!available_[i]) continue;
+    EntrySource entry(source, entries[i].first, entries[i].second);
+    TF_RETURN_IF_ERROR(responses_[i]->ParseFrom(&entry));
+  }
+  return Status::OK();
+}
+
+Status PushedTensor::ParseFrom(TensorResponse::Source* source) {
+  // As in TensorResponses::ParseFrom(), the tensor is parsed in place
+  // once it has been located.
+  int offset = -1;
+  int size = 0;
+  {
+    protobuf::io::CodedInputStream input(source->contents());
+    input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
+    while (true) {
+      const uint32 tag = input.ReadTag();
+      if (tag == 0) break;
+      const WireType wt = GetTagWireType(tag);
+      bool ok = false;
+      switch (GetTagFieldNumber(tag)) {
+        case PushTensorRequest::kStepIdFieldNumber: {
+          protobuf_uint64 v;
+          ok = wt == WIRETYPE_VARINT && input.ReadVarint64(&v);
+          step_id_ = static_cast<int64>(v);
+          break;
+        }
+        case PushTensorRequest::kRendezvousKeyFieldNumber: {
+          int length;
+          ok = wt == WIRETYPE_LENGTH_DELIMITED &&
+               ReadVarintSizeAsInt(&input, &length) &&
+               input.ReadString(&rendezvous_key_, length);
+          break;
+        }
+        case PushTensorRequest::kResponseFieldNumber: {
+          ok = wt == WIRETYPE_LENGTH_DELIMITED &&
+               ReadVarintSizeAsInt(&input, &size);
+          offset = input.CurrentPosition();
+          ok = ok && input.Skip(size);
+          break;
+        }
+      }
+      if (!ok) {
+        return errors::InvalidArgument("Cannot parse pushed tensor");
+      }
+    }
+  }
+  if (offset < 0) {
+    return errors::InvalidArgument("No tensor pushed for ", rendezvous_key_);
+  }
+  TensorResponse response;
+  response.InitHostAlloc();
+  EntrySource entry(source, offset, size);
+  TF_RETURN_IF_ERROR(response.ParseFrom(&entry));
+  tensor_ = response.tensor();
+  is_dead_ = response.metadata().is_dead();
+  return Status::OK();
+}
+
 }  // namespace tensorflow
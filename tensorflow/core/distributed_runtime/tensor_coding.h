@@ -16,9 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
 
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
@@ -46,6 +49,10 @@ class TensorResponse {
   // Initialize memory allocation related members.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
+  // Initialize memory allocation related members to decode into host
+  // memory that belongs to no particular device.
+  void InitHostAlloc();
+
   // Source provides a way for a particular RPC implementation to provide
   // received data to ParseFrom.
   class Source {
@@ -64,6 +71,16 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Return a TensorBuffer that shares, rather than copies, the "size"
+    // bytes at "offset" in the data yielded by contents(), or nullptr if
+    // those bytes cannot be shared.  The data() of the result must be
+    // aligned to EIGEN_MAX_ALIGN_BYTES, and must stay valid and unchanged
+    // until the result is unreferenced.  The caller owns one reference
+    // to the result.
+    //
+    // The default implementation returns nullptr.
+    virtual TensorBuffer* ShareBytes(int64 offset, int64 size);
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
@@ -88,12 +105,20 @@ class TensorResponse {
   const RecvTensorResponse& metadata() const { return meta_; }
 
  private:
-  bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
+  bool ParseTensorSubmessage(Source* source,
+                             protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
+  // Decodes the contents of meta_.tensor() in place if they were encoded
+  // with a TensorTransferOptions codec.
+  Status DecodeTensorContent();
+
   bool on_host_ = false;
+  // True if tensor content may be shared with the Source instead of being
+  // copied into memory from allocator_.
+  bool share_ok_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
@@ -102,6 +127,74 @@ class TensorResponse {
   RecvTensorResponse meta_;
 };
 
+// TensorResponses can be used as the destination of an RPC that returns
+// a RecvTensorsResponse.  Each entry of the response is decoded into the
+// TensorResponse at the same position, as if it had been returned by a
+// RecvTensor RPC on its own.  An empty entry stands for a tensor that was
+// not available yet, whose TensorResponse is left untouched.
+class TensorResponses {
+ public:
+  TensorResponses() {}
+
+  // Append "response", which must already be initialized with
+  // InitAlloc().  Does not take ownership of "response".
+  void Add(TensorResponse* response) {
+    responses_.push_back(response);
+    available_.push_back(true);
+  }
+
+  int size() const { return responses_.size(); }
+  TensorResponse* response(int i) const { return responses_[i]; }
+
+  // Whether the tensor of response(i) was available when the call was
+  // served.  If not, it must be received by a RecvTensor call instead.
+  bool available(int i) const { return available_[i]; }
+  void set_available(int i, bool available) { available_[i] = available; }
+
+  // Parse the RecvTensorsResponse encoded in the data yielded by
+  // source->contents() into the added responses.  Fails unless the
+  // number of entries matches size().
+  Status ParseFrom(TensorResponse::Source* source);
+
+ private:
+  std::vector<TensorResponse*> responses_;  // Not owned.
+  std::vector<bool> available_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TensorResponses);
+};
+
+// PushedTensor can be used as the source and the destination of an RPC
+// whose request is a PushTensorRequest.  The tensor is encoded and
+// decoded as that of a RecvTensorResponse, and decoded into host memory.
+class PushedTensor {
+ public:
+  PushedTensor() {}
+
+  int64 step_id() const { return step_id_; }
+  void set_step_id(int64 step_id) { step_id_ = step_id; }
+
+  const string& rendezvous_key() const { return rendezvous_key_; }
+  void set_rendezvous_key(StringPiece key) { rendezvous_key_ = key.ToString(); }
+
+  const Tensor& tensor() const { return tensor_; }
+  Tensor* mutable_tensor() { return &tensor_; }
+
+  bool is_dead() const { return is_dead_; }
+  void set_is_dead(bool is_dead) { is_dead_ = is_dead; }
+
+  // Parse the PushTensorRequest encoded in the data yielded by
+  // source->contents() into *this.
+  Status ParseFrom(TensorResponse::Source* source);
+
+ private:
+  int64 step_id_ = 0;
+  string rendezvous_key_;
+  Tensor tensor_;
+  bool is_dead_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PushedTensor);
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -71,6 +75,48 @@ class StringSource : public TensorResponse::Source {
   int block_size_;
 };
 
+// A TensorBuffer over an aligned copy of some bytes.
+class CopiedBuffer : public TensorBuffer {
+ public:
+  explicit CopiedBuffer(StringPiece bytes) : size_(bytes.size()) {
+    data_ = port::AlignedMalloc(size_, EIGEN_MAX_ALIGN_BYTES);
+    memcpy(data_, bytes.data(), size_);
+  }
+  ~CopiedBuffer() override { port::AlignedFree(data_); }
+
+  void* data() const override { return data_; }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  void* data_;
+  const size_t size_;
+};
+
+// A StringSource that shares bytes through CopiedBuffers, and keeps
+// track of the data they hold.
+class SharingSource : public StringSource {
+ public:
+  explicit SharingSource(const string* s) : StringSource(s, 1024), s_(s) {}
+
+  TensorBuffer* ShareBytes(int64 offset, int64 size) override {
+    TensorBuffer* buf =
+        new CopiedBuffer(StringPiece(*s_).substr(offset, size));
+    shared_.push_back(buf->data());
+    return buf;
+  }
+
+  const std::vector<const void*>& shared() const { return shared_; }
+
+ private:
+  const string* s_;
+  std::vector<const void*> shared_;
+};
+
 class TensorResponseTest : public ::testing::Test {
  public:
   void Validate(const Tensor& src, bool is_dead, bool use_tensor_content) {
@@ -153,8 +199,238 @@ TEST_F(TensorResponseTest, Simple) {
   DoTest<Eigen::half>(DT_HALF);
 }
 
+TEST_F(TensorResponseTest, Encoded) {
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  src.flat<float>().setZero();
+  src.flat<float>()(17) = 1.5f;
+  TensorTransferOptions options;
+  TensorTransferOptions::Policy* policy = options.add_policy();
+  policy->set_dtype(DT_FLOAT);
+  policy->set_codec(TensorTransferOptions::SPARSE);
+  string data;
+  ASSERT_EQ(TensorTransferOptions::SPARSE,
+            EncodeTensorData(options, src, &data));
+
+  RecvTensorResponse codec_proto;
+  codec_proto.set_codec(TensorTransferOptions::SPARSE);
+  RecvTensorResponse tensor_proto;
+  tensor_proto.set_send_start_micros(123456);
+  Tensor(DT_FLOAT, src.shape()).AsProtoTensorContent(
+      tensor_proto.mutable_tensor());
+  tensor_proto.mutable_tensor()->set_tensor_content(data);
+  // The fast path handles a codec that precedes the tensor, the slow path
+  // one that follows it.
+  for (bool codec_first : {true, false}) {
+    string encoded;
+    if (codec_first) {
+      codec_proto.AppendToString(&encoded);
+      tensor_proto.AppendToString(&encoded);
+    } else {
+      tensor_proto.AppendToString(&encoded);
+      codec_proto.AppendToString(&encoded);
+    }
+    StringSource source(&encoded, 1024);
+    TensorResponse response;
+    DummyDevice cpu_device(Env::Default());
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_ASSERT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(123456, response.metadata().send_start_micros());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+}
+
+TEST_F(TensorResponseTest, SharedContent) {
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  test::FillIota<float>(&src, 0.5);
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  // Memory that must be pinned for a GPU is never shared.
+  for (bool gpu_compatible : {false, true}) {
+    SharingSource source(&encoded);
+    TensorResponse response;
+    AllocatorAttributes attr;
+    attr.set_gpu_compatible(gpu_compatible);
+    response.InitAlloc(&cpu_device, attr);
+    TF_ASSERT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(123456, response.metadata().send_start_micros());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+    if (gpu_compatible) {
+      EXPECT_TRUE(source.shared().empty());
+    } else {
+      ASSERT_EQ(1, source.shared().size());
+      EXPECT_EQ(source.shared()[0], response.tensor().tensor_data().data());
+    }
+  }
+}
+
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST(TensorResponsesTest, Simple) {
+  std::vector<Tensor> tensors;
+  tensors.push_back(test::AsTensor<float>({1.0, 2.0, 3.0}, {3}));
+  tensors.push_back(test::AsTensor<string>({"a", "bc"}, {2, 1}));
+  tensors.push_back(Tensor(DT_INT32, TensorShape({0})));
+  tensors.push_back(test::AsTensor<int64>({-7}, {}));
+  tensors.push_back(Tensor(DT_FLOAT, TensorShape({100, 30})));
+  test::FillIota<float>(&tensors.back(), 0.5);
+  RecvTensorsResponse proto;
+  for (size_t i = 0; i < tensors.size(); i++) {
+    RecvTensorResponse* entry = proto.add_response();
+    entry->set_is_dead(i == 2);
+    entry->set_send_start_micros(100 + i);
+    tensors[i].AsProtoTensorContent(entry->mutable_tensor());
+  }
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  for (int block_size : {1, 7, 1024, -1}) {
+    StringSource source(&encoded, block_size);
+    std::vector<TensorResponse> responses(tensors.size());
+    TensorResponses batch;
+    for (TensorResponse& response : responses) {
+      response.InitAlloc(&cpu_device, AllocatorAttributes());
+      batch.Add(&response);
+    }
+    TF_EXPECT_OK(batch.ParseFrom(&source));
+    for (size_t i = 0; i < tensors.size(); i++) {
+      EXPECT_EQ(responses[i].metadata().is_dead(), i == 2);
+      EXPECT_EQ(responses[i].metadata().send_start_micros(), 100 + i);
+      EXPECT_EQ(responses[i].tensor().DebugString(), tensors[i].DebugString());
+    }
+  }
+}
+
+TEST(TensorResponsesTest, SharedContent) {
+  std::vector<Tensor> tensors;
+  tensors.push_back(test::AsTensor<int64>({-7, 8}, {2}));
+  tensors.push_back(test::AsTensor<string>({"a", "bc"}, {2, 1}));
+  tensors.push_back(Tensor(DT_FLOAT, TensorShape({100, 30})));
+  test::FillIota<float>(&tensors.back(), 0.5);
+  RecvTensorsResponse proto;
+  for (const Tensor& t : tensors) {
+    t.AsProtoTensorContent(proto.add_response()->mutable_tensor());
+  }
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  SharingSource source(&encoded);
+  std::vector<TensorResponse> responses(tensors.size());
+  TensorResponses batch;
+  for (TensorResponse& response : responses) {
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    batch.Add(&response);
+  }
+  TF_ASSERT_OK(batch.ParseFrom(&source));
+  // The string tensor is not shared, since it is parsed on the slow path.
+  ASSERT_EQ(2, source.shared().size());
+  EXPECT_EQ(source.shared()[0], responses[0].tensor().tensor_data().data());
+  EXPECT_EQ(source.shared()[1], responses[2].tensor().tensor_data().data());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    EXPECT_EQ(responses[i].tensor().DebugString(), tensors[i].DebugString());
+  }
+}
+
+TEST(TensorResponsesTest, UnavailableEntry) {
+  // The empty entry in the middle stands for an unavailable tensor.
+  RecvTensorsResponse proto;
+  for (int i = 0; i < 3; i++) {
+    RecvTensorResponse* entry = proto.add_response();
+    if (i != 1) {
+      test::AsTensor<int64>({i}, {}).AsProtoTensorContent(
+          entry->mutable_tensor());
+    }
+  }
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  StringSource source(&encoded, 1024);
+  TensorResponse responses[3];
+  TensorResponses batch;
+  for (TensorResponse& response : responses) {
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    batch.Add(&response);
+  }
+  TF_EXPECT_OK(batch.ParseFrom(&source));
+  EXPECT_TRUE(batch.available(0));
+  EXPECT_FALSE(batch.available(1));
+  EXPECT_TRUE(batch.available(2));
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({0}, {}),
+                                 responses[0].tensor());
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({2}, {}),
+                                 responses[2].tensor());
+}
+
+TEST(TensorResponsesTest, WrongNumberOfEntries) {
+  RecvTensorsResponse proto;
+  proto.add_response()->set_is_dead(true);
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  StringSource source(&encoded, 1024);
+  TensorResponse responses[2];
+  TensorResponses batch;
+  for (TensorResponse& response : responses) {
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    batch.Add(&response);
+  }
+  EXPECT_EQ(error::INVALID_ARGUMENT, batch.ParseFrom(&source).code());
+}
+
+TEST(PushedTensorTest, Simple) {
+  Tensor t(DT_FLOAT, TensorShape({100, 30}));
+  test::FillIota<float>(&t, 0.5);
+  PushTensorRequest proto;
+  proto.set_step_id(-7);
+  proto.set_rendezvous_key("key");
+  t.AsProtoTensorContent(proto.mutable_response()->mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  SharingSource source(&encoded);
+  PushedTensor pushed;
+  TF_ASSERT_OK(pushed.ParseFrom(&source));
+  EXPECT_EQ(-7, pushed.step_id());
+  EXPECT_EQ("key", pushed.rendezvous_key());
+  EXPECT_FALSE(pushed.is_dead());
+  // The tensor is decoded into host memory, sharing the received data.
+  ASSERT_EQ(1, source.shared().size());
+  EXPECT_EQ(source.shared()[0], pushed.tensor().tensor_data().data());
+  test::ExpectTensorEqual<float>(t, pushed.tensor());
+}
+
+TEST(PushedTensorTest, DeadTensor) {
+  PushTensorRequest proto;
+  proto.set_rendezvous_key("key");
+  proto.mutable_response()->set_is_dead(true);
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  PushedTensor pushed;
+  TF_ASSERT_OK(pushed.ParseFrom(&source));
+  EXPECT_TRUE(pushed.is_dead());
+}
+
+TEST(PushedTensorTest, MissingTensor) {
+  PushTensorRequest proto;
+  proto.set_rendezvous_key("key");
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  PushedTensor pushed;
+  EXPECT_EQ(error::INVALID_ARGUMENT, pushed.ParseFrom(&source).code());
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
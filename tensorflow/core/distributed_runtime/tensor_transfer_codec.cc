@@ -0,0 +1,194 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
+
+#include <string.h>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool EncodeBFloat16(const Tensor& val, string* encoded) {
+  if (val.dtype() != DT_FLOAT) return false;
+  const int64 n = val.NumElements();
+  encoded->resize(n * sizeof(bfloat16));
+  FloatToBFloat16(val.flat<float>().data(),
+                  reinterpret_cast<bfloat16*>(&(*encoded)[0]), n);
+  return true;
+}
+
+bool IsZero(const char* element, size_t element_size) {
+  for (size_t i = 0; i < element_size; ++i) {
+    if (element[i] != 0) return false;
+  }
+  return true;
+}
+
+// The sparse encoding is a sequence of runs, each of which is
+//
+//   <varint64 number of zero elements Z>
+//   <varint64 number of other elements N>
+//   <the N other elements, as in the tensor data>
+//
+// that together cover all elements of the tensor.
+bool EncodeSparse(StringPiece data, size_t element_size, string* encoded) {
+  const size_t n = data.size() / element_size;
+  const char* base = data.data();
+  size_t i = 0;
+  while (i < n) {
+    const size_t zeros_begin = i;
+    while (i < n && IsZero(base + i * element_size, element_size)) ++i;
+    const size_t values_begin = i;
+    while (i < n && !IsZero(base + i * element_size, element_size)) ++i;
+    core::PutVarint64(encoded, values_begin - zeros_begin);
+    core::PutVarint64(encoded, i - values_begin);
+    encoded->append(base + values_begin * element_size,
+                    (i - values_begin) * element_size);
+    // Give up as soon as the encoding is no smaller than the data.
+    if (encoded->size() >= data.size()) return false;
+  }
+  return true;
+}
+
+Status DecodeSparse(StringPiece encoded, size_t element_size, char* data,
+                    size_t data_size) {
+  const size_t n = data_size / element_size;
+  size_t i = 0;
+  while (i < n) {
+    uint64 zeros;
+    uint64 values;
+    if (!core::GetVarint64(&encoded, &zeros) ||
+        !core::GetVarint64(&encoded, &values) || zeros > n - i ||
+        values > n - i - zeros ||
+        encoded.size() < values * element_size) {
+      return errors::InvalidArgument("Corrupt sparse tensor data");
+    }
+    memset(data + i * element_size, 0, zeros * element_size);
+    i += zeros;
+    memcpy(data + i * element_size, encoded.data(), values * element_size);
+    encoded.remove_prefix(values * element_size);
+    i += values;
+  }
+  if (!encoded.empty()) {
+    return errors::InvalidArgument("Corrupt sparse tensor data");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool TensorTransferOptionsApplyToEdge(const TensorTransferOptions& options,
+                                      StringPiece edge_name) {
+  if (options.policy_size() == 0) return false;
+  if (options.src_node_prefix_size() == 0) return true;
+  // Edges between graph partitions are named "edge_<id>_<source node>"
+  // (see graph_partition.cc).
+  StringPiece src_node = edge_name;
+  uint64 edge_id;
+  if (!str_util::ConsumePrefix(&src_node, "edge_") ||
+      !str_util::ConsumeLeadingDigits(&src_node, &edge_id) ||
+      !str_util::ConsumePrefix(&src_node, "_")) {
+    src_node = edge_name;
+  }
+  for (const string& prefix : options.src_node_prefix()) {
+    if (src_node.starts_with(prefix)) return true;
+  }
+  return false;
+}
+
+TensorTransferOptions::Codec EncodeTensorData(
+    const TensorTransferOptions& options, const Tensor& val, string* encoded) {
+  encoded->clear();
+  if (!DataTypeCanUseMemcpy(val.dtype())) return TensorTransferOptions::NONE;
+  const StringPiece data = val.tensor_data();
+  for (const TensorTransferOptions::Policy& policy : options.policy()) {
+    if (policy.dtype() != val.dtype()) continue;
+    if (data.empty() ||
+        data.size() < static_cast<uint64>(policy.min_bytes())) {
+      break;
+    }
+    bool ok = false;
+    switch (policy.codec()) {
+      case TensorTransferOptions::BFLOAT16:
+        ok = EncodeBFloat16(val, encoded);
+        break;
+      case TensorTransferOptions::SNAPPY:
+        ok = port::Snappy_Compress(data.data(), data.size(), encoded);
+        break;
+      case TensorTransferOptions::SPARSE:
+        ok = EncodeSparse(data, DataTypeSize(val.dtype()), encoded);
+        break;
+      default:
+        break;
+    }
+    if (ok && encoded->size() < data.size()) return policy.codec();
+    break;
+  }
+  encoded->clear();
+  return TensorTransferOptions::NONE;
+}
+
+Status DecodeTensorData(TensorTransferOptions::Codec codec,
+                        StringPiece encoded, Tensor* val) {
+  if (!DataTypeCanUseMemcpy(val->dtype())) {
+    return errors::InvalidArgument("Cannot decode tensor data of type ",
+                                   DataTypeString(val->dtype()));
+  }
+  const StringPiece buf = val->tensor_data();
+  char* data = const_cast<char*>(buf.data());
+  switch (codec) {
+    case TensorTransferOptions::NONE:
+      if (encoded.size() != buf.size()) {
+        return errors::InvalidArgument("Expected ", buf.size(),
+                                       " bytes of tensor data, got ",
+                                       encoded.size());
+      }
+      memcpy(data, encoded.data(), encoded.size());
+      return Status::OK();
+    case TensorTransferOptions::BFLOAT16:
+      if (val->dtype() != DT_FLOAT ||
+          encoded.size() != val->NumElements() * sizeof(bfloat16)) {
+        return errors::InvalidArgument("Corrupt bfloat16 tensor data");
+      }
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(encoded.data()),
+                      val->flat<float>().data(), val->NumElements());
+      return Status::OK();
+    case TensorTransferOptions::SNAPPY: {
+      size_t size;
+      if (!port::Snappy_GetUncompressedLength(encoded.data(), encoded.size(),
+                                              &size) ||
+          size != buf.size() ||
+          !port::Snappy_Uncompress(encoded.data(), encoded.size(), data)) {
+        return errors::InvalidArgument("Corrupt snappy tensor data");
+      }
+      return Status::OK();
+    }
+    case TensorTransferOptions::SPARSE:
+      return DecodeSparse(encoded, DataTypeSize(val->dtype()), data,
+                          buf.size());
+    default:
+      return errors::Unimplemented("Unknown tensor transfer codec ", codec);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,49 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSFER_CODEC_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSFER_CODEC_H_
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+// Returns true if "options" asks for the data of the tensor sent along
+// the edge named "edge_name" (as in Rendezvous::ParsedKey) to be
+// encoded.
+bool TensorTransferOptionsApplyToEdge(const TensorTransferOptions& options,
+                                      StringPiece edge_name);
+
+// Encodes the data of "val" into "*encoded" with the codec that
+// "options" chooses for it, and returns that codec.
+//
+// Returns TensorTransferOptions::NONE, and leaves "*encoded" empty, if
+// the data of "val" should be sent as is instead.
+TensorTransferOptions::Codec EncodeTensorData(
+    const TensorTransferOptions& options, const Tensor& val, string* encoded);
+
+// Decodes "encoded", the data of a tensor encoded with "codec", into the
+// backing store of "*val", which must already have the dtype and shape
+// of the encoded tensor.
+Status DecodeTensorData(TensorTransferOptions::Codec codec,
+                        StringPiece encoded, Tensor* val);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_TRANSFER_CODEC_H_
@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_transfer_codec.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TensorTransferOptions Options(DataType dtype,
+                              TensorTransferOptions::Codec codec,
+                              int64 min_bytes = 0) {
+  TensorTransferOptions options;
+  TensorTransferOptions::Policy* policy = options.add_policy();
+  policy->set_dtype(dtype);
+  policy->set_codec(codec);
+  policy->set_min_bytes(min_bytes);
+  return options;
+}
+
+// Encodes "val" with "options" and returns the decoded tensor.
+Tensor RoundTrip(const TensorTransferOptions& options, const Tensor& val,
+                 TensorTransferOptions::Codec* codec) {
+  string encoded;
+  *codec = EncodeTensorData(options, val, &encoded);
+  Tensor decoded(val.dtype(), val.shape());
+  if (*codec == TensorTransferOptions::NONE) {
+    EXPECT_TRUE(encoded.empty());
+    TF_EXPECT_OK(DecodeTensorData(*codec, val.tensor_data(), &decoded));
+  } else {
+    EXPECT_LT(encoded.size(), val.tensor_data().size());
+    TF_EXPECT_OK(DecodeTensorData(*codec, encoded, &decoded));
+  }
+  return decoded;
+}
+
+TEST(TensorTransferCodecTest, BFloat16) {
+  Tensor val = test::AsTensor<float>({1.0f, -2.5f, 0.0f, 1.0f + 1.0f / 1024});
+  TensorTransferOptions::Codec codec;
+  Tensor decoded =
+      RoundTrip(Options(DT_FLOAT, TensorTransferOptions::BFLOAT16), val,
+                &codec);
+  EXPECT_EQ(TensorTransferOptions::BFLOAT16, codec);
+  // The last value is rounded to 8 significant bits.
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.0f, -2.5f, 0.0f, 1.0f}), decoded);
+}
+
+TEST(TensorTransferCodecTest, Snappy) {
+  Tensor val(DT_INT32, TensorShape({100, 30}));
+  val.flat<int32>().setConstant(7);
+  TensorTransferOptions::Codec codec;
+  Tensor decoded = RoundTrip(
+      Options(DT_INT32, TensorTransferOptions::SNAPPY), val, &codec);
+  if (codec != TensorTransferOptions::NONE) {
+    // Only if TensorFlow was built with snappy support.
+    EXPECT_EQ(TensorTransferOptions::SNAPPY, codec);
+  }
+  test::ExpectTensorEqual<int32>(val, decoded);
+}
+
+TEST(TensorTransferCodecTest, Sparse) {
+  Tensor val(DT_DOUBLE, TensorShape({1000}));
+  val.flat<double>().setZero();
+  val.flat<double>()(0) = -1.0;
+  val.flat<double>()(17) = 2.0;
+  val.flat<double>()(18) = 3.0;
+  val.flat<double>()(999) = 4.0;
+  TensorTransferOptions::Codec codec;
+  Tensor decoded = RoundTrip(
+      Options(DT_DOUBLE, TensorTransferOptions::SPARSE), val, &codec);
+  EXPECT_EQ(TensorTransferOptions::SPARSE, codec);
+  test::ExpectTensorEqual<double>(val, decoded);
+}
+
+TEST(TensorTransferCodecTest, SentAsIs) {
+  Tensor val = test::AsTensor<int64>({1, 2, 3, 4, 5, 6, 7, 8});
+  TensorTransferOptions::Codec codec;
+  // Sparse encoding does not make dense data smaller.
+  Tensor decoded = RoundTrip(
+      Options(DT_INT64, TensorTransferOptions::SPARSE), val, &codec);
+  EXPECT_EQ(TensorTransferOptions::NONE, codec);
+  test::ExpectTensorEqual<int64>(val, decoded);
+
+  // The tensor is too small.
+  val.flat<int64>().setZero();
+  RoundTrip(Options(DT_INT64, TensorTransferOptions::SPARSE, 1024), val,
+            &codec);
+  EXPECT_EQ(TensorTransferOptions::NONE, codec);
+
+  // No policy applies to the dtype.
+  RoundTrip(Options(DT_INT32, TensorTransferOptions::SPARSE), val, &codec);
+  EXPECT_EQ(TensorTransferOptions::NONE, codec);
+
+  // Strings are always sent as is.
+  Tensor str = test::AsTensor<string>({"", "", ""});
+  string encoded;
+  EXPECT_EQ(TensorTransferOptions::NONE,
+            EncodeTensorData(
+                Options(DT_STRING, TensorTransferOptions::SPARSE), str,
+                &encoded));
+}
+
+TEST(TensorTransferCodecTest, CorruptData) {
+  Tensor val(DT_FLOAT, TensorShape({4}));
+  EXPECT_FALSE(
+      DecodeTensorData(TensorTransferOptions::NONE, "abc", &val).ok());
+  EXPECT_FALSE(
+      DecodeTensorData(TensorTransferOptions::BFLOAT16, "abc", &val).ok());
+  EXPECT_FALSE(
+      DecodeTensorData(TensorTransferOptions::SNAPPY, "abc", &val).ok());
+  // 5 zeros do not fit.
+  EXPECT_FALSE(DecodeTensorData(TensorTransferOptions::SPARSE,
+                                StringPiece("\x05\x00", 2), &val)
+                   .ok());
+  // Too few values.
+  EXPECT_FALSE(DecodeTensorData(TensorTransferOptions::SPARSE,
+                                StringPiece("\x03\x01", 2), &val)
+                   .ok());
+  // Too few elements.
+  EXPECT_FALSE(DecodeTensorData(TensorTransferOptions::SPARSE,
+                                StringPiece("\x03\x00", 2), &val)
+                   .ok());
+  TF_EXPECT_OK(DecodeTensorData(TensorTransferOptions::SPARSE,
+                                StringPiece("\x04\x00", 2), &val));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({0, 0, 0, 0}), val);
+}
+
+TEST(TensorTransferCodecTest, ApplyToEdge) {
+  TensorTransferOptions options;
+  EXPECT_FALSE(TensorTransferOptionsApplyToEdge(options, "edge_1_foo"));
+  options = Options(DT_FLOAT, TensorTransferOptions::BFLOAT16);
+  EXPECT_TRUE(TensorTransferOptionsApplyToEdge(options, "edge_1_foo"));
+  options.add_src_node_prefix("gradients/");
+  EXPECT_FALSE(TensorTransferOptionsApplyToEdge(options, "edge_1_foo"));
+  EXPECT_TRUE(TensorTransferOptionsApplyToEdge(
+      options, "edge_12_gradients/MatMul_grad/MatMul"));
+  EXPECT_TRUE(TensorTransferOptionsApplyToEdge(options, "gradients/x"));
+  EXPECT_FALSE(TensorTransferOptionsApplyToEdge(options, "edge_gradients/x"));
+}
+
+}  // namespace
+}  // namespace tensorflow
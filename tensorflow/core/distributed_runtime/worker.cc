@@ -322,4 +322,35 @@ void Worker::RecvTensorAsync(CallOptions* opts,
   done(errors::Unimplemented("Worker::RecvTensorAsync()"));
 }
 
+void Worker::RecvTensorsAsync(CallOptions* opts,
+                              const RecvTensorsRequest* request,
+                              TensorResponses* response, StatusCallback done) {
+  // As with RecvTensorAsync, use a transport-specific implementation
+  // (such as `GrpcWorker::RecvTensorsAsync()`) instead.
+  done(errors::Unimplemented("Worker::RecvTensorsAsync()"));
+}
+
+void Worker::PushTensorAsync(CallOptions* opts, const PushedTensor* request,
+                             PushTensorResponse* response,
+                             StatusCallback done) {
+  const int64 step_id = request->step_id();
+  const string& key = request->rendezvous_key();
+  TRACEPRINTF("PushTensor: %lld %s", step_id, key.c_str());
+  Rendezvous::ParsedKey parsed;
+  Status s = Rendezvous::ParseKey(key, &parsed);
+  Device* dst_dev = nullptr;
+  if (s.ok()) {
+    s = env_->device_mgr->LookupDevice(
+        DeviceNameUtils::LocalName(parsed.dst_device), &dst_dev);
+  }
+  if (s.ok()) {
+    // The tensor was decoded into host memory, where it is buffered until
+    // its consumer runs, and then copied to the consumer's device if
+    // necessary.
+    s = env_->rendezvous_mgr->AcceptPushedTensor(
+        step_id, parsed, request->tensor(), request->is_dead());
+  }
+  done(s);
+}
+
 }  // namespace tensorflow
@@ -79,6 +79,14 @@ class Worker : public WorkerInterface {
   void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
                        TensorResponse* response, StatusCallback done) override;
 
+  void RecvTensorsAsync(CallOptions* opts, const RecvTensorsRequest* request,
+                        TensorResponses* response,
+                        StatusCallback done) override;
+
+  void PushTensorAsync(CallOptions* opts, const PushedTensor* request,
+                       PushTensorResponse* response,
+                       StatusCallback done) override;
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
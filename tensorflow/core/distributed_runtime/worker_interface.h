@@ -33,6 +33,12 @@ typedef std::function<void(const Status&)> StatusCallback;
 // Custom decoder for a response to RecvTensorAsync.
 class TensorResponse;
 
+// Custom decoder for a response to RecvTensorsAsync.
+class TensorResponses;
+
+// Custom encoder and decoder for a request to PushTensorAsync.
+class PushedTensor;
+
 // Interface for talking with the TensorFlow Worker service.
 class WorkerInterface {
  public:
@@ -102,6 +108,15 @@ class WorkerInterface {
                                TensorResponse* response,
                                StatusCallback done) = 0;
 
+  virtual void RecvTensorsAsync(CallOptions* opts,
+                                const RecvTensorsRequest* request,
+                                TensorResponses* response,
+                                StatusCallback done) = 0;
+
+  virtual void PushTensorAsync(CallOptions* opts, const PushedTensor* request,
+                               PushTensorResponse* response,
+                               StatusCallback done) = 0;
+
   virtual void LoggingAsync(const LoggingRequest* request,
                             LoggingResponse* response, StatusCallback done) = 0;
 
@@ -244,9 +244,18 @@ OpKernelContext::~OpKernelContext() {
   if (params_->record_tensor_accesses) referenced_tensors_.Destroy();
 }
 
-Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
-  Allocator* allocator =
-      params_->device->GetStepAllocator(attr, resource_manager());
+Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr,
+                                          bool persistent, int output_index) {
+  Allocator* allocator = nullptr;
+  if (!persistent && !attr.gpu_compatible() && !attr.nic_compatible()) {
+    if (output_index >= 0 && params_->output_allocators != nullptr) {
+      allocator = params_->output_allocators[output_index];
+    }
+    if (allocator == nullptr) allocator = params_->step_allocator;
+  }
+  if (allocator == nullptr) {
+    allocator = params_->device->GetStepAllocator(attr, resource_manager());
+  }
   if (track_allocations()) {
     mutex_lock lock(mu_);
     for (const auto& wrapped : wrapped_allocators_) {
@@ -588,8 +597,9 @@ Status OpKernelContext::allocate_output(StringPiece name,
 
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    AllocatorAttributes attr, const AllocationAttributes& allocation_attr,
+    bool persistent, int output_index) {
+  Allocator* a = get_allocator(attr, persistent, output_index);
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
   Tensor new_tensor(a, type, shape, logged_attr);
@@ -616,7 +626,8 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Status s = allocate_tensor(type, shape, output_tensor, attr,
+                             AllocationAttributes(), false, index);
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -651,7 +662,8 @@ Status OpKernelContext::allocate_persistent(DataType type,
                                             Tensor** out_tensor,
                                             AllocatorAttributes attr) {
   Tensor persistent;
-  Status s = allocate_tensor(type, shape, &persistent, attr);
+  Status s = allocate_tensor(type, shape, &persistent, attr,
+                             AllocationAttributes(), true /* persistent */);
   if (s.ok()) {
     *out_persistent = PersistentTensor(persistent);
     if (out_tensor) {
@@ -560,6 +560,17 @@ class OpKernelContext {
 
     // TensorSliceReaderCache support.
     checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache = nullptr;
+
+    // If not nullptr, the allocator used instead of the device's for the
+    // tensors of this step that need neither GPU- nor NIC-compatible
+    // memory. Persistent tensors always use the device's allocator.
+    Allocator* step_allocator = nullptr;
+
+    // If not nullptr, output_allocators[i] is the allocator used instead of
+    // the step allocator for output i of the kernel when it needs neither
+    // GPU- nor NIC-compatible memory, unless it is nullptr. See
+    // common_runtime/memory_planner.h.
+    Allocator* const* output_allocators = nullptr;
   };
 
   // params must outlive the OpKernelContext.
@@ -1066,7 +1077,11 @@ class OpKernelContext {
   bool input_is_ref(int index) const;
 
  private:
-  Allocator* get_allocator(AllocatorAttributes attr);
+  // Returns the allocator for a tensor with attributes "attr". Tensors that
+  // are "persistent" outlive the step, so they never use the step allocator.
+  // If "output_index" is not -1, the tensor is that output of the kernel.
+  Allocator* get_allocator(AllocatorAttributes attr, bool persistent = false,
+                           int output_index = -1);
 
   // Internal method to add a tensor's buffer to the list of buffers
   // referenced during the execution of the Op, so that GPUs may
@@ -1085,7 +1100,8 @@ class OpKernelContext {
 
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
-                         const AllocationAttributes& allocation_attr);
+                         const AllocationAttributes& allocation_attr,
+                         bool persistent = false, int output_index = -1);
 
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
@@ -113,6 +113,11 @@ Status Rendezvous::ParseKey(StringPiece key, ParsedKey* out) {
 
 Rendezvous::~Rendezvous() {}
 
+bool Rendezvous::RecvIfReadyAsync(const ParsedKey& key, const Args& args,
+                                  DoneCallback done) {
+  return false;
+}
+
 Status Rendezvous::Recv(const ParsedKey& key, const Args& recv_args,
                         Tensor* val, bool* is_dead, int64 timeout_ms) {
   Status ret;
@@ -286,6 +291,20 @@ class LocalRendezvousImpl : public Rendezvous {
     return;
   }
 
+  bool RecvIfReadyAsync(const ParsedKey& key, const Args& recv_args,
+                        DoneCallback done) override {
+    {
+      mutex_lock l(mu_);
+      // Items are only removed from the table when the rendezvous is
+      // aborted, so RecvAsync() below does not wait either.
+      if (status_.ok() && table_.find(KeyHash(key.FullKey())) == table_.end()) {
+        return false;
+      }
+    }
+    RecvAsync(key, recv_args, std::move(done));
+    return true;
+  }
+
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
     std::vector<Item*> items;
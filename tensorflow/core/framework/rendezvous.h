@@ -102,6 +102,15 @@ class Rendezvous : public core::RefCounted {
   virtual void RecvAsync(const ParsedKey& key, const Args& args,
                          DoneCallback done) = 0;
 
+  // Like RecvAsync, but does not wait for the message. If none has been
+  // sent under "key" yet, returns false without calling "done", and leaves
+  // a message sent later to another Recv*() call. Otherwise calls "done" as
+  // RecvAsync does, and returns true.
+  //
+  // The default implementation always returns false.
+  virtual bool RecvIfReadyAsync(const ParsedKey& key, const Args& args,
+                                DoneCallback done);
+
   // Synchronous wrapper for RecvAsync.
   Status Recv(const ParsedKey& key, const Args& args, Tensor* val,
               bool* is_dead, int64 timeout_ms);
@@ -135,6 +135,22 @@ TEST_F(LocalRendezvousTest, RecvSend) {
   EXPECT_EQ("hello", V(val));
 }
 
+TEST_F(LocalRendezvousTest, RecvIfReady) {
+  Rendezvous::Args args;
+  string val;
+  auto recv_done = [&val](const Status& s, const Rendezvous::Args& send_args,
+                          const Rendezvous::Args& recv_args, const Tensor& v,
+                          const bool dead) {
+    TF_EXPECT_OK(s);
+    val = V(v);
+  };
+  // Nothing has been sent yet, and no waiter is left behind.
+  EXPECT_FALSE(rendez_->RecvIfReadyAsync(KeyFoo(), args, recv_done));
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("hello"), false));
+  EXPECT_TRUE(rendez_->RecvIfReadyAsync(KeyFoo(), args, recv_done));
+  EXPECT_EQ("hello", val);
+}
+
 TEST_F(LocalRendezvousTest, DuplicateWaiterRecv) {
   SchedClosure([this]() {
     Tensor t(DT_STRING);
@@ -0,0 +1,615 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+// The key of component `component` of element `index` in a cache file.
+string ElementKey(int64 index, int component) {
+  return strings::Printf("%020lld_%05d", static_cast<long long>(index),
+                         component);
+}
+
+// The writer of a cache file refreshes its lockfile at this interval, and
+// a lockfile that has not been refreshed for kLockfileExpiryMicros is
+// assumed to belong to a writer that died.
+const int64 kLockfileRefreshMicros = 60 * 1000 * 1000;
+const int64 kLockfileExpiryMicros = 10 * kLockfileRefreshMicros;
+
+class CacheDatasetOp : public OpKernel {
+ public:
+  explicit CacheDatasetOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    DatasetBase* input;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &input));
+    core::ScopedUnref unref_input(input);
+
+    const Tensor* filename_t;
+    OP_REQUIRES_OK(ctx, ctx->input("filename", &filename_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(filename_t->shape()),
+                errors::InvalidArgument("filename must be a scalar"));
+    const string& filename = filename_t->scalar<string>()();
+
+    DatasetBase* dataset = new Dataset(input, filename, ctx->env());
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->flat<ResourceHandle>()(0) = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, const string& filename, Env* env)
+        : input_(input), filename_(filename), env_(env) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    // Iterators replay the cache once an iterator has seen the whole input.
+    // Until then, the first iterator records the elements that it returns,
+    // and the iterators created meanwhile pass the input through.
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      if (filename_.empty()) {
+        mutex_lock l(mu_);
+        if (memory_cache_) {
+          return std::unique_ptr<IteratorBase>(
+              new MemoryReaderIterator(this, memory_cache_));
+        }
+        if (!memory_writer_active_) {
+          memory_writer_active_ = true;
+          return std::unique_ptr<IteratorBase>(new MemoryWriterIterator(this));
+        }
+      } else {
+        if (env_->FileExists(filename_).ok()) {
+          return std::unique_ptr<IteratorBase>(new FileReaderIterator(this));
+        }
+        if (AcquireLockfile()) {
+          return std::unique_ptr<IteratorBase>(new FileWriterIterator(this));
+        }
+      }
+      return std::unique_ptr<IteratorBase>(new PassThroughIterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "CacheDatasetOp::Dataset"; }
+
+   private:
+    typedef std::vector<std::vector<Tensor>> Elements;
+
+    // The cache file holds the name of the tensor bundle, next to it, that
+    // holds the elements. Each writer writes a bundle of its own, and then
+    // replaces the cache file, so that readers see either no cache or a
+    // complete one.
+    Status BundlePrefix(string* prefix) const {
+      string bundle;
+      TF_RETURN_IF_ERROR(ReadFileToString(env_, filename_, &bundle));
+      *prefix = io::JoinPath(io::Dirname(filename_), bundle);
+      return Status::OK();
+    }
+
+    // The lockfile is a directory, since creating a directory fails if it
+    // exists, even if another process created it. Its holder writes the time
+    // to an owner file in it, and refreshes it while writing the cache.
+    string LockfileName() const {
+      return strings::StrCat(filename_, ".lockfile");
+    }
+
+    string LockfileOwnerName() const {
+      return io::JoinPath(LockfileName(), "owner");
+    }
+
+    // Returns true if this iterator now holds the lockfile of the cache file,
+    // which makes it the only writer of the cache file. An expired lockfile
+    // is broken, so that a writer that died does not disable the cache.
+    bool AcquireLockfile() const {
+      const string lockfile = LockfileName();
+      Status s = env_->CreateDir(lockfile);
+      if (errors::IsAlreadyExists(s) && LockfileExpired()) {
+        LOG(WARNING) << "The lockfile " << lockfile << " has not been "
+                     << "refreshed for " << kLockfileExpiryMicros / 1000000
+                     << " seconds, so its writer is assumed to have died.";
+        // Only one process can move the lockfile away. If a writer was
+        // merely slow, both writers commit complete caches, and the last
+        // one is read.
+        const string expired =
+            strings::StrCat(lockfile, ".expired", random::New64());
+        if (env_->RenameFile(lockfile, expired).ok()) {
+          DeleteLockfile(expired);
+        }
+        s = env_->CreateDir(lockfile);
+      }
+      if (errors::IsAlreadyExists(s)) {
+        LOG(WARNING) << "The cache file " << filename_
+                     << " is being written by another iterator, so this "
+                        "iterator reads its input instead.";
+        return false;
+      }
+      if (s.ok()) {
+        s = RefreshLockfile();
+        if (!s.ok()) {
+          DeleteLockfile(lockfile);
+        }
+      }
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to create " << lockfile
+                     << ", so the cache file " << filename_
+                     << " will not be written: " << s;
+        return false;
+      }
+      return true;
+    }
+
+    // Writes the current time to the owner file of the lockfile, which
+    // is replaced at once so that it is never read partially written.
+    Status RefreshLockfile() const {
+      const string owner = LockfileOwnerName();
+      const string tmp = strings::StrCat(owner, ".tempstate", random::New64());
+      Status s = WriteStringToFile(env_, tmp,
+                                   strings::StrCat(env_->NowMicros()));
+      if (s.ok()) {
+        s = env_->RenameFile(tmp, owner);
+      }
+      if (!s.ok()) {
+        env_->DeleteFile(tmp).IgnoreError();
+      }
+      return s;
+    }
+
+    bool LockfileExpired() const {
+      string contents;
+      int64 micros;
+      if (!ReadFileToString(env_, LockfileOwnerName(), &contents).ok() ||
+          !strings::safe_strto64(contents, &micros)) {
+        // The holder may not have written the owner file yet.
+        FileStatistics stat;
+        if (!env_->Stat(LockfileName(), &stat).ok()) {
+          return false;
+        }
+        micros = stat.mtime_nsec / 1000;
+      }
+      return static_cast<int64>(env_->NowMicros()) - micros >
+             kLockfileExpiryMicros;
+    }
+
+    void DeleteLockfile(const string& lockfile) const {
+      int64 undeleted_files, undeleted_dirs;
+      env_->DeleteRecursively(lockfile, &undeleted_files, &undeleted_dirs)
+          .IgnoreError();
+    }
+
+    // Every cache iterator saves the number of elements that it has
+    // returned, and the iterators that read the input also save its state.
+    // The state can then be restored to an iterator of any kind, since the
+    // cache may have been completed or abandoned in the meantime: a reader
+    // seeks to the saved index, and an iterator that reads the input
+    // restores it, or skips the elements before the saved index if it was
+    // saved by a reader.
+    static Status SaveCacheIterator(const string& prefix, int64 index,
+                                    IteratorBase* input,
+                                    IteratorStateWriter* writer) {
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(strings::StrCat(prefix, "/index"), index));
+      if (input == nullptr) {
+        return Status::OK();
+      }
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(strings::StrCat(prefix, "/has_input"), 1));
+      return input->Save(strings::StrCat(prefix, "/input"), writer);
+    }
+
+    static Status RestoreCacheIterator(IteratorContext* ctx,
+                                       const string& prefix,
+                                       IteratorBase* input,
+                                       IteratorStateReader* reader,
+                                       int64* index) {
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(strings::StrCat(prefix, "/index"), index));
+      if (*index < 0) {
+        return errors::DataLoss("Invalid iterator state: ", *index,
+                                " is not a valid cache index.");
+      }
+      if (input == nullptr) {
+        return Status::OK();
+      }
+      if (reader->Contains(strings::StrCat(prefix, "/has_input"))) {
+        return input->Restore(ctx, strings::StrCat(prefix, "/input"), reader);
+      }
+      for (int64 i = 0; i < *index; ++i) {
+        std::vector<Tensor> unused;
+        bool end_of_sequence;
+        TF_RETURN_IF_ERROR(input->GetNext(ctx, &unused, &end_of_sequence));
+        if (end_of_sequence) {
+          break;
+        }
+      }
+      return Status::OK();
+    }
+
+    // Returns the elements of the input, without caching them.
+    class PassThroughIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit PassThroughIterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (!*end_of_sequence) {
+          ++index_;
+        }
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveCacheIterator(prefix, index_, input_impl_.get(), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return RestoreCacheIterator(ctx, prefix, input_impl_.get(), reader,
+                                    &index_);
+      }
+
+     private:
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      int64 index_ GUARDED_BY(mu_) = 0;
+    };
+
+    // Returns the elements of the input, and stores them in the memory cache
+    // once the input is exhausted. An error from the input is returned, but
+    // then nothing is cached, so that the replayed elements always match the
+    // input.
+    class MemoryWriterIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit MemoryWriterIterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~MemoryWriterIterator() override {
+        mutex_lock l(mu_);
+        if (!committed_) {
+          mutex_lock dataset_lock(dataset()->mu_);
+          dataset()->memory_writer_active_ = false;
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        Status s = input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
+        if (!s.ok()) {
+          failed_ = true;
+          return s;
+        }
+        if (*end_of_sequence) {
+          if (!failed_ && !committed_) {
+            mutex_lock dataset_lock(dataset()->mu_);
+            dataset()->memory_cache_ =
+                std::make_shared<const Elements>(std::move(elements_));
+            dataset()->memory_writer_active_ = false;
+            committed_ = true;
+          }
+          return Status::OK();
+        }
+        ++index_;
+        if (!failed_) {
+          elements_.push_back(*out_tensors);
+        }
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveCacheIterator(prefix, index_, input_impl_.get(), writer);
+      }
+
+      // The elements before the restored position are not available, so
+      // this iterator passes the rest of the input through, and a later
+      // iterator fills the cache.
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        failed_ = true;
+        elements_.clear();
+        return RestoreCacheIterator(ctx, prefix, input_impl_.get(), reader,
+                                    &index_);
+      }
+
+     private:
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      int64 index_ GUARDED_BY(mu_) = 0;
+      Elements elements_ GUARDED_BY(mu_);
+      bool failed_ GUARDED_BY(mu_) = false;
+      bool committed_ GUARDED_BY(mu_) = false;
+    };
+
+    // Replays the memory cache. The tensors share their buffers with the
+    // cache.
+    class MemoryReaderIterator : public DatasetIterator<Dataset> {
+     public:
+      MemoryReaderIterator(const Dataset* dataset,
+                           std::shared_ptr<const Elements> elements)
+          : DatasetIterator<Dataset>(dataset), elements_(std::move(elements)) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (index_ == elements_->size()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        *out_tensors = (*elements_)[index_++];
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveCacheIterator(prefix, index_, nullptr, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 index;
+        TF_RETURN_IF_ERROR(
+            RestoreCacheIterator(ctx, prefix, nullptr, reader, &index));
+        index_ = std::min<size_t>(index, elements_->size());
+        return Status::OK();
+      }
+
+     private:
+      const std::shared_ptr<const Elements> elements_;
+      mutex mu_;
+      size_t index_ GUARDED_BY(mu_) = 0;
+    };
+
+    // Returns the elements of the input, and writes them to a tensor bundle
+    // with a prefix of its own. Once the input is exhausted, the cache file is
+    // replaced with one that names the bundle. As with the memory cache, an
+    // error from the input abandons the bundle, and so does destroying the
+    // iterator early.
+    class FileWriterIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit FileWriterIterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()),
+            bundle_prefix_(strings::StrCat(dataset->filename_, ".bundle",
+                                           random::New64())),
+            writer_(new BundleWriter(dataset->env_, bundle_prefix_)),
+            last_refresh_micros_(dataset->env_->NowMicros()) {}
+
+      ~FileWriterIterator() override {
+        mutex_lock l(mu_);
+        if (writer_) {
+          Abandon();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        Status s = input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
+        if (s.ok() && !*end_of_sequence) {
+          ++index_;
+        }
+        if (!writer_) {
+          return s;
+        }
+        if (!s.ok()) {
+          Abandon();
+          return s;
+        }
+        if (*end_of_sequence) {
+          Commit();
+          return Status::OK();
+        }
+        for (int i = 0; i < out_tensors->size(); ++i) {
+          s.Update(
+              writer_->Add(ElementKey(num_elements_, i), (*out_tensors)[i]));
+        }
+        ++num_elements_;
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to write to the cache file "
+                       << dataset()->filename_ << ": " << s;
+          Abandon();
+          return Status::OK();
+        }
+        const int64 now_micros = dataset()->env_->NowMicros();
+        if (now_micros - last_refresh_micros_ > kLockfileRefreshMicros) {
+          // At worst, a failed refresh lets another writer break the
+          // lockfile.
+          dataset()->RefreshLockfile().IgnoreError();
+          last_refresh_micros_ = now_micros;
+        }
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveCacheIterator(prefix, index_, input_impl_.get(), writer);
+      }
+
+      // The elements before the restored position are not available, so
+      // this iterator abandons the cache file and passes the rest of the
+      // input through, and a later iterator writes the cache file.
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (writer_) {
+          Abandon();
+        }
+        return RestoreCacheIterator(ctx, prefix, input_impl_.get(), reader,
+                                    &index_);
+      }
+
+     private:
+      // Finishes the bundle, replaces the cache file with one that names it,
+      // and releases the lockfile.
+      void Commit() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = dataset()->env_;
+        const string& filename = dataset()->filename_;
+        const string tmp =
+            strings::StrCat(filename, ".tempstate", random::New64());
+        Status s = writer_->Finish();
+        writer_.reset();
+        if (s.ok()) {
+          s = WriteStringToFile(env, tmp, io::Basename(bundle_prefix_));
+        }
+        if (s.ok()) {
+          s = env->RenameFile(tmp, filename);
+        }
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to write the cache file " << filename << ": "
+                       << s;
+          env->DeleteFile(tmp).IgnoreError();
+          DeleteBundle();
+        }
+        dataset()->DeleteLockfile(dataset()->LockfileName());
+      }
+
+      // Deletes the bundle, and releases the lockfile.
+      void Abandon() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        // Finishing the writer closes its files, which may then be deleted.
+        writer_->Finish().IgnoreError();
+        writer_.reset();
+        DeleteBundle();
+        dataset()->DeleteLockfile(dataset()->LockfileName());
+      }
+
+      void DeleteBundle() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Env* env = dataset()->env_;
+        env->DeleteFile(DataFilename(bundle_prefix_, 0, 1)).IgnoreError();
+        env->DeleteFile(MetaFilename(bundle_prefix_)).IgnoreError();
+      }
+
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      const string bundle_prefix_;
+      // Null once the bundle is committed or abandoned.
+      std::unique_ptr<BundleWriter> writer_ GUARDED_BY(mu_);
+      int64 last_refresh_micros_ GUARDED_BY(mu_);
+      int64 num_elements_ GUARDED_BY(mu_) = 0;
+      // The number of elements returned, including those returned after
+      // the bundle was abandoned.
+      int64 index_ GUARDED_BY(mu_) = 0;
+    };
+
+    // Replays the cache file. Any number of readers may read the same cache
+    // file concurrently.
+    class FileReaderIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit FileReaderIterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset) {
+        string prefix;
+        status_ = dataset->BundlePrefix(&prefix);
+        if (status_.ok()) {
+          reader_.reset(new BundleReader(dataset->env_, prefix));
+          status_ = reader_->status();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(status_);
+        if (!reader_->Contains(ElementKey(index_, 0))) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        const int num_components = dataset()->output_dtypes().size();
+        out_tensors->clear();
+        out_tensors->reserve(num_components);
+        for (int i = 0; i < num_components; ++i) {
+          const string key = ElementKey(index_, i);
+          DataType dtype;
+          TensorShape shape;
+          TF_RETURN_IF_ERROR(
+              reader_->LookupDtypeAndShape(key, &dtype, &shape));
+          out_tensors->emplace_back(dtype, shape);
+          TF_RETURN_IF_ERROR(reader_->Lookup(key, &out_tensors->back()));
+        }
+        ++index_;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveCacheIterator(prefix, index_, nullptr, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return RestoreCacheIterator(ctx, prefix, nullptr, reader, &index_);
+      }
+
+     private:
+      mutex mu_;
+      Status status_;
+      std::unique_ptr<BundleReader> reader_ GUARDED_BY(mu_);
+      int64 index_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const string filename_;
+    Env* const env_;
+
+    mutable mutex mu_;
+    // The elements of the input, once an iterator has seen all of them.
+    mutable std::shared_ptr<const Elements> memory_cache_ GUARDED_BY(mu_);
+    mutable bool memory_writer_active_ GUARDED_BY(mu_) = false;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
+                        CacheDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -134,6 +134,29 @@ Status CapturedFunction::Run(FunctionLibraryRuntime::Options f_opts,
   return s;
 }
 
+void CapturedFunction::RunAsync(FunctionLibraryRuntime::Options f_opts,
+                                std::vector<Tensor> args,
+                                std::vector<Tensor>* rets,
+                                FunctionLibraryRuntime::DoneCallback done) {
+  // NOTE(mrry): The cancellation manager and the arguments must outlive the
+  // asynchronous call, so unlike in `Run()` they are owned by the callback.
+  CancellationManager* c_mgr = new CancellationManager;
+  f_opts.cancellation_manager = c_mgr;
+  std::vector<Tensor>* args_with_captured = new std::vector<Tensor>;
+  args_with_captured->reserve(args.size() + captured_inputs_.size());
+  for (Tensor& t : args) {
+    args_with_captured->push_back(std::move(t));
+  }
+  args_with_captured->insert(args_with_captured->end(),
+                             captured_inputs_.begin(), captured_inputs_.end());
+  lib_->Run(f_opts, f_handle_, *args_with_captured, rets,
+            [c_mgr, args_with_captured, done](Status func_status) {
+              delete c_mgr;
+              delete args_with_captured;
+              done(func_status);
+            });
+}
+
 CapturedFunction::CapturedFunction(
     std::unique_ptr<Device> device,
     std::unique_ptr<FunctionLibraryDefinition> flib_def,
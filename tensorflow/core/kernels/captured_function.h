@@ -62,6 +62,14 @@ class CapturedFunction {
   Status Run(FunctionLibraryRuntime::Options f_opts,
              gtl::ArraySlice<Tensor> args, std::vector<Tensor>* rets);
 
+  // Asynchronously runs the function, and calls `done` when it completes.
+  // The caller must keep `*rets` alive until `done` is called, but `done`
+  // may be called on any thread, including the calling thread before this
+  // method returns.
+  void RunAsync(FunctionLibraryRuntime::Options f_opts,
+                std::vector<Tensor> args, std::vector<Tensor>* rets,
+                FunctionLibraryRuntime::DoneCallback done);
+
   Device* device() const { return device_.get(); }
 
   ResourceMgr* resource_manager() const { return device_->resource_manager(); }
@@ -18,6 +18,10 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
 
@@ -75,6 +79,109 @@ class IteratorContext {
   Params params_;
 };
 
+// Interface through which an iterator saves its state, as a set of named
+// tensors. See `IteratorBase::Save()`.
+class IteratorStateWriter {
+ public:
+  virtual ~IteratorStateWriter() {}
+
+  virtual Status WriteTensor(const string& key, const Tensor& val) = 0;
+
+  Status WriteScalar(const string& key, int64 val) {
+    Tensor t(DT_INT64, TensorShape({}));
+    t.scalar<int64>()() = val;
+    return WriteTensor(key, t);
+  }
+
+  Status WriteScalar(const string& key, const string& val) {
+    Tensor t(DT_STRING, TensorShape({}));
+    t.scalar<string>()() = val;
+    return WriteTensor(key, t);
+  }
+
+  // Writes the components of an element, under keys that start with `key`.
+  Status WriteElement(const string& key, const std::vector<Tensor>& element) {
+    TF_RETURN_IF_ERROR(WriteScalar(strings::StrCat(key, ".size"),
+                                   static_cast<int64>(element.size())));
+    for (size_t i = 0; i < element.size(); ++i) {
+      TF_RETURN_IF_ERROR(WriteTensor(strings::StrCat(key, "[", i, "]"),
+                                     element[i]));
+    }
+    return Status::OK();
+  }
+
+  // Writes a status, under keys that start with `key`.
+  Status WriteStatus(const string& key, const Status& status) {
+    TF_RETURN_IF_ERROR(WriteScalar(strings::StrCat(key, ".code"),
+                                   static_cast<int64>(status.code())));
+    if (!status.ok()) {
+      TF_RETURN_IF_ERROR(WriteScalar(strings::StrCat(key, ".message"),
+                                     status.error_message()));
+    }
+    return Status::OK();
+  }
+};
+
+// Interface through which an iterator restores the state that it saved
+// through an `IteratorStateWriter`. See `IteratorBase::Restore()`.
+class IteratorStateReader {
+ public:
+  virtual ~IteratorStateReader() {}
+
+  virtual bool Contains(const string& key) = 0;
+
+  virtual Status ReadTensor(const string& key, Tensor* val) = 0;
+
+  Status ReadScalar(const string& key, int64* val) {
+    Tensor t;
+    TF_RETURN_IF_ERROR(ReadTensor(key, &t));
+    if (t.dtype() != DT_INT64 || !TensorShapeUtils::IsScalar(t.shape())) {
+      return errors::DataLoss("Iterator state ", key,
+                              " is not an int64 scalar.");
+    }
+    *val = t.scalar<int64>()();
+    return Status::OK();
+  }
+
+  Status ReadScalar(const string& key, string* val) {
+    Tensor t;
+    TF_RETURN_IF_ERROR(ReadTensor(key, &t));
+    if (t.dtype() != DT_STRING || !TensorShapeUtils::IsScalar(t.shape())) {
+      return errors::DataLoss("Iterator state ", key,
+                              " is not a string scalar.");
+    }
+    *val = t.scalar<string>()();
+    return Status::OK();
+  }
+
+  Status ReadElement(const string& key, std::vector<Tensor>* element) {
+    int64 size;
+    TF_RETURN_IF_ERROR(ReadScalar(strings::StrCat(key, ".size"), &size));
+    element->clear();
+    element->reserve(size);
+    for (int64 i = 0; i < size; ++i) {
+      element->emplace_back();
+      TF_RETURN_IF_ERROR(
+          ReadTensor(strings::StrCat(key, "[", i, "]"), &element->back()));
+    }
+    return Status::OK();
+  }
+
+  Status ReadStatus(const string& key, Status* status) {
+    int64 code;
+    TF_RETURN_IF_ERROR(ReadScalar(strings::StrCat(key, ".code"), &code));
+    if (code == error::OK) {
+      *status = Status::OK();
+      return Status::OK();
+    }
+    string message;
+    TF_RETURN_IF_ERROR(
+        ReadScalar(strings::StrCat(key, ".message"), &message));
+    *status = Status(static_cast<error::Code>(code), message);
+    return Status::OK();
+  }
+};
+
 // Represents the current position in a range of outputs, where the
 // range of outputs is typically represented by an `DatasetBase`,
 // defined below.
@@ -108,6 +215,27 @@ class IteratorBase {
   // (and possibly partially defined) shapes of each tuple component
   // in the outputs of this iterator.
   virtual const std::vector<PartialTensorShape>& output_shapes() const = 0;
+
+  // Saves the state of this iterator to `writer`, under keys that start with
+  // `prefix`. An iterator saves the state of each of its input iterators
+  // under a longer prefix, so that it can restore them in turn.
+  //
+  // This method is thread-safe.
+  virtual Status Save(const string& prefix, IteratorStateWriter* writer) {
+    return errors::Unimplemented(
+        "Saving the state of this iterator is not supported.");
+  }
+
+  // Restores the state that `Save()` wrote under `prefix` to this
+  // iterator, which must have been created from the same dataset by
+  // `DatasetBase::MakeIterator()`, and not used yet.
+  //
+  // This method is thread-safe.
+  virtual Status Restore(IteratorContext* ctx, const string& prefix,
+                         IteratorStateReader* reader) {
+    return errors::Unimplemented(
+        "Restoring the state of this iterator is not supported.");
+  }
 };
 
 // Represents a (potentially infinite) range of outputs, where each
@@ -136,6 +264,33 @@ class DatasetBase : public ResourceBase {
   virtual const std::vector<PartialTensorShape>& output_shapes() const = 0;
 };
 
+// Saves the state of `input`, an iterator over an input dataset, under
+// `prefix`. An iterator commonly resets `input` once it has consumed all of
+// its elements, in which case this records that the input is exhausted.
+inline Status SaveInputIterator(const string& prefix,
+                                const std::unique_ptr<IteratorBase>& input,
+                                IteratorStateWriter* writer) {
+  if (!input) {
+    return writer->WriteScalar(strings::StrCat(prefix, ".exhausted"), 1);
+  }
+  return input->Save(prefix, writer);
+}
+
+// Restores the state that `SaveInputIterator()` wrote under `prefix` to a
+// new iterator over `dataset`, and stores it in `*input`, or resets `*input`
+// if the saved input was exhausted.
+inline Status RestoreInputIterator(IteratorContext* ctx, const string& prefix,
+                                   const DatasetBase* dataset,
+                                   IteratorStateReader* reader,
+                                   std::unique_ptr<IteratorBase>* input) {
+  if (reader->Contains(strings::StrCat(prefix, ".exhausted"))) {
+    input->reset();
+    return Status::OK();
+  }
+  *input = dataset->MakeIterator();
+  return (*input)->Restore(ctx, prefix, reader);
+}
+
 // Represents an iterator that is associated with a particular parent dataset.
 template <class DatasetType>
 class DatasetIterator : public IteratorBase {
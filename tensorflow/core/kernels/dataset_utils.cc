@@ -0,0 +1,160 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset_utils.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/lib/random/random.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+Status MakeIteratorFromInputElement(
+    IteratorContext* ctx, const std::vector<Tensor>& input_element,
+    CapturedFunction* captured_func,
+    std::unique_ptr<IteratorBase>* out_iterator) {
+  FunctionLibraryRuntime::Options opts;
+  opts.runner = ctx->runner();
+  // Choose a step ID that is guaranteed not to clash with any
+  // Session-generated step ID. DirectSession only generates
+  // non-negative step IDs (contiguous, starting from 0), and
+  // MasterSession generates 56-bit random step IDs whose MSB
+  // is always 0, so a negative random step ID should suffice.
+  opts.step_id = -std::abs(static_cast<int64>(random::New64()));
+  ScopedStepContainer step_container(
+      opts.step_id, [captured_func](const string& name) {
+        captured_func->resource_manager()->Cleanup(name).IgnoreError();
+      });
+  opts.step_container = &step_container;
+  std::vector<Tensor> return_values;
+  TF_RETURN_IF_ERROR(captured_func->Run(opts, input_element, &return_values));
+
+  if (!(return_values.size() == 1 && return_values[0].dtype() == DT_RESOURCE &&
+        TensorShapeUtils::IsScalar(return_values[0].shape()))) {
+    return errors::InvalidArgument(
+        "`f` must return a single scalar of dtype DT_RESOURCE.");
+  }
+
+  // Retrieve the dataset that was created in `f`.
+  DatasetBase* returned_dataset;
+  const ResourceHandle& dataset_resource =
+      return_values[0].scalar<ResourceHandle>()();
+
+  // NOTE(mrry): We cannot use the core `LookupResource()` or
+  // `DeleteResource()` functions, because we have an
+  // `IteratorContext*` and not an `OpKernelContext*`, so we
+  // replicate the necessary functionality here.
+  auto type_index = MakeTypeIndex<DatasetBase>();
+  if (type_index.hash_code() != dataset_resource.hash_code()) {
+    return errors::InvalidArgument("`f` must return a Dataset resource.");
+  }
+  TF_RETURN_IF_ERROR(captured_func->resource_manager()->Lookup(
+      dataset_resource.container(), dataset_resource.name(),
+      &returned_dataset));
+  core::ScopedUnref unref_dataset(returned_dataset);
+
+  // Create an iterator for the dataset that was returned by
+  // `f`. This transfers ownership of the dataset to the
+  // iterator, so we can delete it from the resource manager.
+  *out_iterator = returned_dataset->MakeIterator();
+  return captured_func->resource_manager()->Delete<DatasetBase>(
+      dataset_resource.container(), dataset_resource.name());
+}
+
+Status SaveElementIterator(const string& prefix,
+                           const std::vector<Tensor>& input_element,
+                           IteratorBase* element_iterator,
+                           IteratorStateWriter* writer) {
+  if (element_iterator == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(
+      writer->WriteElement(strings::StrCat(prefix, "/args"), input_element));
+  return element_iterator->Save(strings::StrCat(prefix, "/iterator"), writer);
+}
+
+Status RestoreElementIterator(IteratorContext* ctx, const string& prefix,
+                              CapturedFunction* captured_func,
+                              IteratorStateReader* reader,
+                              std::vector<Tensor>* input_element,
+                              std::unique_ptr<IteratorBase>* out_iterator) {
+  const string args_key = strings::StrCat(prefix, "/args");
+  if (!reader->Contains(strings::StrCat(args_key, ".size"))) {
+    input_element->clear();
+    out_iterator->reset();
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(reader->ReadElement(args_key, input_element));
+  TF_RETURN_IF_ERROR(MakeIteratorFromInputElement(ctx, *input_element,
+                                                  captured_func, out_iterator));
+  return (*out_iterator)
+      ->Restore(ctx, strings::StrCat(prefix, "/iterator"), reader);
+}
+
+namespace {
+
+// TODO(mrry): Reconcile this method with the similar method in the queue
+// implementation.
+template <DataType DT>
+Status HandleElementToSlice(const Tensor& element, Tensor* parent,
+                            int64 index) {
+  typedef typename EnumToDataType<DT>::Type T;
+  if (element.NumElements() != (parent->NumElements() / parent->dim_size(0))) {
+    TensorShape chip_shape = parent->shape();
+    chip_shape.RemoveDim(0);
+    return errors::Internal(
+        "HandleElementToSlice Cannot copy slice: number of elements does not "
+        "match.  Shapes are: [element]: ",
+        element.shape().DebugString(),
+        ", [parent slice]: ", chip_shape.DebugString());
+  }
+  auto parent_as_matrix = parent->flat_outer_dims<T>();
+  parent_as_matrix.chip(index, 0) = element.flat<T>();
+  return Status::OK();
+}
+
+}  // namespace
+
+Status CopyElementToSlice(const Tensor& element, Tensor* parent, int64 index) {
+#define HANDLE_TYPE(DT)                                                   \
+  if (element.dtype() == DT) {                                            \
+    TF_RETURN_IF_ERROR(HandleElementToSlice<DT>(element, parent, index)); \
+    return Status::OK();                                                  \
+  }
+  HANDLE_TYPE(DT_FLOAT);
+  HANDLE_TYPE(DT_HALF);
+  HANDLE_TYPE(DT_DOUBLE);
+  HANDLE_TYPE(DT_INT32);
+  HANDLE_TYPE(DT_UINT8);
+  HANDLE_TYPE(DT_INT16);
+  HANDLE_TYPE(DT_INT8);
+  HANDLE_TYPE(DT_STRING);
+  HANDLE_TYPE(DT_COMPLEX64);
+  HANDLE_TYPE(DT_COMPLEX128);
+  HANDLE_TYPE(DT_INT64);
+  HANDLE_TYPE(DT_BOOL);
+  HANDLE_TYPE(DT_QINT8);
+  HANDLE_TYPE(DT_QUINT8);
+  HANDLE_TYPE(DT_QINT32);
+  HANDLE_TYPE(DT_QINT16);
+  HANDLE_TYPE(DT_QUINT16);
+#undef HANDLE_TYPE
+  return errors::Unimplemented("CopyElementToSlice Unhandled data type: ",
+                               element.dtype());
+}
+
+}  // namespace dataset
+
+}  // namespace tensorflow
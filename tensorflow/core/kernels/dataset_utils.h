@@ -0,0 +1,65 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+// Runs `captured_func` on `input_element`, which must return a scalar
+// Dataset resource, and stores an iterator over that dataset in
+// `*out_iterator`. The dataset is removed from the resource manager of
+// `captured_func`, and is owned by the iterator.
+Status MakeIteratorFromInputElement(
+    IteratorContext* ctx, const std::vector<Tensor>& input_element,
+    CapturedFunction* captured_func,
+    std::unique_ptr<IteratorBase>* out_iterator);
+
+// Saves `input_element` and the state of `element_iterator`, which
+// `MakeIteratorFromInputElement()` created from it, under `prefix`. Writes
+// nothing if `element_iterator` is null.
+Status SaveElementIterator(const string& prefix,
+                           const std::vector<Tensor>& input_element,
+                           IteratorBase* element_iterator,
+                           IteratorStateWriter* writer);
+
+// Restores the state that `SaveElementIterator()` wrote under `prefix`, by
+// running `captured_func` on the saved input element again and restoring
+// the resulting iterator. Stores the input element in `*input_element` and
+// the iterator in `*out_iterator`, or clears both if nothing was saved.
+Status RestoreElementIterator(IteratorContext* ctx, const string& prefix,
+                              CapturedFunction* captured_func,
+                              IteratorStateReader* reader,
+                              std::vector<Tensor>* input_element,
+                              std::unique_ptr<IteratorBase>* out_iterator);
+
+// Copies `element` into the `index`th slice of `parent` (in the 0th
+// dimension). The number of elements in `element` must match the number of
+// elements in a slice of `parent`.
+Status CopyElementToSlice(const Tensor& element, Tensor* parent, int64 index);
+
+}  // namespace dataset
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
@@ -253,6 +253,18 @@ class DenseToSparseBatchDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return input_impl_->Save(strings::StrCat(prefix, "/input"), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return input_impl_->Restore(ctx, strings::StrCat(prefix, "/input"),
+                                    reader);
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
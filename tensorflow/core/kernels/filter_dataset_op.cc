@@ -138,6 +138,16 @@ class FilterDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return input_impl_->Save(strings::StrCat(prefix, "/input"), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return input_impl_->Restore(ctx, strings::StrCat(prefix, "/input"),
+                                    reader);
+      }
+
      private:
       const std::unique_ptr<IteratorBase> input_impl_;
     };
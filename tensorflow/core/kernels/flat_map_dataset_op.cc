@@ -17,9 +17,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
-#include "tensorflow/core/lib/random/random.h"
 
 #include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_utils.h"
 
 namespace tensorflow {
 
@@ -121,77 +121,49 @@ class FlatMapDatasetOp : public OpKernel {
             // We have reached the end of the current element, so maybe move on
             // to the next element.
             current_element_iterator_.reset();
+            current_element_args_.clear();
           }
 
           // Get the next element from the input dataset.
-          std::vector<Tensor> args;
-          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &args, end_of_sequence));
+          current_element_args_.clear();
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &current_element_args_,
+                                                  end_of_sequence));
           if (*end_of_sequence) {
             return Status::OK();
           }
 
-          FunctionLibraryRuntime::Options opts;
-          opts.runner = ctx->runner();
-          // Choose a step ID that is guaranteed not to clash with any
-          // Session-generated step ID. DirectSession only generates
-          // non-negative step IDs (contiguous, starting from 0), and
-          // MasterSession generates 56-bit random step IDs whose MSB
-          // is always 0, so a negative random step ID should suffice.
-          opts.step_id = -std::abs(static_cast<int64>(random::New64()));
-          ScopedStepContainer step_container(
-              opts.step_id, [this, ctx](const string& name) {
-                dataset()
-                    ->captured_func_->resource_manager()
-                    ->Cleanup(name)
-                    .IgnoreError();
-              });
-          opts.step_container = &step_container;
-          std::vector<Tensor> return_values;
-          TF_RETURN_IF_ERROR(
-              dataset()->captured_func_->Run(opts, args, &return_values));
-
-          if (!(return_values.size() == 1 &&
-                return_values[0].dtype() == DT_RESOURCE &&
-                TensorShapeUtils::IsScalar(return_values[0].shape()))) {
-            return errors::InvalidArgument(
-                "`f` must return a single scalar of dtype DT_RESOURCE.");
-          }
-
-          // Retrieve the dataset that was created in `f`.
-          DatasetBase* returned_dataset;
-          const ResourceHandle& dataset_resource =
-              return_values[0].scalar<ResourceHandle>()();
-
-          // NOTE(mrry): We cannot use the core `LookupResource()` or
-          // `DeleteResource()` functions, because we have an
-          // `IteratorContext*` and not an `OpKernelContext*`, so we
-          // replicate the necessary functionality here.
-          auto type_index = MakeTypeIndex<DatasetBase>();
-          if (type_index.hash_code() != dataset_resource.hash_code()) {
-            return errors::InvalidArgument(
-                "`f` must return a Dataset resource.");
-          }
-          TF_RETURN_IF_ERROR(
-              dataset()->captured_func_->resource_manager()->Lookup(
-                  dataset_resource.container(), dataset_resource.name(),
-                  &returned_dataset));
-          core::ScopedUnref unref_dataset(returned_dataset);
-
-          // Create an iterator for the dataset that was returned by
-          // `f`. This transfers ownership of the dataset to the
-          // iterator, so we can delete it from the resource manager.
-          current_element_iterator_ = returned_dataset->MakeIterator();
-          TF_RETURN_IF_ERROR(
-              dataset()
-                  ->captured_func_->resource_manager()
-                  ->Delete<DatasetBase>(dataset_resource.container(),
-                                        dataset_resource.name()));
+          TF_RETURN_IF_ERROR(dataset::MakeIteratorFromInputElement(
+              ctx, current_element_args_, dataset()->captured_func_.get(),
+              &current_element_iterator_));
         } while (true);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        return dataset::SaveElementIterator(
+            strings::StrCat(prefix, "/current_element"), current_element_args_,
+            current_element_iterator_.get(), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        return dataset::RestoreElementIterator(
+            ctx, strings::StrCat(prefix, "/current_element"),
+            dataset()->captured_func_.get(), reader, &current_element_args_,
+            &current_element_iterator_);
+      }
+
      private:
       mutex mu_;
       const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      // The input element from which `current_element_iterator_` was created,
+      // which is saved so that the iterator can be recreated on restore.
+      std::vector<Tensor> current_element_args_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> current_element_iterator_ GUARDED_BY(mu_);
     };
 
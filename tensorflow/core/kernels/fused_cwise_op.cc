@@ -0,0 +1,296 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The element-wise operations that _FusedCwise can evaluate. The fusion pass
+// in common_runtime/cwise_fusion_pass.cc only fuses these.
+enum class FusedOpcode {
+  kAdd,
+  kSub,
+  kMul,
+  kRealDiv,
+  kMaximum,
+  kMinimum,
+  kSquaredDifference,
+  kNeg,
+  kAbs,
+  kSquare,
+  kSqrt,
+  kRsqrt,
+  kExp,
+  kLog,
+  kTanh,
+  kSigmoid,
+  kRelu,
+};
+
+struct FusedOpInfo {
+  const char* name;
+  FusedOpcode opcode;
+  bool is_binary;
+};
+
+const FusedOpInfo kFusedOps[] = {
+    {"Add", FusedOpcode::kAdd, true},
+    {"Sub", FusedOpcode::kSub, true},
+    {"Mul", FusedOpcode::kMul, true},
+    {"RealDiv", FusedOpcode::kRealDiv, true},
+    {"Maximum", FusedOpcode::kMaximum, true},
+    {"Minimum", FusedOpcode::kMinimum, true},
+    {"SquaredDifference", FusedOpcode::kSquaredDifference, true},
+    {"Neg", FusedOpcode::kNeg, false},
+    {"Abs", FusedOpcode::kAbs, false},
+    {"Square", FusedOpcode::kSquare, false},
+    {"Sqrt", FusedOpcode::kSqrt, false},
+    {"Rsqrt", FusedOpcode::kRsqrt, false},
+    {"Exp", FusedOpcode::kExp, false},
+    {"Log", FusedOpcode::kLog, false},
+    {"Tanh", FusedOpcode::kTanh, false},
+    {"Sigmoid", FusedOpcode::kSigmoid, false},
+    {"Relu", FusedOpcode::kRelu, false},
+};
+
+// The number of elements evaluated at a time, small enough for the
+// registers of a block to stay in the L1 cache.
+const int64 kBlockSize = 1024;
+
+// Evaluates "opcode" on "n" elements of "x" and, for binary operations, "y".
+template <typename T>
+void EvaluateBlock(FusedOpcode opcode, const T* x_data, const T* y_data,
+                   T* out_data, int64 n) {
+  typedef Eigen::Array<T, Eigen::Dynamic, 1> Array;
+  Eigen::Map<const Array> x(x_data, n);
+  Eigen::Map<Array> out(out_data, n);
+  switch (opcode) {
+    case FusedOpcode::kAdd:
+      out = x + Eigen::Map<const Array>(y_data, n);
+      break;
+    case FusedOpcode::kSub:
+      out = x - Eigen::Map<const Array>(y_data, n);
+      break;
+    case FusedOpcode::kMul:
+      out = x * Eigen::Map<const Array>(y_data, n);
+      break;
+    case FusedOpcode::kRealDiv:
+      out = x / Eigen::Map<const Array>(y_data, n);
+      break;
+    case FusedOpcode::kMaximum:
+      out = x.max(Eigen::Map<const Array>(y_data, n));
+      break;
+    case FusedOpcode::kMinimum:
+      out = x.min(Eigen::Map<const Array>(y_data, n));
+      break;
+    case FusedOpcode::kSquaredDifference:
+      out = (x - Eigen::Map<const Array>(y_data, n)).square();
+      break;
+    case FusedOpcode::kNeg:
+      out = -x;
+      break;
+    case FusedOpcode::kAbs:
+      out = x.abs();
+      break;
+    case FusedOpcode::kSquare:
+      out = x.square();
+      break;
+    case FusedOpcode::kSqrt:
+      out = x.sqrt();
+      break;
+    case FusedOpcode::kRsqrt:
+      out = x.sqrt().inverse();
+      break;
+    case FusedOpcode::kExp:
+      out = x.exp();
+      break;
+    case FusedOpcode::kLog:
+      out = x.log();
+      break;
+    case FusedOpcode::kTanh:
+      out = x.tanh();
+      break;
+    case FusedOpcode::kSigmoid:
+      out = (T(1) + (-x).exp()).inverse();
+      break;
+    case FusedOpcode::kRelu:
+      out = x.max(T(0));
+      break;
+  }
+}
+
+}  // namespace
+
+// Evaluates a tape of element-wise operations block by block, so that the
+// intermediate results stay in cache instead of making a round-trip through
+// memory for each operation.
+template <typename T>
+class FusedCwiseOp : public OpKernel {
+ public:
+  explicit FusedCwiseOp(OpKernelConstruction* context) : OpKernel(context) {
+    int num_inputs;
+    OP_REQUIRES_OK(context, context->GetAttr("N", &num_inputs));
+    std::vector<string> ops;
+    OP_REQUIRES_OK(context, context->GetAttr("ops", &ops));
+    std::vector<int> operands;
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands));
+    OP_REQUIRES(context, operands.size() == 2 * ops.size(),
+                errors::InvalidArgument("Expected ", 2 * ops.size(),
+                                        " operands, got ", operands.size()));
+    for (int i = 0; i < ops.size(); ++i) {
+      const FusedOpInfo* info = nullptr;
+      for (const FusedOpInfo& candidate : kFusedOps) {
+        if (ops[i] == candidate.name) info = &candidate;
+      }
+      OP_REQUIRES(context, info != nullptr,
+                  errors::InvalidArgument("Unsupported fused operation: ",
+                                          ops[i]));
+      // Operation i may read the inputs and the results of operations
+      // 0 to i - 1.
+      const int num_registers = num_inputs + i;
+      const int x = operands[2 * i];
+      const int y = operands[2 * i + 1];
+      OP_REQUIRES(
+          context,
+          x >= 0 && x < num_registers &&
+              (info->is_binary ? y >= 0 && y < num_registers : y == -1),
+          errors::InvalidArgument("Invalid operands for fused operation ", i,
+                                  " (", ops[i], "): ", x, ", ", y));
+      instructions_.push_back({info->opcode, x, y});
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(context, context->input_list("inputs", &inputs));
+
+    // The output has the shape of the non-scalar inputs, whose buffers may be
+    // forwarded to it.
+    TensorShape shape;
+    gtl::InlinedVector<int, 4> forwardable_inputs;
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (TensorShapeUtils::IsScalar(inputs[i].shape())) continue;
+      if (forwardable_inputs.empty()) {
+        shape = inputs[i].shape();
+      } else {
+        OP_REQUIRES(context, shape == inputs[i].shape(),
+                    errors::InvalidArgument(
+                        "Inputs of _FusedCwise must be scalars or have the "
+                        "same shape, got ",
+                        shape.DebugString(), " and ",
+                        inputs[i].shape().DebugString()));
+      }
+      forwardable_inputs.push_back(i);
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                forwardable_inputs, 0, shape, &output));
+    const int64 size = shape.num_elements();
+    if (size == 0) return;
+
+    const int num_inputs = inputs.size();
+    gtl::InlinedVector<const T*, 8> input_data(num_inputs);
+    gtl::InlinedVector<int, 8> scalar_inputs;
+    for (int i = 0; i < num_inputs; ++i) {
+      input_data[i] = inputs[i].flat<T>().data();
+      if (TensorShapeUtils::IsScalar(inputs[i].shape())) {
+        scalar_inputs.push_back(i);
+      }
+    }
+    T* output_data = output->flat<T>().data();
+
+    auto work = [this, num_inputs, size, &input_data, &scalar_inputs,
+                 output_data](int64 start_block, int64 limit_block) {
+      // One buffer per scalar input, filled with its value, and one per
+      // operation but the last, which writes to the output. The buffers of
+      // each thread are reused by its later shards.
+      const int num_ops = instructions_.size();
+      const int num_scalars = scalar_inputs.size();
+      static thread_local std::vector<T> buffers;
+      const size_t num_buffer_elements =
+          (num_scalars + num_ops - 1) * kBlockSize;
+      if (buffers.size() < num_buffer_elements) {
+        buffers.resize(num_buffer_elements);
+      }
+      T* const scratch = buffers.data();
+      gtl::InlinedVector<const T*, 16> registers(num_inputs + num_ops);
+      for (int i = 0; i < num_scalars; ++i) {
+        T* buffer = scratch + i * kBlockSize;
+        std::fill(buffer, buffer + kBlockSize, input_data[scalar_inputs[i]][0]);
+        registers[scalar_inputs[i]] = buffer;
+      }
+      T* const intermediates = scratch + num_scalars * kBlockSize;
+      for (int64 block = start_block; block < limit_block; ++block) {
+        const int64 begin = block * kBlockSize;
+        const int64 n = std::min(kBlockSize, size - begin);
+        for (int i = 0, s = 0; i < num_inputs; ++i) {
+          if (s < num_scalars && scalar_inputs[s] == i) {
+            ++s;
+          } else {
+            registers[i] = input_data[i] + begin;
+          }
+        }
+        for (int j = 0; j < num_ops; ++j) {
+          const Instruction& instruction = instructions_[j];
+          T* out = j + 1 == num_ops ? output_data + begin
+                                    : intermediates + j * kBlockSize;
+          EvaluateBlock<T>(
+              instruction.opcode, registers[instruction.x],
+              instruction.y < 0 ? nullptr : registers[instruction.y], out, n);
+          registers[num_inputs + j] = out;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks = (size + kBlockSize - 1) / kBlockSize;
+    // A few cycles per element and operation.
+    const int64 cost_per_block = kBlockSize * instructions_.size() * 5;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          cost_per_block, work);
+  }
+
+ private:
+  struct Instruction {
+    FusedOpcode opcode;
+    int x;
+    int y;  // -1 for unary operations.
+  };
+  std::vector<Instruction> instructions_;
+};
+
+#define REGISTER_KERNEL(T)                                           \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("_FusedCwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedCwiseOp<T>);
+
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(double);
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,120 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+class FusedCwiseOpTest : public OpsTestBase {
+ protected:
+  Status Init(int num_inputs, const std::vector<string>& ops,
+              const std::vector<int>& operands) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("fused", "_FusedCwise")
+                           .Input(FakeInput(num_inputs, DT_FLOAT))
+                           .Attr("ops", ops)
+                           .Attr("operands", operands)
+                           .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedCwiseOpTest, MulAddRelu) {
+  // relu(x * y + 1)
+  TF_ASSERT_OK(Init(3, {"Mul", "Add", "Relu"}, {0, 1, 3, 2, 4, -1}));
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, -2, 3, -4});
+  AddInputFromArray<float>(TensorShape({2, 2}), {2, 2, -1, 0});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&expected, {3, 0, 0, 1});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedCwiseOpTest, SpansSeveralBlocks) {
+  // sigmoid(x)^2 - x, on more elements than fit in one block.
+  TF_ASSERT_OK(
+      Init(1, {"Sigmoid", "Square", "Sub"}, {0, -1, 1, -1, 2, 0}));
+  const int size = 3000;
+  std::vector<float> x(size);
+  std::vector<float> y(size);
+  for (int i = 0; i < size; ++i) {
+    x[i] = (i - size / 2) / 100.0f;
+    const float sigmoid = 1.0f / (1.0f + std::exp(-x[i]));
+    y[i] = sigmoid * sigmoid - x[i];
+  }
+  AddInputFromArray<float>(TensorShape({size}), x);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({size}));
+  test::FillValues<float>(&expected, y);
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedCwiseOpTest, ScalarsSpanSeveralBlocks) {
+  // (x - s) * y, run twice with a different scalar since the buffers of
+  // the scalars are reused across runs.
+  TF_ASSERT_OK(Init(3, {"Sub", "Mul"}, {0, 1, 3, 2}));
+  const int size = 3000;
+  std::vector<float> x(size);
+  std::vector<float> y(size);
+  for (int i = 0; i < size; ++i) {
+    x[i] = i;
+    y[i] = i % 7;
+  }
+  for (float s : {1.0f, 5.0f}) {
+    inputs_.clear();
+    AddInputFromArray<float>(TensorShape({size}), x);
+    AddInputFromArray<float>(TensorShape({}), {s});
+    AddInputFromArray<float>(TensorShape({size}), y);
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<float> z(size);
+    for (int i = 0; i < size; ++i) {
+      z[i] = (x[i] - s) * y[i];
+    }
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({size}));
+    test::FillValues<float>(&expected, z);
+    test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+  }
+}
+
+TEST_F(FusedCwiseOpTest, InvalidOperands) {
+  // Operation 0 cannot read its own result.
+  EXPECT_FALSE(Init(1, {"Neg"}, {1, -1}).ok());
+  // Binary operations need two operands.
+  EXPECT_FALSE(Init(2, {"Add"}, {0, -1}).ok());
+  EXPECT_FALSE(Init(1, {"MatMul"}, {0, 0}).ok());
+}
+
+TEST_F(FusedCwiseOpTest, MismatchedShapes) {
+  TF_ASSERT_OK(Init(2, {"Add"}, {0, 1}));
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+}  // namespace tensorflow
@@ -153,6 +153,7 @@ class GroupByWindowDatasetOp : public OpKernel {
             // We have reached the end of the current group, so maybe move on
             // to the next group.
             current_group_iterator_.reset();
+            current_group_.clear();
           }
 
           // Iterate through the input dataset until we get a full
@@ -219,9 +220,111 @@ class GroupByWindowDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/end_of_input"), end_of_input_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/groups.size"),
+                                static_cast<int64>(groups_.size())));
+        int64 group_index = 0;
+        for (const auto& group : groups_) {
+          const string group_prefix =
+              strings::StrCat(prefix, "/groups[", group_index++, "]");
+          TF_RETURN_IF_ERROR(SaveGroup(group_prefix, group.first,
+                                       group.second, writer));
+        }
+        if (current_group_iterator_) {
+          const string current_prefix =
+              strings::StrCat(prefix, "/current_group");
+          TF_RETURN_IF_ERROR(SaveGroup(current_prefix, current_group_key_,
+                                       current_group_, writer));
+          TF_RETURN_IF_ERROR(current_group_iterator_->Save(
+              strings::StrCat(current_prefix, "/iterator"), writer));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        end_of_input_ = end_of_input != 0;
+        int64 num_groups;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/groups.size"), &num_groups));
+        groups_.clear();
+        for (int64 i = 0; i < num_groups; ++i) {
+          int64 key;
+          std::vector<std::vector<Tensor>> group;
+          TF_RETURN_IF_ERROR(
+              RestoreGroup(strings::StrCat(prefix, "/groups[", i, "]"),
+                           reader, &key, &group));
+          groups_[key] = std::move(group);
+        }
+        const string current_prefix = strings::StrCat(prefix, "/current_group");
+        if (reader->Contains(strings::StrCat(current_prefix, "/key"))) {
+          TF_RETURN_IF_ERROR(RestoreGroup(current_prefix, reader,
+                                          &current_group_key_,
+                                          &current_group_));
+          TF_RETURN_IF_ERROR(MakeCurrentGroupIterator(ctx));
+          TF_RETURN_IF_ERROR(current_group_iterator_->Restore(
+              ctx, strings::StrCat(current_prefix, "/iterator"), reader));
+        }
+        return Status::OK();
+      }
+
      private:
+      Status SaveGroup(const string& prefix, int64 key,
+                       const std::vector<std::vector<Tensor>>& group,
+                       IteratorStateWriter* writer) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/key"), key));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/elements.size"),
+                                static_cast<int64>(group.size())));
+        for (size_t i = 0; i < group.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(prefix, "/elements[", i, "]"), group[i]));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreGroup(const string& prefix, IteratorStateReader* reader,
+                          int64* key,
+                          std::vector<std::vector<Tensor>>* group) {
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(prefix, "/key"), key));
+        int64 num_elements;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/elements.size"), &num_elements));
+        group->clear();
+        group->resize(num_elements);
+        for (int64 i = 0; i < num_elements; ++i) {
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(prefix, "/elements[", i, "]"), &(*group)[i]));
+        }
+        return Status::OK();
+      }
+
       Status StartFlushingGroup(IteratorContext* ctx, int64 key)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        current_group_key_ = key;
+        current_group_ = std::move(groups_[key]);
+        groups_.erase(key);
+        return MakeCurrentGroupIterator(ctx);
+      }
+
+      // Runs the reduce function on the current group, and creates an
+      // iterator over the dataset that it returns.
+      Status MakeCurrentGroupIterator(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         FunctionLibraryRuntime::Options opts;
         // Choose a step ID that is guaranteed not to clash with any
         // Session-generated step ID. DirectSession only generates
@@ -239,14 +342,15 @@ class GroupByWindowDatasetOp : public OpKernel {
             });
         opts.step_container = &step_container;
 
+        // NOTE: The window dataset takes a copy of the (reference-counted)
+        // tensors in the group, which is retained to save the group.
         DatasetBase* group_dataset;
         TF_RETURN_IF_ERROR(NewWindowDataset(
-            std::move(groups_[key]), dataset()->input_->output_dtypes(),
+            current_group_, dataset()->input_->output_dtypes(),
             dataset()->input_->output_shapes(), &group_dataset));
-        groups_.erase(key);
 
         Tensor key_arg(DT_INT64, TensorShape({}));
-        key_arg.scalar<int64>()() = key;
+        key_arg.scalar<int64>()() = current_group_key_;
 
         Tensor group_dataset_arg(DT_RESOURCE, TensorShape({}));
 
@@ -314,6 +418,10 @@ class GroupByWindowDatasetOp : public OpKernel {
       // TODO(mrry): Optimize for dense key space if appropriate.
       bool end_of_input_ GUARDED_BY(mu_) = false;
       std::map<int64, std::vector<std::vector<Tensor>>> groups_ GUARDED_BY(mu_);
+      // The key and elements of the group from which
+      // `current_group_iterator_` was created.
+      int64 current_group_key_ GUARDED_BY(mu_) = 0;
+      std::vector<std::vector<Tensor>> current_group_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> current_group_iterator_ GUARDED_BY(mu_);
     };
 
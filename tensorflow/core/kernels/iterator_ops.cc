@@ -18,7 +18,9 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/protobuf/named_tensor.pb.h"
 
 namespace tensorflow {
 
@@ -64,17 +66,108 @@ Status VerifyShapesCompatible(const std::vector<PartialTensorShape>& expected,
   return Status::OK();
 }
 
+// The key prefix under which an `IteratorResource` saves the state of its
+// iterator.
+constexpr char kIteratorStatePrefix[] = "Iterator";
+
+// Accumulates iterator state as a list of `NamedTensorProto`s.
+class NamedTensorStateWriter : public IteratorStateWriter {
+ public:
+  Status WriteTensor(const string& key, const Tensor& val) override {
+    NamedTensorProto proto;
+    proto.set_name(key);
+    if (val.dtype() == DT_STRING) {
+      val.AsProtoField(proto.mutable_tensor());
+    } else {
+      val.AsProtoTensorContent(proto.mutable_tensor());
+    }
+    protos_.push_back(std::move(proto));
+    return Status::OK();
+  }
+
+  // Stores each saved tensor as an element of the 1-D string tensor `out`.
+  Status Serialize(Tensor* out) const {
+    auto out_flat = out->vec<string>();
+    for (size_t i = 0; i < protos_.size(); ++i) {
+      if (!protos_[i].SerializeToString(&out_flat(i))) {
+        return errors::Internal("Failed to serialize iterator state ",
+                                protos_[i].name(), ".");
+      }
+    }
+    return Status::OK();
+  }
+
+  int64 size() const { return protos_.size(); }
+
+ private:
+  std::vector<NamedTensorProto> protos_;
+};
+
+// Reads iterator state from the tensor written by `NamedTensorStateWriter`.
+class NamedTensorStateReader : public IteratorStateReader {
+ public:
+  Status Initialize(const Tensor& serialized) {
+    if (serialized.dtype() != DT_STRING ||
+        !TensorShapeUtils::IsVector(serialized.shape())) {
+      return errors::InvalidArgument(
+          "Serialized iterator state must be a vector of strings.");
+    }
+    auto serialized_flat = serialized.vec<string>();
+    for (int64 i = 0; i < serialized_flat.size(); ++i) {
+      NamedTensorProto proto;
+      if (!proto.ParseFromString(serialized_flat(i))) {
+        return errors::DataLoss("Could not parse serialized iterator state.");
+      }
+      Tensor val;
+      if (!val.FromProto(proto.tensor())) {
+        return errors::DataLoss("Could not parse iterator state ",
+                                proto.name(), ".");
+      }
+      tensors_[proto.name()] = std::move(val);
+    }
+    return Status::OK();
+  }
+
+  bool Contains(const string& key) override {
+    return tensors_.find(key) != tensors_.end();
+  }
+
+  Status ReadTensor(const string& key, Tensor* val) override {
+    auto it = tensors_.find(key);
+    if (it == tensors_.end()) {
+      return errors::NotFound("Iterator state ", key,
+                              " is missing from the checkpoint.");
+    }
+    *val = it->second;
+    return Status::OK();
+  }
+
+ private:
+  gtl::FlatMap<string, Tensor> tensors_;
+};
+
 class IteratorResource : public ResourceBase {
  public:
   IteratorResource(const DataTypeVector& output_dtypes,
                    const std::vector<PartialTensorShape>& output_shapes)
-      : iterator_(nullptr),
+      : dataset_(nullptr),
+        iterator_(nullptr),
         output_dtypes_(output_dtypes),
         output_shapes_(output_shapes) {}
 
+  ~IteratorResource() override {
+    if (dataset_ != nullptr) {
+      dataset_->Unref();
+    }
+  }
+
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) {
-    std::shared_ptr<IteratorBase> captured_iterator(iterator_);
+    std::shared_ptr<IteratorBase> captured_iterator;
+    {
+      mutex_lock l(mu_);
+      captured_iterator = iterator_;
+    }
     if (captured_iterator) {
       return captured_iterator->GetNext(ctx, out_tensors, end_of_sequence);
     } else {
@@ -85,15 +178,73 @@ class IteratorResource : public ResourceBase {
     }
   }
 
-  // Transfers ownership of iterator to this. This method is thread-safe.
-  Status set_iterator(std::unique_ptr<IteratorBase> iterator) {
-    if (iterator) {
+  // Creates a new iterator over `dataset` and transfers its ownership to
+  // this, or resets the iterator if `dataset` is null. This method is
+  // thread-safe.
+  Status set_dataset(DatasetBase* dataset) {
+    std::unique_ptr<IteratorBase> iterator;
+    if (dataset != nullptr) {
+      iterator = dataset->MakeIterator();
       TF_RETURN_IF_ERROR(
           VerifyTypesMatch(output_dtypes_, iterator->output_dtypes()));
       TF_RETURN_IF_ERROR(
           VerifyShapesCompatible(output_shapes_, iterator->output_shapes()));
+      dataset->Ref();
+    }
+    DatasetBase* old_dataset;
+    {
+      mutex_lock l(mu_);
+      old_dataset = dataset_;
+      dataset_ = dataset;
+      iterator_.reset(iterator.release());
+    }
+    if (old_dataset != nullptr) {
+      old_dataset->Unref();
     }
-    iterator_.reset(iterator.release());
+    return Status::OK();
+  }
+
+  // Saves the state of the iterator to `writer`. This method is
+  // thread-safe.
+  Status Save(IteratorStateWriter* writer) {
+    std::shared_ptr<IteratorBase> captured_iterator;
+    {
+      mutex_lock l(mu_);
+      captured_iterator = iterator_;
+    }
+    if (!captured_iterator) {
+      return errors::FailedPrecondition(
+          "Save() failed because the iterator has not been initialized. "
+          "Ensure that you have run the initializer operation for this "
+          "iterator before saving it.");
+    }
+    return captured_iterator->Save(kIteratorStatePrefix, writer);
+  }
+
+  // Replaces the iterator with a new iterator over the same dataset, which
+  // resumes from the state in `reader`. This method is thread-safe.
+  Status Restore(IteratorContext* ctx, IteratorStateReader* reader) {
+    DatasetBase* dataset;
+    {
+      mutex_lock l(mu_);
+      dataset = dataset_;
+      if (dataset == nullptr) {
+        return errors::FailedPrecondition(
+            "Restore() failed because the iterator has not been "
+            "initialized. Ensure that you have run the initializer "
+            "operation for this iterator before restoring it.");
+      }
+      dataset->Ref();
+    }
+    core::ScopedUnref unref_dataset(dataset);
+    std::shared_ptr<IteratorBase> iterator(dataset->MakeIterator());
+    TF_RETURN_IF_ERROR(iterator->Restore(ctx, kIteratorStatePrefix, reader));
+    mutex_lock l(mu_);
+    if (dataset_ != dataset) {
+      return errors::Aborted(
+          "The iterator was reinitialized while it was being restored.");
+    }
+    iterator_ = std::move(iterator);
     return Status::OK();
   }
 
@@ -106,7 +257,9 @@ class IteratorResource : public ResourceBase {
   }
 
  private:
-  std::shared_ptr<IteratorBase> iterator_;
+  mutex mu_;
+  DatasetBase* dataset_ GUARDED_BY(mu_);  // Owns one reference.
+  std::shared_ptr<IteratorBase> iterator_ GUARDED_BY(mu_);
   const DataTypeVector output_dtypes_;
   const std::vector<PartialTensorShape> output_shapes_;
 };
@@ -151,8 +304,7 @@ class MakeIteratorOp : public OpKernel {
     IteratorResource* iterator_resource;
     OP_REQUIRES_OK(
         ctx, LookupResource(ctx, HandleFromInput(ctx, 1), &iterator_resource));
-    OP_REQUIRES_OK(ctx,
-                   iterator_resource->set_iterator(dataset->MakeIterator()));
+    OP_REQUIRES_OK(ctx, iterator_resource->set_dataset(dataset));
     iterator_resource->Unref();
   }
 };
@@ -261,9 +413,9 @@ class OneShotIteratorOp : public OpKernel {
 
       // Create an iterator for the dataset that was created in the
       // factory function. This transfers ownership of the dataset to
-      // the iterator, so we can delete it from the resource manager.
-      OP_REQUIRES_OK(ctx,
-                     iterator_resource_->set_iterator(dataset->MakeIterator()));
+      // the iterator resource, so we can delete it from the resource
+      // manager.
+      OP_REQUIRES_OK(ctx, iterator_resource_->set_dataset(dataset));
       OP_REQUIRES_OK(ctx, DeleteResource<DatasetBase>(ctx, dataset_resource));
     }
     Tensor* handle;
@@ -325,7 +477,50 @@ class IteratorDisposeOp : public OpKernel {
     OP_REQUIRES_OK(ctx,
                    LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
     core::ScopedUnref unref_iterator(iterator);
-    OP_REQUIRES_OK(ctx, iterator->set_iterator(nullptr));
+    OP_REQUIRES_OK(ctx, iterator->set_dataset(nullptr));
+  }
+};
+
+class SerializeIteratorOp : public OpKernel {
+ public:
+  explicit SerializeIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+
+    NamedTensorStateWriter writer;
+    OP_REQUIRES_OK(ctx, iterator->Save(&writer));
+    Tensor* serialized;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({writer.size()}),
+                                             &serialized));
+    OP_REQUIRES_OK(ctx, writer.Serialize(serialized));
+  }
+};
+
+class DeserializeIteratorOp : public OpKernel {
+ public:
+  explicit DeserializeIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+
+    NamedTensorStateReader reader;
+    OP_REQUIRES_OK(ctx, reader.Initialize(ctx->input(1)));
+
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.step_id = ctx->step_id();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+    IteratorContext iter_ctx(std::move(params));
+
+    OP_REQUIRES_OK(ctx, iterator->Restore(&iter_ctx, &reader));
   }
 };
 
@@ -338,6 +533,10 @@ REGISTER_KERNEL_BUILDER(Name("IteratorGetNext").Device(DEVICE_CPU),
                         IteratorGetNextOp);
 REGISTER_KERNEL_BUILDER(Name("IteratorDispose").Device(DEVICE_CPU),
                         IteratorDisposeOp);
+REGISTER_KERNEL_BUILDER(Name("SerializeIterator").Device(DEVICE_CPU),
+                        SerializeIteratorOp);
+REGISTER_KERNEL_BUILDER(Name("DeserializeIterator").Device(DEVICE_CPU),
+                        DeserializeIteratorOp);
 
 }  // namespace
 
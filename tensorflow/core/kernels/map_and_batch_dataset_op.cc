@@ -0,0 +1,505 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class MapAndBatchDatasetOp : public OpKernel {
+ public:
+  explicit MapAndBatchDatasetOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    DatasetBase* input;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &input));
+    core::ScopedUnref unref_input(input);
+
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+    }
+
+    const Tensor* batch_size_t;
+    OP_REQUIRES_OK(ctx, ctx->input("batch_size", &batch_size_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(batch_size_t->shape()),
+                errors::InvalidArgument("batch_size must be a scalar"));
+    const int64 batch_size = batch_size_t->flat<int64>()(0);
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("batch_size must be greater than zero."));
+
+    const Tensor* num_parallel_batches_t;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input("num_parallel_batches", &num_parallel_batches_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsScalar(num_parallel_batches_t->shape()),
+        errors::InvalidArgument("num_parallel_batches must be a scalar"));
+    const int64 num_parallel_batches = num_parallel_batches_t->flat<int64>()(0);
+    OP_REQUIRES(ctx, num_parallel_batches > 0,
+                errors::InvalidArgument(
+                    "num_parallel_batches must be greater than zero."));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    // The runner thread and the calls to `f` outlive this kernel's
+    // OpKernelContext, so we capture the params from it as
+    // ParallelMapDatasetOp does.
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    DatasetBase* dataset =
+        new Dataset(input, batch_size, num_parallel_batches, std::move(params),
+                    output_types_, output_shapes_, std::move(captured_func));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->flat<ResourceHandle>()(0) = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 batch_size,
+            int64 num_parallel_batches, IteratorContext::Params ctx_params,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes,
+            std::unique_ptr<CapturedFunction> captured_func)
+        : input_(input),
+          batch_size_(batch_size),
+          num_parallel_batches_(num_parallel_batches),
+          ctx_params_(std::move(ctx_params)),
+          output_types_(output_types),
+          output_shapes_(output_shapes),
+          captured_func_(std::move(captured_func)) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return strings::StrCat("MapAndBatchDatasetOp(", batch_size_,
+                             ")::Dataset");
+    }
+
+   private:
+    // Applies `f` to the elements of up to `num_parallel_batches` batches
+    // at a time, in parallel. Each call to `f` copies its return values
+    // into the slices of the output tensors of its batch, which the first
+    // call to complete allocates for the whole batch. This avoids
+    // buffering the mapped elements, and copying them again when the batch
+    // is assembled, as a ParallelMapDataset followed by a BatchDataset
+    // would.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the runner thread, if any, so that it terminates. We will
+        // then join that thread when we delete `this->runner_thread_`,
+        // and wait for the calls in progress when we delete
+        // `this->thread_pool_`.
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureRunnerThreadStarted(ctx);
+
+        // Wait until all of the calls for the next batch have completed,
+        // the input is exhausted, or we are shutting down.
+        while (!cancelled_ && !IsNextBatchReady() &&
+               !(batch_results_.empty() && end_of_input_)) {
+          cond_var_.wait(l);
+        }
+
+        if (cancelled_) {
+          return errors::Cancelled(
+              "MapAndBatchDatasetOp::Dataset::Iterator::GetNext");
+        }
+
+        if (batch_results_.empty()) {
+          // The final batch was partial, and has been consumed.
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        BatchResult& result = batch_results_.front();
+        if (result.num_elements == 0 && result.status.ok()) {
+          // The input is exhausted. We leave the empty batch in place, so
+          // that subsequent calls also return the end of the sequence.
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        Status s = result.status;
+        if (s.ok()) {
+          for (Tensor& component : result.output) {
+            if (result.num_elements < dataset()->batch_size_) {
+              // The last batch is smaller, so we return the filled slices
+              // of its output tensors.
+              out_tensors->push_back(component.Slice(0, result.num_elements));
+            } else {
+              out_tensors->push_back(std::move(component));
+            }
+          }
+        }
+        batch_results_.pop_front();
+        *end_of_sequence = false;
+
+        // Wake the runner thread, in case it has been waiting for a batch
+        // to be consumed.
+        cond_var_.notify_all();
+        return s;
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        // Stop the runner thread from starting another batch, and wait for
+        // the batches in progress to complete, so that every batch result is
+        // complete and consistent with the state of the input.
+        ++num_saves_;
+        while (!AreAllBatchesReady()) {
+          cond_var_.wait(l);
+        }
+        Status s = SaveLocked(prefix, writer);
+        --num_saves_;
+        cond_var_.notify_all();
+        return s;
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (runner_thread_) {
+          return errors::FailedPrecondition(
+              "Cannot restore an iterator that has already been used.");
+        }
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        end_of_input_ = end_of_input != 0;
+        int64 num_batches;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/batch_results.size"), &num_batches));
+        for (int64 i = 0; i < num_batches; ++i) {
+          const string batch_prefix =
+              strings::StrCat(prefix, "/batch_results[", i, "]");
+          batch_results_.emplace_back();
+          BatchResult* result = &batch_results_.back();
+          TF_RETURN_IF_ERROR(reader->ReadStatus(
+              strings::StrCat(batch_prefix, "/status"), &result->status));
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(batch_prefix, "/output"), &result->output));
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              strings::StrCat(batch_prefix, "/num_elements"),
+              &result->num_elements));
+          result->is_scheduled = true;
+        }
+        return Status::OK();
+      }
+
+     private:
+      // The state of a batch whose elements are being computed.
+      struct BatchResult {
+        // Set if getting an input element, or a call to `f`, fails.
+        Status status;
+        // One tensor per tuple component, with `batch_size` rows.
+        std::vector<Tensor> output;
+        // The number of input elements in this batch.
+        int64 num_elements = 0;
+        // The number of calls to `f` that have not completed.
+        int64 num_calls = 0;
+        // True when all of the input elements of this batch have been
+        // scheduled.
+        bool is_scheduled = false;
+      };
+
+      bool IsNextBatchReady() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return !batch_results_.empty() &&
+               batch_results_.front().is_scheduled &&
+               batch_results_.front().num_calls == 0;
+      }
+
+      bool AreAllBatchesReady() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (const BatchResult& result : batch_results_) {
+          if (!result.is_scheduled || result.num_calls > 0) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      Status SaveLocked(const string& prefix, IteratorStateWriter* writer)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/end_of_input"), end_of_input_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/batch_results.size"),
+            static_cast<int64>(batch_results_.size())));
+        for (size_t i = 0; i < batch_results_.size(); ++i) {
+          const string batch_prefix =
+              strings::StrCat(prefix, "/batch_results[", i, "]");
+          const BatchResult& result = batch_results_[i];
+          TF_RETURN_IF_ERROR(writer->WriteStatus(
+              strings::StrCat(batch_prefix, "/status"), result.status));
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(batch_prefix, "/output"), result.output));
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat(batch_prefix, "/num_elements"),
+              result.num_elements));
+        }
+        return Status::OK();
+      }
+
+      void EnsureRunnerThreadStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!runner_thread_ && !end_of_input_) {
+          // Choose a step ID that is guaranteed not to clash with any
+          // Session-generated step ID. DirectSession only generates
+          // non-negative step IDs (contiguous, starting from 0), and
+          // MasterSession generates 56-bit random step IDs whose MSB
+          // is always 0, so a negative random step ID should suffice.
+          f_opts_.step_id = -std::abs(static_cast<int64>(random::New64()));
+          f_opts_.runner = iter_ctx_.runner();
+
+          const int64 num_threads = std::min<int64>(
+              dataset()->batch_size_ * dataset()->num_parallel_batches_,
+              port::NumSchedulableCPUs());
+          thread_pool_.reset(new thread::ThreadPool(
+              ctx->env(), "map_and_batch", static_cast<int>(num_threads)));
+          runner_thread_.reset(ctx->env()->StartThread(
+              {}, "map_and_batch_runner", [this]() { RunnerThread(); }));
+        }
+      }
+
+      // Gets the input elements of each batch in order, and schedules a call
+      // to `f` for each of them on `thread_pool_`, as long as fewer than
+      // `num_parallel_batches` batches are waiting to be consumed.
+      void RunnerThread() {
+        while (true) {
+          BatchResult* result;
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ &&
+                   (batch_results_.size() == dataset()->num_parallel_batches_ ||
+                    num_saves_ > 0)) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            batch_results_.emplace_back();
+            result = &batch_results_.back();
+          }
+
+          // Only this thread calls `input_impl_->GetNext()`, so the input
+          // elements are assigned to batches in order.
+          bool end_of_input = false;
+          for (int64 i = 0; i < dataset()->batch_size_; ++i) {
+            std::vector<Tensor> input_element;
+            Status s =
+                input_impl_->GetNext(&iter_ctx_, &input_element, &end_of_input);
+            mutex_lock l(mu_);
+            if (!s.ok() || end_of_input || cancelled_) {
+              result->status.Update(s);
+              break;
+            }
+            ++result->num_elements;
+            ++result->num_calls;
+            thread_pool_->Schedule(std::bind(&Iterator::CallFunction, this,
+                                             result, i,
+                                             std::move(input_element)));
+          }
+
+          {
+            mutex_lock l(mu_);
+            result->is_scheduled = true;
+            if (end_of_input) {
+              end_of_input_ = true;
+            }
+            cond_var_.notify_all();
+            if (end_of_input) {
+              return;
+            }
+          }
+        }
+      }
+
+      // Applies `f` to the `offset`th input element of the batch in
+      // `result`, and writes its return values into that batch.
+      void CallFunction(BatchResult* result, int64 offset,
+                        const std::vector<Tensor>& input_element) {
+        std::vector<Tensor> return_values;
+        Status s = dataset()->captured_func_->Run(f_opts_, input_element,
+                                                  &return_values);
+        if (s.ok()) {
+          s = WriteToBatch(result, offset, return_values);
+        }
+
+        mutex_lock l(mu_);
+        result->status.Update(s);
+        --result->num_calls;
+        if (result->num_calls == 0) {
+          cond_var_.notify_all();
+        }
+      }
+
+      Status WriteToBatch(BatchResult* result, int64 offset,
+                          const std::vector<Tensor>& return_values) {
+        const DataTypeVector& output_types = dataset()->output_types_;
+        if (return_values.size() != output_types.size()) {
+          return errors::InvalidArgument(
+              "The map function returned ", return_values.size(),
+              " components, but ", output_types.size(), " were expected.");
+        }
+        for (size_t i = 0; i < return_values.size(); ++i) {
+          if (return_values[i].dtype() != output_types[i]) {
+            return errors::InvalidArgument(
+                "Component ", i, " of the map function's return value has "
+                "type ", DataTypeString(return_values[i].dtype()),
+                ", but ", DataTypeString(output_types[i]), " was expected.");
+          }
+        }
+
+        {
+          mutex_lock l(mu_);
+          if (result->output.empty()) {
+            // This is the first call of the batch to complete, so its return
+            // values determine the shapes of the batch components.
+            result->output.reserve(return_values.size());
+            for (const Tensor& t : return_values) {
+              TensorShape component_shape({dataset()->batch_size_});
+              component_shape.AppendShape(t.shape());
+              result->output.emplace_back(cpu_allocator(), t.dtype(),
+                                          component_shape);
+            }
+          }
+        }
+
+        // The output tensors are not resized until all calls of the batch
+        // have completed, so we can copy into disjoint slices of them
+        // without holding the lock.
+        for (size_t i = 0; i < return_values.size(); ++i) {
+          Tensor* component = &result->output[i];
+          TensorShape slice_shape = component->shape();
+          slice_shape.RemoveDim(0);
+          if (return_values[i].shape() != slice_shape) {
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different shapes in component ", i,
+                ". First element had shape ", slice_shape.DebugString(),
+                " and element ", offset, " had shape ",
+                return_values[i].shape().DebugString(), ".");
+          }
+          TF_RETURN_IF_ERROR(
+              dataset::CopyElementToSlice(return_values[i], component, offset));
+        }
+        return Status::OK();
+      }
+
+      IteratorContext iter_ctx_;
+      FunctionLibraryRuntime::Options f_opts_;
+      const std::unique_ptr<IteratorBase> input_impl_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BatchResult> batch_results_ GUARDED_BY(mu_);
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      // The number of calls to `Save()` that are waiting for the batches in
+      // progress to complete, during which no new batch is started.
+      int64 num_saves_ GUARDED_BY(mu_) = 0;
+      // Declared after the state that the calls to `f` use, so that all
+      // scheduled calls complete before that state is destroyed.
+      std::unique_ptr<thread::ThreadPool> thread_pool_;
+      // Declared last, so that the thread is joined before the state that
+      // it uses is destroyed.
+      std::unique_ptr<Thread> runner_thread_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 batch_size_;
+    const int64 num_parallel_batches_;
+    const IteratorContext::Params ctx_params_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("MapAndBatchDataset").Device(DEVICE_CPU),
+                        MapAndBatchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -128,6 +128,16 @@ class MapDatasetOp : public OpKernel {
         return dataset()->captured_func_->Run(opts, args, out_tensors);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return input_impl_->Save(strings::StrCat(prefix, "/input"), writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return input_impl_->Restore(ctx, strings::StrCat(prefix, "/input"),
+                                    reader);
+      }
+
      private:
       const std::unique_ptr<IteratorBase> input_impl_;
     };
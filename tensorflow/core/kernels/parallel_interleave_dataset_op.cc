@@ -0,0 +1,602 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParallelInterleaveDatasetOp : public OpKernel {
+ public:
+  explicit ParallelInterleaveDatasetOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx), graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    DatasetBase* input;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &input));
+    core::ScopedUnref unref_input(input);
+
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+    }
+
+    const Tensor* cycle_length_t;
+    OP_REQUIRES_OK(ctx, ctx->input("cycle_length", &cycle_length_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(cycle_length_t->shape()),
+                errors::InvalidArgument("cycle_length must be a scalar"));
+    const int64 cycle_length = cycle_length_t->flat<int64>()(0);
+    OP_REQUIRES(
+        ctx, cycle_length > 0,
+        errors::InvalidArgument("cycle_length must be greater than zero."));
+
+    const Tensor* block_length_t;
+    OP_REQUIRES_OK(ctx, ctx->input("block_length", &block_length_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(block_length_t->shape()),
+                errors::InvalidArgument("block_length must be a scalar"));
+    const int64 block_length = block_length_t->flat<int64>()(0);
+    OP_REQUIRES(
+        ctx, block_length > 0,
+        errors::InvalidArgument("block_length must be greater than zero."));
+
+    const Tensor* sloppy_t;
+    OP_REQUIRES_OK(ctx, ctx->input("sloppy", &sloppy_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(sloppy_t->shape()),
+                errors::InvalidArgument("sloppy must be a scalar"));
+    const bool sloppy = sloppy_t->flat<bool>()(0);
+
+    const Tensor* buffer_output_elements_t;
+    OP_REQUIRES_OK(ctx, ctx->input("buffer_output_elements",
+                                   &buffer_output_elements_t));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsScalar(buffer_output_elements_t->shape()),
+        errors::InvalidArgument("buffer_output_elements must be a scalar"));
+    const int64 buffer_output_elements =
+        buffer_output_elements_t->flat<int64>()(0);
+    OP_REQUIRES(ctx, buffer_output_elements > 0,
+                errors::InvalidArgument(
+                    "buffer_output_elements must be greater than zero."));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    // The worker threads outlive this kernel's OpKernelContext, so we
+    // capture the params from it as ParallelMapDatasetOp does.
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    DatasetBase* dataset = new Dataset(
+        input, std::move(captured_func), cycle_length, block_length, sloppy,
+        buffer_output_elements, std::move(params), output_types_,
+        output_shapes_);
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->flat<ResourceHandle>()(0) = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
+            int64 block_length, bool sloppy, int64 buffer_output_elements,
+            IteratorContext::Params ctx_params,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : input_(input),
+          captured_func_(std::move(captured_func)),
+          cycle_length_(cycle_length),
+          block_length_(block_length),
+          sloppy_(sloppy),
+          buffer_output_elements_(buffer_output_elements),
+          ctx_params_(std::move(ctx_params)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return "ParallelInterleaveDatasetOp::Dataset";
+    }
+
+   private:
+    // Interleaves the elements of the datasets returned by `f` as
+    // InterleaveDatasetOp does, but each of the `cycle_length` positions of
+    // the cycle has a worker thread that reads up to `buffer_output_elements`
+    // ahead from its dataset.
+    //
+    // In the deterministic mode, the output order is the same as that of
+    // InterleaveDatasetOp. In the sloppy mode, when the worker of the current
+    // position has no buffered element, an element of another worker is
+    // returned instead of waiting.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()),
+            workers_(dataset->cycle_length_) {}
+
+      ~Iterator() override {
+        // Signal the worker threads, if any, so that they terminate. We will
+        // then join those threads when we delete `this->worker_threads_`.
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureWorkerThreadsStarted(ctx);
+
+        while (true) {
+          if (cancelled_) {
+            return errors::Cancelled(
+                "ParallelInterleaveDatasetOp::Dataset::Iterator::GetNext");
+          }
+          WorkerState* current = &workers_[cycle_index_];
+          if (!current->outputs.empty()) {
+            // Produce the next buffered subelement of the current position.
+            const Status s = TakeOutput(current, out_tensors);
+            if (s.ok()) {
+              AdvancePosition();
+            }
+            *end_of_sequence = false;
+            return s;
+          }
+          if (current->is_active && current->is_producing) {
+            // The worker has not produced the next subelement yet.
+            if (dataset()->sloppy_) {
+              for (WorkerState& worker : workers_) {
+                if (!worker.outputs.empty()) {
+                  *end_of_sequence = false;
+                  return TakeOutput(&worker, out_tensors);
+                }
+              }
+            }
+            cond_var_.wait(l);
+          } else if (current->is_active) {
+            // We have reached the end of the current element, so move on to
+            // the next element in the cycle.
+            current->is_active = false;
+            --num_active_;
+            AdvanceToNextInCycle();
+          } else if (!end_of_input_) {
+            // Get the next element from the input dataset, and hand it to
+            // the worker of the current position.
+            std::vector<Tensor> args;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &args, &end_of_input_));
+            if (!end_of_input_) {
+              current->input = std::move(args);
+              current->is_active = true;
+              current->is_producing = true;
+              ++num_active_;
+              cond_var_.notify_all();
+              // Also start the elements of the positions ahead in the cycle
+              // that are empty, which InterleaveDatasetOp would get next in
+              // the same order, so that their workers read ahead.
+              TF_RETURN_IF_ERROR(StartElementsAhead(ctx));
+            }
+          } else if (num_active_ == 0) {
+            *end_of_sequence = true;
+            return Status::OK();
+          } else {
+            AdvanceToNextInCycle();
+          }
+        }
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        // Stop the workers from making progress, and wait for those that are
+        // busy, so that the state of every worker is consistent.
+        ++num_saves_;
+        while (AnyWorkerBusy()) {
+          cond_var_.wait(l);
+        }
+        Status s = SaveLocked(prefix, writer);
+        --num_saves_;
+        cond_var_.notify_all();
+        return s;
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (!worker_threads_.empty()) {
+          return errors::FailedPrecondition(
+              "Cannot restore an iterator that has already been used.");
+        }
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 cycle_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/cycle_index"), &cycle_index));
+        if (cycle_index < 0 || cycle_index >= dataset()->cycle_length_) {
+          return errors::DataLoss("Invalid iterator state: cycle index ",
+                                  cycle_index, " is out of range.");
+        }
+        cycle_index_ = cycle_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/block_index"), &block_index_));
+        int64 flag;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &flag));
+        end_of_input_ = flag != 0;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/initial_elements_started"), &flag));
+        initial_elements_started_ = flag != 0;
+        num_active_ = 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+          TF_RETURN_IF_ERROR(RestoreWorker(
+              ctx, strings::StrCat(prefix, "/worker_", i), reader,
+              &workers_[i]));
+          if (workers_[i].is_active) {
+            ++num_active_;
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      // A subelement produced by a worker, or the error from producing it.
+      struct OutputElement {
+        Status status;
+        std::vector<Tensor> output;
+      };
+
+      // The state of a position in the cycle, and of its worker thread.
+      struct WorkerState {
+        // True from when an input element is handed to the worker, until the
+        // consumer has taken all of the subelements of that element.
+        bool is_active = false;
+        // True from when an input element is handed to the worker, until the
+        // worker reaches the end of that element.
+        bool is_producing = false;
+        // The input element, until the worker takes it.
+        std::vector<Tensor> input;
+        // The input element that the worker has taken, and the iterator
+        // that it created from it, while the worker is producing.
+        std::vector<Tensor> element_args;
+        std::unique_ptr<IteratorBase> iterator;
+        // True while the worker creates or uses `iterator` without holding
+        // the lock.
+        bool is_busy = false;
+        // The subelements produced, not yet taken by the consumer.
+        std::deque<OutputElement> outputs;
+      };
+
+      bool AnyWorkerBusy() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (const WorkerState& worker : workers_) {
+          if (worker.is_busy) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      // Returns true if `worker` has an input element to start, or an
+      // iterator to read from and space in its buffer.
+      bool CanMakeProgress(const WorkerState& worker)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (num_saves_ > 0 || !worker.is_producing) {
+          return false;
+        }
+        if (worker.iterator) {
+          return worker.outputs.size() < dataset()->buffer_output_elements_;
+        }
+        return !worker.input.empty();
+      }
+
+      Status SaveLocked(const string& prefix, IteratorStateWriter* writer)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/cycle_index"), cycle_index_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/block_index"), block_index_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/end_of_input"), end_of_input_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/initial_elements_started"),
+            initial_elements_started_ ? 1 : 0));
+        for (size_t i = 0; i < workers_.size(); ++i) {
+          TF_RETURN_IF_ERROR(SaveWorker(strings::StrCat(prefix, "/worker_", i),
+                                        workers_[i], writer));
+        }
+        return Status::OK();
+      }
+
+      Status SaveWorker(const string& prefix, const WorkerState& worker,
+                        IteratorStateWriter* writer)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/is_active"), worker.is_active ? 1 : 0));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/is_producing"),
+                                worker.is_producing ? 1 : 0));
+        TF_RETURN_IF_ERROR(writer->WriteElement(
+            strings::StrCat(prefix, "/input"), worker.input));
+        TF_RETURN_IF_ERROR(dataset::SaveElementIterator(
+            strings::StrCat(prefix, "/element"), worker.element_args,
+            worker.iterator.get(), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/outputs.size"),
+                                static_cast<int64>(worker.outputs.size())));
+        for (size_t i = 0; i < worker.outputs.size(); ++i) {
+          const string output_prefix =
+              strings::StrCat(prefix, "/outputs[", i, "]");
+          TF_RETURN_IF_ERROR(
+              writer->WriteStatus(strings::StrCat(output_prefix, "/status"),
+                                  worker.outputs[i].status));
+          TF_RETURN_IF_ERROR(
+              writer->WriteElement(strings::StrCat(output_prefix, "/output"),
+                                   worker.outputs[i].output));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreWorker(IteratorContext* ctx, const string& prefix,
+                           IteratorStateReader* reader, WorkerState* worker)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        int64 flag;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(prefix, "/is_active"), &flag));
+        worker->is_active = flag != 0;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/is_producing"), &flag));
+        worker->is_producing = flag != 0;
+        TF_RETURN_IF_ERROR(reader->ReadElement(
+            strings::StrCat(prefix, "/input"), &worker->input));
+        TF_RETURN_IF_ERROR(dataset::RestoreElementIterator(
+            ctx, strings::StrCat(prefix, "/element"),
+            dataset()->captured_func_.get(), reader, &worker->element_args,
+            &worker->iterator));
+        int64 num_outputs;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/outputs.size"), &num_outputs));
+        worker->outputs.clear();
+        for (int64 i = 0; i < num_outputs; ++i) {
+          const string output_prefix =
+              strings::StrCat(prefix, "/outputs[", i, "]");
+          OutputElement element;
+          TF_RETURN_IF_ERROR(reader->ReadStatus(
+              strings::StrCat(output_prefix, "/status"), &element.status));
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(output_prefix, "/output"), &element.output));
+          worker->outputs.push_back(std::move(element));
+        }
+        return Status::OK();
+      }
+
+      void EnsureWorkerThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (worker_threads_.empty()) {
+          for (int64 i = 0; i < dataset()->cycle_length_; ++i) {
+            worker_threads_.emplace_back(ctx->env()->StartThread(
+                {}, "parallel_interleave_worker",
+                [this, i]() { WorkerThread(i); }));
+          }
+        }
+      }
+
+      // Starts the next input elements in the empty positions that follow
+      // the current one, up to the first position that is still active.
+      // Until the cycle wraps around, InterleaveDatasetOp visits those
+      // positions in order and would start the same elements in them.
+      Status StartElementsAhead(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!initial_elements_started_) {
+          for (int64 i = cycle_index_ + 1;
+               i < dataset()->cycle_length_ && !end_of_input_; ++i) {
+            WorkerState* worker = &workers_[i];
+            if (worker->is_active) break;
+            std::vector<Tensor> args;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &args, &end_of_input_));
+            if (!end_of_input_) {
+              worker->input = std::move(args);
+              worker->is_active = true;
+              worker->is_producing = true;
+              ++num_active_;
+            }
+          }
+          initial_elements_started_ = true;
+          cond_var_.notify_all();
+        }
+        return Status::OK();
+      }
+
+      Status TakeOutput(WorkerState* worker, std::vector<Tensor>* out_tensors)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        OutputElement& element = worker->outputs.front();
+        Status s = element.status;
+        if (s.ok()) {
+          *out_tensors = std::move(element.output);
+        }
+        worker->outputs.pop_front();
+        // Wake the worker, in case it has been waiting for space in its
+        // buffer.
+        cond_var_.notify_all();
+        return s;
+      }
+
+      void AdvanceToNextInCycle() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        block_index_ = 0;
+        cycle_index_ = (cycle_index_ + 1) % dataset()->cycle_length_;
+      }
+
+      void AdvancePosition() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        ++block_index_;
+        if (block_index_ == dataset()->block_length_) {
+          AdvanceToNextInCycle();
+        }
+      }
+
+      void WorkerThread(int64 worker_index) {
+        WorkerState* worker;
+        {
+          mutex_lock l(mu_);
+          worker = &workers_[worker_index];
+        }
+        while (true) {
+          // 1. Wait for an input element, or for space in the buffer if the
+          // worker is reading the subelements of an element.
+          IteratorBase* iterator;
+          std::vector<Tensor> input;
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && !CanMakeProgress(*worker)) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) return;
+            iterator = worker->iterator.get();
+            if (iterator == nullptr) {
+              worker->element_args.swap(worker->input);
+              worker->input.clear();
+              input = worker->element_args;
+            }
+            worker->is_busy = true;
+          }
+
+          if (iterator == nullptr) {
+            // 2a. Create an iterator over the dataset that `f` returns for
+            // the input element.
+            std::unique_ptr<IteratorBase> new_iterator;
+            Status s = dataset::MakeIteratorFromInputElement(
+                &iter_ctx_, input, dataset()->captured_func_.get(),
+                &new_iterator);
+            mutex_lock l(mu_);
+            worker->is_busy = false;
+            if (s.ok()) {
+              worker->iterator = std::move(new_iterator);
+            } else {
+              worker->outputs.push_back({s, {}});
+              worker->element_args.clear();
+              worker->is_producing = false;
+            }
+            cond_var_.notify_all();
+            continue;
+          }
+
+          // 2b. Read the next subelement. Only this worker uses `iterator`,
+          // and `Save()` waits until it is no longer busy.
+          OutputElement element;
+          bool end_of_element;
+          element.status =
+              iterator->GetNext(&iter_ctx_, &element.output, &end_of_element);
+
+          // 3. Signal that the subelement has been produced, or that the
+          // element is exhausted.
+          mutex_lock l(mu_);
+          worker->is_busy = false;
+          if (element.status.ok() && end_of_element) {
+            worker->iterator.reset();
+            worker->element_args.clear();
+            worker->is_producing = false;
+          } else {
+            worker->outputs.push_back(std::move(element));
+          }
+          cond_var_.notify_all();
+        }
+      }
+
+      IteratorContext iter_ctx_;
+      mutex mu_;
+      condition_variable cond_var_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::vector<WorkerState> workers_ GUARDED_BY(mu_);
+      size_t cycle_index_ GUARDED_BY(mu_) = 0;
+      int64 block_index_ GUARDED_BY(mu_) = 0;
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool initial_elements_started_ GUARDED_BY(mu_) = false;
+      size_t num_active_ GUARDED_BY(mu_) = 0;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      // The number of calls to `Save()` that are waiting for the busy
+      // workers, during which no worker makes progress.
+      int64 num_saves_ GUARDED_BY(mu_) = 0;
+      // Declared last, so that the threads are joined before the state that
+      // they use is destroyed.
+      std::vector<std::unique_ptr<Thread>> worker_threads_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+    const int64 cycle_length_;
+    const int64 block_length_;
+    const bool sloppy_;
+    const int64 buffer_output_elements_;
+    const IteratorContext::Params ctx_params_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParallelInterleaveDataset").Device(DEVICE_CPU),
+                        ParallelInterleaveDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <deque>
+#include <memory>
 
 #include "tensorflow/core/kernels/dataset.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -36,6 +37,7 @@ class ParallelMapDatasetOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sloppy", &sloppy_));
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -67,17 +69,9 @@ class ParallelMapDatasetOp : public OpKernel {
         ctx, TensorShapeUtils::IsScalar(output_buffer_size_t->shape()),
         errors::InvalidArgument("output_buffer_size must be a scalar."));
     const int64 output_buffer_size = output_buffer_size_t->flat<int64>()(0);
-
-    // TODO(mrry): Relax this requirement? If the output buffer owns
-    // the (tuples of) tensors into which `f` writes its output, it
-    // seems like this constraint would make it easier to (i)
-    // constrain the memory usage of the iterator, and (ii) enforce a
-    // consistent ordering between input and output.
-    OP_REQUIRES(ctx, output_buffer_size >= num_threads,
+    OP_REQUIRES(ctx, output_buffer_size > 0,
                 errors::InvalidArgument(
-                    "output_buffer_size (", output_buffer_size,
-                    ") must be greater than or equal to num_threads (",
-                    num_threads, ")."));
+                    "output_buffer_size must be greater than zero."));
 
     std::unique_ptr<CapturedFunction> captured_func;
     OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
@@ -97,9 +91,9 @@ class ParallelMapDatasetOp : public OpKernel {
     params.resource_manager = ctx->resource_manager();
     params.runner = *(ctx->runner());
 
-    DatasetBase* dataset =
-        new Dataset(input, num_threads, output_buffer_size, std::move(params),
-                    output_types_, output_shapes_, std::move(captured_func));
+    DatasetBase* dataset = new Dataset(
+        input, num_threads, output_buffer_size, sloppy_, std::move(params),
+        output_types_, output_shapes_, std::move(captured_func));
 
     Tensor* output = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -113,13 +107,15 @@ class ParallelMapDatasetOp : public OpKernel {
   class Dataset : public DatasetBase {
    public:
     Dataset(const DatasetBase* input, int32 num_threads,
-            int64 output_buffer_size, IteratorContext::Params ctx_params,
+            int64 output_buffer_size, bool sloppy,
+            IteratorContext::Params ctx_params,
             const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes,
             std::unique_ptr<CapturedFunction> captured_func)
         : input_(input),
           num_threads_(num_threads),
           output_buffer_size_(output_buffer_size),
+          sloppy_(sloppy),
           ctx_params_(std::move(ctx_params)),
           output_types_(output_types),
           output_shapes_(output_shapes),
@@ -143,190 +139,271 @@ class ParallelMapDatasetOp : public OpKernel {
     string DebugString() override { return "ParallelMapDatasetOp::Dataset"; }
 
    private:
+    // Runs up to `num_threads` calls to `f` at a time, asynchronously on the
+    // session's inter-op thread pool, and buffers up to `output_buffer_size`
+    // elements whose calls are in progress or complete. A call completes
+    // independently of the calls for the elements before it, so the next
+    // call can start as soon as any call completes and there is space in the
+    // buffer. In the sloppy mode, any completed element is returned, so a
+    // slow element does not hold up the elements after it.
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Dataset* dataset)
           : DatasetIterator<Dataset>(dataset),
             iter_ctx_(dataset->ctx_params_),
-            input_impl_(dataset->input_->MakeIterator()) {}
+            input_impl_(dataset->input_->MakeIterator()) {
+        // Choose a step ID that is guaranteed not to clash with any
+        // Session-generated step ID. DirectSession only generates
+        // non-negative step IDs (contiguous, starting from 0), and
+        // MasterSession generates 56-bit random step IDs whose MSB
+        // is always 0, so a negative random step ID should suffice.
+        f_opts_.step_id = -std::abs(static_cast<int64>(random::New64()));
+        f_opts_.runner = iter_ctx_.runner();
+      }
 
       ~Iterator() override {
-        // Signal the mapper threads, if any, so that they terminate.
-        // We will then join those threads when we delete
-        // `this->mapper_threads_`.
+        // Stop starting new calls, and wait for the calls and the call
+        // starter in progress, which refer to `this`, to complete.
         //
         // TODO(mrry): Replace this cancellation logic with a
-        // CancellationManager. The syntax would be more heavyweight,
-        // but it would be possible to thread a cancellation manager
-        // through the IteratorContext to upstream,
-        // potentially-blocking iterators, when we add these.
-        {
-          mutex_lock l(output_mu_);
-          cancelled_ = true;
-          cond_var_.notify_all();
+        // CancellationManager, so that we can also cancel the calls in
+        // progress, and thread it through the IteratorContext to
+        // upstream, potentially-blocking iterators, when we add these.
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        while (num_calls_ > 0 || call_starter_active_) {
+          cond_var_.wait(l);
         }
       }
 
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                      bool* end_of_sequence) override {
-        mutex_lock l(output_mu_);
-        TF_RETURN_IF_ERROR(EnsureMapperThreadsStarted(ctx));
-
         while (true) {
-          // 1. Wait until the next element in the output queue has
-          // been produced, or we are shutting down.
-          while (
-              !cancelled_ && active_threads_ > 0 &&
-              (output_buffer_.empty() || !output_buffer_.front().is_produced)) {
-            cond_var_.wait(l);
-          }
+          bool start_calls = false;
+          {
+            mutex_lock l(mu_);
+            // 1. Return the next completed element, if any.
+            for (auto it = invocation_results_.begin();
+                 it != invocation_results_.end(); ++it) {
+              if ((*it)->is_ready) {
+                Status s = (*it)->status;
+                if (s.ok()) {
+                  *out_tensors = std::move((*it)->return_values);
+                }
+                invocation_results_.erase(it);
+                *end_of_sequence = false;
+                MaybeScheduleCallStarter();
+                return s;
+              }
+              if (!dataset()->sloppy_) {
+                // Elements are returned in order, so we must wait for the
+                // first one.
+                break;
+              }
+            }
 
-          if (cancelled_) {
-            return errors::Cancelled(
-                "ParallelMapDatasetOp::Dataset::Iterator::GetNext");
-          }
+            if (invocation_results_.empty() && end_of_input_) {
+              *end_of_sequence = true;
+              return Status::OK();
+            }
 
-          if (!output_buffer_.empty() && output_buffer_.front().is_produced) {
-            // A new output element is available. Forward the status
-            // from computing it, and (if we successfully got an
-            // element) the output values.
-            Status s = output_buffer_.front().output_status;
-            if (s.ok()) {
-              *out_tensors = std::move(output_buffer_.front().output_value);
+            // 2. If there is room for another call, start it in this
+            // thread, because we would otherwise wait for it. Otherwise,
+            // wait until an element completes.
+            if (!call_starter_active_ && CanStartCall()) {
+              call_starter_active_ = true;
+              start_calls = true;
+            } else {
+              cond_var_.wait(l);
             }
-            output_buffer_.pop_front();
-            *end_of_sequence = false;
-
-            // Wake one of the producing threads, in case they have been
-            // waiting for space in the queue.
-            cond_var_.notify_one();
-            return s;
-          } else if (active_threads_ == 0) {
-            *end_of_sequence = true;
-            return Status::OK();
           }
+          if (start_calls) {
+            StartCalls();
+          }
+        }
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        // Stop starting new calls, and wait for the calls in progress to
+        // complete, so that every invocation result is ready and consistent
+        // with the state of the input.
+        ++num_saves_;
+        while (num_calls_ > 0 || call_starter_active_) {
+          cond_var_.wait(l);
         }
+        Status s = SaveLocked(prefix, writer);
+        --num_saves_;
+        MaybeScheduleCallStarter();
+        cond_var_.notify_all();
+        return s;
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (num_calls_ > 0 || call_starter_active_ ||
+            !invocation_results_.empty()) {
+          return errors::FailedPrecondition(
+              "Cannot restore an iterator that has already been used.");
+        }
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        end_of_input_ = end_of_input != 0;
+        int64 num_results;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/invocation_results.size"),
+            &num_results));
+        for (int64 i = 0; i < num_results; ++i) {
+          const string result_prefix =
+              strings::StrCat(prefix, "/invocation_results[", i, "]");
+          auto result = std::make_shared<InvocationResult>();
+          TF_RETURN_IF_ERROR(reader->ReadStatus(
+              strings::StrCat(result_prefix, "/status"), &result->status));
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(result_prefix, "/return_values"),
+              &result->return_values));
+          result->is_ready = true;
+          invocation_results_.push_back(std::move(result));
+        }
+        return Status::OK();
       }
 
      private:
-      // An output queue element comprises a bool (which indicates
-      // whether the element has been produced yet) and a vector of
-      // tensors (which contains the tuple of tensors if the bool is
-      // true).
-      struct OutputQueueElement {
-        // The producer must set `is_produced` to `true` after
-        // `output_status` or `output_value` has been written.
-        bool is_produced = false;
-        // The producer sets `output_status` if either getting the
-        // input element or applying the mapper function to it fails.
-        Status output_status;
+      // The result of a call to `f`, which becomes ready when the call
+      // completes.
+      struct InvocationResult {
+        // The producer must set `is_ready` to `true` after `status` or
+        // `return_values` has been written.
+        bool is_ready = false;
+        // Set if either getting the input element or applying `f` to it
+        // fails.
+        Status status;
         // The mapped data element.
-        std::vector<Tensor> output_value;
+        std::vector<Tensor> return_values;
       };
 
-      Status EnsureMapperThreadsStarted(IteratorContext* ctx)
-          EXCLUSIVE_LOCKS_REQUIRED(output_mu_) {
-        if (mapper_threads_.empty()) {
-          // Choose a step ID that is guaranteed not to clash with any
-          // Session-generated step ID. DirectSession only generates
-          // non-negative step IDs (contiguous, starting from 0), and
-          // MasterSession generates 56-bit random step IDs whose MSB
-          // is always 0, so a negative random step ID should suffice.
-          f_opts_.step_id = -std::abs(static_cast<int64>(random::New64()));
-          f_opts_.runner = iter_ctx_.runner();
-
-          active_threads_ = dataset()->num_threads_;
-          for (int i = 0; i < dataset()->num_threads_; ++i) {
-            mapper_threads_.emplace_back(
-                std::unique_ptr<Thread>(ctx->env()->StartThread(
-                    {}, "mapper_thread", [this]() { MapperThread(); })));
-          }
+      Status SaveLocked(const string& prefix, IteratorStateWriter* writer)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/end_of_input"), end_of_input_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(prefix, "/invocation_results.size"),
+            static_cast<int64>(invocation_results_.size())));
+        for (size_t i = 0; i < invocation_results_.size(); ++i) {
+          const string result_prefix =
+              strings::StrCat(prefix, "/invocation_results[", i, "]");
+          TF_RETURN_IF_ERROR(
+              writer->WriteStatus(strings::StrCat(result_prefix, "/status"),
+                                  invocation_results_[i]->status));
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(result_prefix, "/return_values"),
+              invocation_results_[i]->return_values));
         }
         return Status::OK();
       }
 
-      void MapperThread() {
-        while (true) {
-          OutputQueueElement* output_queue_element_;
-
-          std::vector<Tensor> input_args;
-          std::vector<Tensor> output_value;
+      bool CanStartCall() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return !cancelled_ && !end_of_input_ && num_saves_ == 0 &&
+               num_calls_ < dataset()->num_threads_ &&
+               invocation_results_.size() < dataset()->output_buffer_size_;
+      }
 
-          Status s;
+      // Schedules `StartCalls()` on the inter-op thread pool, unless it is
+      // already active or there is no room for another call.
+      void MaybeScheduleCallStarter() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!call_starter_active_ && CanStartCall()) {
+          call_starter_active_ = true;
+          (*iter_ctx_.runner())([this]() { StartCalls(); });
+        }
+      }
 
-          // 1. Acquire a slot in the output queue and a corresponding input
-          // element.
+      // Gets input elements, and starts a call to `f` for each of them,
+      // until there is no room for another call. At most one call starter
+      // is active at a time, and only the active call starter calls
+      // `input_impl_->GetNext()`, which preserves the order of the input
+      // elements in `invocation_results_`.
+      void StartCalls() {
+        while (true) {
+          std::shared_ptr<InvocationResult> result;
           {
-            // First acquire the input lock. Only one MapperThread may
-            // call GetNext() on the input iterator at a time, to
-            // preserve the ordering of elements.
-            mutex_lock input_lock(input_mu_);
-            {
-              // This MapperThread is now responsible for producing
-              // the next element in the output queue. We acquire a
-              // slot in the output queue atomically, which may block,
-              // but we deliberately do not release input_mu_ to
-              // prevent another MapperThread from overtaking us.
-              mutex_lock output_lock(output_mu_);
-              while (!cancelled_ &&
-                     output_buffer_.size() == dataset()->output_buffer_size_) {
-                cond_var_.wait(output_lock);
-              }
-
-              if (cancelled_) {
-                --active_threads_;
-                return;
-              }
-
-              output_buffer_.push_back(OutputQueueElement());
-              output_queue_element_ = &output_buffer_.back();
-            }
-
-            bool end_of_sequence;
-            s = input_impl_->GetNext(&iter_ctx_, &input_args, &end_of_sequence);
-            if (s.ok() && end_of_sequence) {
-              mutex_lock output_lock(output_mu_);
-              --active_threads_;
-              if (active_threads_ == 0) {
-                cond_var_.notify_all();
-              }
+            mutex_lock l(mu_);
+            if (!CanStartCall()) {
+              call_starter_active_ = false;
+              cond_var_.notify_all();
               return;
             }
+            result = std::make_shared<InvocationResult>();
+            invocation_results_.push_back(result);
+            ++num_calls_;
           }
 
-          if (s.ok()) {
-            s = dataset()->captured_func_->Run(f_opts_, input_args,
-                                               &output_value);
+          std::vector<Tensor> input_element;
+          bool end_of_input = false;
+          Status s =
+              input_impl_->GetNext(&iter_ctx_, &input_element, &end_of_input);
+          if (s.ok() && !end_of_input) {
+            CallFunction(result, std::move(input_element));
+            continue;
           }
 
-          // 3. Signal that the element has been produced.
-          {
-            mutex_lock output_lock(output_mu_);
-            output_queue_element_->output_status.Update(s);
-            output_queue_element_->is_produced = true;
-            std::swap(output_queue_element_->output_value, output_value);
-            cond_var_.notify_all();
+          mutex_lock l(mu_);
+          --num_calls_;
+          if (s.ok()) {
+            // No calls have been added since `result`, and it is not
+            // ready, so it is still the last invocation result.
+            DCHECK(invocation_results_.back() == result);
+            invocation_results_.pop_back();
+            end_of_input_ = true;
+          } else {
+            result->status = s;
+            result->is_ready = true;
           }
+          cond_var_.notify_all();
         }
       }
 
+      void CallFunction(const std::shared_ptr<InvocationResult>& result,
+                        std::vector<Tensor> input_element) {
+        dataset()->captured_func_->RunAsync(
+            f_opts_, std::move(input_element), &result->return_values,
+            [this, result](Status s) {
+              mutex_lock l(mu_);
+              result->status.Update(s);
+              result->is_ready = true;
+              --num_calls_;
+              MaybeScheduleCallStarter();
+              cond_var_.notify_all();
+            });
+      }
+
       IteratorContext iter_ctx_;
-      mutex input_mu_;
-      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(input_mu_);
       FunctionLibraryRuntime::Options f_opts_;
-      mutex output_mu_;
+      // Only the active call starter uses `input_impl_`.
+      const std::unique_ptr<IteratorBase> input_impl_;
+      mutex mu_;
       condition_variable cond_var_;
-      std::deque<OutputQueueElement> output_buffer_ GUARDED_BY(output_mu_);
-      std::vector<std::unique_ptr<Thread>> mapper_threads_
-          GUARDED_BY(output_mu_);
-      bool cancelled_ GUARDED_BY(output_mu_) = false;
-      int32 active_threads_ GUARDED_BY(output_mu_);
+      std::deque<std::shared_ptr<InvocationResult>> invocation_results_
+          GUARDED_BY(mu_);
+      int64 num_calls_ GUARDED_BY(mu_) = 0;
+      bool call_starter_active_ GUARDED_BY(mu_) = false;
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      // The number of calls to `Save()` that are waiting for the calls in
+      // progress to complete, during which no new calls are started.
+      int64 num_saves_ GUARDED_BY(mu_) = 0;
     };
 
     const DatasetBase* const input_;
     const NameAttrList func_;
     const int32 num_threads_;
     const int64 output_buffer_size_;
+    const bool sloppy_;
     const IteratorContext::Params ctx_params_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
@@ -337,6 +414,7 @@ class ParallelMapDatasetOp : public OpKernel {
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   const NameAttrList* func_;
+  bool sloppy_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParallelMapDataset").Device(DEVICE_CPU),
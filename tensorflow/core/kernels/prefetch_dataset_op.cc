@@ -0,0 +1,289 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class PrefetchDatasetOp : public OpKernel {
+ public:
+  explicit PrefetchDatasetOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    DatasetBase* input;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &input));
+    core::ScopedUnref unref_input(input);
+
+    const Tensor* buffer_size_t;
+    OP_REQUIRES_OK(ctx, ctx->input("buffer_size", &buffer_size_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(buffer_size_t->shape()),
+                errors::InvalidArgument("buffer_size must be a scalar"));
+    const int64 buffer_size = buffer_size_t->flat<int64>()(0);
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    // The prefetch thread outlives this kernel's OpKernelContext, so we
+    // capture the params from it as ParallelMapDatasetOp does.
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    DatasetBase* dataset = new Dataset(input, buffer_size, std::move(params));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->flat<ResourceHandle>()(0) = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size,
+            IteratorContext::Params ctx_params)
+        : input_(input),
+          buffer_size_(buffer_size),
+          ctx_params_(std::move(ctx_params)) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "PrefetchDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the prefetch thread, if any, so that it terminates.
+        // We will then join that thread when we delete
+        // `this->prefetch_thread_`. The thread finishes any call to
+        // `input_impl_->GetNext()` that is in progress first.
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsurePrefetchThreadStarted(ctx);
+
+        // Wait until the next element in the buffer has been produced, or
+        // we are shutting down.
+        while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_) {
+          cond_var_.wait(l);
+        }
+
+        if (cancelled_) {
+          return errors::Cancelled(
+              "PrefetchDatasetOp::Dataset::Iterator::GetNext");
+        }
+
+        if (!buffer_.empty()) {
+          // Forward the status from getting the element, and (if we
+          // successfully got an element) the output values.
+          Status s = buffer_.front().status;
+          if (s.ok()) {
+            *out_tensors = std::move(buffer_.front().value);
+          }
+          buffer_.pop_front();
+          *end_of_sequence = false;
+
+          // Wake the prefetch thread, in case it has been waiting for
+          // space in the buffer.
+          cond_var_.notify_all();
+          return s;
+        }
+
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        // Wait until the prefetch thread is not getting an element, so that
+        // the state of the input and the buffer are consistent. The thread
+        // cannot start getting another element while we hold `mu_`.
+        while (input_busy_) {
+          cond_var_.wait(l);
+        }
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/end_of_input"),
+                                prefetch_thread_finished_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/buffer.size"),
+                                static_cast<int64>(buffer_.size())));
+        for (size_t i = 0; i < buffer_.size(); ++i) {
+          const string element_prefix =
+              strings::StrCat(prefix, "/buffer[", i, "]");
+          TF_RETURN_IF_ERROR(writer->WriteStatus(
+              strings::StrCat(element_prefix, "/status"), buffer_[i].status));
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(element_prefix, "/value"), buffer_[i].value));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (prefetch_thread_) {
+          return errors::FailedPrecondition(
+              "Cannot restore an iterator that has already been used.");
+        }
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        prefetch_thread_finished_ = end_of_input != 0;
+        int64 buffer_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/buffer.size"), &buffer_size));
+        buffer_.clear();
+        for (int64 i = 0; i < buffer_size; ++i) {
+          const string element_prefix =
+              strings::StrCat(prefix, "/buffer[", i, "]");
+          BufferElement buffer_element;
+          TF_RETURN_IF_ERROR(reader->ReadStatus(
+              strings::StrCat(element_prefix, "/status"),
+              &buffer_element.status));
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(element_prefix, "/value"),
+              &buffer_element.value));
+          buffer_.push_back(std::move(buffer_element));
+        }
+        return Status::OK();
+      }
+
+     private:
+      // A buffer element comprises a status and (if that status is OK) a
+      // vector of tensors, representing an element of the input dataset.
+      struct BufferElement {
+        // The producer sets `status` if getting the input element fails.
+        Status status;
+        // The element in the input dataset.
+        std::vector<Tensor> value;
+      };
+
+      void EnsurePrefetchThreadStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!prefetch_thread_ && !prefetch_thread_finished_) {
+          prefetch_thread_.reset(ctx->env()->StartThread(
+              {}, "prefetch_thread", [this]() { PrefetchThread(); }));
+        }
+      }
+
+      // Gets elements from `input_impl_` ahead of their consumption, until
+      // the input is exhausted or the iterator is destroyed. An error does
+      // not end the sequence: it is returned from the corresponding call to
+      // `GetNext()`, as it would be without prefetching.
+      void PrefetchThread() {
+        while (true) {
+          // 1. Wait for a slot in the buffer.
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && buffer_.size() == dataset()->buffer_size_) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            input_busy_ = true;
+          }
+
+          // 2. Get the next element from the input, without holding the
+          // lock, so that the consumer can take buffered elements
+          // meanwhile. Only this thread calls `input_impl_->GetNext()`.
+          BufferElement buffer_element;
+          bool end_of_sequence;
+          buffer_element.status = input_impl_->GetNext(
+              &iter_ctx_, &buffer_element.value, &end_of_sequence);
+
+          // 3. Signal that the element has been produced, or that the input
+          // is exhausted.
+          {
+            mutex_lock l(mu_);
+            input_busy_ = false;
+            if (buffer_element.status.ok() && end_of_sequence) {
+              prefetch_thread_finished_ = true;
+              cond_var_.notify_all();
+              return;
+            }
+            buffer_.push_back(std::move(buffer_element));
+            cond_var_.notify_all();
+          }
+        }
+      }
+
+      IteratorContext iter_ctx_;
+      const std::unique_ptr<IteratorBase> input_impl_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+      // True while the prefetch thread is getting an element from the input.
+      bool input_busy_ GUARDED_BY(mu_) = false;
+      // Declared last, so that the thread is joined before the state that
+      // it uses is destroyed.
+      std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const IteratorContext::Params ctx_params_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("PrefetchDataset").Device(DEVICE_CPU),
+                        PrefetchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
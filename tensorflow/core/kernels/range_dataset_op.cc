@@ -109,6 +109,17 @@ class RangeDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(strings::StrCat(prefix, "/next"), next_);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return reader->ReadScalar(strings::StrCat(prefix, "/next"), &next_);
+      }
+
      private:
       mutex mu_;
       int64 next_;
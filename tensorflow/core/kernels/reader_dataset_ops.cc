@@ -14,9 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/dataset.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
-#include "tensorflow/core/lib/io/inputbuffer.h"
+#include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 
 namespace tensorflow {
@@ -26,9 +31,83 @@ namespace {
 // See documentation in ../ops/dataset_ops.cc for a high-level
 // description of the following ops.
 
+// Restores the index of the file that a reader iterator is reading, which
+// must be in the range [0, `num_files`], or [0, `num_files`) if the iterator
+// saved its position in that file under `position_key`.
+Status RestoreFileIndex(const string& prefix, const string& position_key,
+                        size_t num_files, IteratorStateReader* reader,
+                        size_t* file_index) {
+  int64 index;
+  TF_RETURN_IF_ERROR(reader->ReadScalar(
+      strings::StrCat(prefix, "/current_file_index"), &index));
+  const int64 limit = static_cast<int64>(num_files);
+  if (index < 0 || index > limit ||
+      (index == limit && reader->Contains(position_key))) {
+    return errors::DataLoss("Invalid iterator state: file index ", index,
+                            " is out of range.");
+  }
+  *file_index = index;
+  return Status::OK();
+}
+
+// Reads the `buffer_size` and `read_ahead_blocks` attrs of a reader dataset
+// op, whose ranges the op definition checks.
+Status GetBufferAttrs(OpKernelConstruction* ctx, int64* buffer_size,
+                      int64* read_ahead_blocks) {
+  TF_RETURN_IF_ERROR(ctx->GetAttr("buffer_size", buffer_size));
+  return ctx->GetAttr("read_ahead_blocks", read_ahead_blocks);
+}
+
+// Reads a file sequentially through a buffer of `buffer_size` bytes. If
+// `read_ahead_blocks` > 0, up to that many further blocks of `buffer_size`
+// bytes are read ahead of the buffer on a background thread, so that
+// reading the file overlaps with processing its contents.
+class BufferedFileStream {
+ public:
+  BufferedFileStream(std::unique_ptr<RandomAccessFile> file, int64 buffer_size,
+                     int64 read_ahead_blocks, Env* env)
+      : file_(std::move(file)),
+        file_stream_(file_.get()),
+        read_ahead_stream_(read_ahead_blocks > 0
+                               ? new io::ReadAheadInputStream(
+                                     &file_stream_, buffer_size,
+                                     read_ahead_blocks, env)
+                               : nullptr),
+        buffered_stream_(read_ahead_stream_
+                             ? static_cast<io::InputStreamInterface*>(
+                                   read_ahead_stream_.get())
+                             : &file_stream_,
+                         buffer_size) {}
+
+  io::BufferedInputStream* stream() { return &buffered_stream_; }
+
+ private:
+  // Each stream reads the one declared before it, which must outlive it.
+  const std::unique_ptr<RandomAccessFile> file_;
+  io::RandomAccessInputStream file_stream_;
+  const std::unique_ptr<io::ReadAheadInputStream> read_ahead_stream_;
+  io::BufferedInputStream buffered_stream_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BufferedFileStream);
+};
+
+// Opens `filename` as a BufferedFileStream.
+Status OpenBufferedFile(Env* env, const string& filename, int64 buffer_size,
+                        int64 read_ahead_blocks,
+                        std::unique_ptr<BufferedFileStream>* out) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  out->reset(new BufferedFileStream(std::move(file), buffer_size,
+                                    read_ahead_blocks, env));
+  return Status::OK();
+}
+
 class TextLineDatasetOp : public OpKernel {
  public:
-  using OpKernel::OpKernel;
+  explicit TextLineDatasetOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx,
+                   GetBufferAttrs(ctx, &buffer_size_, &read_ahead_blocks_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor* filenames_tensor;
@@ -43,7 +122,8 @@ class TextLineDatasetOp : public OpKernel {
       filenames.push_back(filenames_tensor->flat<string>()(i));
     }
 
-    DatasetBase* dataset = new Dataset(std::move(filenames));
+    DatasetBase* dataset =
+        new Dataset(std::move(filenames), buffer_size_, read_ahead_blocks_);
     Tensor* output = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
     ResourceHandle handle = MakeResourceHandle<DatasetBase>(
@@ -55,8 +135,11 @@ class TextLineDatasetOp : public OpKernel {
  private:
   class Dataset : public DatasetBase {
    public:
-    explicit Dataset(std::vector<string> filenames)
-        : filenames_(std::move(filenames)) {}
+    Dataset(std::vector<string> filenames, int64 buffer_size,
+            int64 read_ahead_blocks)
+        : filenames_(std::move(filenames)),
+          buffer_size_(buffer_size),
+          read_ahead_blocks_(read_ahead_blocks) {}
 
     std::unique_ptr<IteratorBase> MakeIterator() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
@@ -86,9 +169,9 @@ class TextLineDatasetOp : public OpKernel {
         mutex_lock l(mu_);
         do {
           // We are currently processing a file, so try to read the next line.
-          if (input_buffer_) {
+          if (file_) {
             string line_contents;
-            Status s = input_buffer_->ReadLine(&line_contents);
+            Status s = file_->stream()->ReadLine(&line_contents);
             if (s.ok()) {
               // Produce the line as output.
               Tensor line_tensor(cpu_allocator(), DT_STRING, {});
@@ -103,7 +186,6 @@ class TextLineDatasetOp : public OpKernel {
 
             // We have reached the end of the current file, so maybe
             // move on to next file.
-            input_buffer_.reset();
             file_.reset();
             ++current_file_index_;
           }
@@ -115,26 +197,58 @@ class TextLineDatasetOp : public OpKernel {
           }
 
           // Actually move on to next file.
-          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
-              dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_.reset(new io::InputBuffer(file_.get(), kBufferSize));
+          TF_RETURN_IF_ERROR(OpenFile(ctx->env()));
         } while (true);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/current_file_index"),
+                                static_cast<int64>(current_file_index_)));
+        if (file_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(strings::StrCat(prefix, "/current_pos"),
+                                  file_->stream()->Tell()));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        const string pos_key = strings::StrCat(prefix, "/current_pos");
+        TF_RETURN_IF_ERROR(RestoreFileIndex(prefix, pos_key,
+                                            dataset()->filenames_.size(),
+                                            reader, &current_file_index_));
+        if (reader->Contains(pos_key)) {
+          int64 current_pos;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(pos_key, &current_pos));
+          TF_RETURN_IF_ERROR(OpenFile(ctx->env()));
+          TF_RETURN_IF_ERROR(file_->stream()->Seek(current_pos));
+        }
+        return Status::OK();
+      }
+
      private:
-      // TODO(mrry): Make this configurable via an attr on the dataset op?
-      // Or maybe via a data input?
-      enum { kBufferSize = 256 << 10 /* 256 kB */ };
+      Status OpenFile(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return OpenBufferedFile(
+            env, dataset()->filenames_[current_file_index_],
+            dataset()->buffer_size_, dataset()->read_ahead_blocks_, &file_);
+      }
 
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
-      std::unique_ptr<RandomAccessFile> file_
-          GUARDED_BY(mu_);  // must outlive input_buffer_
-      std::unique_ptr<io::InputBuffer> input_buffer_ GUARDED_BY(mu_);
+      std::unique_ptr<BufferedFileStream> file_ GUARDED_BY(mu_);
     };
 
     const std::vector<string> filenames_;
+    const int64 buffer_size_;
+    const int64 read_ahead_blocks_;
   };
+
+  int64 buffer_size_;
+  int64 read_ahead_blocks_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TextLineDataset").Device(DEVICE_CPU),
@@ -142,7 +256,11 @@ REGISTER_KERNEL_BUILDER(Name("TextLineDataset").Device(DEVICE_CPU),
 
 class FixedLengthRecordDatasetOp : public OpKernel {
  public:
-  using OpKernel::OpKernel;
+  explicit FixedLengthRecordDatasetOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx,
+                   GetBufferAttrs(ctx, &buffer_size_, &read_ahead_blocks_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor* filenames_tensor;
@@ -175,8 +293,9 @@ class FixedLengthRecordDatasetOp : public OpKernel {
                 errors::InvalidArgument("`footer_bytes` must be a scalar."));
     const int64 footer_bytes = footer_bytes_tensor->scalar<int64>()();
 
-    DatasetBase* dataset = new Dataset(std::move(filenames), header_bytes,
-                                       record_bytes, footer_bytes);
+    DatasetBase* dataset =
+        new Dataset(std::move(filenames), header_bytes, record_bytes,
+                    footer_bytes, buffer_size_, read_ahead_blocks_);
     Tensor* output = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
     ResourceHandle handle = MakeResourceHandle<DatasetBase>(
@@ -188,12 +307,15 @@ class FixedLengthRecordDatasetOp : public OpKernel {
  private:
   class Dataset : public DatasetBase {
    public:
-    explicit Dataset(std::vector<string> filenames, int64 header_bytes,
-                     int64 record_bytes, int64 footer_bytes)
+    Dataset(std::vector<string> filenames, int64 header_bytes,
+            int64 record_bytes, int64 footer_bytes, int64 buffer_size,
+            int64 read_ahead_blocks)
         : filenames_(std::move(filenames)),
           header_bytes_(header_bytes),
           record_bytes_(record_bytes),
-          footer_bytes_(footer_bytes) {}
+          footer_bytes_(footer_bytes),
+          buffer_size_(buffer_size),
+          read_ahead_blocks_(read_ahead_blocks) {}
 
     std::unique_ptr<IteratorBase> MakeIterator() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
@@ -225,13 +347,13 @@ class FixedLengthRecordDatasetOp : public OpKernel {
         mutex_lock l(mu_);
         do {
           // We are currently processing a file, so try to read the next record.
-          if (input_buffer_) {
-            const int64 current_pos = input_buffer_->Tell();
+          if (file_) {
+            const int64 current_pos = file_->stream()->Tell();
             DCHECK_GE(file_pos_limit_, 0);
             if (current_pos < file_pos_limit_) {
               string record;
-              TF_RETURN_IF_ERROR(
-                  input_buffer_->ReadNBytes(dataset()->record_bytes_, &record));
+              TF_RETURN_IF_ERROR(file_->stream()->ReadNBytes(
+                  dataset()->record_bytes_, &record));
               // Produce the record as output.
               Tensor record_tensor(cpu_allocator(), DT_STRING, {});
               record_tensor.scalar<string>()() = record;
@@ -242,7 +364,6 @@ class FixedLengthRecordDatasetOp : public OpKernel {
 
             // We have reached the end of the current file, so maybe
             // move on to next file.
-            input_buffer_.reset();
             file_.reset();
             ++current_file_index_;
           }
@@ -258,24 +379,55 @@ class FixedLengthRecordDatasetOp : public OpKernel {
           TF_RETURN_IF_ERROR(ctx->env()->GetFileSize(
               dataset()->filenames_[current_file_index_], &file_size));
           file_pos_limit_ = file_size - dataset()->footer_bytes_;
-          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
-              dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_.reset(new io::InputBuffer(file_.get(), kBufferSize));
+          TF_RETURN_IF_ERROR(OpenFile(ctx->env()));
           TF_RETURN_IF_ERROR(
-              input_buffer_->SkipNBytes(dataset()->header_bytes_));
+              file_->stream()->SkipNBytes(dataset()->header_bytes_));
         } while (true);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/current_file_index"),
+                                static_cast<int64>(current_file_index_)));
+        if (file_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(strings::StrCat(prefix, "/current_pos"),
+                                  file_->stream()->Tell()));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        const string pos_key = strings::StrCat(prefix, "/current_pos");
+        TF_RETURN_IF_ERROR(RestoreFileIndex(prefix, pos_key,
+                                            dataset()->filenames_.size(),
+                                            reader, &current_file_index_));
+        if (reader->Contains(pos_key)) {
+          int64 current_pos;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(pos_key, &current_pos));
+          const string& filename = dataset()->filenames_[current_file_index_];
+          uint64 file_size;
+          TF_RETURN_IF_ERROR(ctx->env()->GetFileSize(filename, &file_size));
+          file_pos_limit_ = file_size - dataset()->footer_bytes_;
+          TF_RETURN_IF_ERROR(OpenFile(ctx->env()));
+          TF_RETURN_IF_ERROR(file_->stream()->Seek(current_pos));
+        }
+        return Status::OK();
+      }
+
      private:
-      // TODO(mrry): Make this configurable via an attr on the dataset op?
-      // Or maybe via a data input?
-      enum { kBufferSize = 256 << 10 /* 256 kB */ };
+      Status OpenFile(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return OpenBufferedFile(
+            env, dataset()->filenames_[current_file_index_],
+            dataset()->buffer_size_, dataset()->read_ahead_blocks_, &file_);
+      }
 
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
-      std::unique_ptr<RandomAccessFile> file_
-          GUARDED_BY(mu_);  // must outlive input_buffer_
-      std::unique_ptr<io::InputBuffer> input_buffer_ GUARDED_BY(mu_);
+      std::unique_ptr<BufferedFileStream> file_ GUARDED_BY(mu_);
       int64 file_pos_limit_ GUARDED_BY(mu_) = -1;
     };
 
@@ -283,7 +435,12 @@ class FixedLengthRecordDatasetOp : public OpKernel {
     const int64 header_bytes_;
     const int64 record_bytes_;
     const int64 footer_bytes_;
+    const int64 buffer_size_;
+    const int64 read_ahead_blocks_;
   };
+
+  int64 buffer_size_;
+  int64 read_ahead_blocks_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("FixedLengthRecordDataset").Device(DEVICE_CPU),
@@ -315,7 +472,48 @@ class TFRecordDatasetOp : public OpKernel {
     const string& compression_type =
         compression_type_tensor->scalar<string>()();
 
-    DatasetBase* dataset = new Dataset(std::move(filenames), compression_type);
+    // All the records of each file are read, unless this is a
+    // "TFRecordRangeDataset", which selects a range of them.
+    int64 start = 0;
+    int64 count = -1;
+    int64 num_shards = 1;
+    int64 shard_index = 0;
+    if (ctx->num_inputs() > 2) {
+      const Tensor* start_tensor;
+      OP_REQUIRES_OK(ctx, ctx->input("start", &start_tensor));
+      OP_REQUIRES(ctx, start_tensor->dims() == 0,
+                  errors::InvalidArgument("`start` must be a scalar."));
+      start = start_tensor->scalar<int64>()();
+      OP_REQUIRES(ctx, start >= 0,
+                  errors::InvalidArgument("`start` must be >= 0."));
+
+      const Tensor* count_tensor;
+      OP_REQUIRES_OK(ctx, ctx->input("count", &count_tensor));
+      OP_REQUIRES(ctx, count_tensor->dims() == 0,
+                  errors::InvalidArgument("`count` must be a scalar."));
+      count = count_tensor->scalar<int64>()();
+
+      const Tensor* num_shards_tensor;
+      OP_REQUIRES_OK(ctx, ctx->input("num_shards", &num_shards_tensor));
+      OP_REQUIRES(ctx, num_shards_tensor->dims() == 0,
+                  errors::InvalidArgument("`num_shards` must be a scalar."));
+      num_shards = num_shards_tensor->scalar<int64>()();
+      OP_REQUIRES(ctx, num_shards > 0,
+                  errors::InvalidArgument("`num_shards` must be > 0."));
+
+      const Tensor* shard_index_tensor;
+      OP_REQUIRES_OK(ctx, ctx->input("shard_index", &shard_index_tensor));
+      OP_REQUIRES(ctx, shard_index_tensor->dims() == 0,
+                  errors::InvalidArgument("`shard_index` must be a scalar."));
+      shard_index = shard_index_tensor->scalar<int64>()();
+      OP_REQUIRES(ctx, shard_index >= 0 && shard_index < num_shards,
+                  errors::InvalidArgument(
+                      "`shard_index` must be in the range [0, `num_shards`)."));
+    }
+
+    DatasetBase* dataset =
+        new Dataset(std::move(filenames), compression_type, start, count,
+                    num_shards, shard_index);
     Tensor* output = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
     ResourceHandle handle = MakeResourceHandle<DatasetBase>(
@@ -327,11 +525,21 @@ class TFRecordDatasetOp : public OpKernel {
  private:
   class Dataset : public DatasetBase {
    public:
-    explicit Dataset(std::vector<string> filenames,
-                     const string& compression_type)
+    Dataset(std::vector<string> filenames, const string& compression_type,
+            int64 start, int64 count, int64 num_shards, int64 shard_index)
         : filenames_(std::move(filenames)),
           options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {}
+              compression_type)),
+          start_(start),
+          count_(count),
+          num_shards_(num_shards),
+          shard_index_(shard_index) {
+#if !defined(IS_SLIM_BUILD)
+      // Decompress the next records while the iterator's consumer processes
+      // the current ones.
+      options_.decompression_read_ahead_buffers = 2;
+#endif  // IS_SLIM_BUILD
+    }
 
     std::unique_ptr<IteratorBase> MakeIterator() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
@@ -360,12 +568,19 @@ class TFRecordDatasetOp : public OpKernel {
                      bool* end_of_sequence) override {
         mutex_lock l(mu_);
         do {
-          // We are currently processing a file, so try to read the next record.
+          // We are currently processing a file, so try to read the next
+          // record, unless we have read all the records in its range.
           if (reader_) {
+            Status s = errors::OutOfRange("end of range");
             Tensor result_tensor(cpu_allocator(), DT_STRING, {});
-            Status s = reader_->ReadRecord(&offset_,
-                                           &result_tensor.scalar<string>()());
+            if (records_remaining_ != 0) {
+              s = reader_->ReadRecord(&offset_,
+                                      &result_tensor.scalar<string>()());
+            }
             if (s.ok()) {
+              if (records_remaining_ > 0) {
+                --records_remaining_;
+              }
               out_tensors->emplace_back(std::move(result_tensor));
               *end_of_sequence = false;
               return Status::OK();
@@ -387,19 +602,172 @@ class TFRecordDatasetOp : public OpKernel {
           }
 
           // Actually move on to next file.
-          const string& next_filename =
-              dataset()->filenames_[current_file_index_];
-          TF_RETURN_IF_ERROR(
-              ctx->env()->NewRandomAccessFile(next_filename, &file_));
-          reader_.reset(new io::RecordReader(file_.get(), dataset()->options_));
-          offset_ = 0;
+          TF_RETURN_IF_ERROR(OpenFile(ctx));
+          TF_RETURN_IF_ERROR(SeekToRange(ctx));
         } while (true);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/current_file_index"),
+                                static_cast<int64>(current_file_index_)));
+        if (reader_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(strings::StrCat(prefix, "/offset"),
+                                  static_cast<int64>(offset_)));
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(strings::StrCat(prefix, "/records_remaining"),
+                                  records_remaining_));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        const string offset_key = strings::StrCat(prefix, "/offset");
+        TF_RETURN_IF_ERROR(RestoreFileIndex(prefix, offset_key,
+                                            dataset()->filenames_.size(),
+                                            reader, &current_file_index_));
+        if (reader->Contains(offset_key)) {
+          int64 offset;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(offset_key, &offset));
+          TF_RETURN_IF_ERROR(OpenFile(ctx));
+          const string records_remaining_key =
+              strings::StrCat(prefix, "/records_remaining");
+          if (reader->Contains(records_remaining_key)) {
+            TF_RETURN_IF_ERROR(reader->ReadScalar(records_remaining_key,
+                                                  &records_remaining_));
+          }
+          if (dataset()->options_.compression_type ==
+              io::RecordReaderOptions::NONE) {
+            // Records are read directly from the file at `offset_`.
+            offset_ = offset;
+          } else {
+            // A compressed file can only be read sequentially, so
+            // decompress the records before the saved offset again.
+            string record;
+            while (offset_ < offset) {
+              TF_RETURN_IF_ERROR(reader_->ReadRecord(&offset_, &record));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
      private:
+      // Opens the current file and starts reading it from the beginning.
+      Status OpenFile(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
+            dataset()->filenames_[current_file_index_], &file_));
+        reader_.reset(new io::RecordReader(file_.get(), dataset()->options_));
+        offset_ = 0;
+        records_remaining_ = -1;
+        return Status::OK();
+      }
+
+      // Reads the record index of the current file into "*index", and
+      // returns true if there is one that can be used. The index of a
+      // compressed file is not used, since the file cannot be read from an
+      // arbitrary offset, and the index cannot be checked against it. An
+      // index that is corrupted, or that no longer matches the size of its
+      // file because the file was rewritten, is ignored with a warning.
+      bool ReadRecordIndex(IteratorContext* ctx, io::RecordIndex* index)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (dataset()->options_.compression_type !=
+            io::RecordReaderOptions::NONE) {
+          return false;
+        }
+        const string& filename = dataset()->filenames_[current_file_index_];
+        const string index_filename = io::RecordIndexFilename(filename);
+        Status s = index->Read(ctx->env(), index_filename);
+        if (errors::IsNotFound(s)) {
+          return false;
+        }
+        uint64 file_size;
+        if (s.ok()) {
+          s = ctx->env()->GetFileSize(filename, &file_size);
+        }
+        if (s.ok() && file_size != index->data_size()) {
+          s = errors::DataLoss("The index is for ", index->data_size(),
+                               " bytes of records, but the file has ",
+                               file_size, " bytes.");
+        }
+        if (!s.ok()) {
+          LOG(WARNING) << "Ignoring the record index " << index_filename
+                       << ", and reading the records of " << filename
+                       << " sequentially instead: " << s;
+          return false;
+        }
+        return true;
+      }
+
+      // Moves `offset_` to the first record of the range of records that
+      // this dataset reads from the newly opened current file, and sets
+      // `records_remaining_` to the length of the range. If the file has a
+      // record index, it is used to find the first record of the range.
+      Status SeekToRange(IteratorContext* ctx) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (dataset()->start_ == 0 && dataset()->count_ < 0 &&
+            dataset()->num_shards_ == 1) {
+          return Status::OK();
+        }
+
+        io::RecordIndex index;
+        const bool has_index = ReadRecordIndex(ctx, &index);
+
+        // The total number of records in the file, or -1 if it is unknown.
+        int64 num_records = -1;
+        Status s;
+        if (has_index) {
+          num_records = index.num_records();
+        } else if (dataset()->num_shards_ > 1) {
+          // Sharding needs the number of records, so count them.
+          s = reader_->SkipRecords(&offset_, kint64max, &num_records);
+          if (!errors::IsOutOfRange(s)) {
+            return s;
+          }
+          TF_RETURN_IF_ERROR(OpenFile(ctx));
+        }
+
+        int64 begin = dataset()->start_;
+        int64 end = kint64max;
+        if (dataset()->count_ >= 0 && dataset()->count_ < end - begin) {
+          end = begin + dataset()->count_;
+        }
+        if (num_records >= 0) {
+          begin = std::min(begin, num_records);
+          end = std::min(end, num_records);
+        }
+        if (dataset()->num_shards_ > 1) {
+          const int64 length = end - begin;
+          end = begin + length * (dataset()->shard_index_ + 1) /
+                            dataset()->num_shards_;
+          begin += length * dataset()->shard_index_ / dataset()->num_shards_;
+        }
+
+        int64 num_to_skip = begin;
+        if (has_index) {
+          index.Lookup(begin, &offset_, &num_to_skip);
+        }
+        int64 num_skipped;
+        s = reader_->SkipRecords(&offset_, num_to_skip, &num_skipped);
+        if (errors::IsOutOfRange(s)) {
+          // The file has no records in the range.
+          records_remaining_ = 0;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(s);
+        records_remaining_ = end == kint64max ? -1 : end - begin;
+        return Status::OK();
+      }
+
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
       uint64 offset_ GUARDED_BY(mu_) = 0;
+      // The number of records left to read from the current file, or -1 to
+      // read all of them.
+      int64 records_remaining_ GUARDED_BY(mu_) = -1;
 
       // `reader_` will borrow the object that `file_` points to, so
       // we must destroy `reader_` before `file_`.
@@ -409,11 +777,17 @@ class TFRecordDatasetOp : public OpKernel {
 
     const std::vector<string> filenames_;
     io::RecordReaderOptions options_;
+    const int64 start_;
+    const int64 count_;
+    const int64 num_shards_;
+    const int64 shard_index_;
   };
 };
 
 REGISTER_KERNEL_BUILDER(Name("TFRecordDataset").Device(DEVICE_CPU),
                         TFRecordDatasetOp);
+REGISTER_KERNEL_BUILDER(Name("TFRecordRangeDataset").Device(DEVICE_CPU),
+                        TFRecordDatasetOp);
 
 }  // namespace
 
@@ -87,6 +87,15 @@ class RepeatDatasetOp : public OpKernel {
         *end_of_sequence = true;
         return Status::OK();
       }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return Status::OK();
+      }
     };
 
     class FiniteIterator : public DatasetIterator<Dataset> {
@@ -113,6 +122,23 @@ class RepeatDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(strings::StrCat(prefix, "/i"),
+                                               i_));
+        return SaveInputIterator(strings::StrCat(prefix, "/input"),
+                                 input_impl_, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader->ReadScalar(strings::StrCat(prefix, "/i"),
+                                              &i_));
+        return RestoreInputIterator(ctx, strings::StrCat(prefix, "/input"),
+                                    dataset()->input_, reader, &input_impl_);
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
@@ -156,6 +182,20 @@ class RepeatDatasetOp : public OpKernel {
         } while (true);
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        // A missing input means that the next call starts a new epoch.
+        return SaveInputIterator(strings::StrCat(prefix, "/input"),
+                                 input_impl_, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return RestoreInputIterator(ctx, strings::StrCat(prefix, "/input"),
+                                    dataset()->input_, reader, &input_impl_);
+      }
+
      private:
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
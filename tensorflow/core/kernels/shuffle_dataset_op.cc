@@ -12,18 +12,95 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <map>
+
 #include "tensorflow/core/kernels/dataset.h"
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Generates the random indices with which a shuffle iterator chooses
+// elements from its buffer. Counts the samples that it generates, so that
+// its state can be saved, and restored by skipping ahead in the stream.
+class ShuffleGenerator {
+ public:
+  ShuffleGenerator(int64 seed, int64 seed2)
+      : seed_(seed), seed2_(seed2), generator_(&parent_generator_) {
+    if (seed_ == 0 && seed2_ == 0) {
+      // If both seeds are unspecified, use completely random seeds.
+      seed_ = random::New64();
+      seed2_ = random::New64();
+    }
+    Reset(0);
+  }
+
+  uint32 operator()() {
+    ++num_samples_;
+    return generator_();
+  }
+
+  Status Save(const string& prefix, IteratorStateWriter* writer) {
+    TF_RETURN_IF_ERROR(
+        writer->WriteScalar(strings::StrCat(prefix, "/seed"), seed_));
+    TF_RETURN_IF_ERROR(
+        writer->WriteScalar(strings::StrCat(prefix, "/seed2"), seed2_));
+    return writer->WriteScalar(strings::StrCat(prefix, "/num_samples"),
+                               num_samples_);
+  }
+
+  Status Restore(const string& prefix, IteratorStateReader* reader) {
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(strings::StrCat(prefix, "/seed"), &seed_));
+    TF_RETURN_IF_ERROR(
+        reader->ReadScalar(strings::StrCat(prefix, "/seed2"), &seed2_));
+    int64 num_samples;
+    TF_RETURN_IF_ERROR(reader->ReadScalar(
+        strings::StrCat(prefix, "/num_samples"), &num_samples));
+    if (num_samples < 0) {
+      return errors::DataLoss("Invalid iterator state: ", num_samples,
+                              " random samples.");
+    }
+    Reset(num_samples);
+    return Status::OK();
+  }
+
+ private:
+  // Positions the generator after the first `num_samples` samples of the
+  // stream for the seeds.
+  void Reset(int64 num_samples) {
+    constexpr int64 kSamplesPerResult =
+        random::PhiloxRandom::kResultElementCount;
+    parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+    parent_generator_.Skip(num_samples / kSamplesPerResult);
+    generator_ =
+        random::SingleSampleAdapter<random::PhiloxRandom>(&parent_generator_);
+    for (int64 i = 0; i < num_samples % kSamplesPerResult; ++i) {
+      generator_();
+    }
+    num_samples_ = num_samples;
+  }
+
+  int64 seed_;
+  int64 seed2_;
+  int64 num_samples_ = 0;
+  random::PhiloxRandom parent_generator_;
+  random::SingleSampleAdapter<random::PhiloxRandom> generator_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShuffleGenerator);
+};
+
 // See documentation in ../ops/dataset_ops.cc for a high-level
 // description of the following op.
 
@@ -102,16 +179,8 @@ class ShuffleDatasetOp : public OpKernel {
       explicit Iterator(const Dataset* dataset)
           : DatasetIterator<Dataset>(dataset),
             input_impl_(dataset->input_->MakeIterator()),
-            generator_(&parent_generator_) {
+            generator_(dataset->seed_, dataset->seed2_) {
         buffer_.reserve(dataset->buffer_size_);
-        int64 seed = dataset->seed_;
-        int64 seed2 = dataset->seed2_;
-        if (seed == 0 && seed2 == 0) {
-          // If both seeds are unspecified, use completely random seeds.
-          seed = random::New64();
-          seed2 = random::New64();
-        }
-        parent_generator_ = random::PhiloxRandom(seed, seed2);
       }
 
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
@@ -142,14 +211,54 @@ class ShuffleDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/end_of_input"),
+                                end_of_input_sequence_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(
+            generator_.Save(strings::StrCat(prefix, "/generator"), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/buffer.size"),
+                                static_cast<int64>(buffer_.size())));
+        for (size_t i = 0; i < buffer_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(prefix, "/buffer[", i, "]"), buffer_[i]));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        end_of_input_sequence_ = end_of_input != 0;
+        TF_RETURN_IF_ERROR(
+            generator_.Restore(strings::StrCat(prefix, "/generator"), reader));
+        int64 buffer_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/buffer.size"), &buffer_size));
+        buffer_.clear();
+        buffer_.resize(buffer_size);
+        for (int64 i = 0; i < buffer_size; ++i) {
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(prefix, "/buffer[", i, "]"), &buffer_[i]));
+        }
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       std::vector<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
       bool end_of_input_sequence_ GUARDED_BY(mu_) = false;
-      random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
-      random::SingleSampleAdapter<random::PhiloxRandom> generator_
-          GUARDED_BY(mu_);
+      ShuffleGenerator generator_ GUARDED_BY(mu_);
     };
 
     const DatasetBase* const input_;
@@ -159,9 +268,436 @@ class ShuffleDatasetOp : public OpKernel {
   };
 };
 
+class SpillingShuffleDatasetOp : public OpKernel {
+ public:
+  explicit SpillingShuffleDatasetOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    DatasetBase* input;
+    OP_REQUIRES_OK(ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &input));
+    core::ScopedUnref unref_input(input);
+
+    const Tensor* buffer_size_t;
+    OP_REQUIRES_OK(ctx, ctx->input("buffer_size", &buffer_size_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(buffer_size_t->shape()),
+                errors::InvalidArgument("buffer_size must be a scalar"));
+    const int64 buffer_size = buffer_size_t->flat<int64>()(0);
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    const Tensor* seed_t;
+    OP_REQUIRES_OK(ctx, ctx->input("seed", &seed_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(seed_t->shape()),
+                errors::InvalidArgument("seed must be a scalar"));
+    const int64 seed = seed_t->flat<int64>()(0);
+
+    const Tensor* seed2_t;
+    OP_REQUIRES_OK(ctx, ctx->input("seed2", &seed2_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(seed2_t->shape()),
+                errors::InvalidArgument("seed2 must be a scalar"));
+    const int64 seed2 = seed2_t->flat<int64>()(0);
+
+    const Tensor* scratch_directory_t;
+    OP_REQUIRES_OK(ctx,
+                   ctx->input("scratch_directory", &scratch_directory_t));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(scratch_directory_t->shape()),
+                errors::InvalidArgument("scratch_directory must be a scalar"));
+    const string scratch_directory = scratch_directory_t->flat<string>()(0);
+    OP_REQUIRES(
+        ctx, !scratch_directory.empty(),
+        errors::InvalidArgument("scratch_directory must not be empty."));
+
+    DatasetBase* dataset = new Dataset(input, buffer_size, seed, seed2,
+                                       scratch_directory, ctx->env());
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->flat<ResourceHandle>()(0) = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size, int64 seed,
+            int64 seed2, const string& scratch_directory, Env* env)
+        : input_(input),
+          buffer_size_(buffer_size),
+          seed_(seed),
+          seed2_(seed2),
+          scratch_directory_(scratch_directory),
+          env_(env) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override {
+      return strings::StrCat("SpillingShuffleDatasetOp(", buffer_size_, ", ",
+                             seed_, ", ", seed2_, ")::Dataset");
+    }
+
+   private:
+    // Samples elements uniformly at random from a buffer of `buffer_size`
+    // elements, as ShuffleDatasetOp does. The buffer holds only a handle
+    // per element, and the element itself is written to a scratch file,
+    // with one TFRecord-framed TensorProto per component.
+    //
+    // The scratch files are segments of `buffer_size` elements each. A
+    // segment is deleted as soon as all of its elements have been
+    // produced, but a few elements that stay in the buffer for long keep
+    // about ln(buffer_size) + 1 segments alive. So once the scratch files
+    // grow to more than twice the size of the buffered elements, the
+    // buffered elements are rewritten to a new segment and the others are
+    // deleted. This bounds the scratch space to twice the size of the
+    // buffer, or three times while compacting, and rewrites each element
+    // at most once on average.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()),
+            generator_(dataset->seed_, dataset->seed2_) {
+        buffer_.reserve(dataset->buffer_size_);
+        filename_prefix_ = io::JoinPath(
+            dataset->scratch_directory_,
+            strings::Printf("shuffle_%016llx",
+                            static_cast<unsigned long long>(random::New64())));
+      }
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        for (auto& segment : segments_) {
+          DeleteSegment(&segment.second);
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        while (!end_of_input_sequence_ &&
+               buffer_.size() < dataset()->buffer_size_) {
+          std::vector<Tensor> input_element;
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &input_element,
+                                                  &end_of_input_sequence_));
+          if (!end_of_input_sequence_) {
+            ElementHandle handle;
+            TF_RETURN_IF_ERROR(WriteElement(input_element, &handle));
+            buffer_.push_back(handle);
+          }
+        }
+
+        if (!buffer_.empty()) {
+          *end_of_sequence = false;
+          // Choose an element to produce uniformly at random, and
+          // swap the last element into its place in the buffer.
+          int64 index = generator_() % buffer_.size();
+          const ElementHandle handle = buffer_[index];
+          std::swap(buffer_[index], buffer_.back());
+          buffer_.pop_back();
+          return ReadElement(handle, out_tensors);
+        } else {
+          DCHECK(end_of_input_sequence_);
+          *end_of_sequence = true;
+        }
+        return Status::OK();
+      }
+
+      // NOTE: The buffered elements are saved in the checkpoint itself,
+      // because the scratch files belong to this iterator and are deleted
+      // with it. On restore they are written to new scratch files.
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            input_impl_->Save(strings::StrCat(prefix, "/input"), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/end_of_input"),
+                                end_of_input_sequence_ ? 1 : 0));
+        TF_RETURN_IF_ERROR(
+            generator_.Save(strings::StrCat(prefix, "/generator"), writer));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(strings::StrCat(prefix, "/buffer.size"),
+                                static_cast<int64>(buffer_.size())));
+        for (size_t i = 0; i < buffer_.size(); ++i) {
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(PeekElement(buffer_[i], &element));
+          TF_RETURN_IF_ERROR(writer->WriteElement(
+              strings::StrCat(prefix, "/buffer[", i, "]"), element));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(input_impl_->Restore(
+            ctx, strings::StrCat(prefix, "/input"), reader));
+        int64 end_of_input;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/end_of_input"), &end_of_input));
+        end_of_input_sequence_ = end_of_input != 0;
+        TF_RETURN_IF_ERROR(
+            generator_.Restore(strings::StrCat(prefix, "/generator"), reader));
+        int64 buffer_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/buffer.size"), &buffer_size));
+        for (int64 i = 0; i < buffer_size; ++i) {
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(reader->ReadElement(
+              strings::StrCat(prefix, "/buffer[", i, "]"), &element));
+          ElementHandle handle;
+          TF_RETURN_IF_ERROR(WriteElement(element, &handle));
+          buffer_.push_back(handle);
+        }
+        return Status::OK();
+      }
+
+     private:
+      // The location of an element in the scratch files.
+      struct ElementHandle {
+        int64 segment_index;
+        uint64 offset;
+        uint64 size;
+      };
+
+      struct Segment {
+        string filename;
+        // The writer of the segment that is being written, which is
+        // released when the segment is full.
+        std::unique_ptr<WritableFile> write_file;
+        std::unique_ptr<io::RecordWriter> writer;
+        bool needs_flush = false;
+        uint64 size = 0;
+        int64 num_written = 0;
+        // The number of elements in the segment that have not been produced.
+        int64 num_live = 0;
+        std::unique_ptr<RandomAccessFile> read_file;
+        std::unique_ptr<io::RecordReader> reader;
+      };
+
+      // Writes `element`, which is then live, and compacts the scratch
+      // files if they have grown to more than twice the size of the live
+      // elements.
+      Status WriteElement(const std::vector<Tensor>& element,
+                          ElementHandle* handle) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(AppendElement(element, handle));
+        if (scratch_bytes_ > 2 * live_bytes_) {
+          // The element being written is not in the buffer yet.
+          buffer_.push_back(*handle);
+          Status s = Compact();
+          *handle = buffer_.back();
+          buffer_.pop_back();
+          TF_RETURN_IF_ERROR(s);
+        }
+        return Status::OK();
+      }
+
+      // Rewrites the live elements to a new segment. Each of the other
+      // segments is deleted once its last live element has been moved.
+      Status Compact() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(CloseCurrentSegment());
+        for (ElementHandle& handle : buffer_) {
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(PeekElement(handle, &element));
+          TF_RETURN_IF_ERROR(ReleaseElement(handle));
+          TF_RETURN_IF_ERROR(AppendElement(element, &handle));
+        }
+        return Status::OK();
+      }
+
+      // Closes the writer of the current segment, if any, so that the next
+      // element is written to a new segment.
+      Status CloseCurrentSegment() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        auto it = segments_.find(current_segment_index_);
+        if (it == segments_.end()) {
+          return Status::OK();
+        }
+        ++current_segment_index_;
+        Segment* segment = &it->second;
+        TF_RETURN_IF_ERROR(segment->writer->Close());
+        TF_RETURN_IF_ERROR(segment->write_file->Close());
+        segment->writer.reset();
+        segment->write_file.reset();
+        segment->needs_flush = false;
+        if (segment->num_live == 0) {
+          DeleteSegment(segment);
+          segments_.erase(it);
+        }
+        return Status::OK();
+      }
+
+      // Writes `element` to the current segment, or to a new segment if it
+      // is full, without compacting.
+      Status AppendElement(const std::vector<Tensor>& element,
+                           ElementHandle* handle)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Segment* segment = nullptr;
+        auto it = segments_.find(current_segment_index_);
+        if (it != segments_.end() &&
+            it->second.num_written == dataset()->buffer_size_) {
+          TF_RETURN_IF_ERROR(CloseCurrentSegment());
+          it = segments_.end();
+        }
+        if (it == segments_.end()) {
+          segment = &segments_[current_segment_index_];
+          segment->filename =
+              strings::StrCat(filename_prefix_, "_", current_segment_index_);
+          Env* env = dataset()->env_;
+          TF_RETURN_IF_ERROR(
+              env->NewWritableFile(segment->filename, &segment->write_file));
+          segment->writer.reset(
+              new io::RecordWriter(segment->write_file.get()));
+          TF_RETURN_IF_ERROR(
+              env->NewRandomAccessFile(segment->filename, &segment->read_file));
+          segment->reader.reset(new io::RecordReader(segment->read_file.get()));
+        } else {
+          segment = &it->second;
+        }
+
+        handle->segment_index = current_segment_index_;
+        handle->offset = segment->size;
+        string record;
+        for (const Tensor& component : element) {
+          TensorProto proto;
+          component.AsProtoTensorContent(&proto);
+          record.clear();
+          proto.SerializeToString(&record);
+          TF_RETURN_IF_ERROR(segment->writer->WriteRecord(record));
+          segment->size += kRecordOverhead + record.size();
+        }
+        handle->size = segment->size - handle->offset;
+        scratch_bytes_ += handle->size;
+        live_bytes_ += handle->size;
+        segment->needs_flush = true;
+        ++segment->num_written;
+        ++segment->num_live;
+        return Status::OK();
+      }
+
+      // Reads the element at `handle`, which is then no longer live.
+      Status ReadElement(const ElementHandle& handle,
+                         std::vector<Tensor>* out_tensors)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(PeekElement(handle, out_tensors));
+        return ReleaseElement(handle);
+      }
+
+      // Marks the element at `handle` as no longer live, and deletes its
+      // segment if it was the last live element of a full segment.
+      Status ReleaseElement(const ElementHandle& handle)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        auto it = segments_.find(handle.segment_index);
+        DCHECK(it != segments_.end());
+        Segment* segment = &it->second;
+        --segment->num_live;
+        live_bytes_ -= handle.size;
+        if (segment->num_live == 0 && !segment->writer) {
+          DeleteSegment(segment);
+          segments_.erase(it);
+        }
+        return Status::OK();
+      }
+
+      // Reads the element at `handle`, which remains live.
+      Status PeekElement(const ElementHandle& handle,
+                         std::vector<Tensor>* out_tensors)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        auto it = segments_.find(handle.segment_index);
+        DCHECK(it != segments_.end());
+        Segment* segment = &it->second;
+        if (segment->needs_flush) {
+          // The element may still be buffered in the writer of the current
+          // segment.
+          TF_RETURN_IF_ERROR(segment->writer->Flush());
+          TF_RETURN_IF_ERROR(segment->write_file->Flush());
+          segment->needs_flush = false;
+        }
+
+        const size_t num_components = dataset()->output_dtypes().size();
+        out_tensors->reserve(num_components);
+        uint64 offset = handle.offset;
+        string record;
+        for (size_t i = 0; i < num_components; ++i) {
+          TF_RETURN_IF_ERROR(segment->reader->ReadRecord(&offset, &record));
+          TensorProto proto;
+          if (!proto.ParseFromString(record)) {
+            return errors::DataLoss("Could not parse a shuffled element from ",
+                                    segment->filename, " at offset ",
+                                    handle.offset);
+          }
+          Tensor t;
+          if (!t.FromProto(proto)) {
+            return errors::DataLoss("Could not parse a shuffled element from ",
+                                    segment->filename, " at offset ",
+                                    handle.offset);
+          }
+          out_tensors->emplace_back(std::move(t));
+        }
+        return Status::OK();
+      }
+
+      void DeleteSegment(Segment* segment) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        segment->reader.reset();
+        segment->read_file.reset();
+        segment->writer.reset();
+        segment->write_file.reset();
+        scratch_bytes_ -= segment->size;
+        Status s = dataset()->env_->DeleteFile(segment->filename);
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to delete the shuffle scratch file "
+                       << segment->filename << ": " << s;
+        }
+      }
+
+      // The number of bytes that the TFRecord framing adds to each record:
+      // a length and its masked CRC before the data, and the masked CRC of
+      // the data after it.
+      static constexpr uint64 kRecordOverhead =
+          sizeof(uint64) + 2 * sizeof(uint32);
+
+      mutex mu_;
+      std::vector<ElementHandle> buffer_ GUARDED_BY(mu_);
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      bool end_of_input_sequence_ GUARDED_BY(mu_) = false;
+      ShuffleGenerator generator_ GUARDED_BY(mu_);
+      string filename_prefix_;
+      std::map<int64, Segment> segments_ GUARDED_BY(mu_);
+      int64 current_segment_index_ GUARDED_BY(mu_) = 0;
+      // The total size of the segments, and of the live elements in them.
+      uint64 scratch_bytes_ GUARDED_BY(mu_) = 0;
+      uint64 live_bytes_ GUARDED_BY(mu_) = 0;
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const int64 seed_;
+    const int64 seed2_;
+    const string scratch_directory_;
+    Env* const env_;
+  };
+};
+
 REGISTER_KERNEL_BUILDER(Name("ShuffleDataset").Device(DEVICE_CPU),
                         ShuffleDatasetOp);
 
+REGISTER_KERNEL_BUILDER(Name("SpillingShuffleDataset").Device(DEVICE_CPU),
+                        SpillingShuffleDatasetOp);
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -88,6 +88,15 @@ class SkipDatasetOp : public OpKernel {
         *end_of_sequence = true;
         return Status::OK();
       }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return Status::OK();
+      }
     };
 
     class FiniteIterator : public DatasetIterator<Dataset> {
@@ -100,6 +109,10 @@ class SkipDatasetOp : public OpKernel {
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                      bool* end_of_sequence) override {
         mutex_lock l(mu_);  // TODO(mrry): Make locking less conservative.
+        if (!input_impl_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
 
         // Keep calling GetNext().  TODO(vrv): Figure out a way to
         // skip records without reading, perhaps by adding an
@@ -124,6 +137,23 @@ class SkipDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(strings::StrCat(prefix, "/i"),
+                                               i_));
+        return SaveInputIterator(strings::StrCat(prefix, "/input"),
+                                 input_impl_, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader->ReadScalar(strings::StrCat(prefix, "/i"),
+                                              &i_));
+        return RestoreInputIterator(ctx, strings::StrCat(prefix, "/input"),
+                                    dataset()->input_, reader, &input_impl_);
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
@@ -127,6 +127,30 @@ class Dataset : public DatasetBase {
       return Status::OK();
     }
 
+    Status Save(const string& prefix, IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      return writer->WriteScalar(strings::StrCat(prefix, "/i"), i_);
+    }
+
+    Status Restore(IteratorContext* ctx, const string& prefix,
+                   IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(strings::StrCat(prefix, "/i"), &i_));
+      if (i_ < 0 || i_ > num_elements_) {
+        return errors::DataLoss("Invalid iterator state: ", i_,
+                                " is not a valid slice index.");
+      }
+      // Skip the groups of the slices that were already produced, so that
+      // the next call to `GetNext()` reads the next non-empty group.
+      next_non_empty_i_ = kNextNonEmptyUnknown;
+      while (iter_ != group_iterable_.end() &&
+             (*iter_).indices()(0, 0) < i_) {
+        ++iter_;
+      }
+      return Status::OK();
+    }
+
    private:
     const Dataset<T>* const dataset_;
     const int64 num_elements_;
@@ -87,6 +87,15 @@ class TakeDatasetOp : public OpKernel {
         *end_of_sequence = true;
         return Status::OK();
       }
+
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        return Status::OK();
+      }
     };
 
     class FiniteIterator : public DatasetIterator<Dataset> {
@@ -99,6 +108,10 @@ class TakeDatasetOp : public OpKernel {
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                      bool* end_of_sequence) override {
         mutex_lock l(mu_);  // TODO(mrry): Make locking less conservative.
+        if (!input_impl_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
         while (i_ < dataset()->count_) {
           TF_RETURN_IF_ERROR(
               input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
@@ -113,6 +126,23 @@ class TakeDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(strings::StrCat(prefix, "/i"),
+                                               i_));
+        return SaveInputIterator(strings::StrCat(prefix, "/input"),
+                                 input_impl_, writer);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader->ReadScalar(strings::StrCat(prefix, "/i"),
+                                              &i_));
+        return RestoreInputIterator(ctx, strings::StrCat(prefix, "/input"),
+                                    dataset()->input_, reader, &input_impl_);
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
@@ -91,6 +91,22 @@ class TensorDatasetOp : public OpKernel {
         }
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(strings::StrCat(prefix, "/produced"),
+                                   produced_ ? 1 : 0);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 produced;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(prefix, "/produced"), &produced));
+        produced_ = produced != 0;
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       bool produced_ GUARDED_BY(mu_);
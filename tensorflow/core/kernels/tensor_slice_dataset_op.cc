@@ -165,6 +165,25 @@ class TensorSliceDatasetOp : public OpKernel {
         return Status::OK();
       }
 
+      Status Save(const string& prefix, IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(strings::StrCat(prefix, "/i"), i_);
+      }
+
+      Status Restore(IteratorContext* ctx, const string& prefix,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 i;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(strings::StrCat(prefix, "/i"), &i));
+        if (i < 0 || i > n_) {
+          return errors::DataLoss("Invalid iterator state: ", i,
+                                  " is not a valid slice index.");
+        }
+        i_ = i;
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       int i_ GUARDED_BY(mu_);
@@ -55,6 +55,25 @@ class WindowDataset : public DatasetBase {
       return Status::OK();
     }
 
+    Status Save(const string& prefix, IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      return writer->WriteScalar(strings::StrCat(prefix, "/i"),
+                                 static_cast<int64>(i_));
+    }
+
+    Status Restore(IteratorContext* ctx, const string& prefix,
+                   IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      int64 i;
+      TF_RETURN_IF_ERROR(reader->ReadScalar(strings::StrCat(prefix, "/i"), &i));
+      if (i < 0 || i > dataset()->elements_.size()) {
+        return errors::DataLoss("Invalid iterator state: ", i,
+                                " is not a valid window index.");
+      }
+      i_ = i;
+      return Status::OK();
+    }
+
     mutex mu_;
     size_t i_ GUARDED_BY(mu_) = 0;
   };
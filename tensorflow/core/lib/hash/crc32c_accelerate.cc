@@ -17,19 +17,21 @@ limitations under the License.
 #include <stdint.h>
 
 // SSE4.2 accelerated CRC32c.
+//
+// The accelerated code is compiled for the SSE4.2 and PCLMUL targets
+// whatever the flags of the rest of the build are, and it is only called
+// when the CPU supports them at run time.
 
-// See if the SSE4.2 crc32c instruction is available.
+// See if the SSE4.2 crc32c instruction can be compiled.
 #undef USE_SSE_CRC32C
-#ifdef __SSE4_2__
-#if defined(__x86_64__) && defined(__GNUC__) && \
-    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
-#define USE_SSE_CRC32C 1
-#elif defined(__x86_64__) && defined(__clang__)
+#if defined(__x86_64__) && defined(__clang__)
 #if __has_builtin(__builtin_cpu_supports)
 #define USE_SSE_CRC32C 1
 #endif
+#elif defined(__x86_64__) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define USE_SSE_CRC32C 1
 #endif
-#endif /* __SSE4_2__ */
 
 // This version of Apple clang has a bug:
 // https://llvm.org/bugs/show_bug.cgi?id=25510
@@ -38,7 +40,13 @@ limitations under the License.
 #endif
 
 #ifdef USE_SSE_CRC32C
+#include <emmintrin.h>
 #include <nmmintrin.h>
+#include <wmmintrin.h>
+
+#include "tensorflow/core/platform/cpu_info.h"
+
+#define TF_CRC32C_TARGET __attribute__((target("sse4.2,pclmul")))
 #endif
 
 namespace tensorflow {
@@ -54,10 +62,87 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
+namespace {
+
+// Buffers of at least three blocks are split into three adjacent blocks
+// whose crc32c are computed at the same time, which hides the latency of
+// the crc32 instruction. The crc of each block is then shifted past the
+// blocks that follow it, by a carry-less multiplication, and the results
+// are combined.
+const size_t kLongBlockSize = 8192;
+const size_t kShortBlockSize = 256;
+
+// Returns x^n modulo the crc32c polynomial, bit-reflected.
+uint32_t XPowN(uint64_t n) {
+  uint32_t r = 0x80000000u;  // x^0
+  for (; n > 0; --n) {
+    r = (r & 1) ? (r >> 1) ^ 0x82f63b78u : r >> 1;
+  }
+  return r;
+}
+
+// The constants that shift a crc past one and two blocks. The carry-less
+// product of two bit-reflected 32-bit polynomials is off by one factor of
+// x, and the crc32 instruction multiplies its input by x^32, so the
+// constant that shifts a crc past n bytes is x^(8n - 33).
+struct ShiftConstants {
+  explicit ShiftConstants(size_t block_size)
+      : one_block(XPowN(8 * block_size - 33)),
+        two_blocks(XPowN(16 * block_size - 33)) {}
+  const uint64_t one_block;
+  const uint64_t two_blocks;
+};
+
+// Extends the (unconditioned) crc `l` with the `num_triples` triples of
+// blocks of `block_size` bytes at `*p`, and advances `*p` past them. `*p`
+// must be 8-byte aligned.
+TF_CRC32C_TARGET uint64_t ExtendBlockTriples(uint64_t l, size_t block_size,
+                                             const ShiftConstants &k,
+                                             size_t num_triples,
+                                             const uint8_t **p) {
+  const __m128i one_block = _mm_cvtsi64_si128(k.one_block);
+  const __m128i two_blocks = _mm_cvtsi64_si128(k.two_blocks);
+  for (; num_triples > 0; --num_triples) {
+    const uint8_t *p0 = *p;
+    const uint8_t *p1 = p0 + block_size;
+    const uint8_t *p2 = p1 + block_size;
+    const uint8_t *e = p1;
+    uint64_t crc0 = l;
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    while (p0 < e) {
+      crc0 = _mm_crc32_u64(crc0, *reinterpret_cast<const uint64_t *>(p0));
+      crc1 = _mm_crc32_u64(crc1, *reinterpret_cast<const uint64_t *>(p1));
+      crc2 = _mm_crc32_u64(crc2, *reinterpret_cast<const uint64_t *>(p2));
+      p0 += 8;
+      p1 += 8;
+      p2 += 8;
+    }
+    const __m128i shifted = _mm_xor_si128(
+        _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc0), two_blocks, 0),
+        _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc1), one_block, 0));
+    l = _mm_crc32_u64(0, _mm_cvtsi128_si64(shifted)) ^ crc2;
+    *p = p2;
+  }
+  return l;
+}
+
+}  // namespace
+
 // SSE4.2 optimized crc32c computation.
-bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+bool CanAccelerate() {
+  return port::TestCPUFeature(port::CPUFeature::SSE4_2);
+}
+
+TF_CRC32C_TARGET uint32_t AcceleratedExtend(uint32_t crc, const char *buf,
+                                            size_t size) {
+  static const bool can_interleave =
+      port::TestCPUFeature(port::CPUFeature::PCLMULQDQ);
+  static const ShiftConstants *long_constants =
+      new ShiftConstants(kLongBlockSize);
+  static const ShiftConstants *short_constants =
+      new ShiftConstants(kShortBlockSize);
 
-uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
@@ -75,8 +160,16 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
     }
   }
 
-  // Process bytes 16 at a time
   uint64_t l64 = l;
+  if (can_interleave) {
+    // Process large buffers three blocks at a time.
+    l64 = ExtendBlockTriples(l64, kLongBlockSize, *long_constants,
+                             (e - p) / (3 * kLongBlockSize), &p);
+    l64 = ExtendBlockTriples(l64, kShortBlockSize, *short_constants,
+                             (e - p) / (3 * kShortBlockSize), &p);
+  }
+
+  // Process bytes 16 at a time
   while ((e - p) >= 16) {
     l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
     l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/lib/hash/crc32c.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -62,6 +65,26 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+TEST(CRC, LargeExtend) {
+  // Large buffers are processed in interleaved blocks when accelerated, so
+  // compare with extending the crc a few bytes at a time.
+  string data(100000, 0);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 2654435761u >> 24);
+  }
+  for (size_t offset : {0, 3}) {
+    for (size_t size : {767, 768, 24575, 24576, 50000, 99990}) {
+      uint32 expected = 0;
+      for (size_t i = 0; i < size; i += 100) {
+        expected = Extend(expected, data.data() + offset + i,
+                          std::min<size_t>(100, size - i));
+      }
+      EXPECT_EQ(expected, Value(data.data() + offset, size))
+          << "offset: " << offset << " size: " << size;
+    }
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
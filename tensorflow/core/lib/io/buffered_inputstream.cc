@@ -58,17 +58,27 @@ Status BufferedInputStream::ReadLineHelper(string* result, bool include_eol) {
         break;
       }
     }
-    char c = buf_[pos_++];
-    if (c == '\n') {
+    const char* start = buf_.data() + pos_;
+    const char* limit = buf_.data() + limit_;
+    const char* newline =
+        static_cast<const char*>(memchr(start, '\n', limit - start));
+    const char* end = newline != nullptr ? newline : limit;
+    result->append(start, end - start);
+    pos_ = end - buf_.data();
+    if (newline != nullptr) {
+      ++pos_;
+      // We don't append the '\r' of a "\r\n" line ending to *result
+      if (!result->empty() && result->back() == '\r') {
+        result->pop_back();
+      }
       if (include_eol) {
-        *result += c;
+        *result += '\n';
       }
       return Status::OK();
     }
-    // We don't append '\r' to *result
-    if (c != '\r') {
-      *result += c;
-    }
+  }
+  if (!result->empty() && result->back() == '\r') {
+    result->pop_back();
   }
   if (errors::IsOutOfRange(s) && !result->empty()) {
     return Status::OK();
@@ -152,6 +152,32 @@ TEST(BufferedInputStream, ReadLine_CRLF) {
   }
 }
 
+TEST(BufferedInputStream, ReadLine_EmbeddedCR) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/buffered_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname,
+                                 "one\rtwo\r\n\rthree\n\r\r\nfour\r"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    std::unique_ptr<RandomAccessInputStream> input_stream(
+        new RandomAccessInputStream(file.get()));
+    BufferedInputStream in(input_stream.get(), buf_size);
+    string line;
+    // Only the '\r' that ends a line is dropped.
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "one\rtwo");
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "\rthree");
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "\r");
+    TF_ASSERT_OK(in.ReadLine(&line));
+    EXPECT_EQ(line, "four");
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadLine(&line)));
+  }
+}
+
 TEST(BufferedInputStream, ReadNBytes) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/buffer_test";
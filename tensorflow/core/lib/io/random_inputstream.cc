@@ -57,6 +57,30 @@ Status RandomAccessInputStream::ReadNBytes(int64 bytes_to_read,
   return Status::OK();
 }
 
+Status RandomAccessInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes");
+  }
+  if (bytes_to_skip == 0) {
+    return Status::OK();
+  }
+  // Check that the last byte to skip exists, without reading the ones
+  // before it.
+  char scratch;
+  StringPiece data;
+  Status s = file_->Read(pos_ + bytes_to_skip - 1, 1, &data, &scratch);
+  if ((s.ok() || errors::IsOutOfRange(s)) && data.size() == 1) {
+    pos_ += bytes_to_skip;
+    return Status::OK();
+  }
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  // The skip goes past the end of the file, so read up to the end to find
+  // its length.
+  return InputStreamInterface::SkipNBytes(bytes_to_skip);
+}
+
 int64 RandomAccessInputStream::Tell() const { return pos_; }
 
 }  // namespace io
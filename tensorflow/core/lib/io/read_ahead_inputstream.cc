@@ -0,0 +1,202 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ReadAheadInputStream::ReadAheadInputStream(InputStreamInterface* input_stream,
+                                           size_t block_bytes, int max_blocks,
+                                           Env* env)
+    : input_stream_(input_stream),
+      block_bytes_(block_bytes),
+      max_blocks_(max_blocks),
+      env_(env),
+      position_(input_stream->Tell()) {
+  CHECK_GT(block_bytes, 0);
+  CHECK_GT(max_blocks, 0);
+  StartReading();
+}
+
+ReadAheadInputStream::~ReadAheadInputStream() { StopReading(); }
+
+void ReadAheadInputStream::StartReading() {
+  {
+    mutex_lock l(mu_);
+    if (done_reading_) {
+      return;
+    }
+    cancelled_ = false;
+  }
+  thread_.reset(env_->StartThread(ThreadOptions(), "read_ahead",
+                                  [this]() { ReadLoop(); }));
+}
+
+void ReadAheadInputStream::StopReading() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    cond_var_.notify_all();
+  }
+  // Joins the thread, which finishes its current read first.
+  thread_.reset();
+}
+
+void ReadAheadInputStream::ReadLoop() {
+  while (true) {
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_ && blocks_.size() >= max_blocks_) {
+        cond_var_.wait(l);
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    string block;
+    Status s = input_stream_->ReadNBytes(block_bytes_, &block);
+    mutex_lock l(mu_);
+    if (!block.empty()) {
+      blocks_.push_back(std::move(block));
+    }
+    if (!s.ok()) {
+      read_status_ = s;
+      done_reading_ = true;
+    }
+    cond_var_.notify_all();
+    if (done_reading_) {
+      return;
+    }
+  }
+}
+
+Status ReadAheadInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  result->clear();
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->reserve(bytes_to_read);
+  while (static_cast<int64>(result->size()) < bytes_to_read) {
+    if (pos_ == current_block_.size()) {
+      mutex_lock l(mu_);
+      while (blocks_.empty() && !done_reading_) {
+        cond_var_.wait(l);
+      }
+      if (blocks_.empty()) {
+        // Like the underlying stream, return the bytes that were read
+        // before the end of the stream, along with the error.
+        return read_status_;
+      }
+      current_block_ = std::move(blocks_.front());
+      blocks_.pop_front();
+      pos_ = 0;
+      // Let the background thread read another block.
+      cond_var_.notify_all();
+    }
+    const size_t bytes_to_copy = std::min<size_t>(
+        bytes_to_read - result->size(), current_block_.size() - pos_);
+    result->append(current_block_, pos_, bytes_to_copy);
+    pos_ += bytes_to_copy;
+    position_ += bytes_to_copy;
+  }
+  return Status::OK();
+}
+
+int64 ReadAheadInputStream::SkipBufferedBytes(int64 bytes_to_skip) {
+  int64 bytes_skipped = 0;
+  while (bytes_skipped < bytes_to_skip) {
+    if (pos_ == current_block_.size()) {
+      mutex_lock l(mu_);
+      if (blocks_.empty()) {
+        break;
+      }
+      current_block_ = std::move(blocks_.front());
+      blocks_.pop_front();
+      pos_ = 0;
+    }
+    const size_t n = std::min<size_t>(bytes_to_skip - bytes_skipped,
+                                      current_block_.size() - pos_);
+    pos_ += n;
+    bytes_skipped += n;
+  }
+  position_ += bytes_skipped;
+  return bytes_skipped;
+}
+
+Status ReadAheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  const size_t in_current_block =
+      std::min<size_t>(bytes_to_skip, current_block_.size() - pos_);
+  pos_ += in_current_block;
+  position_ += in_current_block;
+  bytes_to_skip -= in_current_block;
+  if (bytes_to_skip == 0) {
+    return Status::OK();
+  }
+
+  StopReading();
+  bytes_to_skip -= SkipBufferedBytes(bytes_to_skip);
+  Status s;
+  if (bytes_to_skip > 0) {
+    // All the data that was read ahead was skipped, so the underlying
+    // stream is at `position_`.
+    bool done_reading;
+    {
+      mutex_lock l(mu_);
+      done_reading = done_reading_;
+      s = read_status_;
+    }
+    if (!done_reading) {
+      s = input_stream_->SkipNBytes(bytes_to_skip);
+      position_ = input_stream_->Tell();
+      if (!s.ok()) {
+        mutex_lock l(mu_);
+        read_status_ = s;
+        done_reading_ = true;
+      }
+    }
+  }
+  StartReading();
+  return s;
+}
+
+int64 ReadAheadInputStream::Tell() const { return position_; }
+
+Status ReadAheadInputStream::Reset() {
+  StopReading();
+  current_block_.clear();
+  pos_ = 0;
+  {
+    mutex_lock l(mu_);
+    blocks_.clear();
+    read_status_ = Status::OK();
+    done_reading_ = false;
+  }
+  Status s = input_stream_->Reset();
+  position_ = input_stream_->Tell();
+  StartReading();
+  return s;
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads an InputStreamInterface ahead of its consumer on a background
+// thread, so that reading the underlying stream, e.g. waiting for I/O or
+// decompressing, overlaps with processing the data that was already read.
+// The underlying stream is read in blocks of `block_bytes`, and at most
+// `max_blocks` blocks are buffered. A single instance of
+// ReadAheadInputStream is NOT safe for concurrent use by multiple threads.
+class ReadAheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of input_stream, which must outlive *this, and
+  // must not be used by anything else while *this is live. The background
+  // thread is started by `env`.
+  ReadAheadInputStream(InputStreamInterface* input_stream, size_t block_bytes,
+                       int max_blocks, Env* env = Env::Default());
+
+  ~ReadAheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  // Skips the data that was read ahead, and if that is not enough, skips
+  // the rest in the underlying stream.
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  // Starts reading ahead from the current position of the underlying
+  // stream, unless it was read to the end.
+  void StartReading();
+  void StopReading();
+  // Returns up to `bytes_to_skip` bytes of the data that was read ahead.
+  // The background thread must be stopped.
+  int64 SkipBufferedBytes(int64 bytes_to_skip);
+  // The body of the background thread.
+  void ReadLoop();
+
+  InputStreamInterface* const input_stream_;  // not owned.
+  const size_t block_bytes_;
+  const size_t max_blocks_;
+  Env* const env_;
+
+  mutex mu_;
+  condition_variable cond_var_;
+  // The blocks that were read ahead, and not yet returned.
+  std::deque<string> blocks_ GUARDED_BY(mu_);
+  // The status of the read that stopped the background thread, e.g.
+  // OUT_OF_RANGE at the end of the stream.
+  Status read_status_ GUARDED_BY(mu_);
+  bool done_reading_ GUARDED_BY(mu_) = false;
+  bool cancelled_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+
+  // The block that data is currently returned from, which is accessed only
+  // by the consumer.
+  string current_block_;
+  size_t pos_ = 0;  // current position in current_block_.
+  // The offset of the next byte to return in the underlying stream.
+  int64 position_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadAheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
@@ -0,0 +1,126 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+static std::vector<int> BlockSizes() { return {1, 2, 3, 4, 5, 7, 10, 65536}; }
+
+TEST(ReadAheadInputStream, ReadNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/read_ahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    for (int max_blocks : {1, 3}) {
+      RandomAccessInputStream input_stream(file.get());
+      ReadAheadInputStream in(&input_stream, block_size, max_blocks);
+      string read;
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "3456");
+      EXPECT_EQ(7, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "789");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST(ReadAheadInputStream, SkipAndReset) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/read_ahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    RandomAccessInputStream input_stream(file.get());
+    ReadAheadInputStream in(&input_stream, block_size, 2);
+    string read;
+    TF_ASSERT_OK(in.SkipNBytes(4));
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "45");
+    TF_ASSERT_OK(in.Reset());
+    EXPECT_EQ(0, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "01");
+    TF_ASSERT_OK(in.SkipNBytes(5));
+    EXPECT_EQ(7, in.Tell());
+    TF_ASSERT_OK(in.ReadNBytes(1, &read));
+    EXPECT_EQ(read, "7");
+    EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(20)));
+    EXPECT_EQ(10, in.Tell());
+    EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  }
+}
+
+TEST(ReadAheadInputStream, BufferedSeek) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/read_ahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    RandomAccessInputStream input_stream(file.get());
+    ReadAheadInputStream read_ahead_stream(&input_stream, block_size, 2);
+    BufferedInputStream in(&read_ahead_stream, 4);
+    string read;
+    TF_ASSERT_OK(in.Seek(6));
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "67");
+    TF_ASSERT_OK(in.Seek(1));
+    TF_ASSERT_OK(in.ReadNBytes(2, &read));
+    EXPECT_EQ(read, "12");
+    EXPECT_EQ(3, in.Tell());
+  }
+}
+
+TEST(ReadAheadInputStream, DestroyBeforeEnd) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/read_ahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, string(1 << 20, 'x')));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  // The background thread must stop when the stream is destroyed, even if it
+  // is waiting for the consumer.
+  RandomAccessInputStream input_stream(file.get());
+  ReadAheadInputStream in(&input_stream, 1024, 2);
+  string read;
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
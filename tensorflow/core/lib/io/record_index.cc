@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+const uint64 kRecordIndexMagic = 0x5844494452465446ull;
+const size_t kFooterSize = 4 * sizeof(uint64) + sizeof(uint32);
+
+}  // namespace
+
+string RecordIndexFilename(const string& filename) {
+  return strings::StrCat(filename, ".ridx");
+}
+
+RecordIndexBuilder::RecordIndexBuilder(WritableFile* dest, int64 interval)
+    : dest_(dest), interval_(interval) {
+  CHECK_GT(interval, 0);
+}
+
+Status RecordIndexBuilder::Append(const char* data, size_t n) {
+  crc_ = crc32c::Extend(crc_, data, n);
+  return dest_->Append(StringPiece(data, n));
+}
+
+Status RecordIndexBuilder::AddRecord(uint64 offset) {
+  if (num_records_++ % interval_ != 0) {
+    return Status::OK();
+  }
+  char buf[sizeof(uint64)];
+  core::EncodeFixed64(buf, offset);
+  return Append(buf, sizeof(buf));
+}
+
+Status RecordIndexBuilder::Finish(uint64 data_size) {
+  char buf[3 * sizeof(uint64)];
+  core::EncodeFixed64(buf, num_records_);
+  core::EncodeFixed64(buf + sizeof(uint64), interval_);
+  core::EncodeFixed64(buf + 2 * sizeof(uint64), data_size);
+  TF_RETURN_IF_ERROR(Append(buf, sizeof(buf)));
+  char footer[sizeof(uint32) + sizeof(uint64)];
+  core::EncodeFixed32(footer, crc32c::Mask(crc_));
+  core::EncodeFixed64(footer + sizeof(uint32), kRecordIndexMagic);
+  return dest_->Append(StringPiece(footer, sizeof(footer)));
+}
+
+Status RecordIndex::Read(Env* env, const string& filename) {
+  string data;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &data));
+  if (data.size() < kFooterSize ||
+      (data.size() - kFooterSize) % sizeof(uint64) != 0) {
+    return errors::DataLoss("Record index ", filename, " has invalid size ",
+                            data.size());
+  }
+  const char* footer = data.data() + data.size() - kFooterSize;
+  if (core::DecodeFixed64(footer + 3 * sizeof(uint64) + sizeof(uint32)) !=
+      kRecordIndexMagic) {
+    return errors::DataLoss("Record index ", filename,
+                            " has an invalid magic number");
+  }
+  const size_t checksummed_size = data.size() - sizeof(uint32) -
+                                  sizeof(uint64);
+  const uint32 masked_crc =
+      core::DecodeFixed32(data.data() + checksummed_size);
+  if (crc32c::Unmask(masked_crc) !=
+      crc32c::Value(data.data(), checksummed_size)) {
+    return errors::DataLoss("Record index ", filename, " is corrupted");
+  }
+  const int64 num_records = core::DecodeFixed64(footer);
+  const int64 interval = core::DecodeFixed64(footer + sizeof(uint64));
+  const size_t num_offsets = (data.size() - kFooterSize) / sizeof(uint64);
+  if (num_records < 0 || interval <= 0 ||
+      num_offsets != (num_records + interval - 1) / interval) {
+    return errors::DataLoss("Record index ", filename,
+                            " has an inconsistent footer");
+  }
+  num_records_ = num_records;
+  interval_ = interval;
+  data_size_ = core::DecodeFixed64(footer + 2 * sizeof(uint64));
+  offsets_.resize(num_offsets);
+  for (size_t i = 0; i < num_offsets; ++i) {
+    offsets_[i] = core::DecodeFixed64(data.data() + i * sizeof(uint64));
+  }
+  return Status::OK();
+}
+
+void RecordIndex::Lookup(int64 record, uint64* offset,
+                         int64* num_to_skip) const {
+  DCHECK_GE(record, 0);
+  DCHECK_LE(record, num_records_);
+  if (offsets_.empty()) {
+    *offset = 0;
+    *num_to_skip = record;
+    return;
+  }
+  const size_t i =
+      std::min(static_cast<size_t>(record / interval_), offsets_.size() - 1);
+  *offset = offsets_[i];
+  *num_to_skip = record - i * interval_;
+}
+
+}  // namespace io
+}  // namespace tensorflow
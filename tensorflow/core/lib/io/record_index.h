@@ -0,0 +1,108 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_LIB_IO_RECORD_INDEX_H_
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Env;
+class WritableFile;
+
+namespace io {
+
+// A record index is a sidecar file, written next to a file of records by a
+// RecordWriter, that holds the offset of every `interval`-th record. The
+// offsets are those that RecordReader::ReadRecord() accepts, which for a
+// compressed file are offsets into the uncompressed stream.
+//
+// Format of a record index:
+//   uint64    offset[n]    offset of record (i * interval), for i in [0, n)
+//   uint64    num_records  total number of records in the file
+//   uint64    interval
+//   uint64    data_size    size of the records, in the uncompressed stream
+//   uint32    masked crc of all the preceding bytes
+//   uint64    magic number
+// where n = ceil(num_records / interval).
+
+// Returns the name of the index file for the records in `filename`.
+string RecordIndexFilename(const string& filename);
+
+// Incrementally writes a record index to a WritableFile.
+class RecordIndexBuilder {
+ public:
+  // Create a builder that will append an index with the given `interval`
+  // (which must be positive) to "*dest". "*dest" must be initially empty,
+  // and must remain live while this builder is in use.
+  RecordIndexBuilder(WritableFile* dest, int64 interval);
+
+  // Notes that the next record starts at `offset`.
+  Status AddRecord(uint64 offset);
+
+  // Writes the end of the index, given the offset at which the records end.
+  // Does *not* close the WritableFile.
+  Status Finish(uint64 data_size);
+
+ private:
+  Status Append(const char* data, size_t n);
+
+  WritableFile* const dest_;
+  const int64 interval_;
+  int64 num_records_ = 0;
+  uint32 crc_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordIndexBuilder);
+};
+
+// An in-memory record index, used to find the offset of a record by its
+// number without reading the records that precede it.
+class RecordIndex {
+ public:
+  RecordIndex() {}
+
+  // Reads the index in `filename`, replacing the contents of this index.
+  Status Read(Env* env, const string& filename);
+
+  // Returns the total number of records in the indexed file.
+  int64 num_records() const { return num_records_; }
+
+  // Returns the size of the records in the indexed file, which for an
+  // uncompressed file is the size of the file. An index whose file has been
+  // rewritten since usually no longer matches its size.
+  uint64 data_size() const { return data_size_; }
+
+  // Sets "*offset" to the offset of the closest indexed record at or before
+  // record number `record`, and "*num_to_skip" to the number of records
+  // between the two. `record` must be in [0, num_records()].
+  void Lookup(int64 record, uint64* offset, int64* num_to_skip) const;
+
+ private:
+  int64 num_records_ = 0;
+  int64 interval_ = 1;
+  uint64 data_size_ = 0;
+  std::vector<uint64> offsets_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordIndex);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_RECORD_INDEX_H_
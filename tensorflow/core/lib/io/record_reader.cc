@@ -65,6 +65,13 @@ RecordReader::RecordReader(RandomAccessFile* file,
     zlib_input_stream_.reset(new ZlibInputStream(
         random_input_stream_.get(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options));
+    input_stream_ = zlib_input_stream_.get();
+    if (options.decompression_read_ahead_buffers > 0) {
+      read_ahead_stream_.reset(new ReadAheadInputStream(
+          zlib_input_stream_.get(), options.zlib_options.output_buffer_size,
+          options.decompression_read_ahead_buffers));
+      input_stream_ = read_ahead_stream_.get();
+    }
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordReaderOptions::NONE) {
     // Nothing to do.
@@ -74,6 +81,7 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 RecordReader::~RecordReader() {
+  read_ahead_stream_.reset(nullptr);
   zlib_input_stream_.reset(nullptr);
   random_input_stream_.reset(nullptr);
 }
@@ -91,7 +99,7 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   storage->resize(expected);
 
 #if !defined(IS_SLIM_BUILD)
-  if (zlib_input_stream_) {
+  if (input_stream_) {
     // If we have a zlib compressed buffer, we assume that the
     // file is being read sequentially, and we use the underlying
     // implementation to read the data.
@@ -99,7 +107,7 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
     // No checks are done to validate that the file is being read
     // sequentially.  At some point the zlib input buffer may support
     // seeking, possibly inefficiently.
-    TF_RETURN_IF_ERROR(zlib_input_stream_->ReadNBytes(expected, storage));
+    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(expected, storage));
 
     if (storage->size() != expected) {
       if (storage->empty()) {
@@ -172,5 +180,28 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+Status RecordReader::SkipRecords(uint64* offset, int64 num_to_skip,
+                                 int64* num_skipped) {
+  static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+  static const size_t kFooterSize = sizeof(uint32);
+
+  string scratch;
+  for (*num_skipped = 0; *num_skipped < num_to_skip; ++*num_skipped) {
+#if !defined(IS_SLIM_BUILD)
+    if (input_stream_) {
+      // A compressed file is read sequentially, so decompress the record.
+      TF_RETURN_IF_ERROR(ReadRecord(offset, &scratch));
+      continue;
+    }
+#endif  // IS_SLIM_BUILD
+    StringPiece lbuf;
+    TF_RETURN_IF_ERROR(
+        ReadChecksummed(*offset, sizeof(uint64), &lbuf, &scratch));
+    const uint64 length = core::DecodeFixed64(lbuf.data());
+    *offset += kHeaderSize + length + kFooterSize;
+  }
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
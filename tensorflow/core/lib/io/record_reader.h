@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
@@ -43,6 +44,11 @@ class RecordReaderOptions {
 #if !defined(IS_SLIM_BUILD)
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
+
+  // If positive, a compressed file is decompressed on a background thread,
+  // ahead of the reads, into at most this many buffers of
+  // `zlib_options.output_buffer_size` bytes.
+  int32 decompression_read_ahead_buffers = 0;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -60,6 +66,14 @@ class RecordReader {
   // OUT_OF_RANGE for end of file, or something else for an error.
   Status ReadRecord(uint64* offset, string* record);
 
+  // Skip up to `num_to_skip` records starting at "*offset", set
+  // "*num_skipped" to the number of records skipped, and update *offset to
+  // point to the offset of the next record. Unlike ReadRecord(), this only
+  // reads the header of each record of an uncompressed file. Returns OK on
+  // success, OUT_OF_RANGE if the end of file was reached first, or
+  // something else for an error.
+  Status SkipRecords(uint64* offset, int64 num_to_skip, int64* num_skipped);
+
  private:
   Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result,
                          string* storage);
@@ -69,6 +83,9 @@ class RecordReader {
 #if !defined(IS_SLIM_BUILD)
   std::unique_ptr<RandomAccessInputStream> random_input_stream_;
   std::unique_ptr<ZlibInputStream> zlib_input_stream_;
+  std::unique_ptr<ReadAheadInputStream> read_ahead_stream_;
+  // The stream that the records of a compressed file are read from.
+  InputStreamInterface* input_stream_ = nullptr;
 #endif  // IS_SLIM_BUILD
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 
@@ -87,13 +88,14 @@ TEST(RecordReaderWriterTest, TestZlib) {
       TF_CHECK_OK(writer.Flush());
     }
 
-    {
+    for (int read_ahead_buffers : {0, 2}) {
       std::unique_ptr<RandomAccessFile> read_file;
       // Read it back with the RecordReader.
       TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
       io::RecordReaderOptions options;
       options.compression_type = io::RecordReaderOptions::ZLIB_COMPRESSION;
       options.zlib_options.input_buffer_size = buf_size;
+      options.decompression_read_ahead_buffers = read_ahead_buffers;
       io::RecordReader reader(read_file.get(), options);
       uint64 offset = 0;
       string record;
@@ -101,8 +103,131 @@ TEST(RecordReaderWriterTest, TestZlib) {
       EXPECT_EQ("abc", record);
       TF_CHECK_OK(reader.ReadRecord(&offset, &record));
       EXPECT_EQ("defg", record);
+      EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_index_test";
+  string index_fname = io::RecordIndexFilename(fname);
+
+  for (int num_records : {0, 1, 6, 7, 10}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+      std::unique_ptr<WritableFile> index_file;
+      TF_CHECK_OK(env->NewWritableFile(index_fname, &index_file));
+
+      io::RecordWriterOptions options;
+      options.index_interval = 3;
+      io::RecordWriter writer(file.get(), index_file.get(), options);
+      for (int i = 0; i < num_records; ++i) {
+        TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record_", i)));
+      }
+      TF_CHECK_OK(writer.Close());
+      TF_CHECK_OK(index_file->Close());
     }
+
+    {
+      io::RecordIndex index;
+      TF_CHECK_OK(index.Read(env, index_fname));
+      EXPECT_EQ(num_records, index.num_records());
+      uint64 file_size;
+      TF_CHECK_OK(env->GetFileSize(fname, &file_size));
+      EXPECT_EQ(file_size, index.data_size());
+
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReader reader(read_file.get());
+      for (int i = 0; i <= num_records; ++i) {
+        uint64 offset;
+        int64 num_to_skip;
+        index.Lookup(i, &offset, &num_to_skip);
+        // Only the end of the file can be a whole interval past an offset.
+        EXPECT_LE(num_to_skip, i < num_records ? 2 : 3);
+        int64 num_skipped;
+        TF_CHECK_OK(reader.SkipRecords(&offset, num_to_skip, &num_skipped));
+        EXPECT_EQ(num_to_skip, num_skipped);
+        string record;
+        if (i < num_records) {
+          TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+          EXPECT_EQ(strings::StrCat("record_", i), record);
+        } else {
+          EXPECT_TRUE(
+              errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+        }
+      }
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestSkipRecords) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_skip_test";
+
+  for (auto compression_type : {io::RecordWriterOptions::NONE,
+                                io::RecordWriterOptions::ZLIB_COMPRESSION}) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+      io::RecordWriterOptions options;
+      options.compression_type = compression_type;
+      io::RecordWriter writer(file.get(), options);
+      TF_EXPECT_OK(writer.WriteRecord("abc"));
+      TF_EXPECT_OK(writer.WriteRecord("defg"));
+      TF_EXPECT_OK(writer.WriteRecord("hi"));
+      TF_CHECK_OK(writer.Close());
+    }
+
+    {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.compression_type =
+          static_cast<io::RecordReaderOptions::CompressionType>(
+              compression_type);
+      io::RecordReader reader(read_file.get(), options);
+      uint64 offset = 0;
+      int64 num_skipped;
+      TF_CHECK_OK(reader.SkipRecords(&offset, 2, &num_skipped));
+      EXPECT_EQ(2, num_skipped);
+      string record;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("hi", record);
+      EXPECT_TRUE(
+          errors::IsOutOfRange(reader.SkipRecords(&offset, 1, &num_skipped)));
+      EXPECT_EQ(0, num_skipped);
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestCorruptIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_corrupt_index";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordIndexBuilder builder(file.get(), 2);
+    TF_CHECK_OK(builder.AddRecord(0));
+    TF_CHECK_OK(builder.Finish(0));
+    TF_CHECK_OK(file->Close());
   }
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  contents[0] ^= 1;
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  io::RecordIndex index;
+  EXPECT_TRUE(errors::IsDataLoss(index.Read(env, fname)));
+  EXPECT_TRUE(errors::IsNotFound(index.Read(env, fname + "_missing")));
+
+  // A truncated index is detected too.
+  contents[0] ^= 1;
+  contents.resize(contents.size() - sizeof(uint64));
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  EXPECT_TRUE(errors::IsDataLoss(index.Read(env, fname)));
 }
 
 }  // namespace tensorflow
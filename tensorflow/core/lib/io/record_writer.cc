@@ -56,7 +56,15 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
 
 RecordWriter::RecordWriter(WritableFile* dest,
                            const RecordWriterOptions& options)
+    : RecordWriter(dest, nullptr, options) {}
+
+RecordWriter::RecordWriter(WritableFile* dest, WritableFile* index_dest,
+                           const RecordWriterOptions& options)
     : dest_(dest), options_(options) {
+  if (index_dest != nullptr) {
+    index_builder_.reset(
+        new RecordIndexBuilder(index_dest, options.index_interval));
+  }
   if (IsZlibCompressed(options)) {
 // We don't have zlib available on all embedded platforms, so fail.
 #if defined(IS_SLIM_BUILD)
@@ -105,12 +113,22 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   char footer[sizeof(uint32)];
   core::EncodeFixed32(footer, MaskedCrc(data.data(), data.size()));
 
+  if (index_builder_) {
+    TF_RETURN_IF_ERROR(index_builder_->AddRecord(offset_));
+  }
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(footer, sizeof(footer))));
+  offset_ += sizeof(header) + data.size() + sizeof(footer);
+  return Status::OK();
 }
 
 Status RecordWriter::Close() {
+  if (index_builder_) {
+    Status s = index_builder_->Finish(offset_);
+    index_builder_.reset();
+    TF_RETURN_IF_ERROR(s);
+  }
 #if !defined(IS_SLIM_BUILD)
   if (IsZlibCompressed(options_)) {
     Status s = dest_->Close();
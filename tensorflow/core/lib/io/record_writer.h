@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 #define TENSORFLOW_LIB_IO_RECORD_WRITER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
@@ -43,6 +46,10 @@ class RecordWriterOptions {
 #if !defined(IS_SLIM_BUILD)
   ZlibCompressionOptions zlib_options;
 #endif  // IS_SLIM_BUILD
+
+  // If the RecordWriter writes an index, the number of records between
+  // consecutive entries of the index.
+  int64 index_interval = 1024;
 };
 
 class RecordWriter {
@@ -53,6 +60,13 @@ class RecordWriter {
   RecordWriter(WritableFile* dest,
                const RecordWriterOptions& options = RecordWriterOptions());
 
+  // Create a writer that will also append an index of the records (see
+  // record_index.h) to "*index_dest", if it is not null.
+  // "*index_dest" must be initially empty.
+  // "*index_dest" must remain live while this Writer is in use.
+  RecordWriter(WritableFile* dest, WritableFile* index_dest,
+               const RecordWriterOptions& options);
+
   // Calls Close() and logs if an error occurs.
   //
   // TODO(jhseu): Require that callers explicitly call Close() and remove the
@@ -66,7 +80,8 @@ class RecordWriter {
   // WritableFile.
   Status Flush();
 
-  // Writes all output to the file. Does *not* close the WritableFile.
+  // Writes all output to the file, and completes the index if there is
+  // one. Does *not* close the WritableFiles.
   //
   // After calling Close(), any further calls to `WriteRecord()` or `Flush()`
   // are invalid.
@@ -75,6 +90,9 @@ class RecordWriter {
  private:
   WritableFile* dest_;
   RecordWriterOptions options_;
+  // The offset of the next record in the (uncompressed) output.
+  uint64 offset_ = 0;
+  std::unique_ptr<RecordIndexBuilder> index_builder_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordWriter);
 };
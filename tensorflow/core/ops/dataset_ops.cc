@@ -142,18 +142,51 @@ REGISTER_OP("ParallelMapDataset")
     .Attr("Targuments: list(type) >= 0")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("sloppy: bool = false")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that applies `f` to the outputs of `input_dataset`.
 
-Unlike a "MapDataset", which applies `f` sequentially, this dataset uses
-up to `num_threads` threads to process elements from `input_dataset`
-in parallel.
+Unlike a "MapDataset", which applies `f` sequentially, this dataset runs
+up to `num_threads` invocations of `f` concurrently, on the inter-op
+thread pool, to process elements from `input_dataset` in parallel.
 
-num_threads: The number of threads to use to process elements from
-  `input_dataset`.
+num_threads: The maximum number of elements from `input_dataset` to process
+  concurrently.
 output_buffer_size: The maximum number of output elements to buffer in an
-  iterator over this dataset.
+  iterator over this dataset, including the elements being processed. It
+  may be smaller than `num_threads`.
+sloppy: If false, the output elements are produced in the order of the
+  input elements. If true, each output element is produced as soon as its
+  processing completes, so that a slow element does not delay the
+  elements after it.
+)doc");
+
+REGISTER_OP("MapAndBatchDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("batch_size: int64")
+    .Input("num_parallel_batches: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to the outputs of `input_dataset` and then
+batches `batch_size` of them.
+
+Unlike a "MapDataset" followed by a "BatchDataset", the return values of each
+call to `f` are copied directly into the batch output tensors, and the calls
+for the elements of up to `num_parallel_batches` batches run in parallel.
+
+batch_size: A scalar representing the number of elements to accumulate in a
+  batch. It determines the number of concurrent invocations of `f` that process
+  elements from `input_dataset` in parallel.
+num_parallel_batches: A scalar representing the number of batches to create in
+  parallel. Processing multiple batches in parallel benefits workloads prone to
+  stragglers.
 )doc");
 
 REGISTER_OP("FlatMapDataset")
@@ -177,6 +210,70 @@ f: A function mapping elements of `input_dataset`, concatenated with
   `output_types` and `output_shapes`.
 )doc");
 
+REGISTER_OP("InterleaveDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("cycle_length: int64")
+    .Input("block_length: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to the outputs of `input_dataset`.
+
+Unlike MapDataset, the `f` in InterleaveDataset is expected to return
+a Dataset resource, and InterleaveDataset will flatten successive
+results into a single Dataset. Unlike FlatMapDataset,
+InterleaveDataset will interleave sequences of up to `block_length`
+consecutive elements from `cycle_length` input elements.
+
+f: A function mapping elements of `input_dataset`, concatenated with
+  `other_arguments`, to a Dataset resource that contains elements matching
+  `output_types` and `output_shapes`.
+cycle_length: The number of input elements whose datasets are interleaved
+  concurrently.
+block_length: The number of consecutive elements to produce from each of
+  those datasets before cycling to the next one.
+)doc");
+
+REGISTER_OP("ParallelInterleaveDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("cycle_length: int64")
+    .Input("block_length: int64")
+    .Input("sloppy: bool")
+    .Input("buffer_output_elements: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to the outputs of `input_dataset`.
+
+The resulting dataset is similar to the `InterleaveDataset`, except that the
+datasets returned by `f` for the `cycle_length` input elements are read
+concurrently, each by its own thread. This is useful when `f` reads from
+a high-latency source, such as a file in a remote filesystem.
+
+f: A function mapping elements of `input_dataset`, concatenated with
+  `other_arguments`, to a Dataset resource that contains elements matching
+  `output_types` and `output_shapes`.
+cycle_length: The number of input elements whose datasets are read
+  concurrently.
+block_length: The number of consecutive elements to produce from each of
+  those datasets before cycling to the next one.
+sloppy: If false, the elements are produced in the same deterministic order
+  as by `InterleaveDataset`. If true, an element of another dataset in the
+  cycle may be produced when the next one in order is not ready yet.
+buffer_output_elements: The number of elements that each thread buffers
+  ahead of their consumption.
+)doc");
+
 REGISTER_OP("GroupByWindowDataset")
     .Input("input_dataset: resource")
     .Input("key_func_other_arguments: Tkey_func_other_arguments")
@@ -289,6 +386,24 @@ row_shape: A vector representing the dense shape of each row in the produced
   SparseTensor.
 )doc");
 
+REGISTER_OP("PrefetchDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that asynchronously prefetches elements from `input_dataset`.
+
+An iterator over this dataset runs a background thread that gets elements
+from `input_dataset` ahead of their consumption, so that producing them
+overlaps with the computation that consumes them.
+
+buffer_size: The maximum number of elements to buffer in an iterator over
+  this dataset.
+)doc");
+
 REGISTER_OP("RangeDataset")
     .Input("start: int64")
     .Input("stop: int64")
@@ -326,9 +441,65 @@ seed: A scalar seed for the random number generator. If either seed or
 seed2: A second scalar seed to avoid seed collision.
 )doc");
 
+REGISTER_OP("SpillingShuffleDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Input("scratch_directory: string")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that shuffles elements from `input_dataset` pseudorandomly.
+
+Unlike "ShuffleDataset", which keeps the buffered elements in memory, this
+dataset writes each buffered element to a scratch file in `scratch_directory`
+and keeps only its location in memory. This allows large shuffle buffers of
+large elements, at the cost of writing and reading each element once.
+
+buffer_size: The number of output elements to buffer in an iterator over
+  this dataset. Compare with the `min_after_dequeue` attr when creating a
+  `RandomShuffleQueue`.
+seed: A scalar seed for the random number generator. If either seed or
+  seed2 is set to be non-zero, the random number generator is seeded
+  by the given seed.  Otherwise, a random seed is used.
+seed2: A second scalar seed to avoid seed collision.
+scratch_directory: A scalar representing a local directory, in which the
+  iterators of this dataset create their scratch files. The scratch files
+  are deleted as their elements are produced, or when the iterator is
+  destroyed.
+)doc");
+
+REGISTER_OP("CacheDataset")
+    .Input("input_dataset: resource")
+    .Input("filename: string")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that caches elements from `input_dataset`.
+
+The first iterator over this dataset to reach the end of `input_dataset`
+records its elements, which the iterators created afterwards replay instead of
+evaluating `input_dataset` again. If an iterator is destroyed before reaching
+the end, or gets an error from `input_dataset`, nothing is cached.
+
+filename: A path on the filesystem where the elements should be cached. The
+  elements are written to a tensor bundle next to it, and the cache file, which
+  names the bundle, is written last. If the cache file exists, it is read, even
+  by another process; otherwise, the iterator that holds a lockfile next to it
+  writes it. A lockfile that its holder has not refreshed for 10 minutes is
+  broken. If empty, the elements are cached in memory.
+)doc");
+
 REGISTER_OP("TextLineDataset")
     .Input("filenames: string")
     .Output("handle: resource")
+    .Attr("buffer_size: int >= 1 = 262144")
+    .Attr("read_ahead_blocks: int >= 0 = 0")
     .SetShapeFn(shape_inference::ScalarShape)  // TODO(mrry): validate
                                                // that `filenames` is
                                                // a scalar or a
@@ -338,6 +509,10 @@ Creates a dataset that emits the lines of one or more text files.
 
 filenames: A scalar or a vector containing the name(s) of the file(s) to be
   read.
+buffer_size: The number of bytes to buffer when reading a file.
+read_ahead_blocks: The number of blocks of `buffer_size` bytes to read ahead
+  of the buffer on a background thread. If 0, each block is read when the
+  buffer is empty.
 )doc");
 
 REGISTER_OP("FixedLengthRecordDataset")
@@ -346,6 +521,8 @@ REGISTER_OP("FixedLengthRecordDataset")
     .Input("record_bytes: int64")
     .Input("footer_bytes: int64")
     .Output("handle: resource")
+    .Attr("buffer_size: int >= 1 = 262144")
+    .Attr("read_ahead_blocks: int >= 0 = 0")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that emits the records from one or more binary files.
@@ -357,6 +534,10 @@ header_bytes: A scalar representing the number of bytes to skip at the
 record_bytes: A scalar representing the number of bytes in each record.
 footer_bytes: A scalar representing the number of bytes to skip at the end
   of a file.
+buffer_size: The number of bytes to buffer when reading a file.
+read_ahead_blocks: The number of blocks of `buffer_size` bytes to read ahead
+  of the buffer on a background thread. If 0, each block is read when the
+  buffer is empty.
 )doc");
 
 REGISTER_OP("TFRecordDataset")
@@ -373,6 +554,42 @@ compression_type: A scalar containing either (i) the empty string (no
   compression), (ii) "ZLIB", or (iii) "GZIP".
 )doc");
 
+REGISTER_OP("TFRecordRangeDataset")
+    .Input("filenames: string")
+    .Input("compression_type: string")
+    .Input("start: int64")
+    .Input("count: int64")
+    .Input("num_shards: int64")
+    .Input("shard_index: int64")
+    .Output("handle: resource")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that emits a range of the records of one or more TFRecord
+files.
+
+From each file, the dataset emits the records numbered in the range
+[`start`, `start + count`), split into `num_shards` contiguous shards of
+which it emits the `shard_index`-th. If an uncompressed file has a record
+index, written next to it by a `RecordWriter`, the index is used to find the
+first record to read without reading the records that precede it. Otherwise,
+or if the index does not match the file, the preceding records are skipped
+sequentially, and sharding must first count the records in the file.
+
+filenames: A scalar or vector containing the name(s) of the file(s) to be
+  read.
+compression_type: A scalar containing either (i) the empty string (no
+  compression), (ii) "ZLIB", or (iii) "GZIP".
+start: A scalar representing the number of the first record to read from
+  each file.
+count: A scalar representing the number of records to read from each file,
+  starting at `start`. If negative, all the records from `start` to the end
+  of the file are read.
+num_shards: A scalar representing the number of shards into which the range
+  of records of each file is split.
+shard_index: A scalar representing the shard of each file to read, in the
+  range [0, `num_shards`).
+)doc");
+
 REGISTER_OP("Iterator")
     .Output("handle: resource")
     .Attr("shared_name: string")
@@ -468,4 +685,36 @@ REGISTER_OP("IteratorDispose")
 Releases any resources used by the given iterator.
 )doc");
 
+REGISTER_OP("SerializeIterator")
+    .Input("resource_handle: resource")
+    .Output("serialized: string")
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      c->set_output(0, c->Vector(c->UnknownDim()));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Saves the state of the given iterator.
+
+resource_handle: A handle to an iterator resource.
+serialized: The state of the iterator, as a vector of serialized
+  `NamedTensorProto`s. The state records the position of the iterator in
+  its input pipeline, such as file offsets, counters, buffered elements and
+  random number generator state, so that `DeserializeIterator` can resume
+  from it without replaying the elements that were already produced.
+)doc");
+
+REGISTER_OP("DeserializeIterator")
+    .Input("resource_handle: resource")
+    .Input("serialized: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Restores the state of the given iterator from `serialized`.
+
+The iterator must have been initialized with the same dataset as the
+iterator whose state was saved.
+
+resource_handle: A handle to an iterator resource.
+serialized: The state of an iterator, as produced by `SerializeIterator`.
+)doc");
+
 }  // namespace tensorflow
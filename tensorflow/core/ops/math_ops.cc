@@ -2461,4 +2461,49 @@ Equivalent to np.digitize.
 @end_compatibility
 )doc");
 
+// --------------------------------------------------------------------------
+
+REGISTER_OP("_FusedCwise")
+    .Input("inputs: N * T")
+    .Output("y: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("ops: list(string) >= 1")
+    .Attr("operands: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      // The shape of the non-scalar inputs, or a scalar.
+      ShapeHandle out = c->Scalar();
+      bool has_non_scalar_input = false;
+      for (int i = 0; i < c->num_inputs(); ++i) {
+        ShapeHandle in = c->input(i);
+        if (c->RankKnown(in) && c->Rank(in) == 0) continue;
+        if (!has_non_scalar_input) {
+          out = in;
+          has_non_scalar_input = true;
+        } else {
+          TF_RETURN_WITH_CONTEXT_IF_ERROR(c->Merge(out, in, &out),
+                                          "From merging shape ", i,
+                                          " with other shapes.");
+        }
+      }
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Evaluates a fused chain of element-wise operations in a single pass.
+
+The operations run in order over registers: registers 0 to N - 1 hold the
+inputs, and register N + i holds the result of operation i, which reads
+registers operands[2 * i] and operands[2 * i + 1] (-1 for unary operations).
+Every input is either a scalar or has the shape of the output.
+
+Created by the element-wise fusion pass (see
+OptimizerOptions.do_elementwise_fusion).
+
+inputs: The tensors read by the fused operations.
+ops: The types of the fused operations, such as "Add" or "Relu".
+operands: The two registers read by each operation.
+y: The result of the last operation.
+)doc");
+
 }  // namespace tensorflow
@@ -260,3 +260,9 @@ def tf_additional_mpi_lib_defines():
       "//tensorflow:with_mpi_support": ["TENSORFLOW_USE_MPI"],
       "//conditions:default": [],
   })
+
+def tf_additional_shm_lib_defines():
+  return select({
+      "//tensorflow:with_shm_support": ["TENSORFLOW_USE_SHM"],
+      "//conditions:default": [],
+  })
@@ -39,3 +39,11 @@ def tf_additional_mpi_deps():
       ],
       "//conditions:default": [],
   })
+
+def tf_additional_shm_deps():
+  return select({
+      "//tensorflow:with_shm_support": [
+          "//tensorflow/contrib/shm:shm_server_lib",
+      ],
+      "//conditions:default": [],
+  })
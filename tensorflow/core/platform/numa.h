@@ -0,0 +1,56 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_PLATFORM_NUMA_H_
+#define TENSORFLOW_PLATFORM_NUMA_H_
+
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace port {
+
+// The node of the threads that may run on any NUMA node.
+static const int kNUMANoAffinity = -1;
+
+// Returns the number of NUMA nodes with CPUs this process may run on, or 1
+// if the topology is unknown.
+//
+// Setting the environment variable TF_NUMA_SIMULATED_NODES to N > 1 splits
+// the schedulable CPUs into N simulated nodes instead, which exercises the
+// thread pinning on machines without several NUMA nodes. Memory is not bound
+// to simulated nodes.
+int NUMANumNodes();
+
+// Restricts the calling thread to the CPUs of NUMA node "node", or lets it
+// run on all the schedulable CPUs if "node" is kNUMANoAffinity. Does nothing
+// if the node has no schedulable CPU or if pinning is not supported.
+void NUMASetThreadNodeAffinity(int node);
+
+// Returns the node the calling thread was restricted to with
+// NUMASetThreadNodeAffinity, or kNUMANoAffinity.
+int NUMAGetThreadNodeAffinity();
+
+// Allocates "size" bytes aligned to "minimum_alignment", preferably on the
+// memory of NUMA node "node". "minimum_alignment" must be a power of 2 no
+// larger than the page size. The memory must be freed with NUMAFree with the
+// same size.
+void* NUMAMalloc(int node, size_t size, int minimum_alignment);
+void NUMAFree(void* ptr, size_t size);
+
+}  // namespace port
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_NUMA_H_
@@ -14,10 +14,13 @@ limitations under the License.
 ==============================================================================*/
 
 #include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -33,6 +36,51 @@ TEST(Port, AlignedMalloc) {
   }
 }
 
+// Sets TF_NUMA_SIMULATED_NODES, which makes the port layer simulate that
+// many NUMA nodes whatever the topology of the machine, and restores its
+// previous value when it goes out of scope.
+class ScopedSimulatedNUMANodes {
+ public:
+  explicit ScopedSimulatedNUMANodes(const char* num_nodes) {
+    const char* previous = getenv("TF_NUMA_SIMULATED_NODES");
+    had_previous_ = previous != nullptr;
+    if (had_previous_) previous_ = previous;
+    setenv("TF_NUMA_SIMULATED_NODES", num_nodes, 1);
+  }
+  ~ScopedSimulatedNUMANodes() {
+    if (had_previous_) {
+      setenv("TF_NUMA_SIMULATED_NODES", previous_.c_str(), 1);
+    } else {
+      unsetenv("TF_NUMA_SIMULATED_NODES");
+    }
+  }
+
+ private:
+  bool had_previous_;
+  string previous_;
+};
+
+TEST(Port, NUMASimulatedNodes) {
+  ScopedSimulatedNUMANodes simulated_nodes("3");
+  EXPECT_EQ(3, NUMANumNodes());
+
+  // The threads of a pool pinned to a node report that node.
+  ThreadOptions thread_options;
+  thread_options.numa_node = 2;
+  int node = kNUMANoAffinity;
+  {
+    thread::ThreadPool pool(Env::Default(), thread_options, "test", 1);
+    pool.Schedule([&node]() { node = NUMAGetThreadNodeAffinity(); });
+  }
+  EXPECT_EQ(2, node);
+
+  void* p = NUMAMalloc(1, 1 << 20, 64);
+  ASSERT_TRUE(p != nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0);
+  memset(p, 1, 1 << 20);
+  NUMAFree(p, 1 << 20);
+}
+
 TEST(ConditionVariable, WaitForMilliseconds_Timeout) {
   mutex m;
   mutex_lock l(m);
@@ -20,10 +20,13 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #endif
 #include <stdio.h>
 #include <stdlib.h>
@@ -35,6 +38,7 @@ limitations under the License.
 #if defined(__APPLE__) && defined(__MACH__)
 #include <thread>
 #endif
+#include <vector>
 
 namespace tensorflow {
 namespace port {
@@ -121,6 +125,166 @@ void MallocExtension_ReleaseToSystem(std::size_t num_bytes) {
 
 std::size_t MallocExtension_GetAllocatedSize(const void* p) { return 0; }
 
+namespace {
+
+thread_local int numa_thread_node = kNUMANoAffinity;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+// The CPUs the process could run on before any thread was pinned.
+const cpu_set_t& InitialCPUs() {
+  static const cpu_set_t* cpus = [] {
+    cpu_set_t* cpus = new cpu_set_t;
+    CPU_ZERO(cpus);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), cpus) != 0) {
+      perror("sched_getaffinity");
+    }
+    return cpus;
+  }();
+  return *cpus;
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11" and appends the schedulable
+// CPUs in it to "cpus".
+void ParseCPUList(const char* list, std::vector<int>* cpus) {
+  while (*list != '\0' && *list != '\n') {
+    char* end;
+    const long first = strtol(list, &end, 10);
+    if (end == list) return;
+    long last = first;
+    if (*end == '-') {
+      list = end + 1;
+      last = strtol(list, &end, 10);
+      if (end == list) return;
+    }
+    for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &InitialCPUs())) cpus->push_back(cpu);
+    }
+    list = *end == ',' ? end + 1 : end;
+  }
+}
+
+// Returns the number of nodes simulated with TF_NUMA_SIMULATED_NODES, or 0 if
+// the hardware topology is used. The variable is read on every call, so that
+// tests can change it.
+int NumSimulatedNodes() {
+  const char* simulated = getenv("TF_NUMA_SIMULATED_NODES");
+  const int num_simulated = simulated == nullptr ? 0 : atoi(simulated);
+  if (num_simulated <= 1 || CPU_COUNT(&InitialCPUs()) == 0) return 0;
+  return num_simulated;
+}
+
+// Returns the CPUs of simulated node "node" out of "num_simulated": contiguous
+// ranges of the schedulable CPUs, or a shared CPU per node if there are fewer
+// CPUs than nodes.
+std::vector<int> SimulatedNodeCPUs(int node, int num_simulated) {
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &InitialCPUs())) cpus.push_back(cpu);
+  }
+  const size_t begin = node * cpus.size() / num_simulated;
+  const size_t end = (node + 1) * cpus.size() / num_simulated;
+  if (begin == end) return {cpus[node % cpus.size()]};
+  return std::vector<int>(cpus.begin() + begin, cpus.begin() + end);
+}
+
+// The schedulable CPUs of each NUMA node of the machine. sysfs is only read
+// once.
+const std::vector<std::vector<int>>& NodeCPUs() {
+  static const std::vector<std::vector<int>>* node_cpus = [] {
+    auto* node_cpus = new std::vector<std::vector<int>>;
+    for (int node = 0;; ++node) {
+      char path[64];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               node);
+      FILE* f = fopen(path, "r");
+      if (f == nullptr) break;
+      char list[4096];
+      std::vector<int> cpus;
+      if (fgets(list, sizeof(list), f) != nullptr) ParseCPUList(list, &cpus);
+      fclose(f);
+      node_cpus->push_back(std::move(cpus));
+    }
+    // Nodes without schedulable CPUs, such as memory-only nodes, are only
+    // dropped from the end so that node numbers stay those of the kernel.
+    while (!node_cpus->empty() && node_cpus->back().empty()) {
+      node_cpus->pop_back();
+    }
+    return node_cpus;
+  }();
+  return *node_cpus;
+}
+#endif
+
+}  // namespace
+
+int NUMANumNodes() {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const int num_simulated = NumSimulatedNodes();
+  if (num_simulated > 0) return num_simulated;
+  const int num_nodes = NodeCPUs().size();
+  return num_nodes > 0 ? num_nodes : 1;
+#else
+  return 1;
+#endif
+}
+
+void NUMASetThreadNodeAffinity(int node) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  if (node == kNUMANoAffinity) {
+    cpuset = InitialCPUs();
+  } else {
+    const int num_simulated = NumSimulatedNodes();
+    const int num_nodes =
+        num_simulated > 0 ? num_simulated : NodeCPUs().size();
+    if (node < 0 || node >= num_nodes) return;
+    const std::vector<int> cpus = num_simulated > 0
+                                      ? SimulatedNodeCPUs(node, num_simulated)
+                                      : NodeCPUs()[node];
+    if (cpus.empty()) return;
+    CPU_ZERO(&cpuset);
+    for (int cpu : cpus) CPU_SET(cpu, &cpuset);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    perror("sched_setaffinity");
+    return;
+  }
+  numa_thread_node = node;
+#endif
+}
+
+int NUMAGetThreadNodeAffinity() { return numa_thread_node; }
+
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  // Pages are aligned to more than any supported "minimum_alignment".
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) return nullptr;
+#ifdef SYS_mbind
+  // Prefer the pages of "node" without requiring libnuma. Failures only cost
+  // locality, since the pages are not touched yet.
+  if (node >= 0 && node < 64 && NumSimulatedNodes() == 0) {
+    const unsigned long nodemask = 1UL << node;
+    const int kMPolPreferred = 1;
+    syscall(SYS_mbind, ptr, size, kMPolPreferred, &nodemask,
+            sizeof(nodemask) * 8, 0);
+  }
+#endif
+  return ptr;
+#else
+  return AlignedMalloc(size, minimum_alignment);
+#endif
+}
+
+void NUMAFree(void* ptr, size_t size) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  if (ptr != nullptr) munmap(ptr, size);
+#else
+  AlignedFree(ptr);
+#endif
+}
+
 void AdjustFilenameForLogging(string* filename) {
   // Nothing to do
 }
@@ -801,6 +801,22 @@ class TFRecordIteratorTest(test.TestCase):
       actual.append(r)
     self.assertEqual(actual, original)
 
+  def testIndexWithoutClose(self):
+    """Verify that dropping an unclosed writer finishes its record index."""
+    fn = os.path.join(self.get_temp_dir(), "indexed_without_close")
+    options = tf_record.TFRecordOptions(
+        compression_type=TFRecordCompressionType.NONE, index_interval=3)
+    writer = tf_record.TFRecordWriter(fn, options=options)
+    for i in range(self._num_records):
+      writer.write(self._Record(i))
+    del writer
+    self.assertAllEqual([self._Record(i) for i in range(self._num_records)],
+                        list(tf_record.tf_record_iterator(fn)))
+    # The offsets of records 0, 3 and 6, then the footer: the number of
+    # records, the interval, the size of the records, a crc and a magic
+    # number.
+    self.assertEqual(3 * 8 + 3 * 8 + 4 + 8, os.path.getsize(fn + ".ridx"))
+
   def testBadFile(self):
     """Verify that tf_record_iterator throws an exception on bad TFRecords."""
     fn = os.path.join(self.get_temp_dir(), "bad_file")
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/c/tf_status_helper.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/platform/env.h"
@@ -29,6 +30,7 @@ PyRecordWriter::PyRecordWriter() {}
 
 PyRecordWriter* PyRecordWriter::New(const string& filename,
                                     const string& compression_type_string,
+                                    int64 index_interval,
                                     TF_Status* out_status) {
   std::unique_ptr<WritableFile> file;
   Status s = Env::Default()->NewWritableFile(filename, &file);
@@ -36,13 +38,27 @@ PyRecordWriter* PyRecordWriter::New(const string& filename,
     Set_TF_Status_from_Status(out_status, s);
     return nullptr;
   }
+  std::unique_ptr<WritableFile> index_file;
+  if (index_interval > 0) {
+    s = Env::Default()->NewWritableFile(RecordIndexFilename(filename),
+                                        &index_file);
+    if (!s.ok()) {
+      Set_TF_Status_from_Status(out_status, s);
+      return nullptr;
+    }
+  }
   PyRecordWriter* writer = new PyRecordWriter;
   writer->file_ = std::move(file);
+  writer->index_file_ = std::move(index_file);
 
   RecordWriterOptions options =
       RecordWriterOptions::CreateRecordWriterOptions(compression_type_string);
+  if (index_interval > 0) {
+    options.index_interval = index_interval;
+  }
 
-  writer->writer_.reset(new RecordWriter(writer->file_.get(), options));
+  writer->writer_.reset(new RecordWriter(
+      writer->file_.get(), writer->index_file_.get(), options));
   return writer;
 }
 
@@ -68,6 +84,14 @@ void PyRecordWriter::Close(TF_Status* out_status) {
     return;
   }
   file_.reset(nullptr);
+  if (index_file_ != nullptr) {
+    s = index_file_->Close();
+    if (!s.ok()) {
+      Set_TF_Status_from_Status(out_status, s);
+      return;
+    }
+    index_file_.reset(nullptr);
+  }
 }
 
 }  // namespace io
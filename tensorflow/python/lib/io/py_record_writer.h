@@ -38,9 +38,12 @@ class PyRecordWriter {
  public:
   // TODO(vrv): make this take a shared proto to configure
   // the compression options.
+  //
+  // If `index_interval` is positive, the writer also writes a record index
+  // to RecordIndexFilename(filename).
   static PyRecordWriter* New(const string& filename,
                              const string& compression_type_string,
-                             TF_Status* out_status);
+                             int64 index_interval, TF_Status* out_status);
   ~PyRecordWriter();
 
   bool WriteRecord(tensorflow::StringPiece record);
@@ -49,8 +52,11 @@ class PyRecordWriter {
  private:
   PyRecordWriter();
 
-  std::unique_ptr<io::RecordWriter> writer_;
   std::unique_ptr<WritableFile> file_;
+  std::unique_ptr<WritableFile> index_file_;
+  // Declared after the files, since destroying a writer that has not been
+  // closed finishes writing to them.
+  std::unique_ptr<io::RecordWriter> writer_;
   TF_DISALLOW_COPY_AND_ASSIGN(PyRecordWriter);
 };
 
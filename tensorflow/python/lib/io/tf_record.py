@@ -41,8 +41,18 @@ class TFRecordOptions(object):
       TFRecordCompressionType.NONE: ""
   }
 
-  def __init__(self, compression_type):
+  def __init__(self, compression_type, index_interval=0):
+    """Creates a `TFRecordOptions`.
+
+    Args:
+      compression_type: A `TFRecordCompressionType` value.
+      index_interval: (Optional.) If positive, a `TFRecordWriter` also writes
+        a record index, which holds the offset of every `index_interval`-th
+        record, to the file `path + ".ridx"`. Readers use the index to find
+        a record without reading all the records before it.
+    """
     self.compression_type = compression_type
+    self.index_interval = index_interval
 
   @classmethod
   def get_compression_type_string(cls, options):
@@ -100,10 +110,12 @@ class TFRecordWriter(object):
       IOError: If `path` cannot be opened for writing.
     """
     compression_type = TFRecordOptions.get_compression_type_string(options)
+    index_interval = options.index_interval if options else 0
 
     with errors.raise_exception_on_not_ok_status() as status:
       self._writer = pywrap_tensorflow.PyRecordWriter_New(
-          compat.as_bytes(path), compat.as_bytes(compression_type), status)
+          compat.as_bytes(path), compat.as_bytes(compression_type),
+          index_interval, status)
 
   def __enter__(self):
     """Enter a `with` block."""
@@ -123,6 +123,7 @@ function run_configure_for_cpu_build {
     export TF_NEED_MKL=0
   fi
   export TF_NEED_VERBS=0
+  export TF_NEED_SHM=0
   export TF_NEED_GCP=0
   export TF_NEED_HDFS=0
   export TF_NEED_OPENCL=0
@@ -146,6 +147,7 @@ function run_configure_for_gpu_build {
     export CC_OPT_FLAGS="-march=native"
   fi
   export TF_NEED_VERBS=0
+  export TF_NEED_SHM=0
   export TF_NEED_MKL=0
   export TF_NEED_GCP=0
   export TF_NEED_HDFS=0